@@ -6,9 +6,9 @@ precision mediump float;
 #endif
 
 uniform sampler2D tex;
-uniform float time;
 
 in vec2 tc;
+in float age;
 
 out vec4 color;
 
@@ -18,6 +18,6 @@ void main()
 	color *= mix(
 		vec4(1.0, 1.0, 1.0, 1.0), 
 		vec4(0.1, 0.1, 0.1, 1.0),
-		min(pow(time / 1.5, 3.0), 1.0)
+		min(pow(age / 1.5, 3.0), 1.0)
 	);
 }
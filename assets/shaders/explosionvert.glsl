@@ -6,29 +6,36 @@ precision highp float;
 #endif
 
 layout(location = 0) in vec4 pos;
+//Per particle: center of the explosion + the time it started at
+layout(location = 1) in vec4 particle;
+//Per particle: seed, explosion scale, size multiplier
+layout(location = 2) in vec3 params;
 
 uniform mat4 persp;
 uniform mat4 view;
-uniform mat4 transform;
+//Current time
 uniform float time;
-uniform float scale;
 
 const float SPEED = 16.0;
 
 out vec2 tc;
+out float age;
 
 void main()
 {	
-	float id = float(gl_InstanceID);
+	float id = params.x;
+	float scale = params.y;
+	float t = time - particle.w;
+	age = t;
 
 	vec3 cameraRightWorldSpace = vec3(view[0][0], view[1][0], view[2][0]);
 	vec3 cameraUpWorldSpace = vec3(view[0][1], view[1][1], view[2][1]);
-	vec4 center = transform * vec4(0.0, 0.0, 0.0, 1.0);
+	vec3 center = particle.xyz;
 	float maxsz = 16.0 + cos(id) * 6.0;
-	float sz = (maxsz - maxsz * pow(1.0 - time, 2.0)) * scale;
+	float sz = (maxsz - maxsz * pow(1.0 - t, 2.0)) * scale * params.z;
 
 	float rotationSpeed = sin(id * cos(id)) * 3.14 / 4.0;
-	float rotation = rotationSpeed * time;
+	float rotation = rotationSpeed * t;
 
 	vec2 p = vec2(
 		pos.x * cos(rotation) - pos.z * sin(rotation),
@@ -36,7 +43,7 @@ void main()
 	);
 
 	vec3 vertPosWorldSpace =
-		center.xyz +
+		center +
 		cameraRightWorldSpace * p.x * sz +
 		cameraUpWorldSpace * p.y * sz;
 
@@ -52,7 +59,7 @@ void main()
 		cos(angle1) * cos(angle2) * SPEED, 
 		SPEED / 2.0,
 		cos(angle1) * sin(angle2) * SPEED
-	) * time * scale;
+	) * t * scale;
 
 	gl_Position = persp * view * vec4(vertPosWorldSpace.xyz, 1.0);
 
@@ -0,0 +1,50 @@
+#ifdef GL_ES
+#version 300 es
+precision highp float;
+#else
+#version 330 core
+#endif
+
+layout (std140) uniform GlobalVals {
+	float viewdist;
+};
+
+uniform sampler2D tex;
+
+out vec4 color;
+in vec2 tc;
+in vec3 fragpos;
+//0 = tree, 1 = impostor
+in float fade;
+in vec3 tint;
+
+uniform vec3 camerapos;
+
+const float FOG_DIST = 10000.0;
+const float WATER_FOG_DIST = 128.0;
+
+//Same pattern as tree-frag.glsl
+float dither()
+{
+	return fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+}
+
+void main()
+{
+	if(fade <= dither())
+		discard;
+
+	float d = length(fragpos - camerapos);
+
+	//The atlas was cleared to 0 and is already lit, the color is divided
+	//by alpha to undo the black that filtering blends in at the edges
+	color = texture(tex, tc);
+	if(color.a < 0.5)
+		discard;
+	color = vec4(color.rgb / color.a * tint, 1.0);
+
+	//fog
+	vec4 fogeffect = mix(color, vec4(0.5, 0.8, 1.0, 1.0), min(max(0.0, d - viewdist) / FOG_DIST, 1.0));
+	vec4 watereffect = mix(color, vec4(0.1, 0.7, 0.9, 1.0), min(max(0.0, d) / WATER_FOG_DIST, 1.0));
+	color = fogeffect * float(camerapos.y >= 0.0) + watereffect * float(camerapos.y < 0.0);
+}
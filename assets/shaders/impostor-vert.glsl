@@ -0,0 +1,93 @@
+#ifdef GL_ES
+#version 300 es
+precision highp float;
+#else
+#version 330 core
+#endif
+
+/*
+	Vertex shader for tree impostors, turns the quad around the vertical
+	axis to face the camera and picks the view in the atlas that was
+	rendered from the direction closest to the camera
+*/
+
+layout(location = 0) in vec4 pos;
+layout(location = 1) in vec2 texcoord;
+//Same as tree-vert.glsl
+layout(location = 3) in uint instancedata;
+layout(location = 4) in vec2 chunkorigin;
+
+uniform mat4 persp;
+uniform mat4 view;
+uniform vec3 camerapos;
+uniform float chunkwidth;
+//Scale of the tree models
+uniform float scale;
+//Bounds of the model that was baked into the atlas
+uniform float radius;
+uniform float bottom;
+uniform float top;
+
+uniform float impostordist;
+uniform float impostorfade;
+out float fade;
+
+out vec3 fragpos;
+out vec2 tc;
+out vec3 tint;
+
+//Must match impostor::VIEWS
+const float VIEWS = 8.0;
+const float POSITION_STEPS = 2047.0;
+const float HEIGHT_STEPS = 5.0;
+const float PI = 3.14159265;
+const vec3 MAX_TINT = vec3(0.15, 0.05, -0.1);
+const uint HIDDEN = 0xffffffffu;
+
+uint pcgHash(uint v)
+{
+	uint state = v * 747796405u + 2891336453u;
+	uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+
+void main()
+{
+	if(instancedata == HIDDEN) {
+		gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+		return;
+	}
+
+	vec2 chunkpos = vec2(instancedata & 2047u, (instancedata >> 11) & 2047u) / POSITION_STEPS;
+	vec2 offsetxz = chunkorigin + (chunkpos - 0.5) * chunkwidth;
+	vec3 offset = vec3(
+		offsetxz.x,
+		float(instancedata >> 22) / HEIGHT_STEPS,
+		offsetxz.y
+	);
+	uint variation = pcgHash(instancedata & 0x3fffffu) >> 16;
+	float yaw = float(variation & 63u) * (2.0 * PI / 64.0);
+	float size = scale * float(((variation >> 6) & 31u) + 48u) / 64.0;
+	float tintamount = (float((variation >> 11) & 31u) - 16.0) / 16.0;
+
+	vec2 dir = camerapos.xz - offset.xz;
+	float treedist = length(dir);
+	dir = treedist > 0.0 ? dir / treedist : vec2(0.0, 1.0);
+	//View i was rendered from (sin(a), 0, cos(a)) with a = 2pi * i / VIEWS,
+	//the tree is turned by its yaw so the view is picked in model space
+	float angle = atan(dir.x, dir.y) - yaw;
+	float index = mod(floor(angle / (2.0 * PI) * VIEWS + 0.5), VIEWS);
+	vec3 right = vec3(dir.y, 0.0, -dir.x);
+
+	vec3 transformed =
+		offset +
+		right * pos.x * 2.0 * radius * size +
+		vec3(0.0, bottom + pos.y * (top - bottom), 0.0) * size;
+	gl_Position = persp * view * vec4(transformed, 1.0);
+	fragpos = transformed;
+	tc = vec2((index + texcoord.x) / VIEWS, texcoord.y);
+	//The trunk can not be told apart from the leaves here so the whole
+	//impostor is tinted
+	tint = vec3(1.0) + MAX_TINT * tintamount;
+	fade = clamp((treedist - impostordist + impostorfade) / impostorfade, 0.0, 1.0);
+}
@@ -13,27 +13,89 @@ precision highp float;
 layout(location = 0) in vec4 pos;
 layout(location = 1) in vec2 texcoord;
 layout(location = 2) in vec3 norm;
-layout(location = 3) in vec3 offset;
+//x in bits 0 to 10 and z in bits 11 to 21 (steps across the chunk) and
+//the height in bits 22 to 31, see infworld::DecorationInstance
+layout(location = 3) in uint instancedata;
+//Center of the chunk the instance is in, read once per chunk slot (see
+//plants::pointPlantSlotVao), 0 for a plant vao that has no slots
+layout(location = 4) in vec2 chunkorigin;
 
 uniform float time;
 
+//Width of the chunks
+uniform float chunkwidth;
+
 uniform mat4 persp;
 uniform mat4 view;
 uniform mat4 transform;
 
 uniform float windstrength;
+//Draws every instance without variation (for baking impostors)
+uniform bool novariation;
 
 uniform vec3 lightdir;
 out float lighting;
 
+//Trees fade into their impostors between impostordist - impostorfade
+//and impostordist (see impostor-vert.glsl)
+uniform vec3 camerapos;
+uniform float impostordist;
+uniform float impostorfade;
+out float fade;
+
 out vec3 fragpos;
 out vec3 normal;
 
 out vec2 tc;
+out vec3 tint;
+
+//infworld::DECORATION_POSITION_STEPS and DECORATION_HEIGHT_STEPS
+const float POSITION_STEPS = 2047.0;
+const float HEIGHT_STEPS = 5.0;
+const float PI = 3.14159265;
+//How much the leaves are tinted at the largest tint value
+const vec3 MAX_TINT = vec3(0.15, 0.05, -0.1);
+//infworld::DECORATION_HIDDEN
+const uint HIDDEN = 0xffffffffu;
+//No rotation, a scale of 1 and no tint
+const uint DEFAULT_VARIATION = (16u << 6) | (16u << 11);
+
+//rng::pcgHash
+uint pcgHash(uint v)
+{
+	uint state = v * 747796405u + 2891336453u;
+	uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
 
 void main()
 {
-	vec4 transformed = transform * pos;
+	//Unused entry of a chunk slot, clipped
+	if(instancedata == HIDDEN) {
+		gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+		return;
+	}
+
+	vec2 chunkpos = vec2(instancedata & 2047u, (instancedata >> 11) & 2047u) / POSITION_STEPS;
+	vec2 offsetxz = chunkorigin + (chunkpos - 0.5) * chunkwidth;
+	vec3 offset = vec3(
+		offsetxz.x,
+		float(instancedata >> 22) / HEIGHT_STEPS,
+		offsetxz.y
+	);
+	//Bits of the variation as in infworld::VARIATION_YAW_SHIFT etc, taken
+	//from the position so that it does not have to be stored
+	uint variation = novariation ? DEFAULT_VARIATION : pcgHash(instancedata & 0x3fffffu) >> 16;
+	float yaw = float(variation & 63u) * (2.0 * PI / 64.0);
+	float scale = float(((variation >> 6) & 31u) + 48u) / 64.0;
+	float tintamount = (float((variation >> 11) & 31u) - 16.0) / 16.0;
+	mat2 rotation = mat2(cos(yaw), -sin(yaw), sin(yaw), cos(yaw));
+	vec4 varied = vec4(pos.xyz * scale, pos.w);
+	varied.xz = rotation * varied.xz;
+	vec3 variednorm = norm;
+	variednorm.xz = rotation * variednorm.xz;
+
+	vec4 transformed = transform * varied;
 	transformed += vec4(offset, 0.0);
 	float dist = length(pos.xz);
 	float value = sin(pos.x) * 132.0 + cos(pos.z) * 931.0;
@@ -42,7 +104,11 @@ void main()
 	transformed.z += sin(time * dist + value / 2.0) * 0.04 * dist * windstrength * step(0.5, texcoord.x);
 	gl_Position = persp * view * transformed;
 	fragpos = transformed.xyz;
-	lighting = max(-dot(lightdir, norm), 0.0) * 0.7 + 0.3;
+	lighting = max(-dot(lightdir, variednorm), 0.0) * 0.7 + 0.3;
 	tc = texcoord;
-	normal = norm;
+	normal = variednorm;
+	//Only the leaves are tinted
+	tint = vec3(1.0) + MAX_TINT * tintamount * step(0.5, texcoord.x);
+	float treedist = length(camerapos.xz - offset.xz);
+	fade = clamp((treedist - impostordist + impostorfade) / impostorfade, 0.0, 1.0);
 }
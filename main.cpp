@@ -1,11 +1,24 @@
+#include "assetpack.h"
 #include "camera.h"
 #include "game.h"
 #include "gfx.h"
 #include "gui.h"
 #include "imgui.h"
+#include "importfile.h"
 #include "infworld.h"
+#include "jobs.h"
 #include "window.h"
 #include "logger.h"
+#include "meshfile.h"
+#include "texturefile.h"
+#include <algorithm>
+#include <chrono>
+#include <float.h>
+#include <functional>
+#include <math.h>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
 
 #ifdef __ANDROID__
   #include <GLES3/gl3.h>
@@ -13,7 +26,241 @@
   #include <SDL_opengl.h>
 #endif
 
-int main() {
+//Release builds read everything from assets.pack (made with --pack), if it
+//is missing the loose files are used
+void mountAssetPack() {
+#ifdef USE_ASSET_PACK
+  if (!assetpack::mount("assets.pack"))
+    WARN("assets.pack could not be mounted, using loose files");
+#endif
+}
+
+//Runs the game without a window or GPU and prints frame timings
+//usage: --benchmark [frames] [--record] [--trace file.csv]
+int runBenchmark(int argc, char *argv[]) {
+  unsigned int frames = 1000;
+  bool record = false;
+  const char *tracepath = nullptr;
+  for (int i = 2; i < argc; i++) {
+    if (strcmp(argv[i], "--record") == 0)
+      record = true;
+    else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+      tracepath = argv[++i];
+    else
+      frames = atoi(argv[i]);
+  }
+
+  gfx::NullBackend null;
+  gfx::RecordingBackend recorder(&null);
+  gfx::GraphicsBackend::set(record ? (gfx::GraphicsBackend *)&recorder : &null);
+
+  Window::setHeadless(true);
+  Window &window = Window::getInstance();
+  window.getCamera().pitch = -0.5f;
+  window.updatePerspectiveMat(FOVY, ZNEAR, ZFAR, window.getWidth(), window.getHeight());
+
+  mountAssetPack();
+  game::loadAssets();
+  game::initUniforms();
+  game::benchmarkGameLoop(frames, 0, record ? &recorder : nullptr, tracepath);
+  if (record)
+    recorder.printTotals();
+
+  gfx::GraphicsBackend::set(nullptr);
+  return 0;
+}
+
+//Converts the models and textures listed in the impfiles into baked .mesh
+//and .tex files that are loaded instead of the source files, no window or
+//GPU is needed
+//usage: --bake [models impfile] [textures impfile]
+int runBake(int argc, char *argv[]) {
+  const char *models = argc > 2 ? argv[2] : "assets/models.impfile";
+  const char *textures = argc > 3 ? argv[3] : "assets/textures.impfile";
+  unsigned int failed = meshfile::bakeModels(models);
+  failed += texturefile::bakeTextures(textures);
+  if (failed > 0)
+    ERROR("%u asset(s) could not be baked", failed);
+  return failed > 0 ? 1 : 0;
+}
+
+//Packs the impfiles and every file they refer to into one archive, run
+//--bake first so the baked meshes and textures are included
+//usage: --pack [output]
+int runPack(int argc, char *argv[]) {
+  const char *output = argc > 2 ? argv[2] : "assets.pack";
+  const std::vector<std::string> impfiles = {
+      "assets/models.impfile", "assets/textures.impfile",
+      "assets/shaders.impfile", "assets/fonts.impfile",
+      "assets/sfx.impfile",
+  };
+  if (!assetpack::build(output, impfiles))
+    return 1;
+  assetpack::AssetPack pack;
+  if (!pack.open(output) || !pack.verify()) {
+    ERROR("%s failed to verify", output);
+    return 1;
+  }
+  return 0;
+}
+
+//Times the old line based impfile parser against the single pass parser
+//and the compiled form on a generated impfile
+//usage: --bench-impfile [entries]
+int runImpfileBenchmark(int argc, char *argv[]) {
+  unsigned int count = argc > 2 ? atoi(argv[2]) : 10000;
+  std::string text;
+  for (unsigned int i = 0; i < count; i++) {
+    text += "# Entry " + std::to_string(i) + "\n";
+    text += "\"entry" + std::to_string(i) + "\" {\n";
+    text += "\t\"path\" = \"assets/models/model" + std::to_string(i) + ".obj\";\n";
+    text += "\t\"target\" = \"2d\";\n";
+    text += "\t\"scale\" = \"1.5\";\n";
+    text += "}\n\n";
+  }
+
+  typedef std::chrono::steady_clock clock;
+  auto time = [](const char *name, const std::function<size_t()> &parse) {
+    auto start = clock::now();
+    size_t parsed = parse();
+    std::chrono::duration<double, std::milli> duration = clock::now() - start;
+    INFO("%-8s %zu entries in %.2f ms", name, parsed, duration.count());
+    return parsed;
+  };
+
+  std::vector<impfile::Entry> entries;
+  size_t legacy = time("legacy", [&]() {
+    std::istringstream stream(text);
+    return impfile::parseLegacy(stream, "<generated>").size();
+  });
+  size_t parsed = time("text", [&]() {
+    entries.clear();
+    impfile::parseText(text, entries, "<generated>");
+    return entries.size();
+  });
+  std::string compiled = impfile::compile(entries);
+  size_t loaded = time("compiled", [&]() {
+    std::vector<impfile::Entry> out;
+    impfile::parseCompiled(compiled, out);
+    return out.size();
+  });
+  INFO("text: %zu bytes, compiled: %zu bytes", text.size(), compiled.size());
+  return legacy == count && parsed == count && loaded == count ? 0 : 1;
+}
+
+//Times the old three pass decoration placement against the single pass
+//one over a square of chunks and checks that both place the same trees,
+//that placing the chunks in parallel in any order gives the same trees
+//and that packing them into instances keeps them within the error bound
+//usage: --bench-decorations [chunks] [seed]
+int runDecorationBenchmark(int argc, char *argv[]) {
+  int count = argc > 2 ? atoi(argv[2]) : 10000;
+  int seed = argc > 3 ? atoi(argv[3]) : 0;
+  infworld::worldseed permutations = infworld::makePermutations(seed, 9);
+  int side = 1;
+  while (side * side < count)
+    side++;
+  std::vector<infworld::ChunkPos> chunks;
+  for (int x = 0; x < side; x++)
+    for (int z = 0; z < side; z++)
+      chunks.push_back({x - side / 2, z - side / 2});
+
+  typedef std::chrono::steady_clock clock;
+  std::vector<std::vector<infworld::Decoration>> legacy(chunks.size());
+  std::vector<std::vector<infworld::Decoration>> placed(chunks.size());
+  auto time = [&](const char *name, decltype(infworld::placeDecorations) place,
+                  std::vector<std::vector<infworld::Decoration>> &out) {
+    auto start = clock::now();
+    size_t total = 0;
+    for (size_t i = 0; i < chunks.size(); i++) {
+      place(permutations, chunks[i], CHUNK_SZ, out[i]);
+      total += out[i].size();
+    }
+    std::chrono::duration<double, std::milli> duration = clock::now() - start;
+    INFO("%-8s %zu chunks, %zu decorations in %.2f ms", name, chunks.size(),
+         total, duration.count());
+  };
+  time("legacy", infworld::placeDecorationsLegacy, legacy);
+  time("single", infworld::placeDecorations, placed);
+
+  // Back to front on the job system
+  std::vector<std::vector<infworld::Decoration>> parallel(chunks.size());
+  auto start = clock::now();
+  jobs::parallelFor(chunks.size(), 64, [&](unsigned int begin, unsigned int end) {
+    for (unsigned int i = begin; i < end; i++) {
+      size_t index = chunks.size() - 1 - i;
+      infworld::placeDecorations(permutations, chunks[index], CHUNK_SZ,
+                                 parallel[index]);
+    }
+  });
+  std::chrono::duration<double, std::milli> duration = clock::now() - start;
+  INFO("parallel %zu chunks in %.2f ms (%u workers)", chunks.size(),
+       duration.count(), JOBS->workerCount());
+
+  auto same = [](const std::vector<infworld::Decoration> &a,
+                 const std::vector<infworld::Decoration> &b) {
+    if (a.size() != b.size())
+      return false;
+    for (size_t j = 0; j < a.size(); j++) {
+      if (a[j].position != b[j].position || a[j].type != b[j].type)
+        return false;
+    }
+    return true;
+  };
+  for (size_t i = 0; i < chunks.size(); i++) {
+    if (!same(legacy[i], placed[i]) || !same(placed[i], parallel[i])) {
+      ERROR("Chunk (%d, %d) differs", chunks[i].x, chunks[i].z);
+      return 1;
+    }
+  }
+
+  // Every decoration must come back from its packed instance within the
+  // error bound that the shaders rely on, which only holds up to
+  // DECORATION_MAX_CHUNK_DISTANCE chunks from the origin
+  const float width = infworld::decorationChunkWidth(CHUNK_SZ);
+  float maxxz = 0.0f, maxheight = 0.0f;
+  size_t outside = 0;
+  for (size_t i = 0; i < chunks.size(); i++) {
+    if (float(std::max(abs(chunks[i].x), abs(chunks[i].z))) >
+        infworld::DECORATION_MAX_CHUNK_DISTANCE)
+      continue;
+    glm::vec2 origin = infworld::decorationOrigin(chunks[i], width);
+    for (const auto &decoration : placed[i]) {
+      glm::vec3 position = decoration.position * SCALE;
+      infworld::DecorationInstance instance =
+          infworld::packDecoration(position, origin, width);
+      glm::vec3 error = glm::abs(
+          infworld::unpackDecoration(instance, origin, width) - position);
+      if (std::max(error.x, error.z) > infworld::DECORATION_XZ_ERROR * width ||
+          error.y > infworld::DECORATION_HEIGHT_ERROR)
+        outside++;
+      maxxz = std::max(maxxz, std::max(error.x, error.z));
+      maxheight = std::max(maxheight, error.y);
+    }
+  }
+  INFO("packed positions: max error %.5f horizontal (bound %.5f), %.5f "
+       "vertical (bound %.5f)",
+       maxxz, infworld::DECORATION_XZ_ERROR * width, maxheight,
+       infworld::DECORATION_HEIGHT_ERROR);
+  if (outside > 0) {
+    ERROR("%zu packed decorations are outside the error bound", outside);
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+
+  if (argc > 1 && strcmp(argv[1], "--benchmark") == 0)
+    return runBenchmark(argc, argv);
+  if (argc > 1 && strcmp(argv[1], "--bake") == 0)
+    return runBake(argc, argv);
+  if (argc > 1 && strcmp(argv[1], "--pack") == 0)
+    return runPack(argc, argv);
+  if (argc > 1 && strcmp(argv[1], "--bench-impfile") == 0)
+    return runImpfileBenchmark(argc, argv);
+  if (argc > 1 && strcmp(argv[1], "--bench-decorations") == 0)
+    return runDecorationBenchmark(argc, argv);
 
   Window &window = Window::getInstance();
   Gui &gui = Gui::getInstance();
@@ -21,17 +268,18 @@ int main() {
   window.initMousePos();
   window.getCamera().pitch = -0.5f;
 
-  glEnable(GL_DEPTH_TEST);
-  glDepthFunc(GL_LESS);
-  glEnable(GL_CULL_FACE);
-  glCullFace(GL_BACK);
+  GFX->enable(GL_DEPTH_TEST);
+  GFX->depthFunc(GL_LESS);
+  GFX->enable(GL_CULL_FACE);
+  GFX->cullFace(GL_BACK);
 
   int fbWidth, fbHeight;
   SDL_GL_GetDrawableSize(window.getSDLWindow(), &fbWidth, &fbHeight);
-  glViewport(0, 0, fbWidth, fbHeight);
+  GFX->viewport(0, 0, fbWidth, fbHeight);
   window.updatePerspectiveMat(FOVY, ZNEAR, ZFAR, fbWidth, fbHeight);
 
-  game::loadAssets();
+  mountAssetPack();
+  game::loadAssets(game::loadingScreen);
   game::initUniforms();
 
 
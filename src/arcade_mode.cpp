@@ -1,9 +1,12 @@
 #include "game.h"
+#include "assets.h"
+#include "simulation.h"
 #include "window.h"
 #include "gui.h"
 #include <SDL.h>
 #include "timing.h"
 #include "logger.h"
+#include <chrono>
 
 
 namespace game {
@@ -16,143 +19,128 @@ namespace game {
     //Initially generate world
     std::random_device rd;
     int randSeed = rd();
-    infworld::worldseed permutations = infworld::makePermutations(randSeed, 9);
+    ArcadeWorld world(randSeed);
+    const infworld::worldseed &permutations = world.permutations;
     infworld::ChunkTable chunktables[MAX_LOD];
     game::generateChunks(permutations, chunktables, RANGE);
     infworld::DecorationTable decorations = infworld::DecorationTable(14, CHUNK_SZ);
     decorations.genDecorations(permutations);
-    gfx::generateDecorationOffsets(decorations);
-
-    std::minstd_rand0 lcg;
-		lcg.seed(randSeed);
-		
-    //Gameobjects
-		gameobjects::Player player(glm::vec3(0.0f, HEIGHT * SCALE * 0.5f, 0.0f));
-		std::vector<gameobjects::Bullet> bullets;
-		std::vector<gameobjects::Enemy> balloons;
-		std::vector<gameobjects::Enemy> ships;
-		std::vector<gameobjects::Explosion> explosions;
-		std::vector<gameobjects::Props> barrels;
-
-  	float totalTime = 0.0f;
+    gfx::setDecorationLods(decorations);
+
+    //Once the simulation thread starts only it touches the world, this
+    //loop draws the two latest snapshots blended together
+    const sym::Symbol planeModel = sym::intern(world.player.getPlayerObj());
+    WorldSnapshot prevSnapshot, currSnapshot, view;
+    world.snapshot(currSnapshot);
+    prevSnapshot = currSnapshot;
+    view = currSnapshot;
+
   	float dt = 0.0f;
-    unsigned int score = 0; //Player score
     bool draw_debug_gui = false;
     bool paused = false;
 
-    TimerManager timers;
-    timers.addTimer("spawn_balloon", 0.0f, 50.0f);
-    timers.addTimer("spawn_ship", 0.0f, 100.0f);
-    // timers.addTimer("spawn_barrel", 0.0f, 70.0f);
-
-    game::updateCamera(player);
+    game::updateCamera(view.player);
     
+    gfx::RenderQueue queue;
+    gfx::GLQueueBackend backend;
+    geo::HorizonBuffer horizon(HORIZON_BINS);
+    gfx::FrameData frame;
+    gfx::FrameInput frameinput;
+    frameinput.chunktables = chunktables;
+    frameinput.maxlod = MAX_LOD;
+    frameinput.lodscale = LOD_SCALE;
+    frameinput.decorations = &decorations;
+    frameinput.balloons = &view.balloons;
+    frameinput.ships = &view.ships;
+    frameinput.explosions = &view.explosions;
+
+    //Stopped when this returns
+    SimulationThread simulation(world, SIM_TICK);
+    simulation.start();
+
     while (!window.shouldClose() && window.isRunnning()) {
         float startTime = getTime();
         window.pollEvents();
+        if (!paused)
+          simulation.pushInput(InputState::capture());
+
+        //Pick up the newest snapshot and blend it with the one before,
+        //this is drawn one step behind the simulation
+        if (simulation.update()) {
+          std::swap(prevSnapshot, currSnapshot);
+          currSnapshot = simulation.latest();
+        }
+        std::chrono::duration<float> sincePublished =
+          std::chrono::steady_clock::now() - currSnapshot.published;
+        float t = sincePublished.count() / simulation.getTickDt();
+        interpolateSnapshots(prevSnapshot, currSnapshot, t, simulation.getTickDt(), view);
+        float totalTime = view.totalTime;
+
+        if (!paused) {
+          game::updateCamera(view.player, dt);
+          // to make the terrain infinite, this uploads to the GPU so it
+          // stays on the main thread
+          game::generateNewChunks(permutations, chunktables, decorations);
+        }
 
         gui.newFrame();
 
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        GFX->clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        //Culling and transforms are worked out on the job system first
+        frameinput.playertransform = view.player;
+        frameinput.totalTime = totalTime;
+        gfx::prepareFrame(frame, frameinput, horizon);
+        gui.dItems.framePrep = frame.timings;
+        gui.dItems.framePrepTotal = frame.totalms;
+        gui.dItems.particles = frame.particlestats;
+        queue.begin(window.getCamera().position, window.getZfar());
         //Draw terrain
-        unsigned int drawCount = gfx::displayTerrain(chunktables, MAX_LOD, LOD_SCALE);
+        unsigned int drawCount = gfx::displayTerrain(queue, chunktables, MAX_LOD, frame);
+        for(int i = 0; i < MAX_LOD; i++)
+          gui.dItems.terrainCulling[i] = chunktables[i].getCullStats();
         //Display trees
-        gfx::displayDecorations(decorations, totalTime);
+        gfx::displayDecorations(queue, decorations, totalTime);
+        gui.dItems.decorationCulling = decorations.getCullStats();
         //Display plane
-        if(!player.crashed)
-           gfx::displayPlayerPlane(totalTime, player.transform, player.getPlayerObj());
+        if(!view.crashed)
+           gfx::displayPlayerPlane(queue, totalTime, view.player, planeModel);
         //Display balloons
-        gfx::displayBalloons(balloons);
+        gfx::displayBalloons(queue, frame.balloons);
         //Display ships
-        gfx::displayShips(ships);
-        //Display barrels
-        gfx::displayBarrels(barrels);
+        gfx::displayShips(queue, frame.ships);
         //Display bullets
-        gfx::displayBullets(bullets);
+        gfx::displayBullets(queue, view.bullets);
         //Display water
-        gfx::displayWater(totalTime);
+        gfx::displayWater(queue, totalTime);
         //Draw skybox
-        gfx::displaySkybox();
+        gfx::displaySkybox(queue);
 
         if (!paused) {
-
-          timers.update(dt);
-          
           //Draw HUD Backgorunds
-          gfx::displayCrosshair(player.transform);
-          gfx::displayMiniMapBackground(totalTime);
-          gfx::displayAttitude(player.transform.rotation.x, player.transform.rotation.z);
-          gfx::displaySpeed(player.speed);
-          gfx::displayFuel(player.fuel, totalTime);
-          gfx::displayEnemyMarkers(balloons, player.transform);
-          gfx::displayEnemyMarkers(ships, player.transform);
+          gfx::displayCrosshair(queue, view.player);
+          gfx::displayMiniMapBackground(queue, totalTime);
+          gfx::displayAttitude(queue, view.player.rotation.x, view.player.rotation.z);
+          gfx::displaySpeed(queue, view.speed);
+          gfx::displayFuel(queue, view.fuel, totalTime);
+          gfx::displayEnemyMarkers(queue, frame.balloonmarkers);
+          gfx::displayEnemyMarkers(queue, frame.shipmarkers);
           // gfx::displayPropMarkers(barrels, player.transform);
-          gfx::displayExplosions(explosions);
-        
-          game::updateCamera(player, dt);
-          // to make the terrain infinite
-          game::generateNewChunks(permutations, chunktables, decorations);
+          gfx::displayExplosions(queue, frame.particles, totalTime);
 
-          totalTime += dt;
-          bool justcrashed = player.crashed;
-  				player.checkIfCrashed(dt, permutations);
-  				justcrashed = player.crashed ^ justcrashed;
-  				//Update explosions
-  				if(justcrashed) {
-  					explosions.push_back(gameobjects::Explosion(player.transform.position));
-  					// SNDSRC->playid("explosion", player.transform.position);	
-  					WARN("Plane Crashed");
-  				}
-          player.update(dt);
-          updateExplosions(explosions, player.transform.position, dt);
-          gui.dItems.playerPosition = player.transform.position;
+          gui.dItems.playerPosition = view.player.position;
           gui.dItems.cameraPosition = window.getCamera().position;
-          gui.dItems.shipCount = ships.size();
-          gui.dItems.balloonCount = balloons.size();
+          gui.dItems.shipCount = view.ships.size();
+          gui.dItems.balloonCount = view.balloons.size();
 
           // Update HUD data
-          gui.hudItems.health = player.health;
-          gui.hudItems.speed = player.speed;
-          gui.hudItems.bulletCount = bullets.size();
-          gui.hudItems.altitude = player.transform.position.y;
-          gui.hudItems.score = score;
-          gui.hudItems.crashed = player.crashed;
-          gui.hudItems.fuel = player.fuel;
-
-          //Shoot bullets
-  				KeyState leftbutton = window.getButtonState(SDL_BUTTON_LEFT);
-  				KeyState spacebar = window.getKeyState(SDLK_SPACE);
-  				if(player.shoottimer <= 0.0f && 
-  				   (window.keyIsHeld(spacebar) || window.keyIsHeld(leftbutton)) &&
-  				   !player.crashed) {
-  					// SNDSRC->playid("shoot", player.transform.position);
-  					player.resetShootTimer();
-  					bullets.push_back(gameobjects::Bullet(player, glm::vec3(-8.5f, -0.75f, 8.5f)));
-  					bullets.push_back(gameobjects::Bullet(player, glm::vec3(8.5f, -0.75f, 8.5f)));
-  				}
-  				//Update bullets
-  				game::checkBulletDist(bullets, player);
-  				game::updateBullets(bullets, dt);
-  				game::checkForBulletTerrainCollision(bullets, permutations);
-  				checkForHit(bullets, balloons, 24.0f);
-  				checkForHit(bullets, ships, 32.0f);
-  				// checkForHit(bullets, ufos, 14.0f);
-  				// checkForHit(bullets, planes, 12.0f);
-
-          // Spawn Balloons
-          if(timers.getTimer("spawn_balloon")) spawnBalloons(player, balloons, lcg, permutations);
-          // Update Balloons
-          for( auto &balloon : balloons) balloon.updateBalloon(dt);
-          //Destroy any enemies that are too far away or have run out of health
-  				destroyEnemies(player, balloons, explosions, 1.0f, 24.0f, score);
-
-          // Spawn Ships
-          if(timers.getTimer("spawn_ship")) spawnShips(player, ships, lcg, permutations);
-          // Update Ships
-          for( auto &ship : ships) ship.updateShip(dt, player, bullets);
-          //Destroy any enemies that are too far away or have run out of health
-  				destroyEnemies(player, ships, explosions, 1.0f, 50.0f, score);
-  				
+          gui.hudItems.health = view.health;
+          gui.hudItems.speed = view.speed;
+          gui.hudItems.bulletCount = view.bullets.size();
+          gui.hudItems.altitude = view.player.position.y;
+          gui.hudItems.score = view.score;
+          gui.hudItems.crashed = view.crashed;
+          gui.hudItems.fuel = view.fuel;
+
           // gui.drawHUD();
         
         }
@@ -178,11 +166,19 @@ namespace game {
         
         if (window.getKeyState(SDLK_TAB) == JUST_PRESSED) draw_debug_gui = !draw_debug_gui;
         if (window.getKeyState(SDLK_ESCAPE) == JUST_PRESSED) paused = !paused;
+        simulation.setPaused(paused);
 
         if (draw_debug_gui){
           gui.drawUI();
         }
 
+        //Everything was only queued up until now
+        queue.submit(backend);
+        gui.dItems.renderStats = queue.getStats();
+        //Models and textures that were used for the first time are
+        //uploaded once the queue no longer refers to anything unloaded
+        assets::updateResidency();
+
         gui.render();
 
         window.swapBuffers();
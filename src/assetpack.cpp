@@ -0,0 +1,383 @@
+#include "assetpack.h"
+#include "importfile.h"
+#include "logger.h"
+#include "meshfile.h"
+#include "programcache.h"
+#include "texturefile.h"
+#include <fstream>
+#include <map>
+#include <set>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+namespace {
+	constexpr char MAGIC[4] = { 'P', 'A', 'C', 'K' };
+
+	assetpack::AssetPack mounted;
+	bool ismounted = false;
+
+	uint64_t alignUp(uint64_t n)
+	{
+		return (n + assetpack::ALIGNMENT - 1) & ~(assetpack::ALIGNMENT - 1);
+	}
+
+	//Paths are stored with forward slashes and without a leading "./"
+	std::string normalizeName(const std::string &path)
+	{
+		std::string name = path;
+		for(auto &c : name)
+			if(c == '\\')
+				c = '/';
+		while(name.compare(0, 2, "./") == 0)
+			name.erase(0, 2);
+		return name;
+	}
+
+	bool isRegularFile(const std::string &path)
+	{
+		struct stat st;
+		return stat(path.c_str(), &st) == 0 && (st.st_mode & S_IFMT) == S_IFREG;
+	}
+
+	std::string directoryOf(const std::string &path)
+	{
+		size_t slash = path.find_last_of("/\\");
+		return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+	}
+
+	//.obj files name their material libraries with 'mtllib'
+	void addMaterialLibraries(const std::string &objpath, std::vector<std::string> &files)
+	{
+		std::ifstream obj(objpath);
+		std::string line;
+		while(std::getline(obj, line)) {
+			if(line.compare(0, 7, "mtllib ") != 0)
+				continue;
+			std::string lib = line.substr(7);
+			while(!lib.empty() && (lib.back() == '\r' || lib.back() == ' '))
+				lib.pop_back();
+			std::string libpath = directoryOf(objpath) + lib;
+			if(isRegularFile(libpath))
+				files.push_back(libpath);
+		}
+	}
+
+	//Every variable that names an existing file is packed along with
+	//whatever the game loads in its place
+	void collectFiles(const std::string &impfile, std::vector<std::string> &files)
+	{
+		files.push_back(impfile);
+		std::vector<impfile::Entry> entries = impfile::parseFile(impfile.c_str());
+		for(const auto &entry : entries) {
+			std::vector<std::string> sources;
+			for(const auto &var : entry.variables) {
+				if(!isRegularFile(var.second))
+					continue;
+				sources.push_back(var.second);
+				files.push_back(var.second);
+
+				size_t dot = var.second.find_last_of('.');
+				std::string extension = dot == std::string::npos ? "" : var.second.substr(dot);
+				if(extension != ".obj")
+					continue;
+				addMaterialLibraries(var.second, files);
+				std::string baked = meshfile::bakedPath(var.second);
+				if(meshfile::isUpToDate(baked, var.second))
+					files.push_back(baked);
+			}
+
+			if(entry.variables.count("target") && !sources.empty()) {
+				const std::string &first =
+					entry.getVar("target") == "cubemap" ? entry.getVar("east") : entry.getVar("path");
+				std::string baked = texturefile::bakedPath(entry.name, first);
+				if(texturefile::isUpToDate(baked, sources))
+					files.push_back(baked);
+			}
+		}
+	}
+
+	bool readLooseFile(const std::string &path, std::vector<unsigned char> &contents)
+	{
+		FILE *file = fopen(path.c_str(), "rb");
+		if(!file)
+			return false;
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		contents.resize(size > 0 ? size_t(size) : 0);
+		bool ok = size >= 0 && fread(contents.data(), 1, contents.size(), file) == contents.size();
+		fclose(file);
+		return ok;
+	}
+}
+
+namespace assetpack {
+	const unsigned char* FileData::data() const
+	{
+		return ptr;
+	}
+
+	size_t FileData::size() const
+	{
+		return length;
+	}
+
+	bool FileData::empty() const
+	{
+		return length == 0;
+	}
+
+	std::string FileData::str() const
+	{
+		return std::string((const char*)ptr, length);
+	}
+
+	bool AssetPack::open(const char *path)
+	{
+		header = nullptr;
+		if(!file.open(path))
+			return false;
+
+		const Header *h = (const Header*)file.data();
+		uint64_t size = file.size();
+		bool valid =
+			size >= sizeof(Header) &&
+			memcmp(h->magic, MAGIC, sizeof(MAGIC)) == 0 &&
+			h->version == VERSION &&
+			h->slotcount > 0 && (h->slotcount & (h->slotcount - 1)) == 0 &&
+			h->slotcount >= h->entrycount &&
+			h->entriesoffset + uint64_t(h->entrycount) * sizeof(Entry) <= size &&
+			h->slotsoffset + uint64_t(h->slotcount) * sizeof(uint32_t) <= size &&
+			h->namesoffset <= size;
+		if(valid) {
+			const Entry *e = (const Entry*)(file.data() + h->entriesoffset);
+			for(uint32_t i = 0; i < h->entrycount && valid; i++) {
+				valid =
+					e[i].offset % ALIGNMENT == 0 &&
+					e[i].offset + e[i].size <= size &&
+					h->namesoffset + e[i].nameoffset + e[i].namelength <= size;
+			}
+		}
+
+		if(!valid) {
+			WARN("%s is not a valid asset pack", path);
+			file.close();
+			return false;
+		}
+		header = h;
+		entries = (const Entry*)(file.data() + h->entriesoffset);
+		slots = (const uint32_t*)(file.data() + h->slotsoffset);
+		names = (const char*)(file.data() + h->namesoffset);
+		return true;
+	}
+
+	const Entry* AssetPack::find(const std::string &name) const
+	{
+		if(!header)
+			return nullptr;
+
+		std::string normalized = normalizeName(name);
+		uint64_t hash = shadercache::hash(normalized);
+		uint32_t mask = header->slotcount - 1;
+		//Linear probing, the table is never full
+		for(uint32_t i = 0; i < header->slotcount; i++) {
+			uint32_t slot = slots[(hash + i) & mask];
+			if(slot == 0 || slot > header->entrycount)
+				return nullptr;
+			const Entry &entry = entries[slot - 1];
+			if(entry.namehash == hash &&
+			   entry.namelength == normalized.size() &&
+			   memcmp(names + entry.nameoffset, normalized.data(), normalized.size()) == 0)
+				return &entry;
+		}
+		return nullptr;
+	}
+
+	bool AssetPack::read(const std::string &name, FileData &out) const
+	{
+		const Entry *entry = find(name);
+		if(!entry)
+			return false;
+		//The pack stays mapped for as long as the game runs
+		out.mapped.reset();
+		out.ptr = file.data() + entry->offset;
+		out.length = entry->size;
+		return true;
+	}
+
+	bool AssetPack::verify() const
+	{
+		if(!header)
+			return false;
+		bool valid = true;
+		for(uint32_t i = 0; i < header->entrycount; i++) {
+			const Entry &entry = entries[i];
+			uint64_t hash = shadercache::hash(file.data() + entry.offset, entry.size);
+			if(hash != entry.contenthash) {
+				std::string name(names + entry.nameoffset, entry.namelength);
+				ERROR("%s is corrupt in the asset pack", name.c_str());
+				valid = false;
+			}
+		}
+		return valid;
+	}
+
+	unsigned int AssetPack::count() const
+	{
+		return header ? header->entrycount : 0;
+	}
+
+	bool mount(const char *path)
+	{
+		ismounted = mounted.open(path);
+		if(ismounted)
+			INFO("Mounted asset pack %s (%u files)", path, mounted.count());
+		return ismounted;
+	}
+
+	bool isMounted()
+	{
+		return ismounted;
+	}
+
+	bool contains(const std::string &path)
+	{
+		return ismounted && mounted.find(path) != nullptr;
+	}
+
+	bool readFile(const std::string &path, FileData &out)
+	{
+		if(ismounted && mounted.read(path, out))
+			return true;
+
+		auto file = std::make_shared<MappedFile>();
+		if(!file->open(path.c_str()))
+			return false;
+		out.ptr = file->data();
+		out.length = file->size();
+		out.mapped = file;
+		return true;
+	}
+
+	bool build(const char *output, const std::vector<std::string> &impfiles)
+	{
+		std::vector<std::string> files;
+		for(const auto &impfile : impfiles)
+			if(isRegularFile(impfile))
+				collectFiles(impfile, files);
+
+		//Sorted and without duplicates
+		std::map<std::string, std::string> paths;
+		for(const auto &path : files)
+			paths.insert({ normalizeName(path), path });
+		std::set<std::string> compiled;
+		for(const auto &impfile : impfiles)
+			compiled.insert(normalizeName(impfile));
+
+		Header header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.entrycount = paths.size();
+		header.slotcount = 1;
+		while(header.slotcount < header.entrycount * 2)
+			header.slotcount *= 2;
+		header.entriesoffset = sizeof(Header);
+		header.slotsoffset = header.entriesoffset + uint64_t(header.entrycount) * sizeof(Entry);
+		header.namesoffset = header.slotsoffset + uint64_t(header.slotcount) * sizeof(uint32_t);
+
+		std::vector<Entry> entries;
+		std::vector<uint32_t> slots(header.slotcount, 0);
+		std::string names;
+		std::vector<std::vector<unsigned char>> blobs;
+		//content hash -> index of the blob
+		std::map<std::pair<uint64_t, uint64_t>, size_t> uniqueblobs;
+		std::vector<size_t> blobindex;
+		for(const auto &path : paths) {
+			std::vector<unsigned char> contents;
+			if(!readLooseFile(path.second, contents)) {
+				ERROR("Failed to read %s", path.second.c_str());
+				return false;
+			}
+			//Impfiles are stored compiled under their original name,
+			//impfile::parseFile() accepts either form
+			if(compiled.count(path.first)) {
+				std::vector<impfile::Entry> impentries;
+				std::string text(contents.begin(), contents.end());
+				impfile::Result res = impfile::parseText(text, impentries, path.second.c_str());
+				if(res.isError()) {
+					res.output();
+					return false;
+				}
+				std::string binary = impfile::compile(impentries);
+				contents.assign(binary.begin(), binary.end());
+			}
+
+			Entry entry;
+			memset(&entry, 0, sizeof(entry));
+			entry.namehash = shadercache::hash(path.first);
+			entry.contenthash = shadercache::hash(contents.data(), contents.size());
+			entry.size = contents.size();
+			entry.nameoffset = names.size();
+			entry.namelength = path.first.size();
+			names += path.first;
+
+			auto key = std::make_pair(entry.contenthash, entry.size);
+			auto found = uniqueblobs.find(key);
+			if(found == uniqueblobs.end()) {
+				found = uniqueblobs.insert({ key, blobs.size() }).first;
+				blobs.push_back(std::move(contents));
+			}
+			blobindex.push_back(found->second);
+
+			uint32_t mask = header.slotcount - 1;
+			uint64_t slot = entry.namehash & mask;
+			while(slots[slot] != 0)
+				slot = (slot + 1) & mask;
+			slots[slot] = entries.size() + 1;
+			entries.push_back(entry);
+		}
+
+		std::vector<uint64_t> bloboffsets(blobs.size());
+		uint64_t offset = alignUp(header.namesoffset + names.size());
+		for(size_t i = 0; i < blobs.size(); i++) {
+			bloboffsets[i] = offset;
+			offset = alignUp(offset + blobs[i].size());
+		}
+		for(size_t i = 0; i < entries.size(); i++)
+			entries[i].offset = bloboffsets[blobindex[i]];
+
+		std::string temppath = std::string(output) + ".tmp";
+		FILE *file = fopen(temppath.c_str(), "wb");
+		if(!file) {
+			ERROR("Failed to write %s", temppath.c_str());
+			return false;
+		}
+		bool ok =
+			fwrite(&header, sizeof(header), 1, file) == 1 &&
+			fwrite(entries.data(), sizeof(Entry), entries.size(), file) == entries.size() &&
+			fwrite(slots.data(), sizeof(uint32_t), slots.size(), file) == slots.size() &&
+			fwrite(names.data(), 1, names.size(), file) == names.size();
+		for(size_t i = 0; i < blobs.size() && ok; i++) {
+			ok = fseek(file, long(bloboffsets[i]), SEEK_SET) == 0 &&
+				fwrite(blobs[i].data(), 1, blobs[i].size(), file) == blobs[i].size();
+		}
+		ok = fclose(file) == 0 && ok;
+		remove(output);
+		if(!ok || rename(temppath.c_str(), output) != 0) {
+			ERROR("Failed to write %s", output);
+			remove(temppath.c_str());
+			return false;
+		}
+
+		INFO(
+			"Packed %zu files (%zu unique) into %s, %llu bytes",
+			entries.size(),
+			blobs.size(),
+			output,
+			(unsigned long long)offset
+		);
+		return true;
+	}
+}
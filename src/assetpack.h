@@ -0,0 +1,103 @@
+/*
+ * Single file asset pack, every file the impfiles refer to (and the
+ * impfiles themselves) is stored in one archive that is mapped into memory
+ * once, files are found through a hash table of their paths and each blob
+ * is aligned so that baked meshes and textures can be used in place
+ *
+ * Everything that loads assets goes through readFile(), which looks in the
+ * mounted pack first and falls back to the loose file on disk, so nothing
+ * changes unless a pack has been mounted (see USE_ASSET_PACK)
+ *
+ * Layout (little endian):
+ * Header
+ * entrycount * Entry
+ * slotcount * uint32_t (index + 1 of the entry in that slot, 0 = empty)
+ * names (not null terminated)
+ * blobs, each aligned to ALIGNMENT bytes
+ * */
+
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include "mappedfile.h"
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace assetpack {
+	//Bump this if the layout changes
+	constexpr uint32_t VERSION = 1;
+	constexpr uint64_t ALIGNMENT = 16;
+
+	struct Header {
+		char magic[4];
+		uint32_t version;
+		uint32_t entrycount;
+		//Always a power of 2
+		uint32_t slotcount;
+		uint64_t entriesoffset;
+		uint64_t slotsoffset;
+		uint64_t namesoffset;
+	};
+	static_assert(sizeof(Header) == 40, "Header must be tightly packed");
+
+	struct Entry {
+		uint64_t namehash;
+		//Hash of the contents, identical files share one blob
+		uint64_t contenthash;
+		uint64_t offset;
+		uint64_t size;
+		uint32_t nameoffset;
+		uint32_t namelength;
+	};
+	static_assert(sizeof(Entry) == 40, "Entry must be tightly packed");
+
+	//Contents of a whole file, either a view into the mounted pack or a
+	//loose file mapped on its own, cheap to copy
+	class FileData {
+		std::shared_ptr<MappedFile> mapped;
+		const unsigned char *ptr = nullptr;
+		size_t length = 0;
+		friend class AssetPack;
+		friend bool readFile(const std::string &path, FileData &out);
+	public:
+		const unsigned char* data() const;
+		size_t size() const;
+		bool empty() const;
+		std::string str() const;
+	};
+
+	class AssetPack {
+		MappedFile file;
+		const Header *header = nullptr;
+		const Entry *entries = nullptr;
+		const uint32_t *slots = nullptr;
+		const char *names = nullptr;
+	public:
+		//Returns false if the file can not be read or is not a valid pack
+		bool open(const char *path);
+		const Entry* find(const std::string &name) const;
+		//Returns false if there is no file called 'name' in the pack
+		bool read(const std::string &name, FileData &out) const;
+		//Hashes the contents of every file and compares them against the
+		//index, this touches every page of the pack
+		bool verify() const;
+		unsigned int count() const;
+	};
+
+	//Mounts the pack at 'path', must be called before anything is loaded
+	bool mount(const char *path);
+	bool isMounted();
+	//Returns true if the mounted pack has a file called 'path'
+	bool contains(const std::string &path);
+	//Looks in the mounted pack first and then on disk, returns false if
+	//the file can not be found in either, can be called from any thread
+	bool readFile(const std::string &path, FileData &out);
+	//Writes a pack to 'output' holding the compiled impfiles in 'impfiles' and
+	//every file that they refer to (including .mtl files and up to date
+	//baked meshes and textures)
+	bool build(const char *output, const std::vector<std::string> &impfiles);
+}
+
+#endif
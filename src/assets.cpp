@@ -1,20 +1,265 @@
 #include "assets.h"
+#include "jobs.h"
 #include "logger.h"
+#include "meshfile.h"
+#include "texturefile.h"
+#include <algorithm>
+#include <memory>
+#include <string.h>
+
+namespace {
+// Estimated gpu memory that lazily loaded assets may use
+constexpr size_t TEXTURE_BUDGET = 256 * 1024 * 1024;
+constexpr size_t MODEL_BUDGET = 64 * 1024 * 1024;
+// Spreads the uploads of assets that are needed at the same time over a
+// few frames
+constexpr unsigned int UPLOADS_PER_FRAME = 2;
+// Drawn in place of a model that has not loaded yet
+constexpr sym::Symbol PLACEHOLDER_MODEL = "cube"_sym;
+} // namespace
 
 namespace assets {
+AssetLoader::~AssetLoader() { finish(); }
+
+void AssetLoader::add(Decode decode) {
+  total++;
+  JOBS->submit([this, decode]() {
+    Upload upload = decode();
+    std::lock_guard<std::mutex> lock(mutex);
+    uploads.push_back(std::move(upload));
+    ready.notify_one();
+  });
+}
+
+void AssetLoader::finish(const LoadProgress &progress) {
+  while (loaded < total) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (uploads.empty()) {
+      lock.unlock();
+      // Decode on this thread too rather than sit idle
+      if (JOBS->runPending())
+        continue;
+      lock.lock();
+      ready.wait(lock, [this]() { return !uploads.empty(); });
+    }
+    Upload upload = std::move(uploads.front());
+    uploads.pop_front();
+    lock.unlock();
+
+    if (upload)
+      upload();
+    loaded++;
+    if (progress)
+      progress(loaded, total);
+  }
+}
+
+Residency::Residency(size_t b) : budget(b) {}
+
+void Residency::add(sym::Symbol name) { assets.insert({name, Asset()}); }
+
+bool Residency::contains(sym::Symbol name) const {
+  return assets.count(name) > 0;
+}
+
+Residency::State Residency::use(sym::Symbol name) {
+  Asset &asset = assets.at(name);
+  asset.lastused = frame;
+  return asset.state;
+}
+
+AssetLoader::Upload Residency::finishing(sym::Symbol name,
+                                         AssetLoader::Upload upload) {
+  return [this, name, upload]() {
+    if (upload)
+      upload();
+    if (assets.at(name).state == LOADING)
+      setResident(name, 0);
+  };
+}
+
+void Residency::load(sym::Symbol name, AssetLoader::Decode decode) {
+  assets.at(name).state = LOADING;
+  JOBS->submit([this, name, decode]() {
+    AssetLoader::Upload upload = finishing(name, decode());
+    std::lock_guard<std::mutex> lock(mutex);
+    uploads.push_back(std::move(upload));
+  });
+}
+
+void Residency::load(sym::Symbol name, AssetLoader::Decode decode,
+                     AssetLoader &loader) {
+  assets.at(name).state = LOADING;
+  loader.add([this, name, decode]() { return finishing(name, decode()); });
+}
+
+void Residency::setResident(sym::Symbol name, size_t bytes) {
+  Asset &asset = assets.at(name);
+  asset.state = RESIDENT;
+  asset.bytes = bytes;
+  used += bytes;
+}
+
+void Residency::update(const Unload &unload, unsigned int maxuploads) {
+  for (unsigned int i = 0; i < maxuploads; i++) {
+    AssetLoader::Upload upload;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (uploads.empty())
+        break;
+      upload = std::move(uploads.front());
+      uploads.pop_front();
+    }
+    upload();
+  }
+
+  if (used > budget) {
+    std::vector<std::pair<unsigned int, sym::Symbol>> unused;
+    for (const auto &asset : assets)
+      if (asset.second.state == RESIDENT && asset.second.lastused < frame)
+        unused.push_back({asset.second.lastused, asset.first});
+    std::sort(unused.begin(), unused.end());
+    for (const auto &lru : unused) {
+      if (used <= budget)
+        break;
+      Asset &asset = assets.at(lru.second);
+      unload(lru.second);
+      used -= asset.bytes;
+      asset.bytes = 0;
+      asset.state = UNLOADED;
+      evicted++;
+    }
+  }
+
+  frame++;
+}
+
+void Residency::setBudget(size_t bytes) { budget = bytes; }
+
+ResidencyStats Residency::getStats() const {
+  ResidencyStats stats;
+  stats.total = assets.size();
+  for (const auto &asset : assets) {
+    if (asset.second.state == RESIDENT)
+      stats.resident++;
+    else if (asset.second.state == LOADING)
+      stats.loading++;
+  }
+  stats.used = used;
+  stats.budget = budget;
+  stats.evicted = evicted;
+  return stats;
+}
+
+std::vector<std::pair<sym::Symbol, Residency::Asset>> Residency::list() const {
+  std::vector<std::pair<sym::Symbol, Asset>> sorted(assets.begin(),
+                                                    assets.end());
+  std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+    if (a.second.lastused != b.second.lastused)
+      return a.second.lastused > b.second.lastused;
+    return strcmp(sym::name(a.first), sym::name(b.first)) < 0;
+  });
+  return sorted;
+}
+
+unsigned int Residency::getFrame() const { return frame; }
+
+TextureManager::TextureManager() : residency(TEXTURE_BUDGET) {}
+
 TextureManager *TextureManager::get() {
   static TextureManager *texturemanager = new TextureManager;
   return texturemanager;
 }
 
-void TextureManager::bindTexture(const std::string &name, GLenum texturei) {
+void TextureManager::bindTexture(sym::Symbol name, GLenum texturei) {
   if (!textures.count(name))
     return;
-  TextureInfo info = textures.at(name);
-  glActiveTexture(texturei);
-  glBindTexture(info.target, info.id);
+  TextureInfo info = getTexture(name);
+  GFX->activeTexture(texturei);
+  GFX->bindTexture(info.target, info.id);
+}
+
+TextureInfo TextureManager::getTexture(sym::Symbol name) {
+  auto found = textures.find(name);
+  if (found == textures.end())
+    return {0, GL_TEXTURE_2D};
+  if (lazy.count(name)) {
+    Residency::State state = residency.use(name);
+    if (state == Residency::UNLOADED)
+      startLoading(name, nullptr);
+    if (state != Residency::RESIDENT) {
+      bool cubemap = found->second.target == GL_TEXTURE_CUBE_MAP;
+      return cubemap ? placeholdercubemap : placeholder;
+    }
+  }
+  return found->second;
+}
+
+void TextureManager::add(const std::string &name, TextureInfo texture) {
+  textures.insert({sym::intern(name), texture});
+}
+
+void TextureManager::genPlaceholders() {
+  const unsigned char grey[] = {128, 128, 128, 255};
+  GFX->genTextures(1, &placeholder.id);
+  GFX->bindTexture(GL_TEXTURE_2D, placeholder.id);
+  GFX->texImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA,
+                  GL_UNSIGNED_BYTE, grey);
+  GFX->texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  GFX->texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+  GFX->genTextures(1, &placeholdercubemap.id);
+  GFX->bindTexture(GL_TEXTURE_CUBE_MAP, placeholdercubemap.id);
+  for (unsigned int i = 0; i < 6; i++) {
+    GFX->texImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, 1, 1, 0,
+                    GL_RGBA, GL_UNSIGNED_BYTE, grey);
+  }
+  GFX->texParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  GFX->texParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+void TextureManager::startLoading(sym::Symbol name, AssetLoader *loader) {
+  TextureInfo &info = textures.at(name);
+  GFX->genTextures(1, &info.id);
+  TextureMetaData metadata = lazy.at(name);
+  unsigned int id = info.id;
+  AssetLoader::Decode decode = [this, metadata, id,
+                                name]() -> AssetLoader::Upload {
+    size_t bytes = 0;
+    AssetLoader::Upload upload = decodeTexture(metadata, id, &bytes);
+    if (!upload)
+      return nullptr;
+    return [this, upload, name, bytes]() {
+      upload();
+      residency.setResident(name, bytes);
+    };
+  };
+  if (loader)
+    residency.load(name, decode, *loader);
+  else
+    residency.load(name, decode);
+}
+
+void TextureManager::unload(sym::Symbol name) {
+  TextureInfo &info = textures.at(name);
+  GFX->deleteTextures(1, &info.id);
+  info.id = 0;
+}
+
+void TextureManager::preload(sym::Symbol name, AssetLoader &loader) {
+  if (lazy.count(name) && residency.use(name) == Residency::UNLOADED)
+    startLoading(name, &loader);
 }
 
+void TextureManager::update() {
+  residency.update([this](sym::Symbol name) { unload(name); },
+                   UPLOADS_PER_FRAME);
+}
+
+void TextureManager::setBudget(size_t bytes) { residency.setBudget(bytes); }
+
+const Residency &TextureManager::getResidency() const { return residency; }
+
 TextureMetaData entryToTextureMetaData(const impfile::Entry &entry) {
   TextureMetaData texture;
 
@@ -58,18 +303,95 @@ TextureInfo textureMetaDataToInfo(const TextureMetaData &metadata,
   return info;
 }
 
+AssetLoader::Upload decodeTexture(const TextureMetaData &metadata,
+                                  unsigned int id, size_t *bytes) {
+  if (bytes)
+    *bytes = 0;
+  bool cubemap = metadata.target == "cubemap";
+  std::vector<std::string> sources =
+      cubemap ? metadata.cubemapPaths : std::vector<std::string>{metadata.path};
+  // Baked textures already have their mip chain and only need uploading
+  std::string baked = texturefile::bakedPath(metadata.name, sources.at(0));
+  if (texturefile::isUpToDate(baked, sources)) {
+    auto texture = std::make_shared<texturefile::TextureData>();
+    if (texture->open(baked.c_str())) {
+      const texturefile::Header &header = texture->getHeader();
+      bool flipped = header.flags & texturefile::FLAG_FLIPPED;
+      bool matches = cubemap ? header.target == texturefile::TARGET_CUBEMAP
+                             : header.target == texturefile::TARGET_2D &&
+                                   flipped == metadata.flipv;
+      if (matches) {
+        if (bytes) {
+          for (uint32_t face = 0; face < header.faces; face++)
+            for (uint32_t level = 0; level < header.levels; level++)
+              *bytes += texture->getLevel(face, level).size;
+        }
+        return [texture, id]() { texturefile::upload(*texture, id); };
+      }
+    }
+  }
+
+  if (cubemap) {
+    std::vector<gfx::ImageData> faces(6);
+    for (int i = 0; i < 6; i++) {
+      const std::string &face = metadata.cubemapPaths.at(i);
+      if (!gfx::decodeImage(face.c_str(), false, faces.at(i)))
+        ERROR("Failed to open cubemap file: %s", face.c_str());
+      if (bytes)
+        *bytes += size_t(faces.at(i).width) * faces.at(i).height *
+                  faces.at(i).channels;
+    }
+    return [faces = std::move(faces), id]() { gfx::uploadCubemap(faces, id); };
+  }
+
+  gfx::ImageData image;
+  if (!gfx::decodeImage(metadata.path.c_str(), metadata.flipv, image)) {
+    ERROR("Failed to open: %s", metadata.path.c_str());
+    return nullptr;
+  }
+  // The mip chain adds another third
+  if (bytes)
+    *bytes = size_t(image.width) * image.height * image.channels * 4 / 3;
+  std::string path = metadata.path;
+  return [image, id, path]() {
+    gfx::uploadTexture(image, id);
+    INFO("Texture loaded successfully : %s", path.c_str());
+  };
+}
+
 void TextureManager::importFromFile(const char *path) {
+  AssetLoader loader;
+  importFromFile(path, loader);
+  loader.finish();
+}
+
+void TextureManager::importFromFile(const char *path, AssetLoader &loader) {
   std::vector<impfile::Entry> entries = impfile::parseFile(path);
 
   std::vector<unsigned int> textureids(entries.size());
-  glGenTextures(entries.size(), &textureids[0]);
+  GFX->genTextures(entries.size(), &textureids[0]);
 
   for (int i = 0; i < entries.size(); i++) {
     const impfile::Entry &entry = entries.at(i);
     TextureMetaData metadata = entryToTextureMetaData(entry);
     unsigned id = textureids.at(i);
-    TextureInfo texinfo = textureMetaDataToInfo(metadata, id);
-    textures.insert({entry.name, texinfo});
+    GLenum target =
+        metadata.target == "cubemap" ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    textures.insert({sym::intern(entry.name), {id, target}});
+    loader.add([metadata, id]() { return decodeTexture(metadata, id); });
+  }
+}
+
+void TextureManager::registerFromFile(const char *path) {
+  std::vector<impfile::Entry> entries = impfile::parseFile(path);
+  for (const auto &entry : entries) {
+    TextureMetaData metadata = entryToTextureMetaData(entry);
+    GLenum target =
+        metadata.target == "cubemap" ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    sym::Symbol name = sym::intern(entry.name);
+    textures.insert({name, {0, target}});
+    lazy.insert({name, metadata});
+    residency.add(name);
   }
 }
 
@@ -83,29 +405,38 @@ ShaderMetaData entryToShaderMetaData(const impfile::Entry &entry) {
   return metadata;
 }
 
+void ShaderManager::setCachePrefix(const std::string &prefix) {
+  cacheprefix = prefix;
+}
+
 void ShaderManager::importFromFile(const char *path) {
   std::vector<impfile::Entry> entries = impfile::parseFile(path);
 
-  for (int i = 0; i < entries.size(); i++) {
-    const impfile::Entry &entry = entries.at(i);
-    ShaderMetaData metadata = entryToShaderMetaData(entries.at(i));
-    ShaderProgram program(metadata.vertpath.c_str(), metadata.fragpath.c_str());
-    shaders.insert({metadata.name, program});
+  std::vector<ShaderSource> sources;
+  for (const auto &entry : entries) {
+    ShaderMetaData metadata = entryToShaderMetaData(entry);
+    sources.push_back({metadata.name, metadata.vertpath, metadata.fragpath});
   }
+
+  // Every program is built at once so the driver can overlap the work
+  std::vector<unsigned int> programs = createPrograms(sources, cacheprefix);
+  for (size_t i = 0; i < sources.size(); i++)
+    shaders.insert({sym::intern(sources[i].name), ShaderProgram(programs[i])});
 }
 
-void ShaderManager::use(const std::string &name) {
+void ShaderManager::use(sym::Symbol name) {
   if (!shaders.count(name))
     return;
   shaders.at(name).use();
 }
 
-ShaderProgram &ShaderManager::getShader(const std::string &name) {
-  if (!shaders.count(name)) {
-    ERROR("%s does not exist as a shader!", name.c_str());
+ShaderProgram &ShaderManager::getShader(sym::Symbol name) {
+  auto found = shaders.find(name);
+  if (found == shaders.end()) {
+    ERROR("%s does not exist as a shader!", sym::name(name));
     exit(1); // Crash the program, this hopefully shouldn't happen
   }
-  return static_cast<ShaderProgram &>(shaders.at(name));
+  return found->second;
 }
 
 ShaderManager *ShaderManager::get() {
@@ -120,23 +451,97 @@ ModelMetaData entryToModelMetaData(const impfile::Entry &entry) {
   return metadata;
 }
 
+VaoManager::VaoManager() : residency(MODEL_BUDGET) {}
+
 VaoManager *VaoManager::get() {
   static VaoManager *vaomanager = new VaoManager;
   return vaomanager;
 }
 
 void VaoManager::importFromFile(const char *path) {
+  AssetLoader loader;
+  importFromFile(path, loader);
+  loader.finish();
+}
+
+AssetLoader::Decode VaoManager::decodeModel(const ModelMetaData &metadata,
+                                            bool lazyload) {
+  sym::Symbol symbol = sym::intern(metadata.name);
+  return [this, metadata, lazyload, symbol]() -> AssetLoader::Upload {
+    std::string name = metadata.name;
+    std::string baked = meshfile::bakedPath(metadata.path);
+    if (meshfile::isUpToDate(baked, metadata.path)) {
+      auto mesh = std::make_shared<meshfile::MeshData>();
+      if (mesh->open(baked.c_str())) {
+        const meshfile::Header &header = mesh->getHeader();
+        size_t bytes = header.vertexcount * sizeof(meshfile::Vertex) +
+                       header.indexcount * header.indexsize;
+        return [this, name, symbol, mesh, lazyload, bytes]() {
+          add(name, meshfile::createVao(*mesh));
+          if (lazyload)
+            residency.setResident(symbol, bytes);
+        };
+      }
+    }
+
+    mesh::Model model = mesh::loadObjModel(metadata.path.c_str());
+    size_t bytes = model.vertices.size() * sizeof(glm::vec3) +
+                   model.normals.size() * sizeof(glm::vec3) +
+                   model.texturecoords.size() * sizeof(glm::vec2) +
+                   model.indices.size() * sizeof(unsigned int);
+    return [this, name, symbol, model = std::move(model), lazyload, bytes]() {
+      add(name, gfx::createModelVao(model));
+      if (lazyload)
+        residency.setResident(symbol, bytes);
+    };
+  };
+}
+
+void VaoManager::importFromFile(const char *path, AssetLoader &loader) {
   std::vector<impfile::Entry> entries = impfile::parseFile(path);
 
+  for (const auto &entry : entries)
+    loader.add(decodeModel(entryToModelMetaData(entry), false));
+}
+
+void VaoManager::registerFromFile(const char *path) {
+  std::vector<impfile::Entry> entries = impfile::parseFile(path);
   for (const auto &entry : entries) {
-    ModelMetaData metadata = entryToModelMetaData(entry);
-    add(metadata.name,
-        gfx::createModelVao(mesh::loadObjModel(metadata.path.c_str())));
+    sym::Symbol name = sym::intern(entry.name);
+    lazy.insert({name, entryToModelMetaData(entry)});
+    residency.add(name);
   }
 }
 
+void VaoManager::startLoading(sym::Symbol name, AssetLoader *loader) {
+  AssetLoader::Decode decode = decodeModel(lazy.at(name), true);
+  if (loader)
+    residency.load(name, decode, *loader);
+  else
+    residency.load(name, decode);
+}
+
+void VaoManager::unload(sym::Symbol name) {
+  gfx::destroyVao(vaos.at(name));
+  vaos.erase(name);
+}
+
+void VaoManager::preload(sym::Symbol name, AssetLoader &loader) {
+  if (lazy.count(name) && residency.use(name) == Residency::UNLOADED)
+    startLoading(name, &loader);
+}
+
+void VaoManager::update() {
+  residency.update([this](sym::Symbol name) { unload(name); },
+                   UPLOADS_PER_FRAME);
+}
+
+void VaoManager::setBudget(size_t bytes) { residency.setBudget(bytes); }
+
+const Residency &VaoManager::getResidency() const { return residency; }
+
 void VaoManager::add(const std::string &name, gfx::Vao vao) {
-  vaos.insert({name, vao});
+  vaos.insert({sym::intern(name), vao});
 }
 
 void VaoManager::genSimple() {
@@ -144,29 +549,38 @@ void VaoManager::genSimple() {
   add("cube", gfx::createCubeVao());
 }
 
-void VaoManager::bind(const std::string &name) {
-  if (!vaos.count(name)) {
-    ERROR("vao %s does not exist!", name.c_str());
+void VaoManager::bind(sym::Symbol name) {
+  if (!vaos.count(name) && !lazy.count(name)) {
+    ERROR("vao %s does not exist!", sym::name(name));
     return;
   }
-  vertcount = vaos.at(name).vertcount;
-  vaos.at(name).bind();
+  const gfx::Vao &vao = getVao(name);
+  vertcount = vao.vertcount;
+  indextype = vao.indextype;
+  vao.bind();
 }
 
 void VaoManager::draw() {
-  glDrawElements(GL_TRIANGLES, vertcount, GL_UNSIGNED_INT, 0);
+  GFX->drawElements(GL_TRIANGLES, vertcount, indextype, 0);
 }
 
 void VaoManager::drawInstanced(unsigned int count) {
-  glDrawElementsInstanced(GL_TRIANGLES, vertcount, GL_UNSIGNED_INT, 0, count);
+  GFX->drawElementsInstanced(GL_TRIANGLES, vertcount, indextype, 0, count);
 }
 
-gfx::Vao &VaoManager::getVao(const std::string &name) {
-  if (!vaos.count(name)) {
-    ERROR("vao %s does not exist!", name.c_str());
+gfx::Vao &VaoManager::getVao(sym::Symbol name) {
+  if (lazy.count(name)) {
+    if (residency.use(name) == Residency::UNLOADED)
+      startLoading(name, nullptr);
+    if (!vaos.count(name))
+      return getVao(PLACEHOLDER_MODEL);
+  }
+  auto found = vaos.find(name);
+  if (found == vaos.end()) {
+    ERROR("vao %s does not exist!", sym::name(name));
     exit(1);
   }
-  return vaos.at(name);
+  return found->second;
 }
 
 FontMetaData entryToFontMetaData(const impfile::Entry &entry) {
@@ -200,6 +614,11 @@ void FontManager::importFromFile(const char *path) {
   // nk_glfw3_font_stash_end(state->getNkGlfw());
 }
 
+void updateResidency() {
+  VAOS->update();
+  TEXTURES->update();
+}
+
 FontManager *FontManager::get() {
   static FontManager *fontmanager = new FontManager;
   return fontmanager;
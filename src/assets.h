@@ -9,6 +9,11 @@
 #include "gfx.h"
 #include "importfile.h"
 #include "shader.h"
+#include "symbol.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
 #include <unordered_map>
 #include "opengl.h"
 
@@ -43,43 +48,192 @@ namespace assets {
 		unsigned int fontsize;
 	};
 
+	//Called on the main thread every time an asset has finished loading
+	typedef std::function<void(unsigned int loaded, unsigned int total)> LoadProgress;
+
+	//Loads assets in two halves, the slow half (reading the file, parsing
+	//and decoding it, building meshes) runs as a job and returns the half
+	//that needs the graphics api, finish() runs those on the main thread
+	//one at a time as they come in
+	class AssetLoader {
+	public:
+		//Can be empty if there is nothing to upload (loading failed)
+		typedef std::function<void()> Upload;
+		//Must not touch the graphics api or any of the asset managers
+		typedef std::function<Upload()> Decode;
+	private:
+		std::mutex mutex;
+		std::condition_variable ready;
+		std::deque<Upload> uploads;
+		unsigned int total = 0, loaded = 0;
+	public:
+		AssetLoader() {}
+		//Waits for anything that was added but not finished
+		~AssetLoader();
+		AssetLoader(const AssetLoader&) = delete;
+		AssetLoader& operator=(const AssetLoader&) = delete;
+		void add(Decode decode);
+		//Runs uploads until every added asset is loaded, helps decode
+		//while there is nothing to upload
+		void finish(const LoadProgress &progress = nullptr);
+	};
+
+	//Totals shown in the debug window
+	struct ResidencyStats {
+		unsigned int total = 0, resident = 0, loading = 0;
+		//Estimated bytes used on the gpu by resident assets
+		size_t used = 0, budget = 0;
+		//Assets unloaded since the start
+		unsigned int evicted = 0;
+	};
+
+	//Assets that are only loaded once they are first used, the asset is
+	//decoded as a job and uploaded by update() while the manager that owns
+	//it hands out a placeholder, once the resident assets go over the
+	//budget the ones that were used the longest ago are unloaded again
+	class Residency {
+	public:
+		enum State {
+			UNLOADED,
+			LOADING,
+			RESIDENT,
+		};
+
+		struct Asset {
+			State state = UNLOADED;
+			size_t bytes = 0;
+			//Frame the asset was last used on
+			unsigned int lastused = 0;
+		};
+
+		//Frees whatever the asset 'name' has on the gpu
+		typedef std::function<void(sym::Symbol name)> Unload;
+	private:
+		std::unordered_map<sym::Symbol, Asset> assets;
+		std::mutex mutex;
+		std::deque<AssetLoader::Upload> uploads;
+		unsigned int frame = 1;
+		size_t budget;
+		size_t used = 0;
+		unsigned int evicted = 0;
+		//Marks 'name' as resident after running 'upload' even if the
+		//upload failed or is empty so that it is not loaded every frame
+		AssetLoader::Upload finishing(sym::Symbol name, AssetLoader::Upload upload);
+	public:
+		Residency(size_t budget);
+		void add(sym::Symbol name);
+		bool contains(sym::Symbol name) const;
+		//Marks 'name' as used this frame and returns its state
+		State use(sym::Symbol name);
+		//Decodes 'name' as a job, the upload is run by update()
+		void load(sym::Symbol name, AssetLoader::Decode decode);
+		//Decodes 'name' with 'loader' instead, for assets that are needed
+		//on the first frame
+		void load(sym::Symbol name, AssetLoader::Decode decode, AssetLoader &loader);
+		//Must be called by the upload once the asset is on the gpu
+		void setResident(sym::Symbol name, size_t bytes);
+		//Runs at most 'maxuploads' finished uploads and then unloads
+		//assets that were not used this frame until the total is under
+		//the budget (assets used this frame are never unloaded so the
+		//budget can be exceeded), must be called once per frame on the
+		//main thread
+		void update(const Unload &unload, unsigned int maxuploads);
+		void setBudget(size_t bytes);
+		ResidencyStats getStats() const;
+		//Every asset, the ones used most recently first
+		std::vector<std::pair<sym::Symbol, Asset>> list() const;
+		unsigned int getFrame() const;
+	};
+
+	//The managers are keyed by symbol (see symbol.h), any name that is
+	//looked up every frame should be passed as a literal or a symbol that
+	//was made once rather than as a std::string
 	class TextureManager {
-		std::unordered_map<std::string, TextureInfo> textures = {};
-		TextureManager() {}
+		std::unordered_map<sym::Symbol, TextureInfo> textures = {};
+		//Textures added with registerFromFile
+		std::unordered_map<sym::Symbol, TextureMetaData> lazy = {};
+		Residency residency;
+		TextureInfo placeholder = { 0, GL_TEXTURE_2D };
+		TextureInfo placeholdercubemap = { 0, GL_TEXTURE_CUBE_MAP };
+		TextureManager();
+		void startLoading(sym::Symbol name, AssetLoader *loader);
+		void unload(sym::Symbol name);
 	public:
 		static TextureManager* get();
 		void importFromFile(const char *path);
-		void bindTexture(const std::string &name, GLenum texturei);
+		//Textures are created right away but only get their pixels
+		//once 'loader' has finished
+		void importFromFile(const char *path, AssetLoader &loader);
+		//Textures are only loaded once they are first used and a 1x1 grey
+		//texture is used in their place until then
+		void registerFromFile(const char *path);
+		//Loads a registered texture with 'loader'
+		void preload(sym::Symbol name, AssetLoader &loader);
+		//Creates the placeholder textures
+		void genPlaceholders();
+		//Adds a texture that was created elsewhere (it is never unloaded)
+		void add(const std::string &name, TextureInfo texture);
+		void bindTexture(sym::Symbol name, GLenum texturei);
+		//Returns a texture with an id of 0 if it does not exist
+		TextureInfo getTexture(sym::Symbol name);
+		//Finishes loading and unloads textures over the budget
+		void update();
+		void setBudget(size_t bytes);
+		const Residency& getResidency() const;
 	};
 
 	class VaoManager {
 		unsigned int vertcount = 0;
-		std::unordered_map<std::string, gfx::Vao> vaos = {};
-		VaoManager() {}
+		GLenum indextype = GL_UNSIGNED_INT;
+		std::unordered_map<sym::Symbol, gfx::Vao> vaos = {};
+		//Models added with registerFromFile
+		std::unordered_map<sym::Symbol, ModelMetaData> lazy = {};
+		Residency residency;
+		VaoManager();
+		AssetLoader::Decode decodeModel(const ModelMetaData &metadata, bool lazyload);
+		void startLoading(sym::Symbol name, AssetLoader *loader);
+		void unload(sym::Symbol name);
 	public:
 		static VaoManager* get();
 		//This function will crash the program if you attempt to access
-		//a nonexistent vao
-		gfx::Vao& getVao(const std::string &name);
+		//a nonexistent vao, a registered model that is not loaded yet
+		//returns the placeholder cube (see genSimple)
+		gfx::Vao& getVao(sym::Symbol name);
 		void add(const std::string &name, gfx::Vao vao);
 		//Generates simple models such as a quad or cube
 		void genSimple();
 		void importFromFile(const char *path);
-		void bind(const std::string &name);
+		//The vaos are added once 'loader' has finished, a model whose
+		//baked .mesh file (see meshfile.h) is up to date is mapped from
+		//that instead of parsing the .obj
+		void importFromFile(const char *path, AssetLoader &loader);
+		//Models are only loaded once they are first used
+		void registerFromFile(const char *path);
+		//Loads a registered model with 'loader'
+		void preload(sym::Symbol name, AssetLoader &loader);
+		void bind(sym::Symbol name);
 		void draw();
 		void drawInstanced(unsigned int count);
+		//Finishes loading and unloads models over the budget
+		void update();
+		void setBudget(size_t bytes);
+		const Residency& getResidency() const;
 	};
 
 	class ShaderManager {
-		std::unordered_map<std::string, ShaderProgram> shaders = {};
+		std::unordered_map<sym::Symbol, ShaderProgram> shaders = {};
+		std::string cacheprefix;
 		ShaderManager() {}
 	public:
 		static ShaderManager* get();
+		//Linked programs are cached in files starting with 'prefix',
+		//must be called before importFromFile to have an effect
+		void setCachePrefix(const std::string &prefix);
 		void importFromFile(const char *path);
-		void use(const std::string &name);
+		void use(sym::Symbol name);
 		//Do not attempt to access a shader that does not exist,
 		//it will crash the program
-		ShaderProgram& getShader(const std::string &name);
+		ShaderProgram& getShader(sym::Symbol name);
 	};
 
 	class FontManager {
@@ -105,6 +259,14 @@ namespace assets {
 		const TextureMetaData &metadata, 
 		unsigned int id
 	);
+	//Reads the image(s) for 'metadata', can be called from any thread, the
+	//returned upload passes them to the texture 'id', 'bytes' is set to
+	//the size of the texture on the gpu if it is not null
+	AssetLoader::Upload decodeTexture(
+		const TextureMetaData &metadata,
+		unsigned int id,
+		size_t *bytes = nullptr
+	);
 	//assumes that the entry has the following variables:
 	//vertex, fragment
 	//'vertex' is the path of the vertex shader relative to the executable
@@ -119,6 +281,9 @@ namespace assets {
 	//'path' is the path to a ttf file relative to the executable,
 	//fontsz is the font size
 	FontMetaData entryToFontMetaData(const impfile::Entry &entry);
+	//Calls update() on the texture and vao managers, once per frame after
+	//the render queue has been submitted
+	void updateResidency();
 }
 
 #define TEXTURES assets::TextureManager::get()
@@ -0,0 +1,194 @@
+#include "game.h"
+#include "assets.h"
+#include "simulation.h"
+#include "window.h"
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+
+namespace {
+  double elapsedMs(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double, std::milli> d =
+      std::chrono::steady_clock::now() - start;
+    return d.count();
+  }
+
+  void printTimes(const char *name, std::vector<double> times) {
+    if(times.empty())
+      return;
+    std::sort(times.begin(), times.end());
+    double total = 0.0;
+    for(double t : times)
+      total += t;
+    size_t p95 = std::min(times.size() - 1, times.size() * 95 / 100);
+    printf(
+      "%-10s avg %8.3f ms  min %8.3f ms  p95 %8.3f ms  max %8.3f ms\n",
+      name,
+      total / double(times.size()),
+      times.front(),
+      times[p95],
+      times.back()
+    );
+  }
+
+  //One row per frame, the columns are the same times that are printed
+  bool writeTrace(
+    const char *path,
+    const std::vector<const std::vector<double>*> &columns,
+    const char *header
+  ) {
+    FILE *file = fopen(path, "w");
+    if(!file) {
+      ERROR("Failed to write %s", path);
+      return false;
+    }
+    fprintf(file, "%s\n", header);
+    size_t rows = columns.empty() ? 0 : columns[0]->size();
+    for(size_t i = 0; i < rows; i++) {
+      fprintf(file, "%zu", i);
+      for(const auto *column : columns)
+        fprintf(file, ",%.4f", column->at(i));
+      fprintf(file, "\n");
+    }
+    bool ok = fclose(file) == 0;
+    if(ok)
+      INFO("Wrote frame trace to %s", path);
+    return ok;
+  }
+}
+
+namespace game {
+
+  void benchmarkGameLoop(
+    unsigned int frames,
+    int seed,
+    gfx::RecordingBackend *recorder,
+    const char *tracepath
+  ) {
+    Window& window = Window::getInstance();
+
+    //Same setup as arcade mode but with a fixed seed so that runs can be
+    //compared against each other
+    ArcadeWorld world(seed);
+    const infworld::worldseed &permutations = world.permutations;
+    infworld::ChunkTable chunktables[MAX_LOD];
+    game::generateChunks(permutations, chunktables, RANGE);
+    infworld::DecorationTable decorations = infworld::DecorationTable(14, CHUNK_SZ);
+    decorations.genDecorations(permutations);
+    gfx::setDecorationLods(decorations);
+
+    //The world is stepped on this thread and drawn from its snapshot so
+    //that the cost of making the snapshot is part of the update time
+    const float dt = 1.0f / 60.0f;
+    const sym::Symbol planeModel = sym::intern(world.player.getPlayerObj());
+    InputState input;
+    WorldSnapshot view;
+    world.snapshot(view);
+
+    game::updateCamera(view.player);
+
+    gfx::RenderQueue queue;
+    gfx::GLQueueBackend backend;
+    geo::HorizonBuffer horizon(HORIZON_BINS);
+    gfx::FrameData frame;
+    gfx::FrameInput frameinput;
+    frameinput.chunktables = chunktables;
+    frameinput.maxlod = MAX_LOD;
+    frameinput.lodscale = LOD_SCALE;
+    frameinput.decorations = &decorations;
+    frameinput.balloons = &view.balloons;
+    frameinput.ships = &view.ships;
+    frameinput.explosions = &view.explosions;
+
+    std::vector<double> frameTimes, prepTimes, displayTimes, submitTimes, updateTimes;
+    //Total time of each frame prep task, in the order prepareFrame adds them
+    std::vector<gfx::PrepTiming> taskTotals;
+    unsigned long long draws = 0, calls = 0, bytes = 0;
+
+    //Assets were uploaded before the first frame
+    if(recorder)
+      recorder->clearLog();
+
+    INFO("Running benchmark for %u frames", frames);
+    for(unsigned int i = 0; i < frames; i++) {
+      auto frameStart = std::chrono::steady_clock::now();
+
+      //Culling and transforms are worked out on the job system first
+      frameinput.playertransform = view.player;
+      frameinput.totalTime = view.totalTime;
+      gfx::prepareFrame(frame, frameinput, horizon);
+      prepTimes.push_back(frame.totalms);
+      taskTotals.resize(frame.timings.size(), { nullptr, 0.0f });
+      for(size_t t = 0; t < frame.timings.size(); t++) {
+        taskTotals[t].name = frame.timings[t].name;
+        taskTotals[t].ms += frame.timings[t].ms;
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      GFX->clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      queue.begin(window.getCamera().position, window.getZfar());
+      gfx::displayTerrain(queue, chunktables, MAX_LOD, frame);
+      gfx::displayDecorations(queue, decorations, view.totalTime);
+      if(!view.crashed)
+        gfx::displayPlayerPlane(queue, view.totalTime, view.player, planeModel);
+      gfx::displayBalloons(queue, frame.balloons);
+      gfx::displayShips(queue, frame.ships);
+      gfx::displayBullets(queue, view.bullets);
+      gfx::displayWater(queue, view.totalTime);
+      gfx::displaySkybox(queue);
+      gfx::displayCrosshair(queue, view.player);
+      gfx::displayMiniMapBackground(queue, view.totalTime);
+      gfx::displayAttitude(queue, view.player.rotation.x, view.player.rotation.z);
+      gfx::displaySpeed(queue, view.speed);
+      gfx::displayFuel(queue, view.fuel, view.totalTime);
+      gfx::displayEnemyMarkers(queue, frame.balloonmarkers);
+      gfx::displayEnemyMarkers(queue, frame.shipmarkers);
+      gfx::displayExplosions(queue, frame.particles, view.totalTime);
+      displayTimes.push_back(elapsedMs(start));
+
+      start = std::chrono::steady_clock::now();
+      queue.submit(backend);
+      assets::updateResidency();
+      submitTimes.push_back(elapsedMs(start));
+      draws += queue.getStats().draws;
+
+      start = std::chrono::steady_clock::now();
+      game::updateCamera(view.player, dt);
+      game::generateNewChunks(permutations, chunktables, decorations);
+      world.step(dt, input);
+      world.snapshot(view);
+      updateTimes.push_back(elapsedMs(start));
+
+      frameTimes.push_back(elapsedMs(frameStart));
+
+      if(recorder) {
+        calls += recorder->log.size();
+        bytes += recorder->loggedBytes();
+        recorder->clearLog();
+      }
+    }
+
+    printf("%u frames\n", frames);
+    printTimes("frame", frameTimes);
+    printTimes("prep", prepTimes);
+    printTimes("display", displayTimes);
+    printTimes("submit", submitTimes);
+    printTimes("update", updateTimes);
+    if(tracepath) {
+      writeTrace(
+        tracepath,
+        { &frameTimes, &prepTimes, &displayTimes, &submitTimes, &updateTimes },
+        "frame,frame_ms,prep_ms,display_ms,submit_ms,update_ms"
+      );
+    }
+    if(frames > 0) {
+      for(const auto &task : taskTotals)
+        printf("  %-16s avg %8.3f ms\n", task.name, task.ms / float(frames));
+      printf("draws/frame %llu\n", draws / frames);
+      if(recorder)
+        printf("gl calls/frame %llu  bytes/frame %llu\n", calls / frames, bytes / frames);
+    }
+  }
+
+}
@@ -1,110 +1,309 @@
 #include "infworld.h"
+#include "plants.h"
 #include <algorithm>
+#include <climits>
 #include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
 
 namespace infworld {
-int getChunkSeed(int x, int z, const worldseed &permutations) {
-  // Taken from wikipedia
-  // do some bit magic to hopefully ensure these values are not too periodic
-  const unsigned w = 8 * sizeof(unsigned);
-  const unsigned s = w / 2;
-  unsigned a = x, b = z;
-  a *= 3284157443;
-  b ^= a << s | a >> (w - s);
-  b *= 1911520717;
-  a ^= b << s | b >> (w - s);
-  a *= 2048419325;
-
-  const rng::permutation256 &p = permutations.at(0);
-  return p[unsigned(p[unsigned(p[a % 256] + b) % 256] % 256)];
+DecorationInstance packDecoration(const glm::vec3 &position,
+                                  const glm::vec2 &origin, float width) {
+  // The top height step is left to DECORATION_HIDDEN
+  const int32_t MAX_HEIGHT = int32_t(DECORATION_HIDDEN >> DECORATION_HEIGHT_SHIFT);
+  int32_t height = int32_t(roundf(position.y * DECORATION_HEIGHT_STEPS));
+  height = std::clamp(height, int32_t(0), MAX_HEIGHT - 1);
+  glm::vec2 local = glm::vec2(0.5f);
+  if (width > 0.0f)
+    local += (glm::vec2(position.x, position.z) - origin) / width;
+  local = glm::clamp(local, 0.0f, 1.0f) * DECORATION_POSITION_STEPS;
+  DecorationInstance instance;
+  instance.packed = uint32_t(roundf(local.x)) << DECORATION_X_SHIFT |
+                    uint32_t(roundf(local.y)) << DECORATION_Z_SHIFT |
+                    uint32_t(height) << DECORATION_HEIGHT_SHIFT;
+  return instance;
+}
+
+float decorationChunkWidth(float chunkscale) {
+  return chunkscale * 2.0f * float(PREC) / float(PREC + 1) * float(PREC) /
+         float(PREC + 1) * SCALE;
+}
+
+glm::vec2 decorationOrigin(ChunkPos pos, float width) {
+  return glm::vec2(float(pos.z), float(pos.x)) * width;
+}
+
+glm::vec3 unpackDecoration(const DecorationInstance &instance,
+                           const glm::vec2 &origin, float width) {
+  // Same as tree-vert.glsl
+  const uint32_t XZ_MASK = (1u << DECORATION_Z_SHIFT) - 1;
+  glm::vec2 local =
+      glm::vec2(instance.packed >> DECORATION_X_SHIFT & XZ_MASK,
+                instance.packed >> DECORATION_Z_SHIFT & XZ_MASK) /
+          DECORATION_POSITION_STEPS -
+      0.5f;
+  glm::vec2 xz = origin + local * width;
+  float y = float(instance.packed >> DECORATION_HEIGHT_SHIFT) /
+            DECORATION_HEIGHT_STEPS;
+  return glm::vec3(xz.x, y, xz.y);
 }
 
 DecorationTable::DecorationTable(unsigned int sz, float scale) {
   size = 2 * sz + 1;
   chunkscale = scale;
+  positions.resize(count());
   for (int x = -int(sz); x <= int(sz); x++)
     for (int z = -int(sz); z <= int(sz); z++)
-      positions.push_back({x, z});
-  decorations = std::vector<std::vector<Decoration>>(count());
+      positions.at(slotOf({x, z})) = {x, z};
+  instances = std::vector<ChunkInstances>(count());
+  isdirty.assign(count(), false);
+  generations.assign(count(), 0);
+}
+
+DecorationTable::~DecorationTable() {
+  generating.wait();
+  clearBuffers();
 }
 
 unsigned int DecorationTable::count() { return size * size; }
 
+unsigned int DecorationTable::slotOf(ChunkPos pos) const {
+  int x = (pos.x % int(size) + int(size)) % int(size);
+  int z = (pos.z % int(size) + int(size)) % int(size);
+  return unsigned(x) * size + unsigned(z);
+}
+
 // Draw chunk decorations
-void DecorationTable::drawDecorations(const gfx::Vao &vao) {
-  if (!vaoCount.count(vao.vaoid))
-    return;
-  glDrawElementsInstanced(GL_TRIANGLES, vao.vertcount, GL_UNSIGNED_INT, 0,
-                          vaoCount.at(vao.vaoid));
+void DecorationTable::drawDecorations(gfx::RenderQueue &queue,
+                                      const gfx::Material &material,
+                                      const gfx::Vao &vao) {
+  for (const auto &lod : lods) {
+    if (lod.model.vaoid != vao.vaoid || lod.count == 0)
+      continue;
+    // The chunk origins are read from the origin buffer so a run needs no
+    // uniforms of its own, the queue sorts the runs by their centers
+    for (size_t i = 0; i < lod.runs.size(); i++) {
+      const DecorationRun &run = lod.runs[i];
+      gfx::Vao slots;
+      slots.vaoid = lod.runvaos.at(i);
+      slots.vertcount = lod.model.vertcount;
+      slots.indextype = lod.model.indextype;
+      queue.draw(material, slots, (run.min + run.max) / 2.0f,
+                 gfx::UniformRange(), run.instances);
+    }
+  }
+}
+
+namespace {
+// A run is only continued over the unused entries of its last slot and
+// the slots up to the next chunk if drawing them costs fewer indices than
+// about one more draw call
+constexpr unsigned int RUN_PADDING_INDICES = 16384;
+
+// Which decorations are placed in a chunk, every value is drawn with
+// rng::random() keyed by the chunk so the order does not matter
+struct DecorationPlacement {
+  DecorationType type;
+  // Up to count - 1 candidates are drawn
+  unsigned int count;
+  // Altitude band (height / HEIGHT) the decoration is kept in
+  float minheight, maxheight;
+};
+
+constexpr DecorationPlacement PLACEMENTS[] = {
+    {PINE_TREE, DECORATION_SLOT_SIZE[PINE_TREE] + 1, 0.04f, 0.3f},
+    {TREE, DECORATION_SLOT_SIZE[TREE] + 1, 0.02f, 0.2f},
+};
+
+constexpr bool placementsFitInstances() {
+  for (const auto &placement : PLACEMENTS)
+    if (placement.minheight < 0.0f ||
+        placement.maxheight > DECORATION_MAX_HEIGHT)
+      return false;
+  return true;
+}
+static_assert(placementsFitInstances(),
+              "Decorations must be placed between 0 and DECORATION_MAX_HEIGHT");
+
+// Index of candidate 'i' of 'type' in the random streams of its chunk
+uint32_t candidateIndex(DecorationType type, unsigned int i) {
+  return uint32_t(type) << 16 | i;
+}
+
+unsigned int drawAmount(uint32_t seed, ChunkPos pos,
+                        const DecorationPlacement &placement) {
+  uint32_t r = rng::random(seed, pos.x, pos.z, placement.type,
+                           rng::STREAM_DECORATION_COUNT);
+  return rng::toRange(r, placement.count);
 }
 
-void DecorationTable::genDecorations(const worldseed &permutations,
-                                     DecorationType type, unsigned int n, int x,
-                                     int z, unsigned int index,
-                                     std::minstd_rand0 &lcg) {
+// Draws the x and z of candidate 'index' in the chunk at 'pos' (before it
+// is squeezed by PREC / (PREC + 1), like the terrain vertices)
+glm::vec2 drawCandidate(uint32_t seed, ChunkPos pos, uint32_t index,
+                        float chunkscale) {
   float chunksz = chunkscale * 2.0f * float(PREC) / float(PREC + 1);
-  float posx = float(z) * chunksz;
-  float posz = float(x) * chunksz;
-  unsigned int amount = (unsigned int)(lcg()) % n;
-
-  for (int i = 0; i < amount; i++) {
-    float x = float((unsigned int)(lcg()) % PREC) / float(PREC) - 0.5f;
-    float z = float((unsigned int)(lcg()) % PREC) / float(PREC) - 0.5f;
-    x *= chunksz;
-    z *= chunksz;
-    x += posx;
-    z += posz;
-    float y = getHeight(z, x, permutations);
-    y *= HEIGHT;
-    y -= 0.5f;
-    x *= float(PREC) / float(PREC + 1);
-    z *= float(PREC) / float(PREC + 1);
-    decorations.at(index).push_back({
-        glm::vec3(x, y, z),
-        type,
-    });
+  uint32_t rx =
+      rng::random(seed, pos.x, pos.z, index, rng::STREAM_DECORATION_X);
+  uint32_t rz =
+      rng::random(seed, pos.x, pos.z, index, rng::STREAM_DECORATION_Z);
+  float x = float(rng::toRange(rx, PREC)) / float(PREC) - 0.5f;
+  float z = float(rng::toRange(rz, PREC)) / float(PREC) - 0.5f;
+  x *= chunksz;
+  z *= chunksz;
+  x += float(pos.z) * chunksz;
+  z += float(pos.x) * chunksz;
+  return glm::vec2(x, z);
+}
+
+float decorationHeight(glm::vec2 candidate, const worldseed &permutations) {
+  float y = getHeight(candidate.y, candidate.x, permutations);
+  y *= HEIGHT;
+  y -= 0.5f;
+  return y;
+}
+
+bool inMask(float x, float z, const worldseed &permutations) {
+  return perlin::noise(x / 128.0f, z / 128.0f, permutations.at(0)) >= 0.0f;
+}
+
+bool inBand(const DecorationPlacement &placement, float y) {
+  float height = y / HEIGHT;
+  return height >= placement.minheight && height <= placement.maxheight;
+}
+
+// Sorts the decorations of a chunk into instances by type, this only
+// touches 'chunk' so it can run on a worker
+void buildInstances(const std::vector<Decoration> &chunkdecorations,
+                    const glm::vec2 &origin, float width,
+                    ChunkInstances &chunk) {
+  // Roughly how far the tree models reach from their origin at the
+  // largest scale
+  const glm::vec3 PADDING =
+      glm::vec3(16.0f, 40.0f, 16.0f) * MAX_VARIATION_SCALE;
+
+  // Sized exactly since the table keeps these for as long as the chunk
+  // is in range
+  size_t counts[DECORATION_TYPE_COUNT] = {};
+  for (const auto &decoration : chunkdecorations)
+    counts[decoration.type]++;
+  for (int type = 0; type < DECORATION_TYPE_COUNT; type++) {
+    chunk.offsets[type].clear();
+    chunk.offsets[type].shrink_to_fit();
+    chunk.offsets[type].reserve(counts[type]);
+  }
+  chunk.origin = origin;
+
+  if (chunkdecorations.empty()) {
+    chunk.min = chunk.max = glm::vec3(0.0f);
+    return;
+  }
+
+  chunk.min = chunk.max = chunkdecorations.at(0).position * SCALE;
+  for (const auto &decoration : chunkdecorations) {
+    glm::vec3 offset = decoration.position * SCALE;
+    chunk.offsets[decoration.type].push_back(
+        packDecoration(offset, origin, width));
+    chunk.min = glm::min(chunk.min, offset);
+    chunk.max = glm::max(chunk.max, offset);
+  }
+  chunk.min -= PADDING;
+  chunk.max += PADDING;
+}
+} // namespace
+
+void placeDecorations(const worldseed &permutations, ChunkPos pos,
+                      float chunkscale, std::vector<Decoration> &out) {
+  out.clear();
+  out.reserve(MAX_CHUNK_DECORATIONS);
+  const uint32_t seed = getWorldSeed(permutations);
+  for (const auto &placement : PLACEMENTS) {
+    unsigned int amount = drawAmount(seed, pos, placement);
+    for (unsigned int i = 0; i < amount; i++) {
+      uint32_t index = candidateIndex(placement.type, i);
+      glm::vec2 candidate = drawCandidate(seed, pos, index, chunkscale);
+      float x = candidate.x * (float(PREC) / float(PREC + 1));
+      float z = candidate.y * (float(PREC) / float(PREC + 1));
+      // The mask is one octave of noise, the height is nine
+      if (!inMask(x, z, permutations))
+        continue;
+      float y = decorationHeight(candidate, permutations);
+      if (!inBand(placement, y))
+        continue;
+      out.push_back({glm::vec3(x, y, z), placement.type});
+    }
+  }
+}
+
+void placeDecorationsLegacy(const worldseed &permutations, ChunkPos pos,
+                            float chunkscale, std::vector<Decoration> &out) {
+  out.clear();
+  const uint32_t seed = getWorldSeed(permutations);
+  for (const auto &placement : PLACEMENTS) {
+    unsigned int amount = drawAmount(seed, pos, placement);
+    for (unsigned int i = 0; i < amount; i++) {
+      uint32_t index = candidateIndex(placement.type, i);
+      glm::vec2 candidate = drawCandidate(seed, pos, index, chunkscale);
+      float y = decorationHeight(candidate, permutations);
+      float x = candidate.x * (float(PREC) / float(PREC + 1));
+      float z = candidate.y * (float(PREC) / float(PREC + 1));
+      out.push_back({glm::vec3(x, y, z), placement.type});
+    }
+  }
+
+  out.erase(std::remove_if(out.begin(), out.end(),
+                           [&permutations](Decoration d) {
+                             return !inMask(d.position.x, d.position.z,
+                                            permutations);
+                           }),
+            out.end());
+  for (const auto &placement : PLACEMENTS) {
+    out.erase(std::remove_if(out.begin(), out.end(),
+                             [&placement](Decoration d) {
+                               return d.type == placement.type &&
+                                      !inBand(placement, d.position.y);
+                             }),
+              out.end());
   }
 }
 
 void DecorationTable::generate(const worldseed &permutations,
                                unsigned int index) {
-  ChunkPos pos = positions.at(index);
-  int seed = getChunkSeed(pos.x, pos.z, permutations);
-  std::minstd_rand0 lcg;
-  lcg.seed(seed);
-  genDecorations(permutations, PINE_TREE, 120, pos.x, pos.z, index, lcg);
-  genDecorations(permutations, TREE, 36, pos.x, pos.z, index, lcg);
-
-  decorations.at(index).erase(
-      std::remove_if(decorations.at(index).begin(), decorations.at(index).end(),
-                     [&permutations](Decoration d) {
-                       float x = d.position.x / 128.0f;
-                       float z = d.position.z / 128.0f;
-                       return perlin::noise(x, z, permutations.at(0)) < 0.0f;
-                     }),
-      decorations.at(index).end());
-
-  decorations.at(index).erase(
-      std::remove_if(decorations.at(index).begin(), decorations.at(index).end(),
-                     [](Decoration d) {
-                       float y = d.position.y / HEIGHT;
-                       return d.type == TREE && (y < 0.02f || y > 0.2f);
-                     }),
-      decorations.at(index).end());
-
-  decorations.at(index).erase(
-      std::remove_if(decorations.at(index).begin(), decorations.at(index).end(),
-                     [](Decoration d) {
-                       float y = d.position.y / HEIGHT;
-                       return d.type == PINE_TREE && (y < 0.04f || y > 0.3f);
-                     }),
-      decorations.at(index).end());
+  std::vector<Decoration> chunkdecorations;
+  placeDecorations(permutations, positions.at(index), chunkscale,
+                   chunkdecorations);
+  float width = chunkWidth();
+  buildInstances(chunkdecorations, decorationOrigin(positions.at(index), width),
+                 width, instances.at(index));
+  markDirty(index);
+}
+
+void DecorationTable::markDirty(unsigned int index) {
+  if (!isdirty.at(index)) {
+    isdirty.at(index) = true;
+    dirty.push_back(index);
+  }
+}
+
+void DecorationTable::publishGenerated() {
+  std::vector<GeneratedChunk> finished;
+  {
+    std::lock_guard<std::mutex> lock(generatedmutex);
+    finished.swap(generated);
+  }
+
+  for (auto &chunk : finished) {
+    // The chunk has been moved again since this was started, a newer
+    // job will replace it
+    if (chunk.generation != generations.at(chunk.index))
+      continue;
+    std::swap(instances.at(chunk.index), chunk.instances);
+    markDirty(chunk.index);
+  }
 }
 
 // Generate decorations
 void DecorationTable::genDecorations(const worldseed &permutations) {
-  for (int i = 0; i < decorations.size(); i++)
+  for (int i = 0; i < count(); i++)
     generate(permutations, i);
 }
 
@@ -114,6 +313,7 @@ bool DecorationTable::genNewDecorations(float camerax, float cameraz,
                   float(PREC + 1);
   int ix = int(floorf((cameraz + chunksz * SCALE) / (chunksz * SCALE * 2.0f))),
       iz = int(floorf((camerax + chunksz * SCALE) / (chunksz * SCALE * 2.0f)));
+  publishGenerated();
   if (ix == centerx && iz == centerz)
     return false;
 
@@ -127,20 +327,25 @@ bool DecorationTable::genNewDecorations(float camerax, float cameraz,
     }
   }
 
-  std::vector<unsigned int> indices;
-  for (int i = 0; i < positions.size(); i++) {
-    ChunkPos pos = positions.at(i);
-    if (labs(pos.x - ix) <= range && labs(pos.z - iz) <= range)
-      continue;
-    indices.push_back(i);
-  }
-
-  for (int i = 0; i < indices.size(); i++) {
-    unsigned int index = indices.at(i);
-    ChunkPos pos = newChunks.at(i);
+  // A new chunk is size chunks away from the one it replaces so it lands
+  // in the same slot
+  for (ChunkPos pos : newChunks) {
+    unsigned int index = slotOf(pos);
     positions.at(index) = pos;
-    decorations.at(index).clear();
-    generate(permutations, index);
+    unsigned int generation = ++generations.at(index);
+    float scale = chunkscale, width = chunkWidth();
+    generating.run([this, &permutations, index, pos, generation, scale,
+                    width]() {
+      GeneratedChunk chunk;
+      chunk.index = index;
+      chunk.generation = generation;
+      std::vector<Decoration> chunkdecorations;
+      placeDecorations(permutations, pos, scale, chunkdecorations);
+      buildInstances(chunkdecorations, decorationOrigin(pos, width), width,
+                     chunk.instances);
+      std::lock_guard<std::mutex> lock(generatedmutex);
+      generated.push_back(std::move(chunk));
+    });
   }
 
   centerx = ix;
@@ -149,40 +354,187 @@ bool DecorationTable::genNewDecorations(float camerax, float cameraz,
   return true;
 }
 
-void DecorationTable::generateOffsets(DecorationType type, const gfx::Vao &vao,
-                                      unsigned int minrange,
-                                      unsigned int maxrange) {
-  if (decorations.size() == 0)
+void DecorationTable::setLod(DecorationType type, const gfx::Vao &vao,
+                             float mindist, float maxdist) {
+  for (auto &lod : lods) {
+    if (lod.model.vaoid != vao.vaoid)
+      continue;
+    lod.type = type;
+    lod.mindist = mindist;
+    lod.maxdist = maxdist;
     return;
+  }
+
+  DecorationLod lod;
+  lod.type = type;
+  lod.model = vao;
+  lod.mindist = mindist;
+  lod.maxdist = maxdist;
+  lods.push_back(lod);
+}
 
-  std::vector<float> offsets;
+void DecorationTable::cull(const geo::Frustum &viewfrustum,
+                           const geo::HorizonBuffer *horizon,
+                           const glm::vec3 &camerapos) {
+  cullstats = DecorationCullStats();
+  for (auto &lod : lods)
+    lod.count = 0;
 
+  // Distance to each chunk that is visible, computed once and shared by
+  // every lod (negative if the chunk is not visible)
+  distances.assign(count(), -1.0f);
   for (int i = 0; i < count(); i++) {
-    ChunkPos pos = positions.at(i);
+    const ChunkInstances &chunk = instances.at(i);
+    if (chunk.offsets[TREE].empty() && chunk.offsets[PINE_TREE].empty())
+      continue;
+
+    geo::AABB aabb((chunk.min + chunk.max) / 2.0f, chunk.max - chunk.min);
+    if (!geo::intersectsFrustum(viewfrustum, aabb)) {
+      cullstats.culled++;
+      continue;
+    }
 
-    if ((labs(pos.x - centerx) < minrange &&
-         labs(pos.z - centerz) < minrange) ||
-        (labs(pos.x - centerx) >= maxrange ||
-         labs(pos.z - centerz) >= maxrange))
+    if (horizon && horizon->occluded(chunk.min, chunk.max)) {
+      cullstats.occluded++;
       continue;
+    }
 
-    for (const auto &decoration : decorations.at(i)) {
-      if (decoration.type != type)
+    cullstats.drawn++;
+    glm::vec2 center = glm::vec2(aabb.pos.x, aabb.pos.z);
+    distances[i] = glm::length(center - glm::vec2(camerapos.x, camerapos.z));
+  }
+
+  // The instances already sit in each chunk's slot so only the runs of
+  // slots to draw are gathered here
+  for (auto &lod : lods) {
+    lod.runs.clear();
+    const unsigned int slotsize = DECORATION_SLOT_SIZE[lod.type];
+    // A run can be continued over slots that are empty or not visible
+    // (drawing those changes nothing on screen) but not over a chunk that
+    // is drawn with another lod
+    bool continues = false;
+    for (int i = 0; i < count(); i++) {
+      const ChunkInstances &chunk = instances.at(i);
+      unsigned int n = chunk.offsets[lod.type].size();
+      if (distances[i] < 0.0f || n == 0)
+        continue;
+      if (distances[i] < lod.mindist || distances[i] >= lod.maxdist) {
+        continues = false;
+        continue;
+      }
+      lod.count += n;
+
+      if (continues) {
+        DecorationRun &run = lod.runs.back();
+        unsigned int start = (i - run.first) * slotsize;
+        if ((start - run.instances) * lod.model.vertcount <=
+            RUN_PADDING_INDICES) {
+          run.instances = start + n;
+          run.min = glm::min(run.min, chunk.min);
+          run.max = glm::max(run.max, chunk.max);
+          continue;
+        }
+      }
+      lod.runs.push_back({unsigned(i), n, chunk.min, chunk.max});
+      continues = true;
+    }
+    cullstats.instances += lod.count;
+    cullstats.draws += lod.runs.size();
+  }
+}
+
+void DecorationTable::upload() {
+  if (originbuffer == 0) {
+    GFX->genBuffers(1, &originbuffer);
+    GFX->bindBuffer(GL_ARRAY_BUFFER, originbuffer);
+    GFX->bufferData(GL_ARRAY_BUFFER, sizeof(glm::vec2) * count(), nullptr,
+                    GL_DYNAMIC_DRAW);
+  }
+  for (int type = 0; type < DECORATION_TYPE_COUNT; type++) {
+    if (instancebuffers[type] != 0)
+      continue;
+    GFX->genBuffers(1, &instancebuffers[type]);
+    GFX->bindBuffer(GL_ARRAY_BUFFER, instancebuffers[type]);
+    GFX->bufferData(GL_ARRAY_BUFFER,
+                    sizeof(DecorationInstance) * DECORATION_SLOT_SIZE[type] *
+                        count(),
+                    nullptr, GL_DYNAMIC_DRAW);
+  }
+
+  // Only the chunks that changed since the last upload are written, the
+  // rest of the buffer stays as it is. Slots are written whole, even when
+  // empty, since a run can draw every entry of the slots before its last
+  std::vector<DecorationInstance> slot;
+  for (unsigned int index : dirty) {
+    isdirty.at(index) = false;
+    GFX->bindBuffer(GL_ARRAY_BUFFER, originbuffer);
+    GFX->bufferSubData(GL_ARRAY_BUFFER, sizeof(glm::vec2) * index,
+                       sizeof(glm::vec2), &instances.at(index).origin);
+    for (int type = 0; type < DECORATION_TYPE_COUNT; type++) {
+      const std::vector<DecorationInstance> &offsets =
+          instances.at(index).offsets[type];
+      slot.assign(offsets.begin(), offsets.end());
+      slot.resize(DECORATION_SLOT_SIZE[type], {DECORATION_HIDDEN});
+      GFX->bindBuffer(GL_ARRAY_BUFFER, instancebuffers[type]);
+      GFX->bufferSubData(GL_ARRAY_BUFFER,
+                         sizeof(DecorationInstance) *
+                             DECORATION_SLOT_SIZE[type] * index,
+                         sizeof(DecorationInstance) * slot.size(),
+                         slot.data());
+    }
+  }
+  dirty.clear();
+
+  // GL 3.3/GLES 3.0 do not have base instance so each run is drawn with a
+  // vao that points the instance attributes at its first slot, the vaos
+  // are only pointed again when a run moves
+  for (auto &lod : lods) {
+    for (size_t i = 0; i < lod.runs.size(); i++) {
+      if (i == lod.runvaos.size()) {
+        lod.runvaos.push_back(plants::createPlantSlotVao(lod.model).vaoid);
+        lod.runvaoslots.push_back(UINT_MAX);
+      }
+      unsigned int first = lod.runs[i].first;
+      if (lod.runvaoslots[i] == first)
         continue;
-      offsets.push_back(decoration.position.x * SCALE);
-      offsets.push_back(decoration.position.y * SCALE);
-      offsets.push_back(decoration.position.z * SCALE);
+      plants::pointPlantSlotVao(lod.runvaos[i], instancebuffers[lod.type],
+                                originbuffer, first,
+                                DECORATION_SLOT_SIZE[lod.type]);
+      lod.runvaoslots[i] = first;
+    }
+  }
+  GFX->bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void DecorationTable::clearBuffers() {
+  for (auto &buffer : instancebuffers) {
+    if (buffer != 0)
+      GFX->deleteBuffers(1, &buffer);
+    buffer = 0;
+  }
+  if (originbuffer != 0)
+    GFX->deleteBuffers(1, &originbuffer);
+  originbuffer = 0;
+  for (auto &lod : lods) {
+    for (auto &vao : lod.runvaos)
+      GFX->deleteVertexArrays(1, &vao);
+    lod.runvaos.clear();
+    lod.runvaoslots.clear();
+  }
+  // Every slot has to be written again
+  for (int i = 0; i < count(); i++) {
+    if (!isdirty.at(i)) {
+      isdirty.at(i) = true;
+      dirty.push_back(i);
     }
   }
+}
 
-  if (vaoCount.count(vao.vaoid))
-    vaoCount.at(vao.vaoid) = offsets.size() / 3;
-  else
-    vaoCount.insert({vao.vaoid, offsets.size() / 3});
+const DecorationCullStats &DecorationTable::getCullStats() const {
+  return cullstats;
+}
 
-  glBindBuffer(GL_ARRAY_BUFFER, vao.buffers.at(4));
-  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * offsets.size(), &offsets[0],
-               GL_STATIC_DRAW);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+float DecorationTable::chunkWidth() const {
+  return decorationChunkWidth(chunkscale);
 }
 } // namespace infworld
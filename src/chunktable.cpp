@@ -1,6 +1,7 @@
 #include "infworld.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
 
 namespace infworld {
 	//Default constructor
@@ -19,19 +20,23 @@ namespace infworld {
 		height = h;
 		vaoids = std::vector<unsigned int>(chunkcount);
 		chunkpos = std::vector<infworld::ChunkPos>(chunkcount);
+		chunkbounds = std::vector<ChunkBounds>(chunkcount);
+		chunkmin = std::vector<glm::vec3>(chunkcount);
+		chunkmax = std::vector<glm::vec3>(chunkcount);
+		grid = std::vector<int>(chunkcount);
 		bufferids = std::vector<unsigned int>(BUFFER_PER_CHUNK * chunkcount);
 	}
 
 	void ChunkTable::genBuffers()
 	{	
-		glGenVertexArrays(vaoids.size(), &vaoids[0]);	
-		glGenBuffers(bufferids.size(), &bufferids[0]);
+		GFX->genVertexArrays(vaoids.size(), &vaoids[0]);	
+		GFX->genBuffers(bufferids.size(), &bufferids[0]);
 	}
 
 	void ChunkTable::clearBuffers()
 	{
-		glDeleteVertexArrays(vaoids.size(), &vaoids[0]);
-		glDeleteBuffers(bufferids.size(), &bufferids[0]);
+		GFX->deleteVertexArrays(vaoids.size(), &vaoids[0]);
+		GFX->deleteBuffers(bufferids.size(), &bufferids[0]);
 	}
 
 	void ChunkTable::addChunk(
@@ -41,18 +46,21 @@ namespace infworld {
 		int z
 	) {
 		chunkpos.at(index) = { x, z };
+		//We don't know how tall the chunk is
+		chunkbounds.at(index) = ChunkBounds();
+		updateBounds(index);
 
-		glBindVertexArray(vaoids.at(index));
+		GFX->bindVertexArray(vaoids.at(index));
 
 		//Buffer 0 (vertex positions)
-		glBindBuffer(GL_ARRAY_BUFFER, bufferids.at(index * BUFFER_PER_CHUNK));
-		glBufferData(
+		GFX->bindBuffer(GL_ARRAY_BUFFER, bufferids.at(index * BUFFER_PER_CHUNK));
+		GFX->bufferData(
 			GL_ARRAY_BUFFER, 
 			chunkmesh.mesh.vertices.size() * sizeof(float),
 			&chunkmesh.mesh.vertices[0],
 			GL_STATIC_DRAW
 		);
-		glVertexAttribPointer(
+		GFX->vertexAttribPointer(
 			0,
 			1,
 			GL_FLOAT,
@@ -60,17 +68,17 @@ namespace infworld {
 			CHUNK_VERT_SZ_BYTES,
 			(void*)0
 		);
-		glEnableVertexAttribArray(0);
+		GFX->enableVertexAttribArray(0);
 
 		//Buffer 1 (vertex normals)
-		glBindBuffer(GL_ARRAY_BUFFER, bufferids.at(index * BUFFER_PER_CHUNK + 1));
-		glBufferData(
+		GFX->bindBuffer(GL_ARRAY_BUFFER, bufferids.at(index * BUFFER_PER_CHUNK + 1));
+		GFX->bufferData(
 			GL_ARRAY_BUFFER,
 			chunkmesh.mesh.vertices.size() * sizeof(float),
 			&chunkmesh.mesh.vertices[0],
 			GL_STATIC_DRAW
 		);
-		glVertexAttribPointer(
+		GFX->vertexAttribPointer(
 			1,
 			2,
 			GL_FLOAT, 
@@ -78,10 +86,10 @@ namespace infworld {
 			CHUNK_VERT_SZ_BYTES,
 			(void*)(sizeof(float))
 		);
-		glEnableVertexAttribArray(1);
+		GFX->enableVertexAttribArray(1);
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferids.at(index * BUFFER_PER_CHUNK + 2));
-		glBufferData(
+		GFX->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferids.at(index * BUFFER_PER_CHUNK + 2));
+		GFX->bufferData(
 			GL_ELEMENT_ARRAY_BUFFER,
 			CHUNK_INDICES.size() * sizeof(unsigned int),
 			&CHUNK_INDICES[0],
@@ -92,17 +100,21 @@ namespace infworld {
 	void ChunkTable::addChunk(unsigned int index, const ChunkData &chunk)
 	{
 		addChunk(index, chunk.chunkmesh, chunk.position.x, chunk.position.z);
+		chunkbounds.at(index) = chunk.bounds;
+		updateBounds(index);
 	}
 
 	void ChunkTable::updateChunk(unsigned int index, const ChunkData &chunk)
 	{
 		chunkpos.at(index) = { chunk.position.x, chunk.position.z };
+		chunkbounds.at(index) = chunk.bounds;
+		updateBounds(index);
 
-		glBindVertexArray(vaoids.at(index));
+		GFX->bindVertexArray(vaoids.at(index));
 
 		//Buffer 0 (vertex positions)
-		glBindBuffer(GL_ARRAY_BUFFER, bufferids.at(index * BUFFER_PER_CHUNK));
-		glBufferSubData(
+		GFX->bindBuffer(GL_ARRAY_BUFFER, bufferids.at(index * BUFFER_PER_CHUNK));
+		GFX->bufferSubData(
 			GL_ARRAY_BUFFER,
 			0,
 			chunk.chunkmesh.mesh.vertices.size() * sizeof(float),
@@ -110,8 +122,8 @@ namespace infworld {
 		);
 
 		//Buffer 1 (vertex normals)
-		glBindBuffer(GL_ARRAY_BUFFER, bufferids.at(index * BUFFER_PER_CHUNK + 1));
-		glBufferSubData(
+		GFX->bindBuffer(GL_ARRAY_BUFFER, bufferids.at(index * BUFFER_PER_CHUNK + 1));
+		GFX->bufferSubData(
 			GL_ARRAY_BUFFER,
 			0,
 			chunk.chunkmesh.mesh.vertices.size() * sizeof(float),
@@ -121,7 +133,7 @@ namespace infworld {
 
 	void ChunkTable::bindVao(unsigned int index)
 	{
-		glBindVertexArray(vaoids.at(index));
+		GFX->bindVertexArray(vaoids.at(index));
 	}	
 
 	infworld::ChunkPos ChunkTable::getPos(unsigned int index)
@@ -143,6 +155,7 @@ namespace infworld {
 	{
 		centerx = x;
 		centerz = z;
+		quadtreedirty = true;
 	}
 
 	void ChunkTable::generateNewChunks(
@@ -188,74 +201,237 @@ namespace infworld {
 
 		centerx = ix;
 		centerz = iz;
+		quadtreedirty = true;
 	}
 
-	unsigned int ChunkTable::draw(
-		ShaderProgram &shader,
-		const geo::Frustum &viewfrustum
-	) {
-		unsigned int drawCount = 0;
-		for(int i = 0; i < count(); i++) {
-			infworld::ChunkPos p = getPos(i);
+	glm::vec3 ChunkTable::chunkCenter(unsigned int index)
+	{
+		infworld::ChunkPos p = getPos(index);
+		float x = float(p.z) * chunkscale * 2.0f * float(PREC) / float(PREC + 1);
+		float z = float(p.x) * chunkscale * 2.0f * float(PREC) / float(PREC + 1);
+		return glm::vec3(x, 0.0f, z);
+	}
 
-			float x = float(p.z) * chunkscale * 2.0f * float(PREC) / float(PREC + 1);
-			float z = float(p.x) * chunkscale * 2.0f * float(PREC) / float(PREC + 1);	
+	geo::AABB ChunkTable::chunkAABB(unsigned int index)
+	{
+		//Heights are scaled by HEIGHT in the terrain shader
+		const ChunkBounds &bounds = chunkbounds.at(index);
+		float miny = bounds.minheight * HEIGHT, maxy = bounds.maxheight * HEIGHT;
+		glm::vec3 center = chunkCenter(index);
+		center.y = (miny + maxy) / 2.0f;
+		return geo::AABB(
+			center * SCALE,
+			glm::vec3(chunkscale * 2.0f, maxy - miny, chunkscale * 2.0f) * SCALE
+		);
+	}
 
-			geo::AABB chunkAABB = geo::AABB(
-				glm::vec3(x, 0.0f, z) * SCALE,
-				glm::vec3(chunkscale * 2.0f, HEIGHT * 2.0f, chunkscale * 2.0f) * SCALE
-			);
+	void ChunkTable::updateBounds(unsigned int index)
+	{
+		geo::AABB aabb = chunkAABB(index);
+		chunkmin.at(index) = aabb.pos - aabb.dimensions / 2.0f;
+		chunkmax.at(index) = aabb.pos + aabb.dimensions / 2.0f;
+		quadtreedirty = true;
+	}
 
-			if(!geo::intersectsFrustum(viewfrustum, chunkAABB))
-				continue;
+	//Returns -1 if there are no chunks in the region
+	int ChunkTable::buildQuadtree(int x, int z, int sz, int minrange)
+	{
+		int range = (size - 1) / 2;
+		if(x >= int(size) || z >= int(size))
+			return -1;
+		//Skip regions that are entirely inside the range drawn by the
+		//previous LOD
+		if(x > range - minrange && x + sz - 1 < range + minrange &&
+			z > range - minrange && z + sz - 1 < range + minrange)
+			return -1;
+
+		QuadNode node;
+		node.chunk = -1;
+		for(int i = 0; i < 4; i++)
+			node.children[i] = -1;
+
+		if(sz == 1) {
+			int index = grid.at(x * size + z);
+			if(index < 0)
+				return -1;
+			node.min = chunkmin.at(index);
+			node.max = chunkmax.at(index);
+			node.chunk = index;
+			node.chunks = 1;
+			quadtree.push_back(node);
+			return quadtree.size() - 1;
+		}
 
-			glm::mat4 transform = glm::mat4(1.0f);
-			transform = glm::scale(transform, glm::vec3(SCALE));
-			transform = glm::translate(transform, glm::vec3(x, 0.0f, z));
-			shader.uniformMat4x4("transform", transform);
-			bindVao(i);
-			glDrawElements(GL_TRIANGLES, CHUNK_VERT_COUNT, GL_UNSIGNED_INT, 0);
-			drawCount++;
+		int half = sz / 2;
+		int children[] = {
+			buildQuadtree(x, z, half, minrange),
+			buildQuadtree(x + half, z, half, minrange),
+			buildQuadtree(x, z + half, half, minrange),
+			buildQuadtree(x + half, z + half, half, minrange),
+		};
+
+		int count = 0;
+		node.chunks = 0;
+		for(int child : children) {
+			if(child < 0)
+				continue;
+			if(count == 0) {
+				node.min = quadtree.at(child).min;
+				node.max = quadtree.at(child).max;
+			}
+			node.min = glm::min(node.min, quadtree.at(child).min);
+			node.max = glm::max(node.max, quadtree.at(child).max);
+			node.chunks += quadtree.at(child).chunks;
+			node.children[count++] = child;
 		}
 
-		return drawCount;
+		if(count == 0)
+			return -1;
+		//No point in having a node with a single child
+		if(count == 1)
+			return node.children[0];
+		quadtree.push_back(node);
+		return quadtree.size() - 1;
 	}
 
-	unsigned int ChunkTable::draw(
-		ShaderProgram &shader,
-		unsigned int minrange,
-		const geo::Frustum &viewfrustum
+	void ChunkTable::cullQuadNode(
+		int node,
+		bool inside,
+		const geo::Frustum &viewfrustum,
+		const geo::HorizonBuffer *horizon
 	) {
-		unsigned int drawCount = 0;
+		const QuadNode &n = quadtree.at(node);
+
+		if(!inside) {
+			geo::AABB aabb((n.min + n.max) / 2.0f, n.max - n.min);
+			cullstats.tests++;
+			geo::FrustumTest test = geo::testFrustum(viewfrustum, aabb);
+			if(test == geo::OUTSIDE_FRUSTUM)
+				return;
+			inside = test == geo::INSIDE_FRUSTUM;
+		}
+
+		//Being inside the frustum says nothing about the children being
+		//visible so this is checked for every node
+		if(horizon && horizon->occluded(n.min, n.max)) {
+			cullstats.occluded += n.chunks;
+			return;
+		}
+
+		if(n.chunk >= 0) {
+			visible.push_back(n.chunk);
+			return;
+		}
+
+		for(int child : n.children)
+			if(child >= 0)
+				cullQuadNode(child, inside, viewfrustum, horizon);
+	}
+
+	void ChunkTable::rebuildQuadtree(int minrange)
+	{
+		cullcandidates = 0;
+
+		//Place the chunks in the grid
+		int range = (size - 1) / 2;
+		std::fill(grid.begin(), grid.end(), -1);
+		outsidegrid.clear();
 		for(int i = 0; i < count(); i++) {
 			infworld::ChunkPos p = getPos(i);
 
 			if(std::abs(p.x - centerx) < minrange && 
 				std::abs(p.z - centerz) < minrange)
 				continue;
+			cullcandidates++;
 
-			float x = float(p.z) * chunkscale * 2.0f * float(PREC) / float(PREC + 1);
-			float z = float(p.x) * chunkscale * 2.0f * float(PREC) / float(PREC + 1);	
-		
-			geo::AABB chunkAABB = geo::AABB(
-				glm::vec3(x, 0.0f, z) * SCALE,
-				glm::vec3(chunkscale * 2.0f, HEIGHT * 2.0f, chunkscale * 2.0f) * SCALE
-			);
-			
-			//Frustum culling
-			if(!geo::intersectsFrustum(viewfrustum, chunkAABB))
+			int x = p.x - centerx + range, z = p.z - centerz + range;
+			if(x < 0 || z < 0 || x >= int(size) || z >= int(size))
+				outsidegrid.push_back(i);
+			else
+				grid.at(x * size + z) = i;
+		}
+
+		//Smallest power of 2 that covers the grid
+		int sz = 1;
+		while(sz < int(size))
+			sz *= 2;
+		quadtree.clear();
+		quadtreeroot = buildQuadtree(0, 0, sz, minrange);
+		quadtreeminrange = minrange;
+		quadtreedirty = false;
+	}
+
+	unsigned int ChunkTable::cull(
+		unsigned int minrange,
+		const geo::Frustum &viewfrustum,
+		const geo::HorizonBuffer *horizon
+	) {
+		cullstats = ChunkCullStats();
+		visible.clear();
+
+		if(quadtreedirty || int(minrange) != quadtreeminrange)
+			rebuildQuadtree(minrange);
+		if(quadtreeroot >= 0)
+			cullQuadNode(quadtreeroot, false, viewfrustum, horizon);
+
+		//These have not been replaced with new chunks yet
+		for(auto i : outsidegrid) {
+			cullstats.tests++;
+			const glm::vec3 &min = chunkmin.at(i), &max = chunkmax.at(i);
+			geo::AABB aabb((min + max) / 2.0f, max - min);
+			if(!geo::intersectsFrustum(viewfrustum, aabb))
+				continue;
+			if(horizon && horizon->occluded(min, max)) {
+				cullstats.occluded++;
 				continue;
+			}
+			visible.push_back(i);
+		}
+
+		cullstats.drawn = visible.size();
+		cullstats.culled = cullcandidates - cullstats.drawn - cullstats.occluded;
+		return cullstats.drawn;
+	}
 
+	unsigned int ChunkTable::draw(gfx::RenderQueue &queue, const gfx::Material &material)
+	{
+		for(auto index : visible) {
+			glm::vec3 center = chunkCenter(index);
 			glm::mat4 transform = glm::mat4(1.0f);
 			transform = glm::scale(transform, glm::vec3(SCALE));
-			transform = glm::translate(transform, glm::vec3(x, 0.0f, z));
-			shader.uniformMat4x4("transform", transform);
-			bindVao(i);
-			glDrawElements(GL_TRIANGLES, CHUNK_VERT_COUNT, GL_UNSIGNED_INT, 0);
-			drawCount++;
+			transform = glm::translate(transform, center);
+			queue.draw(
+				material,
+				vaoids.at(index),
+				CHUNK_VERT_COUNT,
+				center * SCALE,
+				{ gfx::uniform("transform"_sym, transform) }
+			);
 		}
+		return visible.size();
+	}
+
+	void ChunkTable::addOccluders(
+		geo::HorizonBuffer &horizon,
+		const glm::vec2 &center,
+		float minrange,
+		float maxrange
+	) {
+		for(int i = 0; i < count(); i++) {
+			const glm::vec3 &min = chunkmin.at(i), &max = chunkmax.at(i);
+			glm::vec2 pos = glm::vec2(min.x + max.x, min.z + max.z) / 2.0f;
+			glm::vec2 extent = glm::vec2(max.x - min.x, max.z - min.z) / 2.0f;
+
+			//Distance is measured the same way as in the terrain shader
+			glm::vec2 d = glm::abs(pos - center);
+			float outer = std::max(d.x + extent.x, d.y + extent.y);
+			float inner = std::max(d.x - extent.x, d.y - extent.y);
+			if(inner < minrange || (maxrange > 0.0f && outer > maxrange))
+				continue;
 
-		return drawCount;
+			float minheight = chunkbounds.at(i).minheight * HEIGHT * SCALE;
+			horizon.addOccluder(pos - extent, pos + extent, minheight);
+		}
 	}
 
 	float ChunkTable::scale() const
@@ -267,4 +443,9 @@ namespace infworld {
 	{
 		return (size - 1) / 2;
 	}
+
+	const ChunkCullStats& ChunkTable::getCullStats() const
+	{
+		return cullstats;
+	}
 }
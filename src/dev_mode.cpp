@@ -1,4 +1,6 @@
+#include "ecs.h"
 #include "game.h"
+#include "assets.h"
 #include "window.h"
 #include "gui.h"
 #include <SDL.h>
@@ -20,17 +22,20 @@ namespace game {
     game::generateChunks(permutations, chunktables, RANGE);
     infworld::DecorationTable decorations = infworld::DecorationTable(14, CHUNK_SZ);
     decorations.genDecorations(permutations);
-    gfx::generateDecorationOffsets(decorations);
+    gfx::setDecorationLods(decorations);
 
-    std::minstd_rand0 lcg;
-		lcg.seed(randSeed);
+    //Each spawn attempt draws its own values (see rng::random)
+    const uint32_t randomseed = infworld::getWorldSeed(permutations);
+    uint32_t spawnattempt = 0;
 		
     //Gameobjects
 		gameobjects::Player player(glm::vec3(0.0f, HEIGHT * SCALE * 0.5f, 0.0f));
+		const sym::Symbol planeModel = sym::intern(player.getPlayerObj());
 		std::vector<gameobjects::Bullet> bullets;
-		std::vector<gameobjects::Enemy> balloons;
+		//Balloons and barrels
+		ecs::World entities;
+		std::vector<game::EntityState> balloonStates, barrelStates;
 		std::vector<gameobjects::Explosion> explosions;
-		std::vector<gameobjects::Props> barrels;
 
   	float totalTime = 0.0f;
   	float dt = 0.0f;
@@ -45,42 +50,68 @@ namespace game {
 
     game::updateCamera(player);
     
+    gfx::RenderQueue queue;
+    gfx::GLQueueBackend backend;
+    geo::HorizonBuffer horizon(HORIZON_BINS);
+    gfx::FrameData frame;
+    gfx::FrameInput frameinput;
+    frameinput.chunktables = chunktables;
+    frameinput.maxlod = MAX_LOD;
+    frameinput.lodscale = LOD_SCALE;
+    frameinput.decorations = &decorations;
+    frameinput.balloons = &balloonStates;
+    frameinput.barrels = &barrelStates;
+    frameinput.explosions = &explosions;
+
     while (!window.shouldClose() && window.isRunnning()) {
         float startTime = getTime();
         window.pollEvents();
 
         gui.newFrame();
 
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        GFX->clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        //Culling and transforms are worked out on the job system first
+        frameinput.playertransform = player.transform;
+        frameinput.totalTime = totalTime;
+        entities.getStates(ecs::BALLOON, balloonStates);
+        entities.getStates(ecs::BARREL, barrelStates);
+        gfx::prepareFrame(frame, frameinput, horizon);
+        gui.dItems.framePrep = frame.timings;
+        gui.dItems.framePrepTotal = frame.totalms;
+        gui.dItems.particles = frame.particlestats;
+        queue.begin(window.getCamera().position, window.getZfar());
         //Draw terrain
-        unsigned int drawCount = gfx::displayTerrain(chunktables, MAX_LOD, LOD_SCALE);
+        unsigned int drawCount = gfx::displayTerrain(queue, chunktables, MAX_LOD, frame);
+        for(int i = 0; i < MAX_LOD; i++)
+          gui.dItems.terrainCulling[i] = chunktables[i].getCullStats();
         chunksPerSecond += drawCount;
         //Display trees
-        gfx::displayDecorations(decorations, totalTime);
+        gfx::displayDecorations(queue, decorations, totalTime);
+        gui.dItems.decorationCulling = decorations.getCullStats();
         //Display plane
         if(!player.crashed)
-           gfx::displayPlayerPlane(totalTime, player.transform, player.getPlayerObj());
+           gfx::displayPlayerPlane(queue, totalTime, player.transform, planeModel);
         //Display balloons
-        gfx::displayBalloons(balloons);
+        gfx::displayBalloons(queue, frame.balloons);
         //Display barrels
-        gfx::displayBarrels(barrels);
+        gfx::displayBarrels(queue, frame.barrels);
         //Display bullets
-        gfx::displayBullets(bullets);
+        gfx::displayBullets(queue, bullets);
         //Display water
-        gfx::displayWater(totalTime);
+        gfx::displayWater(queue, totalTime);
         //Draw skybox
-        gfx::displaySkybox();
+        gfx::displaySkybox(queue);
 
         if (!paused) {
 
           timers.update(dt);
           
           //Draw HUD Backgorunds
-          gfx::displayCrosshair(player.transform);
-          gfx::displayMiniMapBackground(totalTime);
-          gfx::displayEnemyMarkers(balloons, player.transform);
+          gfx::displayCrosshair(queue, player.transform);
+          gfx::displayMiniMapBackground(queue, totalTime);
+          gfx::displayEnemyMarkers(queue, frame.balloonmarkers);
           // gfx::displayPropMarkers(barrels, player.transform);
-          gfx::displayExplosions(explosions);
+          gfx::displayExplosions(queue, frame.particles, totalTime);
         
           game::updateCamera(player, dt);
           // to make the terrain infinite
@@ -125,24 +156,19 @@ namespace game {
   				game::checkBulletDist(bullets, player);
   				game::updateBullets(bullets, dt);
   				game::checkForBulletTerrainCollision(bullets, permutations);
-  				checkForHit(bullets, balloons, 24.0f);
-  				// checkForHit(bullets, blimps, 32.0f);
-  				// checkForHit(bullets, ufos, 14.0f);
-  				// checkForHit(bullets, planes, 12.0f);
+  				ecs::hit(entities, bullets);
 
           // Spawn Balloons
-          if(timers.getTimer("spawn_balloon")) spawnBalloons(player, balloons, lcg, permutations);
-          // Update Balloons
-          for( auto &balloon : balloons) balloon.updateBalloon(dt);
-          //Destroy any enemies that are too far away or have run out of health
-  				destroyEnemies(player, balloons, explosions, 1.0f, 24.0f, score);
-
+          if(timers.getTimer("spawn_balloon"_sym)) spawnBalloons(player, entities, randomseed, spawnattempt++, permutations);
           // Spawn Barrels
-          if(timers.getTimer("spawn_barrel")) spawnBarrels(player, barrels, lcg, permutations);
-          // Update Barrels
-          for( auto &barrel : barrels) barrel.updateBarrel(dt);
+          if(timers.getTimer("spawn_barrel"_sym)) spawnBarrels(player, entities, randomseed, spawnattempt++, permutations);
+          // Update Balloons and Barrels
+          ecs::bob(entities);
+          ecs::move(entities, dt);
           //Destroy any enemies that are too far away or have run out of health
-  				destroyProps(player, barrels, explosions, 1.0f, 24.0f, score);
+  				ecs::destroy(entities, player, explosions, score);
+  				ecs::cull(entities, player.transform.position, ecs::CULL_DIST);
+  				entities.removeDead();
   				
           gui.drawHUD();
         
@@ -174,6 +200,11 @@ namespace game {
           gui.drawUI();
         }
 
+        //Everything was only queued up until now
+        queue.submit(backend);
+        gui.dItems.renderStats = queue.getStats();
+        assets::updateResidency();
+
         gui.render();
 
         window.swapBuffers();
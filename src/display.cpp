@@ -1,9 +1,14 @@
 #include "assets.h"
 #include "game.h"
 #include "glm/ext/matrix_transform.hpp"
+#include "horizon.h"
+#include "impostor.h"
 #include "infworld.h"
 #include "opengl.h"
+#include "renderqueue.h"
 #include "window.h"
+#include <algorithm>
+#include <float.h>
 #include <glm/gtc/matrix_transform.hpp>
 
 // Just debug colors for different terrain LOD levels
@@ -13,196 +18,260 @@ constexpr glm::vec3 TERRAIN_LOD_COLORS[] = {
     glm::vec3(1.0f, 0.0f, 1.0f),
 };
 
-constexpr float MINIMAP_SIZE = 100.0f;
 constexpr float ATTITUDE_SIZE = 120.0f;
 
 namespace gobjs = gameobjects;
 
+
 namespace gfx {
-void displaySkybox() {
+// Builds a material from the names of a shader and a texture,
+// an empty texture name means that no texture is bound
+Material getMaterial(RenderPass pass, sym::Symbol shadername,
+                     sym::Symbol texturename, uint8_t state,
+                     UniformRange shared = UniformRange()) {
+  Material material;
+  material.pass = pass;
+  material.shader = &SHADERS->getShader(shadername);
+  if (!texturename.empty()) {
+    assets::TextureInfo texture = TEXTURES->getTexture(texturename);
+    material.texturetarget = texture.target;
+    material.textureid = texture.id;
+  }
+  material.state = state;
+  material.shared = shared;
+  return material;
+}
+
+// Uniforms shared by everything drawn with the 'textured' shader
+UniformRange addTexturedUniforms(RenderQueue &queue, float specularfactor) {
+  Window &window = Window::getInstance();
+  Camera &cam = window.getCamera();
+  return queue.addUniforms({
+      uniform("persp"_sym, window.getPerspective()),
+      uniform("view"_sym, cam.viewMatrix()),
+      uniform("lightdir"_sym, LIGHT),
+      uniform("camerapos"_sym, cam.position),
+      uniform("specularfactor"_sym, specularfactor),
+  });
+}
+
+// Matrix that converts pixel coordinates to screen coordinates
+glm::mat4 getScreenMatrix() {
+  Window &window = Window::getInstance();
+  int w = window.getWidth(), h = window.getHeight();
+  return glm::scale(glm::mat4(1.0f),
+                    glm::vec3(2.0f / float(w), 2.0f / float(h), 0.0f));
+}
+
+void displaySkybox(RenderQueue &queue) {
   Window &window = Window::getInstance();
   Camera &cam = window.getCamera();
 
   // Draw skybox - render at max depth so it appears behind everything
-  glDepthFunc(GL_LEQUAL);
-  glCullFace(GL_FRONT);
-  TEXTURES->bindTexture("skybox", GL_TEXTURE0);
-  ShaderProgram &skyboxShader = SHADERS->getShader("skybox");
-  skyboxShader.use();
-
-  // Uniforms
-  skyboxShader.uniformInt("skybox", 0);
-  skyboxShader.uniformMat4x4("persp", window.getPerspective());
+  const uint8_t state =
+      STATE_DEPTH_TEST | STATE_DEPTH_WRITE | STATE_DEPTH_LEQUAL | STATE_CULL_FRONT;
+  Material material = getMaterial(PASS_SKY, "skybox"_sym, "skybox"_sym, state);
   glm::mat4 skyboxView = glm::mat4(glm::mat3(cam.viewMatrix()));
-  skyboxShader.uniformMat4x4("view", skyboxView);
-
-  VAOS->bind("cube");
-  VAOS->draw();
-  glCullFace(GL_BACK);
-  glDepthFunc(GL_LESS);
+  const gfx::Vao &cube = VAOS->getVao("cube"_sym);
+  queue.draw(material, cube, cam.position,
+             {
+                 uniform("skybox"_sym, 0),
+                 uniform("persp"_sym, window.getPerspective()),
+                 uniform("view"_sym, skyboxView),
+             });
 }
 
-void displayWater(float totalTime) {
+void displayWater(RenderQueue &queue, float totalTime) {
   Window &window = Window::getInstance();
   Camera &cam = window.getCamera();
 
-  VAOS->bind("quad");
   const int waterrange = 4;
   const int count = (waterrange * 2 + 1) * (waterrange * 2 + 1);
   const float quadscale = CHUNK_SZ * 32.0f * SCALE;
   // Draw water
-  ShaderProgram &waterShader = SHADERS->getShader("water");
-  waterShader.use();
-  TEXTURES->bindTexture("watermaps", GL_TEXTURE0);
-  waterShader.uniformInt("range", waterrange);
-  waterShader.uniformFloat("scale", quadscale);
-  waterShader.uniformInt("waternormals", 0);
-  waterShader.uniformInt("waterdudv", 1);
-  waterShader.uniformMat4x4("persp", window.getPerspective());
-  waterShader.uniformMat4x4("view", cam.viewMatrix());
-  waterShader.uniformVec3("lightdir", glm::normalize(glm::vec3(-1.0f)));
-  waterShader.uniformVec3("camerapos", cam.position);
-  waterShader.uniformFloat("time", totalTime);
+  Material material =
+      getMaterial(PASS_OPAQUE, "water"_sym, "watermaps"_sym, STATE_DEFAULT);
   glm::mat4 transform = glm::mat4(1.0f);
   transform = glm::translate(transform,
                              glm::vec3(cam.position.x, 0.0f, cam.position.z));
   transform = glm::scale(transform, glm::vec3(quadscale));
-  waterShader.uniformMat4x4("transform", transform);
-  VAOS->drawInstanced(count);
+  const gfx::Vao &quad = VAOS->getVao("quad"_sym);
+  queue.draw(material, quad, cam.position,
+             {
+                 uniform("range"_sym, waterrange),
+                 uniform("scale"_sym, quadscale),
+                 uniform("waternormals"_sym, 0),
+                 uniform("waterdudv"_sym, 1),
+                 uniform("persp"_sym, window.getPerspective()),
+                 uniform("view"_sym, cam.viewMatrix()),
+                 uniform("lightdir"_sym, glm::normalize(glm::vec3(-1.0f))),
+                 uniform("camerapos"_sym, cam.position),
+                 uniform("time"_sym, totalTime),
+                 uniform("transform"_sym, transform),
+             },
+             count);
+}
+
+namespace {
+// World space distance where trees have fully turned into impostors and
+// the width of the fade, trees never fade if there are no impostors
+float impostordistance = FLT_MAX;
+float impostorfade = 1.0f;
+
+// The 3d models of a tree type are used from 0 to 2, 2 to 4 and 4 to
+// 'maxdist' chunk widths, with impostors the models stop at the first chunk
+// that can not have a tree before the end of the fade and the impostors
+// start at the first chunk that can have a tree in the fade
+void setTreeLods(infworld::DecorationTable &decorations,
+                 infworld::DecorationType type, const std::string &name,
+                 float maxdist) {
+  const float w = decorations.chunkWidth();
+  // Trees can be up to half a chunk diagonal away from the chunk center
+  const float margin = w * 0.75f;
+  const bool impostors = impostordistance < FLT_MAX;
+  const float cutoff =
+      impostors ? std::min(maxdist, impostordistance + margin) : maxdist;
+  const float bounds[] = {0.0f, w * 2.0f, w * 4.0f, maxdist};
+  const std::string models[] = {name, name + "mediumdetail",
+                                name + "lowdetail"};
+  for (int i = 0; i < 3; i++) {
+    float end = std::min(bounds[i + 1], cutoff);
+    decorations.setLod(type, VAOS->getVao(sym::intern(models[i])),
+                       std::min(bounds[i], end), end);
+  }
+  if (impostors) {
+    float start = std::max(impostordistance - impostorfade - margin, 0.0f);
+    decorations.setLod(type, VAOS->getVao(sym::intern(name + "impostor")),
+                       start, maxdist);
+  }
 }
 
-void generateDecorationOffsets(infworld::DecorationTable &decorations) {
-  decorations.generateOffsets(infworld::PINE_TREE, VAOS->getVao("pinetree"), 0,
-                              4);
-  decorations.generateOffsets(infworld::PINE_TREE,
-                              VAOS->getVao("pinetreelowdetail"), 4, 999);
-  decorations.generateOffsets(infworld::TREE, VAOS->getVao("tree"), 0, 4);
-  decorations.generateOffsets(infworld::TREE, VAOS->getVao("treelowdetail"), 4,
-                              8);
+void displayImpostors(RenderQueue &queue,
+                      infworld::DecorationTable &decorations,
+                      sym::Symbol name, uint8_t state) {
+  const impostor::Atlas *atlas = impostor::get(name);
+  if (!atlas)
+    return;
+  Window &window = Window::getInstance();
+  Camera &cam = window.getCamera();
+  UniformRange shared = queue.addUniforms({
+      uniform("persp"_sym, window.getPerspective()),
+      uniform("view"_sym, cam.viewMatrix()),
+      uniform("camerapos"_sym, cam.position),
+      uniform("scale"_sym, SCALE * 2.5f),
+      uniform("radius"_sym, atlas->radius),
+      uniform("bottom"_sym, atlas->bottom),
+      uniform("top"_sym, atlas->top),
+      uniform("impostordist"_sym, impostordistance),
+      uniform("impostorfade"_sym, impostorfade),
+      uniform("chunkwidth"_sym, decorations.chunkWidth()),
+  });
+  Material material =
+      getMaterial(PASS_OPAQUE, "impostor"_sym, atlas->texture, state, shared);
+  decorations.drawDecorations(queue, material, VAOS->getVao(name));
+}
+} // namespace
+
+void setDecorationLods(infworld::DecorationTable &decorations,
+                       float impostordist) {
+  const float w = decorations.chunkWidth();
+  const bool baked = impostor::get("pinetreeimpostor"_sym) &&
+                     impostor::get("treeimpostor"_sym);
+  impostordistance = baked ? impostordist * w : FLT_MAX;
+  impostorfade = IMPOSTOR_FADE * w;
+  setTreeLods(decorations, infworld::PINE_TREE, "pinetree", FLT_MAX);
+  setTreeLods(decorations, infworld::TREE, "tree", w * 8.0f);
 }
 
-void displayDecorations(infworld::DecorationTable &decorations,
+void displayDecorations(RenderQueue &queue,
+                        infworld::DecorationTable &decorations,
                         float totalTime) {
   Window &window = Window::getInstance();
   Camera &cam = window.getCamera();
 
-  glDisable(GL_CULL_FACE);
+  decorations.upload();
+
   // Display trees
-  ShaderProgram &treeShader = SHADERS->getShader("tree");
-  treeShader.use();
-  treeShader.uniformMat4x4("persp", window.getPerspective());
-  treeShader.uniformMat4x4("view", cam.viewMatrix());
-  treeShader.uniformVec3("lightdir", glm::normalize(glm::vec3(-1.0f)));
-  treeShader.uniformVec3("camerapos", cam.position);
-  treeShader.uniformFloat("time", totalTime);
-  treeShader.uniformFloat("windstrength", SCALE * 3.0f);
-  treeShader.uniformMat4x4(
-      "transform", glm::scale(glm::mat4(1.0f), glm::vec3(SCALE * 2.5f)));
-  // treeShader.uniformFloat("specularfactor", 0.0f);
-  treeShader.uniformVec3("camerapos", cam.position);
+  UniformRange shared = queue.addUniforms({
+      uniform("persp"_sym, window.getPerspective()),
+      uniform("view"_sym, cam.viewMatrix()),
+      uniform("lightdir"_sym, glm::normalize(glm::vec3(-1.0f))),
+      uniform("camerapos"_sym, cam.position),
+      uniform("time"_sym, totalTime),
+      uniform("windstrength"_sym, SCALE * 3.0f),
+      uniform("transform"_sym,
+              glm::scale(glm::mat4(1.0f), glm::vec3(SCALE * 2.5f))),
+      uniform("impostordist"_sym, impostordistance),
+      uniform("impostorfade"_sym, impostorfade),
+      uniform("chunkwidth"_sym, decorations.chunkWidth()),
+  });
+  // Trees are not culled
+  const uint8_t state = STATE_DEPTH_TEST | STATE_DEPTH_WRITE;
   // Draw pine trees
-  TEXTURES->bindTexture("pinetree", GL_TEXTURE0);
-  VAOS->bind("pinetree");
-  decorations.drawDecorations(VAOS->getVao("pinetree"));
-  VAOS->bind("pinetreelowdetail");
-  decorations.drawDecorations(VAOS->getVao("pinetreelowdetail"));
+  Material pinetree =
+      getMaterial(PASS_OPAQUE, "tree"_sym, "pinetree"_sym, state, shared);
+  decorations.drawDecorations(queue, pinetree, VAOS->getVao("pinetree"_sym));
+  decorations.drawDecorations(queue, pinetree,
+                              VAOS->getVao("pinetreemediumdetail"_sym));
+  decorations.drawDecorations(queue, pinetree,
+                              VAOS->getVao("pinetreelowdetail"_sym));
   // Draw trees
-  TEXTURES->bindTexture("tree", GL_TEXTURE0);
-  VAOS->bind("tree");
-  decorations.drawDecorations(VAOS->getVao("tree"));
-  VAOS->bind("treelowdetail");
-  decorations.drawDecorations(VAOS->getVao("treelowdetail"));
-  glEnable(GL_CULL_FACE);
+  Material tree =
+      getMaterial(PASS_OPAQUE, "tree"_sym, "tree"_sym, state, shared);
+  decorations.drawDecorations(queue, tree, VAOS->getVao("tree"_sym));
+  decorations.drawDecorations(queue, tree,
+                              VAOS->getVao("treemediumdetail"_sym));
+  decorations.drawDecorations(queue, tree, VAOS->getVao("treelowdetail"_sym));
+  // Distant trees
+  displayImpostors(queue, decorations, "pinetreeimpostor"_sym, state);
+  displayImpostors(queue, decorations, "treeimpostor"_sym, state);
 }
 
-unsigned int displayTerrain(infworld::ChunkTable *chunktables, int maxlod,
-                            float lodscale) {
+unsigned int displayTerrain(RenderQueue &queue,
+                            infworld::ChunkTable *chunktables, int maxlod,
+                            const FrameData &frame) {
   Window &window = Window::getInstance();
   Camera &cam = window.getCamera();
-  ShaderProgram &terrainShader = SHADERS->getShader("terrain");
-
-  // Draw terrain
-  terrainShader.use();
-  // Textures
-  TEXTURES->bindTexture("terrain", GL_TEXTURE0);
-  terrainShader.uniformInt("terraintexture", 0);
-  // uniforms
-  terrainShader.uniformMat4x4("persp", window.getPerspective());
-  terrainShader.uniformMat4x4("view", cam.viewMatrix());
-  terrainShader.uniformVec3("lightdir", glm::normalize(glm::vec3(-1.0f)));
-  terrainShader.uniformVec3("camerapos", cam.position);
-  unsigned int drawCount = 0;
-
-  geo::Frustum viewfrustum =
-      cam.getViewFrustum(window.getZnear(), window.getZfar(),
-                         window.getAspect(), window.getFovy());
 
-  infworld::ChunkPos center = chunktables[0].getCenter();
-  glm::vec2 centerpos = glm::vec2(float(center.z), float(center.x));
-  centerpos *= float(PREC) / float(PREC + 1);
-  centerpos *= chunktables[0].scale() * SCALE * 2.0f;
-  terrainShader.uniformVec2("center", centerpos);
-
-  float mindist = 0.0f;
+  unsigned int drawCount = 0;
   for (int i = 0; i < maxlod; i++) {
-    terrainShader.uniformVec3("testcolor", TERRAIN_LOD_COLORS[i]);
-    terrainShader.uniformFloat("chunksz", chunktables[i].scale());
-
-    if (i < maxlod - 1) {
-      float chunkscale =
-          chunktables[i].scale() * 2.0f * float(PREC) / float(PREC + 1);
-      float range = float(chunktables[i].range()) - 0.5f;
-      // Slight amount of overlap to mitigate cracks in terrain
-      // We increase this amount due to the terrain becoming less precise
-      // and more likely to have cracks
-      float d = 8.0f * float(i) + 4.0f;
-      float maxrange = chunkscale * range * SCALE + d;
-
-      terrainShader.uniformFloat("minrange", mindist);
-      terrainShader.uniformFloat("maxrange", maxrange);
-
-      mindist = maxrange - 2.0f * d;
-    } else {
-      terrainShader.uniformFloat("minrange", mindist);
-      terrainShader.uniformFloat("maxrange", -1.0f);
-    }
-
-    if (i == 0)
-      drawCount += chunktables[i].draw(terrainShader, viewfrustum);
-    else {
-      int minrange = chunktables[i - 1].range() / int(lodscale);
-      drawCount +=
-          chunktables[i].draw(terrainShader, minrange - 1, viewfrustum);
-    }
+    // Every chunk in a LOD shares these uniforms
+    UniformRange shared = queue.addUniforms({
+        uniform("terraintexture"_sym, 0),
+        uniform("persp"_sym, window.getPerspective()),
+        uniform("view"_sym, cam.viewMatrix()),
+        uniform("lightdir"_sym, glm::normalize(glm::vec3(-1.0f))),
+        uniform("camerapos"_sym, cam.position),
+        uniform("center"_sym, frame.terraincenter),
+        uniform("testcolor"_sym, TERRAIN_LOD_COLORS[i]),
+        uniform("chunksz"_sym, chunktables[i].scale()),
+        uniform("minrange"_sym, frame.terrainranges[i].x),
+        uniform("maxrange"_sym, frame.terrainranges[i].y),
+    });
+    Material material = getMaterial(PASS_OPAQUE, "terrain"_sym, "terrain"_sym,
+                                    STATE_DEFAULT, shared);
+    drawCount += chunktables[i].draw(queue, material);
   }
 
   return drawCount;
 }
 
-void displayPlayerPlane(float totalTime, const game::Transform &transform,
-                        const std::string &plane_model) {
-  Window &window = Window::getInstance();
-  Camera &cam = window.getCamera();
-  ShaderProgram &shader = SHADERS->getShader("textured");
-
-  shader.use();
-  shader.uniformMat4x4("persp", window.getPerspective());
-  shader.uniformMat4x4("view", cam.viewMatrix());
-  shader.uniformVec3("lightdir", LIGHT);
-  shader.uniformVec3("camerapos", cam.position);
-
+void displayPlayerPlane(RenderQueue &queue, float totalTime,
+                        const game::Transform &transform,
+                        sym::Symbol plane_model) {
   // Display plane body
   glm::mat4 transformMat = transform.getTransformMat();
   glm::mat4 normal = glm::mat3(glm::transpose(glm::inverse(transformMat)));
-  TEXTURES->bindTexture(plane_model, GL_TEXTURE0);
-  shader.uniformFloat("specularfactor", 0.5f);
-  shader.uniformMat4x4("transform", transformMat);
-  shader.uniformMat3x3("normalmat", normal);
-  VAOS->bind(plane_model);
-  VAOS->draw();
+  Material body = getMaterial(PASS_OPAQUE, "textured"_sym, plane_model,
+                              STATE_DEFAULT, addTexturedUniforms(queue, 0.5f));
+  const gfx::Vao &bodyvao = VAOS->getVao(plane_model);
+  queue.draw(body, bodyvao, transform.position,
+             {
+                 uniform("transform"_sym, transformMat),
+                 uniform("normalmat"_sym, glm::mat3(normal)),
+             });
 
   // Display propeller
-  TEXTURES->bindTexture("propeller", GL_TEXTURE0);
   glm::mat4 propellerTransform = glm::mat4(1.0f);
   propellerTransform =
       glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 4.0f));
@@ -213,202 +282,130 @@ void displayPlayerPlane(float totalTime, const game::Transform &transform,
       glm::rotate(propellerTransform, rotation, glm::vec3(0.0f, 0.0f, 1.0f));
   propellerTransform = transformMat * propellerTransform;
   normal = glm::mat3(glm::transpose(glm::inverse(propellerTransform)));
-  shader.uniformFloat("specularfactor", 0.0f);
-  shader.uniformMat4x4("transform", propellerTransform);
-  shader.uniformMat3x3("normalmat", normal);
-  VAOS->bind("propeller");
-  VAOS->draw();
+  Material propeller =
+      getMaterial(PASS_OPAQUE, "textured"_sym, "propeller"_sym, STATE_DEFAULT,
+                  addTexturedUniforms(queue, 0.0f));
+  const gfx::Vao &propellervao = VAOS->getVao("propeller"_sym);
+  queue.draw(propeller, propellervao, transform.position,
+             {
+                 uniform("transform"_sym, propellerTransform),
+                 uniform("normalmat"_sym, glm::mat3(normal)),
+             });
 }
 
-void displayExplosions(const std::vector<gobjs::Explosion> &explosions) {
-  if (explosions.empty())
-    return;
+void displayExplosions(RenderQueue &queue,
+                       const std::vector<ParticleInstance> &particles,
+                       float totalTime) {
+  static_assert(sizeof(ParticleInstance) == 7 * sizeof(float),
+                "ParticleInstance must match the particle vao layout");
 
-  Window &window = Window::getInstance();
-
-  glEnable(GL_BLEND);
-  glDisable(GL_DEPTH_TEST);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  glDisable(GL_CULL_FACE);
-  glDepthMask(GL_FALSE);
-  VAOS->bind("quad");
-  SHADERS->use("explosion");
-  TEXTURES->bindTexture("explosion_particle", GL_TEXTURE0);
-  ShaderProgram &shader = SHADERS->getShader("explosion");
-  shader.uniformMat4x4("persp", window.getPerspective());
-  shader.uniformMat4x4("view", window.getCamera().viewMatrix());
-  for (const auto &explosion : explosions) {
-    if (!explosion.visible)
-      continue;
-    shader.uniformFloat("time", explosion.timePassed);
-    shader.uniformFloat("scale", explosion.explosionScale);
-    shader.uniformMat4x4("transform", explosion.transform.getTransformMat());
-    VAOS->drawInstanced(128);
-  }
-  glDepthMask(GL_TRUE);
-  glEnable(GL_CULL_FACE);
-  glDisable(GL_BLEND);
-  glEnable(GL_DEPTH_TEST);
-}
-
-void displayBalloons(const std::vector<gameobjects::Enemy> &balloons) {
-  if (balloons.empty())
+  if (particles.empty())
     return;
+
   Window &window = Window::getInstance();
-  Camera &cam = window.getCamera();
 
-  glDisable(GL_CULL_FACE);
-  VAOS->bind("balloon");
-  SHADERS->use("textured");
-  TEXTURES->bindTexture("balloon", GL_TEXTURE0);
-  ShaderProgram &shader = SHADERS->getShader("textured");
-  shader.uniformMat4x4("persp", window.getPerspective());
-  shader.uniformMat4x4("view", cam.viewMatrix());
-  shader.uniformFloat("specularfactor", 0.0f);
-  shader.uniformVec3("lightdir", LIGHT);
-  shader.uniformVec3("camerapos", cam.position);
-  for (const auto &balloon : balloons) {
-    glm::mat4 transform = balloon.transform.getTransformMat();
-    glm::mat3 normal = glm::mat3(glm::transpose(glm::inverse(transform)));
-    shader.uniformMat4x4("transform", transform);
-    shader.uniformMat3x3("normalmat", normal);
-    VAOS->draw();
-  }
-  glEnable(GL_CULL_FACE);
+  // The instance buffer was sized for MAX_PARTICLES when the vao was
+  // created so it only ever gets overwritten
+  const gfx::Vao &vao = VAOS->getVao("particles"_sym);
+  unsigned int count = std::min<size_t>(particles.size(), MAX_PARTICLES);
+  GFX->bindBuffer(GL_ARRAY_BUFFER, vao.buffers.at(2));
+  GFX->bufferSubData(GL_ARRAY_BUFFER, 0, sizeof(ParticleInstance) * count,
+                     particles.data());
+  GFX->bindBuffer(GL_ARRAY_BUFFER, 0);
+
+  // Blended, no depth test and no culling
+  UniformRange shared = queue.addUniforms({
+      uniform("persp"_sym, window.getPerspective()),
+      uniform("view"_sym, window.getCamera().viewMatrix()),
+      uniform("time"_sym, totalTime),
+  });
+  Material material =
+      getMaterial(PASS_TRANSPARENT, "explosion"_sym, "explosion_particle"_sym,
+                  STATE_BLEND, shared);
+  // The particles are already in back to front order so they all go in
+  // one draw, the nearest explosion is used for sorting it
+  queue.draw(material, vao, particles.back().center,
+             UniformRange(), count);
 }
-void displayBarrels(const std::vector<gameobjects::Props> &barrels) {
-  if (barrels.empty())
-    return;
-  Window &window = Window::getInstance();
-  Camera &cam = window.getCamera();
 
-  glDisable(GL_CULL_FACE);
-  VAOS->bind("barrel");
-  SHADERS->use("textured");
-  TEXTURES->bindTexture("barrel", GL_TEXTURE0);
-  ShaderProgram &shader = SHADERS->getShader("textured");
-  shader.uniformMat4x4("persp", window.getPerspective());
-  shader.uniformMat4x4("view", cam.viewMatrix());
-  shader.uniformFloat("specularfactor", 0.0f);
-  shader.uniformVec3("lightdir", LIGHT);
-  shader.uniformVec3("camerapos", cam.position);
-  for (const auto &barrel : barrels) {
-    glm::mat4 transform = barrel.transform.getTransformMat();
-    glm::mat3 normal = glm::mat3(glm::transpose(glm::inverse(transform)));
-    shader.uniformMat4x4("transform", transform);
-    shader.uniformMat3x3("normalmat", normal);
-    VAOS->draw();
-  }
-  glEnable(GL_CULL_FACE);
+// Returns true if a sphere around 'position' is hidden behind the terrain
+bool hiddenByTerrain(const geo::HorizonBuffer &horizon,
+                     const glm::vec3 &position, float radius) {
+  return horizon.occluded(position - glm::vec3(radius),
+                          position + glm::vec3(radius));
 }
 
-void displayShips(const std::vector<gameobjects::Enemy> &ships) {
-  if (ships.empty())
+// Draws objects that were packed with packObjects using the textured shader
+void drawObjects(RenderQueue &queue, const std::vector<ObjectInstance> &objects,
+                 sym::Symbol model, sym::Symbol texture,
+                 float specularfactor, uint8_t state) {
+  if (objects.empty())
     return;
-  Window &window = Window::getInstance();
-  Camera &cam = window.getCamera();
 
-  glDisable(GL_CULL_FACE);
-  VAOS->bind("warship");
-  SHADERS->use("textured");
-  TEXTURES->bindTexture("barrel", GL_TEXTURE0);
-  ShaderProgram &shader = SHADERS->getShader("textured");
-  shader.uniformMat4x4("persp", window.getPerspective());
-  shader.uniformMat4x4("view", cam.viewMatrix());
-  shader.uniformFloat("specularfactor", 0.3f);
-  shader.uniformVec3("lightdir", LIGHT);
-  shader.uniformVec3("camerapos", cam.position);
-
-  for (const auto &ship : ships) {
-    glm::mat4 transform = ship.transform.getTransformMat();
-    transform = glm::scale(transform, glm::vec3(14.0f, 14.0f, 14.0f));
-    glm::mat3 normal = glm::mat3(glm::transpose(glm::inverse(transform)));
-    shader.uniformMat4x4("transform", transform);
-    shader.uniformMat3x3("normalmat", normal);
-    VAOS->draw();
+  Material material = getMaterial(PASS_OPAQUE, "textured"_sym, texture, state,
+                                  addTexturedUniforms(queue, specularfactor));
+  const gfx::Vao &vao = VAOS->getVao(model);
+  for (const auto &object : objects) {
+    queue.draw(material, vao, object.position,
+               {
+                   uniform("transform"_sym, object.transform),
+                   uniform("normalmat"_sym, object.normal),
+               });
   }
-  glEnable(GL_CULL_FACE);
 }
 
-void displayBlimps(const std::vector<gameobjects::Enemy> &blimps) {
-  if (blimps.empty())
-    return;
-
-  Window &window = Window::getInstance();
-  Camera &cam = window.getCamera();
+void displayBalloons(RenderQueue &queue,
+                     const std::vector<ObjectInstance> &balloons) {
+  drawObjects(queue, balloons, "balloon"_sym, "balloon"_sym, 0.0f,
+              STATE_DEPTH_TEST | STATE_DEPTH_WRITE);
+}
 
-  VAOS->bind("blimp");
-  SHADERS->use("textured");
-  TEXTURES->bindTexture("blimp", GL_TEXTURE0);
-  ShaderProgram &shader = SHADERS->getShader("textured");
-  shader.uniformMat4x4("persp", window.getPerspective());
-  shader.uniformMat4x4("view", cam.viewMatrix());
-  shader.uniformFloat("specularfactor", 0.1f);
-  shader.uniformVec3("lightdir", LIGHT);
-  shader.uniformVec3("camerapos", cam.position);
-  for (const auto &blimp : blimps) {
-    glm::mat4 transform = blimp.transform.getTransformMat();
-    glm::mat3 normal = glm::mat3(glm::transpose(glm::inverse(transform)));
-    shader.uniformMat4x4("transform", transform);
-    shader.uniformMat3x3("normalmat", normal);
-    VAOS->draw();
-  }
+void displayBarrels(RenderQueue &queue,
+                    const std::vector<ObjectInstance> &barrels) {
+  drawObjects(queue, barrels, "barrel"_sym, "barrel"_sym, 0.0f,
+              STATE_DEPTH_TEST | STATE_DEPTH_WRITE);
 }
 
-void displayUfos(const std::vector<gameobjects::Enemy> &ufos) {
-  if (ufos.empty())
-    return;
+void displayShips(RenderQueue &queue, const std::vector<ObjectInstance> &ships) {
+  drawObjects(queue, ships, "warship"_sym, "barrel"_sym, 0.3f,
+              STATE_DEPTH_TEST | STATE_DEPTH_WRITE);
+}
 
-  Window &window = Window::getInstance();
-  Camera &cam = window.getCamera();
+void displayBlimps(RenderQueue &queue,
+                   const std::vector<game::EntityState> &blimps,
+                   const geo::HorizonBuffer &horizon) {
+  std::vector<ObjectInstance> instances;
+  packObjects(blimps, horizon, 64.0f, 1.0f, instances);
+  drawObjects(queue, instances, "blimp"_sym, "blimp"_sym, 0.1f, STATE_DEFAULT);
+}
 
-  VAOS->bind("ufo");
-  SHADERS->use("textured");
-  TEXTURES->bindTexture("ufo", GL_TEXTURE0);
-  ShaderProgram &shader = SHADERS->getShader("textured");
-  shader.uniformMat4x4("persp", window.getPerspective());
-  shader.uniformMat4x4("view", cam.viewMatrix());
-  shader.uniformFloat("specularfactor", 1.0f);
-  shader.uniformVec3("lightdir", LIGHT);
-  shader.uniformVec3("camerapos", cam.position);
-  for (const auto &ufo : ufos) {
-    glm::mat4 transform = ufo.transform.getTransformMat();
-    glm::mat3 normal = glm::mat3(glm::transpose(glm::inverse(transform)));
-    shader.uniformMat4x4("transform", transform);
-    shader.uniformMat3x3("normalmat", normal);
-    VAOS->draw();
-  }
+void displayUfos(RenderQueue &queue,
+                 const std::vector<game::EntityState> &ufos,
+                 const geo::HorizonBuffer &horizon) {
+  std::vector<ObjectInstance> instances;
+  packObjects(ufos, horizon, 32.0f, 1.0f, instances);
+  drawObjects(queue, instances, "ufo"_sym, "ufo"_sym, 1.0f, STATE_DEFAULT);
 }
 
-void displayPlanes(float totalTime,
-                   const std::vector<gameobjects::Enemy> &planes) {
+void displayPlanes(RenderQueue &queue, float totalTime,
+                   const std::vector<game::EntityState> &planes,
+                   const geo::HorizonBuffer &horizon) {
   if (planes.empty())
     return;
 
-  Window &window = Window::getInstance();
-  Camera &cam = window.getCamera();
-
-  VAOS->bind("plane");
-  SHADERS->use("textured");
-  TEXTURES->bindTexture("enemy_plane", GL_TEXTURE0);
-  ShaderProgram &shader = SHADERS->getShader("textured");
-  shader.uniformMat4x4("persp", window.getPerspective());
-  shader.uniformMat4x4("view", cam.viewMatrix());
-  shader.uniformFloat("specularfactor", 0.5f);
-  shader.uniformVec3("lightdir", LIGHT);
-  shader.uniformVec3("camerapos", cam.position);
-  for (const auto &plane : planes) {
-    glm::mat4 transform = plane.transform.getTransformMat();
-    glm::mat3 normal = glm::mat3(glm::transpose(glm::inverse(transform)));
-    shader.uniformMat4x4("transform", transform);
-    shader.uniformMat3x3("normalmat", normal);
-    VAOS->draw();
-  }
+  const float radius = 32.0f;
+  std::vector<ObjectInstance> instances;
+  packObjects(planes, horizon, radius, 1.0f, instances);
+  drawObjects(queue, instances, "plane"_sym, "enemy_plane"_sym, 0.5f,
+              STATE_DEFAULT);
 
-  shader.uniformFloat("specularfactor", 0.0f);
-  VAOS->bind("propeller");
-  TEXTURES->bindTexture("propeller", GL_TEXTURE0);
+  Material propeller =
+      getMaterial(PASS_OPAQUE, "textured"_sym, "propeller"_sym, STATE_DEFAULT,
+                  addTexturedUniforms(queue, 0.0f));
+  const gfx::Vao &vao = VAOS->getVao("propeller"_sym);
   for (const auto &plane : planes) {
+    if (hiddenByTerrain(horizon, plane.transform.position, radius))
+      continue;
     glm::mat4 propellerTransform = glm::mat4(1.0f);
     propellerTransform =
         glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 13.888f));
@@ -418,128 +415,118 @@ void displayPlanes(float totalTime,
     propellerTransform = plane.transform.getTransformMat() * propellerTransform;
     glm::mat3 normal =
         glm::mat3(glm::transpose(glm::inverse(propellerTransform)));
-    shader.uniformMat4x4("transform", propellerTransform);
-    shader.uniformMat3x3("normalmat", normal);
-    VAOS->draw();
+    queue.draw(propeller, vao, plane.transform.position,
+               {
+                   uniform("transform"_sym, propellerTransform),
+                   uniform("normalmat"_sym, normal),
+               });
   }
 }
 
-void displayBullets(const std::vector<gameobjects::Bullet> &bullets) {
+void displayBullets(RenderQueue &queue,
+                    const std::vector<gameobjects::Bullet> &bullets) {
   if (bullets.empty())
     return;
 
   Window &window = Window::getInstance();
   Camera &cam = window.getCamera();
 
-  VAOS->bind("bullet");
-  TEXTURES->bindTexture("bullet", GL_TEXTURE0);
-  SHADERS->use("trail");
-  ShaderProgram &trailshader = SHADERS->getShader("trail");
-  trailshader.uniformMat4x4("persp", window.getPerspective());
-  trailshader.uniformMat4x4("view", cam.viewMatrix());
-  trailshader.uniformFloat("specularfactor", 1.0f);
-  trailshader.uniformVec3("lightdir", LIGHT);
-  trailshader.uniformVec3("camerapos", cam.position);
+  UniformRange shared = queue.addUniforms({
+      uniform("persp"_sym, window.getPerspective()),
+      uniform("view"_sym, cam.viewMatrix()),
+      uniform("specularfactor"_sym, 1.0f),
+      uniform("lightdir"_sym, LIGHT),
+      uniform("camerapos"_sym, cam.position),
+  });
+  Material material = getMaterial(PASS_OPAQUE, "trail"_sym, "bullet"_sym,
+                                  STATE_DEFAULT, shared);
+  const gfx::Vao &vao = VAOS->getVao("bullet"_sym);
   for (const auto &bullet : bullets) {
     glm::mat4 transform = bullet.transform.getTransformMat();
     glm::mat3 normal = glm::mat3(glm::transpose(glm::inverse(transform)));
     glm::vec3 velocity = bullet.transform.direction() * BULLET_SPEED;
-    trailshader.uniformFloat("time", bullet.time);
-    trailshader.uniformVec3("velocity", velocity);
-    trailshader.uniformMat4x4("transform", transform);
-    trailshader.uniformMat3x3("normalmat", normal);
-    VAOS->drawInstanced(32);
+    queue.draw(material, vao, bullet.transform.position,
+               {
+                   uniform("time"_sym, bullet.time),
+                   uniform("velocity"_sym, velocity),
+                   uniform("transform"_sym, transform),
+                   uniform("normalmat"_sym, normal),
+               },
+               32);
   }
 }
 
-void displaySpeed(float speed) {
+// Draws a quad in the HUD pass, HUD packets are drawn in the order they
+// are added to the queue
+void drawHUDQuad(RenderQueue &queue, const Material &material,
+                 std::initializer_list<Uniform> uniforms) {
+  const gfx::Vao &quad = VAOS->getVao("quad"_sym);
+  queue.draw(material, quad, glm::vec3(0.0f), uniforms);
+}
+
+void displaySpeed(RenderQueue &queue, float speed) {
   Window &window = Window::getInstance();
 
   int w, h;
   w = window.getWidth();
   h = window.getHeight();
-  glm::mat4 screenMat = glm::scale(
-      glm::mat4(1.0f), glm::vec3(2.0f / float(w), 2.0f / float(h), 0.0f));
-
-  glEnable(GL_BLEND);
-  glDisable(GL_DEPTH_TEST);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-  VAOS->bind("quad");
-  SHADERS->use("speed");
-  ShaderProgram &attitudeshader = SHADERS->getShader("speed");
-  attitudeshader.uniformMat4x4("screen", screenMat);
-  attitudeshader.uniformFloat("u_speed", speed);
-  attitudeshader.uniformFloat("u_maxSpeed", 150.0f);
+
+  Material material = getMaterial(
+      PASS_HUD, "speed"_sym, ""_sym, STATE_OVERLAY,
+      queue.addUniforms({uniform("screen"_sym, getScreenMatrix())}));
   glm::mat4 transform(1.0f);
-  transform = glm::translate(transform, glm::vec3((w - 60.0f),  130.0f, 0.0f));
+  transform = glm::translate(transform, glm::vec3((w - 60.0f), 130.0f, 0.0f));
   transform = glm::translate(
       transform, glm::vec3(-float(w) / 2.0f, -float(h) / 2.0f, 0.0f));
   transform =
       glm::scale(transform, glm::vec3(ATTITUDE_SIZE, ATTITUDE_SIZE, 0.0f));
   transform =
       glm::rotate(transform, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-  attitudeshader.uniformMat4x4("transform", transform);
-  VAOS->draw();
-
-  glDisable(GL_BLEND);
-  glEnable(GL_DEPTH_TEST);
+  drawHUDQuad(queue, material,
+              {
+                  uniform("u_speed"_sym, speed),
+                  uniform("u_maxSpeed"_sym, 150.0f),
+                  uniform("transform"_sym, transform),
+              });
 }
 
-void displayFuel(float fuel, float totalTime) {
+void displayFuel(RenderQueue &queue, float fuel, float totalTime) {
   Window &window = Window::getInstance();
 
   int w, h;
   w = window.getWidth();
   h = window.getHeight();
-  glm::mat4 screenMat = glm::scale(
-      glm::mat4(1.0f), glm::vec3(2.0f / float(w), 2.0f / float(h), 0.0f));
-
-  glEnable(GL_BLEND);
-  glDisable(GL_DEPTH_TEST);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-  VAOS->bind("quad");
-  SHADERS->use("fuel");
-  ShaderProgram &attitudeshader = SHADERS->getShader("fuel");
-  attitudeshader.uniformMat4x4("screen", screenMat);
-  attitudeshader.uniformFloat("u_fuelLevel", fuel);
-  attitudeshader.uniformFloat("u_lowFuelWarning", 0.15f);
-  attitudeshader.uniformFloat("u_time", totalTime);
+
+  Material material = getMaterial(
+      PASS_HUD, "fuel"_sym, ""_sym, STATE_OVERLAY,
+      queue.addUniforms({uniform("screen"_sym, getScreenMatrix())}));
   glm::mat4 transform(1.0f);
-  transform = glm::translate(transform, glm::vec3(w - 130.0f,  130.0f, 0.0f));
+  transform = glm::translate(transform, glm::vec3(w - 130.0f, 130.0f, 0.0f));
   transform = glm::translate(
       transform, glm::vec3(-float(w) / 2.0f, -float(h) / 2.0f, 0.0f));
   transform =
       glm::scale(transform, glm::vec3(ATTITUDE_SIZE, ATTITUDE_SIZE, 0.0f));
   transform =
       glm::rotate(transform, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-  attitudeshader.uniformMat4x4("transform", transform);
-  VAOS->draw();
-
-  glDisable(GL_BLEND);
-  glEnable(GL_DEPTH_TEST);
+  drawHUDQuad(queue, material,
+              {
+                  uniform("u_fuelLevel"_sym, fuel),
+                  uniform("u_lowFuelWarning"_sym, 0.15f),
+                  uniform("u_time"_sym, totalTime),
+                  uniform("transform"_sym, transform),
+              });
 }
 
-void displayAttitude(float pitch, float roll) {
+void displayAttitude(RenderQueue &queue, float pitch, float roll) {
   Window &window = Window::getInstance();
 
   int w, h;
   w = window.getWidth();
   h = window.getHeight();
-  glm::mat4 screenMat = glm::scale(
-      glm::mat4(1.0f), glm::vec3(2.0f / float(w), 2.0f / float(h), 0.0f));
-
-  glEnable(GL_BLEND);
-  glDisable(GL_DEPTH_TEST);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-  VAOS->bind("quad");
-  SHADERS->use("attitude");
-  ShaderProgram &attitudeshader = SHADERS->getShader("attitude");
-  attitudeshader.uniformMat4x4("screen", screenMat);
-  attitudeshader.uniformFloat("u_pitch", pitch);
-  attitudeshader.uniformFloat("u_roll", roll);
+
+  Material material = getMaterial(
+      PASS_HUD, "attitude"_sym, ""_sym, STATE_OVERLAY,
+      queue.addUniforms({uniform("screen"_sym, getScreenMatrix())}));
   glm::mat4 transform(1.0f);
 
   transform = glm::translate(transform, glm::vec3(130.0f, 130.0f, 0.0f));
@@ -549,32 +536,26 @@ void displayAttitude(float pitch, float roll) {
       glm::scale(transform, glm::vec3(ATTITUDE_SIZE, ATTITUDE_SIZE, 0.0f));
   transform =
       glm::rotate(transform, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-  attitudeshader.uniformMat4x4("transform", transform);
-  VAOS->draw();
-
-  glDisable(GL_BLEND);
-  glEnable(GL_DEPTH_TEST);
+  drawHUDQuad(queue, material,
+              {
+                  uniform("u_pitch"_sym, pitch),
+                  uniform("u_roll"_sym, roll),
+                  uniform("transform"_sym, transform),
+              });
 }
 
-void displayMiniMapBackground(float totalTime) {
+void displayMiniMapBackground(RenderQueue &queue, float totalTime) {
   Window &window = Window::getInstance();
 
   int w, h;
   w = window.getWidth();
   h = window.getHeight();
-  glm::mat4 screenMat = glm::scale(
-      glm::mat4(1.0f), glm::vec3(2.0f / float(w), 2.0f / float(h), 0.0f));
-
-  glEnable(GL_BLEND);
-  glDisable(GL_DEPTH_TEST);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  UniformRange screen =
+      queue.addUniforms({uniform("screen"_sym, getScreenMatrix())});
 
   // Display minimap background
-  VAOS->bind("quad");
-  SHADERS->use("minimap");
-  ShaderProgram &minimapshader = SHADERS->getShader("minimap");
-  minimapshader.uniformMat4x4("screen", screenMat);
-  minimapshader.uniformFloat("u_time", totalTime);
+  Material minimap =
+      getMaterial(PASS_HUD, "minimap"_sym, ""_sym, STATE_OVERLAY, screen);
   glm::mat4 transform(1.0f);
   transform = glm::translate(transform, glm::vec3(110.0f, -110.0f, 0.0f));
   transform = glm::translate(
@@ -583,14 +564,15 @@ void displayMiniMapBackground(float totalTime) {
       glm::scale(transform, glm::vec3(MINIMAP_SIZE, MINIMAP_SIZE, 0.0f));
   transform =
       glm::rotate(transform, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-  minimapshader.uniformMat4x4("transform", transform);
-  VAOS->draw();
+  drawHUDQuad(queue, minimap,
+              {
+                  uniform("u_time"_sym, totalTime),
+                  uniform("transform"_sym, transform),
+              });
 
   // Player icon
-  TEXTURES->bindTexture("player_marker", GL_TEXTURE0);
-  SHADERS->use("textured2d");
-  ShaderProgram &texture2dshader = SHADERS->getShader("textured2d");
-  texture2dshader.uniformMat4x4("screen", screenMat);
+  Material icon = getMaterial(PASS_HUD, "textured2d"_sym, "player_marker"_sym,
+                              STATE_OVERLAY, screen);
   transform = glm::mat4(1.0f);
   transform = glm::translate(transform, glm::vec3(110.0f, -110.0f, 0.0f));
   transform = glm::translate(
@@ -598,90 +580,29 @@ void displayMiniMapBackground(float totalTime) {
   transform = glm::scale(transform, glm::vec3(8.0f, 8.0f, 0.0f));
   transform =
       glm::rotate(transform, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-  texture2dshader.uniformMat4x4("transform", transform);
-  VAOS->draw();
-
-  glDisable(GL_BLEND);
-  glEnable(GL_DEPTH_TEST);
+  drawHUDQuad(queue, icon, {uniform("transform"_sym, transform)});
 }
 
-void displayEnemyMarkers(const std::vector<gameobjects::Enemy> &enemies,
-                         const game::Transform &playertransform) {
-
-  Window &window = Window::getInstance();
-
-  int w, h;
-  w = window.getWidth();
-  h = window.getHeight();
-  glm::mat4 screenMat = glm::scale(
-      glm::mat4(1.0f), glm::vec3(2.0f / float(w), 2.0f / float(h), 0.0f));
-
-  const float MAX_DIST = CHUNK_SZ * 16.0f;
-
-  glEnable(GL_BLEND);
-  glDisable(GL_DEPTH_TEST);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-  VAOS->bind("quad");
-  SHADERS->use("textured2d");
-  TEXTURES->bindTexture("enemy_marker", GL_TEXTURE0);
-  ShaderProgram &texture2dshader = SHADERS->getShader("textured2d");
-  texture2dshader.uniformMat4x4("screen", screenMat);
-  glm::vec2 center(playertransform.position.x, playertransform.position.z);
-  for (const auto &enemy : enemies) {
-    // Calculate distance to player
-    glm::vec2 enemypos(enemy.transform.position.x, enemy.transform.position.z);
-    glm::vec2 diff = enemypos - center;
-    float dist = glm::length(diff);
-
-    // If we are too far away, don't display the icon
-    if (dist > MAX_DIST)
-      continue;
+void displayEnemyMarkers(RenderQueue &queue,
+                         const std::vector<glm::mat4> &markers) {
+  if (markers.empty())
+    return;
 
-    // Caclulate angle with enemy
-    glm::vec3 direction = playertransform.direction();
-    float dirAngle = compressNormal(glm::normalize(direction)).x;
-    diff = glm::normalize(diff);
-    float enemyAngle = compressNormal(glm::vec3(diff.x, 0.0f, diff.y)).x;
-    float angle = dirAngle - enemyAngle + glm::radians(90.0f);
-    dist /= MAX_DIST;
-
-    // Display icon
-    glm::mat4 transform = glm::mat4(1.0f);
-    float x = MINIMAP_SIZE * cosf(angle) * dist;
-    float y = MINIMAP_SIZE * sinf(angle) * dist;
-    transform = glm::translate(transform, glm::vec3(x, y, 0.0f));
-    transform = glm::translate(transform, glm::vec3(100.0f, -100.0f, 0.0f));
-    transform = glm::translate(
-        transform, glm::vec3(-float(w) / 2.0f, float(h) / 2.0f, 0.0f));
-    transform = glm::scale(transform, glm::vec3(8.0f, 8.0f, 0.0f));
-    transform = glm::rotate(transform, glm::radians(90.0f),
-                            glm::vec3(1.0f, 0.0f, 0.0f));
-    texture2dshader.uniformMat4x4("transform", transform);
-    VAOS->draw();
-  }
-  glDisable(GL_BLEND);
-  glEnable(GL_DEPTH_TEST);
+  Material material = getMaterial(
+      PASS_HUD, "textured2d"_sym, "enemy_marker"_sym, STATE_OVERLAY,
+      queue.addUniforms({uniform("screen"_sym, getScreenMatrix())}));
+  for (const auto &transform : markers)
+    drawHUDQuad(queue, material, {uniform("transform"_sym, transform)});
 }
 
-void displayCrosshair(const game::Transform &playertransform) {
+void displayCrosshair(RenderQueue &queue,
+                      const game::Transform &playertransform) {
   Window &window = Window::getInstance();
 
-  int w, h;
-  w = window.getWidth();
-  h = window.getHeight();
-
-  glm::mat4 screenMat = glm::scale(
-      glm::mat4(1.0f), glm::vec3(2.0f / float(w), 2.0f / float(h), 0.0f));
-
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-  VAOS->bind("quad");
-  SHADERS->use("textured2d");
-  TEXTURES->bindTexture("crosshair", GL_TEXTURE0);
-  ShaderProgram &texture2dshader = SHADERS->getShader("textured2d");
-  texture2dshader.uniformMat4x4("screen", screenMat);
+  // The crosshair keeps the depth test
+  Material material = getMaterial(
+      PASS_HUD, "textured2d"_sym, "crosshair"_sym, STATE_DEFAULT | STATE_BLEND,
+      queue.addUniforms({uniform("screen"_sym, getScreenMatrix())}));
 
   // Calculate the screen position of the crosshair based on where the
   // player is facing
@@ -697,32 +618,22 @@ void displayCrosshair(const game::Transform &playertransform) {
   transform = glm::scale(transform, glm::vec3(8.0f, 8.0f, 0.0f));
   transform =
       glm::rotate(transform, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-  texture2dshader.uniformMat4x4("transform", transform);
-  VAOS->draw();
-
-  glDisable(GL_BLEND);
+  drawHUDQuad(queue, material, {uniform("transform"_sym, transform)});
 }
 
-void displayHUDBackGrounds() {
+void displayHUDBackGrounds(RenderQueue &queue) {
   Window &window = Window::getInstance();
 
   int w, h;
   w = window.getWidth();
   h = window.getHeight();
 
-  glm::mat4 screenMat = glm::scale(
-      glm::mat4(1.0f), glm::vec3(2.0f / float(w), 2.0f / float(h), 0.0f));
-
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  Material material = getMaterial(
+      PASS_HUD, "textured2d"_sym, "score_background"_sym,
+      STATE_DEFAULT | STATE_BLEND,
+      queue.addUniforms({uniform("screen"_sym, getScreenMatrix())}));
 
   // Altitude Background (Bottom Left)
-  VAOS->bind("quad");
-  SHADERS->use("textured2d");
-  TEXTURES->bindTexture("score_background", GL_TEXTURE0);
-  ShaderProgram &texture2dshader = SHADERS->getShader("textured2d");
-  texture2dshader.uniformMat4x4("screen", screenMat);
-
   glm::mat4 transform = glm::mat4(1.0f);
   transform = glm::translate(transform, glm::vec3(90.0f, 40.0f, 0.0f));
   transform = glm::translate(
@@ -730,27 +641,17 @@ void displayHUDBackGrounds() {
   transform = glm::scale(transform, glm::vec3(80.0f, 20.0f, 0.0f));
   transform =
       glm::rotate(transform, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-  texture2dshader.uniformMat4x4("transform", transform);
-  VAOS->draw();
+  drawHUDQuad(queue, material, {uniform("transform"_sym, transform)});
 
   // Health Background (Top Left)
-  VAOS->bind("quad");
-  SHADERS->use("textured2d");
-  TEXTURES->bindTexture("score_background", GL_TEXTURE0);
-  ShaderProgram &texture2dshader_ = SHADERS->getShader("textured2d");
-  texture2dshader_.uniformMat4x4("screen", screenMat);
-
-  glm::mat4 transform_ = glm::mat4(1.0f);
-  transform_ =
-      glm::translate(transform_, glm::vec3(125.0f, float(h) - 65.0f, 0.0f));
-  transform_ = glm::translate(
-      transform_, glm::vec3(-float(w) / 2.0f, -float(h) / 2.0f, 0.0f));
-  transform_ = glm::scale(transform_, glm::vec3(125.0f, 45.0f, 0.0f));
-  transform_ =
-      glm::rotate(transform_, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-  texture2dshader_.uniformMat4x4("transform", transform_);
-  VAOS->draw();
-
-  glDisable(GL_BLEND);
+  transform = glm::mat4(1.0f);
+  transform =
+      glm::translate(transform, glm::vec3(125.0f, float(h) - 65.0f, 0.0f));
+  transform = glm::translate(
+      transform, glm::vec3(-float(w) / 2.0f, -float(h) / 2.0f, 0.0f));
+  transform = glm::scale(transform, glm::vec3(125.0f, 45.0f, 0.0f));
+  transform =
+      glm::rotate(transform, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+  drawHUDQuad(queue, material, {uniform("transform"_sym, transform)});
 }
 } // namespace gfx
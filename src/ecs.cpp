@@ -0,0 +1,260 @@
+#include "ecs.h"
+
+namespace gobjs = gameobjects;
+
+namespace {
+	const ecs::ArchetypeInfo ARCHETYPES[ecs::KIND_COUNT] = {
+		//Balloon
+		{
+			ecs::TRANSFORM | ecs::VELOCITY | ecs::HEALTH | ecs::BOB,
+			5, 10, 24.0f, 24.0f, 1.0f, 16.0f, 0.0f
+		},
+		//Ship
+		{
+			ecs::TRANSFORM | ecs::VELOCITY | ecs::HEALTH | ecs::BOB | ecs::SHOOTER,
+			10, 50, 32.0f, 50.0f, 1.0f, 8.0f, 3.0f
+		},
+		//Barrel
+		{
+			ecs::TRANSFORM | ecs::VELOCITY | ecs::HEALTH | ecs::BOB,
+			5, 10, 24.0f, 24.0f, 1.0f, 16.0f, 0.0f
+		},
+	};
+
+	//Keeps the entries that are not dead in order, columns of components
+	//that the archetype does not have are empty and left alone
+	template<typename T>
+	void compact(std::vector<T> &column, const std::vector<uint8_t> &dead)
+	{
+		if(column.empty())
+			return;
+		size_t live = 0;
+		for(size_t i = 0; i < dead.size(); i++)
+			if(!dead[i])
+				column[live++] = column[i];
+		column.resize(live);
+	}
+}
+
+namespace ecs {
+	bool Archetype::has(uint32_t components) const
+	{
+		return (info.components & components) == components;
+	}
+
+	size_t Archetype::size() const
+	{
+		return ids.size();
+	}
+
+	game::Transform Archetype::getTransform(size_t i) const
+	{
+		game::Transform transform;
+		transform.position = positions[i];
+		transform.rotation = rotations[i];
+		transform.scale = scales[i];
+		return transform;
+	}
+
+	World::World()
+	{
+		for(int i = 0; i < KIND_COUNT; i++)
+			archetypes[i].info = ARCHETYPES[i];
+	}
+
+	size_t World::create(Kind kind, const glm::vec3 &position)
+	{
+		Archetype &archetype = archetypes[kind];
+		archetype.ids.push_back(nextid++);
+		archetype.dead.push_back(0);
+		if(archetype.has(TRANSFORM)) {
+			archetype.positions.push_back(position);
+			archetype.rotations.push_back(glm::vec3(0.0f));
+			archetype.scales.push_back(glm::vec3(1.0f));
+		}
+		if(archetype.has(VELOCITY))
+			archetype.velocities.push_back(glm::vec3(0.0f));
+		if(archetype.has(HEALTH))
+			archetype.hitpoints.push_back(archetype.info.hitpoints);
+		if(archetype.has(BOB)) {
+			archetype.bobminy.push_back(position.y);
+			archetype.bobmaxy.push_back(position.y);
+			archetype.bobdirection.push_back(1.0f);
+		}
+		if(archetype.has(SHOOTER))
+			archetype.shoottimers.push_back(0.0f);
+		return archetype.size() - 1;
+	}
+
+	Archetype& World::get(Kind kind)
+	{
+		return archetypes[kind];
+	}
+
+	const Archetype& World::get(Kind kind) const
+	{
+		return archetypes[kind];
+	}
+
+	size_t World::count(Kind kind) const
+	{
+		return archetypes[kind].size();
+	}
+
+	void World::removeDead()
+	{
+		for(auto &archetype : archetypes) {
+			const std::vector<uint8_t> &dead = archetype.dead;
+			compact(archetype.ids, dead);
+			compact(archetype.positions, dead);
+			compact(archetype.rotations, dead);
+			compact(archetype.scales, dead);
+			compact(archetype.velocities, dead);
+			compact(archetype.hitpoints, dead);
+			compact(archetype.bobminy, dead);
+			compact(archetype.bobmaxy, dead);
+			compact(archetype.bobdirection, dead);
+			compact(archetype.shoottimers, dead);
+			archetype.dead.assign(archetype.ids.size(), 0);
+		}
+	}
+
+	void World::getStates(Kind kind, std::vector<game::EntityState> &out) const
+	{
+		const Archetype &archetype = archetypes[kind];
+		out.resize(archetype.size());
+		for(size_t i = 0; i < archetype.size(); i++) {
+			out[i].id = archetype.ids[i];
+			out[i].transform = archetype.getTransform(i);
+		}
+	}
+
+	void bob(World &world)
+	{
+		for(int k = 0; k < KIND_COUNT; k++) {
+			Archetype &archetype = world.get(Kind(k));
+			if(!archetype.has(TRANSFORM | VELOCITY | BOB))
+				continue;
+			const float speed = archetype.info.bobspeed;
+			for(size_t i = 0; i < archetype.size(); i++) {
+				float &y = archetype.positions[i].y;
+				float &direction = archetype.bobdirection[i];
+				if(y > archetype.bobmaxy[i]) {
+					y = archetype.bobmaxy[i];
+					direction = -direction;
+				}
+				else if(y < archetype.bobminy[i]) {
+					y = archetype.bobminy[i];
+					direction = -direction;
+				}
+				archetype.velocities[i].y = speed * direction;
+			}
+		}
+	}
+
+	void move(World &world, float dt)
+	{
+		for(int k = 0; k < KIND_COUNT; k++) {
+			Archetype &archetype = world.get(Kind(k));
+			if(!archetype.has(TRANSFORM | VELOCITY))
+				continue;
+			for(size_t i = 0; i < archetype.size(); i++)
+				archetype.positions[i] += archetype.velocities[i] * dt;
+		}
+	}
+
+	void shoot(
+		World &world,
+		float dt,
+		const gobjs::Player &player,
+		std::vector<gobjs::Bullet> &bullets
+	) {
+		for(int k = 0; k < KIND_COUNT; k++) {
+			Archetype &archetype = world.get(Kind(k));
+			if(!archetype.has(TRANSFORM | SHOOTER))
+				continue;
+			for(size_t i = 0; i < archetype.size(); i++) {
+				archetype.shoottimers[i] += dt;
+				if(archetype.shoottimers[i] <= archetype.info.shootinterval)
+					continue;
+				archetype.shoottimers[i] = 0.0f;
+				//Aim at the player
+				glm::vec3 toplayer =
+					glm::normalize(player.transform.position - archetype.positions[i]);
+				archetype.rotations[i].y = atan2f(toplayer.x, toplayer.z);
+				bullets.push_back(
+					gobjs::Bullet(archetype.getTransform(i), 0.0f, glm::vec3(0.0f, 5.0f, 0.0f))
+				);
+			}
+		}
+	}
+
+	void hit(World &world, std::vector<gobjs::Bullet> &bullets)
+	{
+		for(int k = 0; k < KIND_COUNT; k++) {
+			Archetype &archetype = world.get(Kind(k));
+			if(!archetype.has(TRANSFORM | HEALTH))
+				continue;
+			const float hitdist2 = archetype.info.hitdist * archetype.info.hitdist;
+			for(auto &bullet : bullets) {
+				for(size_t i = 0; i < archetype.size(); i++) {
+					glm::vec3 diff = bullet.transform.position - archetype.positions[i];
+					if(glm::dot(diff, diff) < hitdist2) {
+						bullet.destroyed = true;
+						archetype.hitpoints[i]--;
+					}
+				}
+			}
+		}
+	}
+
+	void destroy(
+		World &world,
+		gobjs::Player &player,
+		std::vector<gobjs::Explosion> &explosions,
+		unsigned int &score
+	) {
+		for(int k = 0; k < KIND_COUNT; k++) {
+			Archetype &archetype = world.get(Kind(k));
+			if(!archetype.has(TRANSFORM | HEALTH))
+				continue;
+			const ArchetypeInfo &info = archetype.info;
+			const float crashdist2 = info.crashdist * info.crashdist;
+			for(size_t i = 0; i < archetype.size(); i++) {
+				if(archetype.dead[i])
+					continue;
+				const glm::vec3 &pos = archetype.positions[i];
+				if(archetype.hitpoints[i] <= 0) {
+					// SNDSRC->playid("explosion", pos);
+					explosions.push_back(gobjs::Explosion(pos, info.explosionscale));
+					score += info.scorevalue;
+					archetype.dead[i] = 1;
+					continue;
+				}
+
+				glm::vec3 diff = pos - player.transform.position;
+				if(glm::dot(diff, diff) < crashdist2 && !player.crashed) {
+					// SNDSRC->playid("explosion", pos, info.explosionscale);
+					player.crashed = true;
+					explosions.push_back(gobjs::Explosion(pos, info.explosionscale));
+					archetype.dead[i] = 1;
+				}
+			}
+		}
+	}
+
+	void cull(World &world, const glm::vec3 &center, float maxdist)
+	{
+		const float maxdist2 = maxdist * maxdist;
+		for(int k = 0; k < KIND_COUNT; k++) {
+			Archetype &archetype = world.get(Kind(k));
+			if(!archetype.has(TRANSFORM))
+				continue;
+			for(size_t i = 0; i < archetype.size(); i++) {
+				glm::vec3 diff = archetype.positions[i] - center;
+				if(glm::dot(diff, diff) > maxdist2)
+					archetype.dead[i] = 1;
+			}
+		}
+	}
+}
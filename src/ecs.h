@@ -0,0 +1,118 @@
+/*
+ * Storage for the objects that fill the sky and the sea in arcade mode
+ * (balloons, ships, barrels), every kind of object is an archetype with a
+ * fixed set of components and each component is kept in its own array so
+ * that the systems below only walk over the data that they use
+ *
+ * Entities are only ever appended and removed without reordering so the
+ * entities of an archetype stay sorted by id
+ * */
+
+#ifndef ECS_H
+#define ECS_H
+
+#include "game.h"
+#include <stdint.h>
+#include <vector>
+
+namespace ecs {
+	//Entities further than this from the player are removed
+	constexpr float CULL_DIST = CHUNK_SZ * 32.0f;
+
+	enum Component : uint32_t {
+		//Position, rotation and scale
+		TRANSFORM = 1 << 0,
+		VELOCITY = 1 << 1,
+		HEALTH = 1 << 2,
+		//Moves up and down between two heights
+		BOB = 1 << 3,
+		//Fires a bullet at the player every so often
+		SHOOTER = 1 << 4,
+	};
+
+	enum Kind {
+		BALLOON,
+		SHIP,
+		BARREL,
+		KIND_COUNT,
+	};
+
+	//Values that are the same for every entity of an archetype
+	struct ArchetypeInfo {
+		uint32_t components;
+		int hitpoints;
+		//How many points the player gets for destroying one
+		unsigned int scorevalue;
+		//Bullets closer than this hit
+		float hitdist;
+		//The player crashes if they get closer than this
+		float crashdist;
+		float explosionscale;
+		float bobspeed;
+		//Seconds between shots
+		float shootinterval;
+	};
+
+	struct Archetype {
+		ArchetypeInfo info;
+		//One entry per entity, the arrays of the components that the
+		//archetype does not have stay empty
+		std::vector<uint32_t> ids;
+		std::vector<glm::vec3> positions, rotations, scales;
+		std::vector<glm::vec3> velocities;
+		std::vector<int> hitpoints;
+		std::vector<float> bobminy, bobmaxy, bobdirection;
+		std::vector<float> shoottimers;
+		//Set by the systems, the entities are removed by removeDead()
+		std::vector<uint8_t> dead;
+		bool has(uint32_t components) const;
+		size_t size() const;
+		game::Transform getTransform(size_t i) const;
+	};
+
+	class World {
+		Archetype archetypes[KIND_COUNT];
+		uint32_t nextid = 1;
+	public:
+		World();
+		//Adds an entity with the default values of its archetype at
+		//'position' and returns its index in the archetype, the index is
+		//only valid until the next call to removeDead()
+		size_t create(Kind kind, const glm::vec3 &position);
+		Archetype& get(Kind kind);
+		const Archetype& get(Kind kind) const;
+		size_t count(Kind kind) const;
+		//Removes every entity that was marked as dead in one pass
+		void removeDead();
+		//Copies the ids and transforms of every entity of 'kind' into 'out'
+		void getStates(Kind kind, std::vector<game::EntityState> &out) const;
+	};
+
+	//Systems, each one goes over every archetype that has the components
+	//it needs
+	//Turns the bobbing entities around at the ends of their range and sets
+	//their vertical velocity
+	void bob(World &world);
+	void move(World &world, float dt);
+	//Shooters turn to face the player and fire a bullet at them
+	void shoot(
+		World &world,
+		float dt,
+		const gameobjects::Player &player,
+		std::vector<gameobjects::Bullet> &bullets
+	);
+	//Bullets that hit an entity are destroyed and take one hitpoint
+	void hit(World &world, std::vector<gameobjects::Bullet> &bullets);
+	//Marks entities without hitpoints as dead and adds their score,
+	//anything that the player flew into crashes the player, both explode
+	void destroy(
+		World &world,
+		gameobjects::Player &player,
+		std::vector<gameobjects::Explosion> &explosions,
+		unsigned int &score
+	);
+	//Marks entities that are further than 'maxdist' from 'center' as dead
+	void cull(World &world, const glm::vec3 &center, float maxdist);
+}
+
+#endif
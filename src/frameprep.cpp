@@ -0,0 +1,336 @@
+#include "game.h"
+#include "jobs.h"
+#include "window.h"
+#include <algorithm>
+#include <chrono>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+	//Objects are treated as spheres of this size when testing if they
+	//are hidden behind the terrain
+	constexpr float BALLOON_RADIUS = 32.0f;
+	constexpr float BARREL_RADIUS = 16.0f;
+	constexpr float SHIP_RADIUS = 96.0f;
+	constexpr float SHIP_SCALE = 14.0f;
+	//Farthest an enemy can be and still show up on the minimap
+	constexpr float MARKER_MAX_DIST = CHUNK_SZ * 16.0f;
+	//Explosions that would get fewer particles than this are dropped
+	constexpr unsigned int MIN_PARTICLES_PER_EXPLOSION = 16;
+
+	float elapsedMs(std::chrono::steady_clock::time_point start)
+	{
+		std::chrono::duration<float, std::milli> d =
+			std::chrono::steady_clock::now() - start;
+		return d.count();
+	}
+
+	void pack(
+		const std::vector<game::EntityState> &objects,
+		const geo::HorizonBuffer &horizon,
+		float radius,
+		float scale,
+		std::vector<gfx::ObjectInstance> &out
+	) {
+		out.clear();
+		for(const auto &object : objects) {
+			const glm::vec3 &pos = object.transform.position;
+			if(horizon.occluded(pos - glm::vec3(radius), pos + glm::vec3(radius)))
+				continue;
+			glm::mat4 transform = object.transform.getTransformMat();
+			if(scale != 1.0f)
+				transform = glm::scale(transform, glm::vec3(scale));
+			gfx::ObjectInstance instance;
+			instance.position = pos;
+			instance.transform = transform;
+			instance.normal = glm::mat3(glm::transpose(glm::inverse(transform)));
+			out.push_back(instance);
+		}
+	}
+
+	void placeMarkers(
+		const std::vector<game::EntityState> &enemies,
+		const game::Transform &playertransform,
+		int w,
+		int h,
+		std::vector<glm::mat4> &out
+	) {
+		out.clear();
+		glm::vec2 center(playertransform.position.x, playertransform.position.z);
+		glm::vec3 direction = playertransform.direction();
+		float dirAngle = gfx::compressNormal(glm::normalize(direction)).x;
+		for(const auto &enemy : enemies) {
+			glm::vec2 enemypos(enemy.transform.position.x, enemy.transform.position.z);
+			glm::vec2 diff = enemypos - center;
+			float dist = glm::length(diff);
+			//Too far away to be on the minimap
+			if(dist > MARKER_MAX_DIST)
+				continue;
+
+			diff = glm::normalize(diff);
+			float enemyAngle = gfx::compressNormal(glm::vec3(diff.x, 0.0f, diff.y)).x;
+			float angle = dirAngle - enemyAngle + glm::radians(90.0f);
+			dist /= MARKER_MAX_DIST;
+
+			glm::mat4 transform = glm::mat4(1.0f);
+			float x = MINIMAP_SIZE * cosf(angle) * dist;
+			float y = MINIMAP_SIZE * sinf(angle) * dist;
+			transform = glm::translate(transform, glm::vec3(x, y, 0.0f));
+			transform = glm::translate(transform, glm::vec3(100.0f, -100.0f, 0.0f));
+			transform = glm::translate(
+				transform,
+				glm::vec3(-float(w) / 2.0f, float(h) / 2.0f, 0.0f)
+			);
+			transform = glm::scale(transform, glm::vec3(8.0f, 8.0f, 0.0f));
+			transform = glm::rotate(transform, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+			out.push_back(transform);
+		}
+	}
+
+	//Insertion sort, back to front, the explosions come in close to this
+	//order already (updateExplosions keeps them sorted by distance to the
+	//player) so this is close to linear
+	void sortExplosions(std::vector<gfx::ExplosionInstance> &explosions)
+	{
+		for(size_t i = 1; i < explosions.size(); i++) {
+			gfx::ExplosionInstance explosion = explosions[i];
+			size_t j = i;
+			for(; j > 0 && explosions[j - 1].distance2 < explosion.distance2; j--)
+				explosions[j] = explosions[j - 1];
+			explosions[j] = explosion;
+		}
+	}
+
+	void prepareParticles(
+		const std::vector<gameobjects::Explosion> &explosions,
+		const glm::vec3 &camerapos,
+		float totalTime,
+		unsigned int budget,
+		gfx::FrameData &frame
+	) {
+		frame.explosions.clear();
+		for(const auto &explosion : explosions) {
+			if(!explosion.visible)
+				continue;
+			glm::vec3 d = explosion.transform.position - camerapos;
+			gfx::ExplosionInstance instance;
+			instance.position = explosion.transform.position;
+			instance.start = totalTime - explosion.timePassed;
+			instance.scale = explosion.explosionScale;
+			instance.distance2 = glm::dot(d, d);
+			frame.explosions.push_back(instance);
+		}
+		sortExplosions(frame.explosions);
+
+		//Split the budget between the explosions, once that gets too thin
+		//the farthest explosions (the front of the list) are dropped
+		gfx::ParticleStats &stats = frame.particlestats;
+		stats = gfx::ParticleStats();
+		frame.particles.clear();
+		budget = std::min(budget, MAX_PARTICLES);
+		unsigned int count = frame.explosions.size();
+		if(count == 0 || budget == 0)
+			return;
+		unsigned int per = std::min(PARTICLES_PER_EXPLOSION, budget / count);
+		unsigned int first = 0;
+		if(per < MIN_PARTICLES_PER_EXPLOSION) {
+			per = std::min(MIN_PARTICLES_PER_EXPLOSION, budget);
+			unsigned int fits = budget / per;
+			first = count - std::min(count, fits);
+		}
+
+		//Seeds are spread over the same range no matter how many particles
+		//there are so the explosion keeps its shape, the particles get
+		//larger to make up for there being fewer of them
+		float seedstep = float(PARTICLES_PER_EXPLOSION) / float(per);
+		float size = sqrtf(seedstep);
+		for(unsigned int i = first; i < count; i++) {
+			const gfx::ExplosionInstance &explosion = frame.explosions[i];
+			for(unsigned int p = 0; p < per; p++) {
+				gfx::ParticleInstance particle;
+				particle.center = explosion.position;
+				particle.start = explosion.start;
+				particle.seed = floorf(float(p) * seedstep);
+				particle.scale = explosion.scale;
+				particle.size = size;
+				frame.particles.push_back(particle);
+			}
+		}
+
+		stats.explosions = count - first;
+		stats.particles = frame.particles.size();
+		stats.perexplosion = per;
+		stats.dropped = first;
+	}
+}
+
+namespace gfx {
+	void packObjects(
+		const std::vector<game::EntityState> &objects,
+		const geo::HorizonBuffer &horizon,
+		float radius,
+		float scale,
+		std::vector<ObjectInstance> &out
+	) {
+		pack(objects, horizon, radius, scale, out);
+	}
+
+	void prepareFrame(FrameData &frame, const FrameInput &input, geo::HorizonBuffer &horizon)
+	{
+		auto prepStart = std::chrono::steady_clock::now();
+
+		//Everything that reads the window is done here on the main thread
+		Window &window = Window::getInstance();
+		Camera &cam = window.getCamera();
+		const glm::vec3 camerapos = cam.position;
+		const int w = window.getWidth(), h = window.getHeight();
+		const geo::Frustum frustum = cam.getViewFrustum(
+			window.getZnear(),
+			window.getZfar(),
+			window.getAspect(),
+			window.getFovy()
+		);
+
+		//Each task writes its time into its own slot
+		frame.timings.clear();
+		auto addTask = [&frame](const char *name) {
+			frame.timings.push_back({ name, 0.0f });
+			return frame.timings.size() - 1;
+		};
+
+		//The horizon has to be complete before anything can be culled
+		//against it so it is built before fanning out
+		infworld::ChunkTable *chunktables = input.chunktables;
+		const int maxlod = chunktables ? input.maxlod : 0;
+		frame.terrainranges.assign(maxlod, glm::vec2(0.0f, -1.0f));
+		horizon.clear(camerapos);
+		if(chunktables) {
+			size_t slot = addTask("horizon");
+			auto start = std::chrono::steady_clock::now();
+
+			infworld::ChunkPos center = chunktables[0].getCenter();
+			glm::vec2 centerpos = glm::vec2(float(center.z), float(center.x));
+			centerpos *= float(PREC) / float(PREC + 1);
+			centerpos *= chunktables[0].scale() * SCALE * 2.0f;
+			frame.terraincenter = centerpos;
+
+			//Range around the center that each LOD is drawn in
+			float mindist = 0.0f;
+			for(int i = 0; i < maxlod; i++) {
+				frame.terrainranges[i] = glm::vec2(mindist, -1.0f);
+				if(i == maxlod - 1)
+					continue;
+				float chunkscale =
+					chunktables[i].scale() * 2.0f * float(PREC) / float(PREC + 1);
+				float range = float(chunktables[i].range()) - 0.5f;
+				//Slight amount of overlap to mitigate cracks in terrain
+				//We increase this amount due to the terrain becoming less
+				//precise and more likely to have cracks
+				float d = 8.0f * float(i) + 4.0f;
+				float maxrange = chunkscale * range * SCALE + d;
+				frame.terrainranges[i].y = maxrange;
+				mindist = maxrange - 2.0f * d;
+			}
+
+			for(int i = 0; i < maxlod; i++) {
+				chunktables[i].addOccluders(
+					horizon,
+					centerpos,
+					frame.terrainranges[i].x,
+					frame.terrainranges[i].y
+				);
+			}
+			frame.timings[slot].ms = elapsedMs(start);
+		}
+
+		//Reserve every slot before any task starts so that the vector
+		//is not reallocated while the tasks write to it
+		static const char *LOD_TASK_NAMES[] = {
+			"terrain lod 0", "terrain lod 1", "terrain lod 2", "terrain lod 3",
+			"terrain lod 4", "terrain lod 5", "terrain lod 6", "terrain lod 7",
+		};
+		std::vector<size_t> lodslots(maxlod);
+		for(int i = 0; i < maxlod; i++)
+			lodslots[i] = addTask(i < 8 ? LOD_TASK_NAMES[i] : "terrain lod");
+		size_t decorationslot = addTask("decorations");
+		size_t balloonslot = addTask("balloons");
+		size_t shipslot = addTask("ships");
+		size_t barrelslot = addTask("barrels");
+		size_t markerslot = addTask("markers");
+		size_t explosionslot = addTask("explosions");
+
+		const geo::HorizonBuffer &occluders = horizon;
+		jobs::TaskGroup group;
+		auto timed = [&group, &frame](size_t slot, std::function<void()> task) {
+			group.run([&frame, slot, task]() {
+				auto start = std::chrono::steady_clock::now();
+				task();
+				frame.timings[slot].ms = elapsedMs(start);
+			});
+		};
+
+		for(int i = 0; i < maxlod; i++) {
+			timed(lodslots[i], [=, &occluders, &frustum]() {
+				//Skip the chunks that the previous LOD draws
+				int minrange = 0;
+				if(i > 0)
+					minrange = chunktables[i - 1].range() / int(input.lodscale) - 1;
+				chunktables[i].cull(minrange, frustum, &occluders);
+			});
+		}
+
+		if(input.decorations) {
+			infworld::DecorationTable *decorations = input.decorations;
+			timed(decorationslot, [=, &occluders, &frustum]() {
+				decorations->cull(frustum, &occluders, camerapos);
+			});
+		}
+
+		frame.balloons.clear();
+		if(input.balloons) {
+			timed(balloonslot, [&input, &occluders, &frame]() {
+				pack(*input.balloons, occluders, BALLOON_RADIUS, 1.0f, frame.balloons);
+			});
+		}
+
+		frame.ships.clear();
+		if(input.ships) {
+			timed(shipslot, [&input, &occluders, &frame]() {
+				pack(*input.ships, occluders, SHIP_RADIUS, SHIP_SCALE, frame.ships);
+			});
+		}
+
+		frame.barrels.clear();
+		if(input.barrels) {
+			timed(barrelslot, [&input, &occluders, &frame]() {
+				pack(*input.barrels, occluders, BARREL_RADIUS, 1.0f, frame.barrels);
+			});
+		}
+
+		frame.balloonmarkers.clear();
+		frame.shipmarkers.clear();
+		timed(markerslot, [&input, &frame, w, h]() {
+			if(input.balloons)
+				placeMarkers(*input.balloons, input.playertransform, w, h, frame.balloonmarkers);
+			if(input.ships)
+				placeMarkers(*input.ships, input.playertransform, w, h, frame.shipmarkers);
+		});
+
+		frame.explosions.clear();
+		frame.particles.clear();
+		frame.particlestats = ParticleStats();
+		if(input.explosions) {
+			timed(explosionslot, [&input, &frame, camerapos]() {
+				prepareParticles(
+					*input.explosions,
+					camerapos,
+					input.totalTime,
+					input.particlebudget,
+					frame
+				);
+			});
+		}
+
+		group.wait();
+		frame.totalms = elapsedMs(prepStart);
+	}
+}
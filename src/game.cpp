@@ -1,10 +1,35 @@
 #include "game.h"
 #include "assets.h"
+#include "impostor.h"
 #include "plants.h"
 #include "window.h"
 //#include "audio.hpp"
 #include <glm/gtc/matrix_transform.hpp>
 
+namespace {
+	//Needed on the first frame of every mode along with the plane a new
+	//player flies, everything else in the impfiles (including the other
+	//planes) is loaded the first time it is drawn
+	const char *PRELOAD_MODELS[] = { "propeller", "bullet" };
+	const char *PRELOAD_TEXTURES[] = {
+		"terrain", "watermaps", "skybox", "pinetree", "tree", "propeller",
+	};
+
+	void addPlant(
+		assets::AssetLoader &loader,
+		const std::string &name,
+		mesh::Model (*createMesh)(unsigned int),
+		unsigned int detail
+	) {
+		loader.add([name, createMesh, detail]() -> assets::AssetLoader::Upload {
+			mesh::Model model = createMesh(detail);
+			return [name, model = std::move(model)]() {
+				VAOS->add(name, plants::createPlantVao(model));
+			};
+		});
+	}
+}
+
 namespace game {
 	Transform::Transform()
 	{
@@ -62,23 +87,47 @@ namespace game {
 		return glm::vec3(transformed.x, transformed.y, transformed.z);
 	}
 
-	void loadAssets()
+	void loadAssets(const assets::LoadProgress &progress)
 	{
+		//Models, plants and textures are read and decoded on the worker
+		//threads while the shaders compile, the vaos and textures are
+		//then created here as they come in
+		assets::AssetLoader loader;
 		//Vaos
 		VAOS->genSimple();
-		VAOS->add("pinetree", plants::createPineTreeModel(8));
-		VAOS->add("pinetreelowdetail", plants::createPineTreeModel(4));
-		VAOS->add("tree", plants::createTreeModel(6));
-		VAOS->add("treelowdetail", plants::createTreeModel(3));
-		VAOS->importFromFile("assets/models.impfile");
+		VAOS->add("particles", gfx::createParticleVao(MAX_PARTICLES));
+		addPlant(loader, "pinetree", plants::createPineTreeMesh, 8);
+		addPlant(loader, "pinetreemediumdetail", plants::createPineTreeMesh, 6);
+		addPlant(loader, "pinetreelowdetail", plants::createPineTreeMesh, 4);
+		addPlant(loader, "tree", plants::createTreeMesh, 6);
+		addPlant(loader, "treemediumdetail", plants::createTreeMesh, 4);
+		addPlant(loader, "treelowdetail", plants::createTreeMesh, 3);
+		VAOS->registerFromFile("assets/models.impfile");
+		const sym::Symbol plane = sym::intern(gameobjects::Player::planeModels().front());
+		VAOS->preload(plane, loader);
+		for(const char *name : PRELOAD_MODELS)
+			VAOS->preload(sym::Symbol(name), loader);
 		//Textures
-		TEXTURES->importFromFile("assets/textures.impfile");
-		//Shaders
+		TEXTURES->genPlaceholders();
+		TEXTURES->registerFromFile("assets/textures.impfile");
+		TEXTURES->preload(plane, loader);
+		for(const char *name : PRELOAD_TEXTURES)
+			TEXTURES->preload(sym::Symbol(name), loader);
+		//Shaders, linked programs are cached so that later launches can
+		//skip compiling them (the null backend has nothing to cache)
+		if(!Window::isHeadless()) {
+			char *prefpath = SDL_GetPrefPath("TheFlightGame", "RiverRaid3D");
+			if(prefpath) {
+				SHADERS->setCachePrefix(std::string(prefpath) + "shadercache_");
+				SDL_free(prefpath);
+			}
+		}
 		SHADERS->importFromFile("assets/shaders.impfile");
 		//Fonts
 		FONTS->importFromFile("assets/fonts.impfile");
 		//Audio
 		//SFX->importFromFile("assets/sfx.impfile");
+		loader.finish(progress);
 	}
 
 	void generateChunks(
@@ -105,10 +154,7 @@ namespace game {
 		}
 
 		//If we generate new terrain, we must generate new decorations as well
-		bool generated = decorations.genNewDecorations(cam.position.x, cam.position.z, permutations);
-		if(generated){
-			gfx::generateDecorationOffsets(decorations);
-		}
+		decorations.genNewDecorations(cam.position.x, cam.position.z, permutations);
 	}
 
 	//This initializes the uniform block of values that should be shared across
@@ -123,27 +169,47 @@ namespace game {
 		};
 
 		unsigned int globalShaderValsUbo;
-		glGenBuffers(1, &globalShaderValsUbo);
-		glBindBuffer(GL_UNIFORM_BUFFER, globalShaderValsUbo);
-		glBufferData(
+		GFX->genBuffers(1, &globalShaderValsUbo);
+		GFX->bindBuffer(GL_UNIFORM_BUFFER, globalShaderValsUbo);
+		GFX->bufferData(
 			GL_UNIFORM_BUFFER,
 			sizeof(globalShaderVals),
 			globalShaderVals,
 			GL_STATIC_DRAW
 		);
-		glBindBuffer(GL_UNIFORM_BUFFER, 0);
-		SHADERS->getShader("water").setBinding("GlobalVals", 0);
-		SHADERS->getShader("tree").setBinding("GlobalVals", 0);
-		SHADERS->getShader("terrain").setBinding("GlobalVals", 0);
-		glBindBufferBase(GL_UNIFORM_BUFFER, 0, globalShaderValsUbo);
+		GFX->bindBuffer(GL_UNIFORM_BUFFER, 0);
+		SHADERS->getShader("water"_sym).setBinding("GlobalVals", 0);
+		SHADERS->getShader("tree"_sym).setBinding("GlobalVals", 0);
+		SHADERS->getShader("impostor"_sym).setBinding("GlobalVals", 0);
+		SHADERS->getShader("terrain"_sym).setBinding("GlobalVals", 0);
+		GFX->bindBufferBase(GL_UNIFORM_BUFFER, 0, globalShaderValsUbo);
+	}
+
+	void bakeImpostors()
+	{
+		//The meshes are only needed for their bounds
+		bool pinetree = impostor::bake(
+			"pinetreeimpostor",
+			"pinetree",
+			"pinetree",
+			plants::createPineTreeMesh(8)
+		);
+		bool tree = impostor::bake("treeimpostor", "tree", "tree", plants::createTreeMesh(6));
+		if(pinetree)
+			VAOS->add("pinetreeimpostor", impostor::createQuadVao());
+		if(tree)
+			VAOS->add("treeimpostor", impostor::createQuadVao());
+		Window &window = Window::getInstance();
+		GFX->viewport(0, 0, window.getWidth(), window.getHeight());
 	}
 
 	void initUniforms()
 	{
 		initGlobalValUniformBlock();
-		SHADERS->use("terrain");
-		SHADERS->getShader("terrain").uniformFloat("maxheight", HEIGHT);
-		SHADERS->getShader("terrain").uniformInt("prec", PREC);
+		SHADERS->use("terrain"_sym);
+		SHADERS->getShader("terrain"_sym).uniformFloat("maxheight", HEIGHT);
+		SHADERS->getShader("terrain"_sym).uniformInt("prec", PREC);
+		bakeImpostors();
 	}
 
 	void TimerManager::addTimer(const std::string &name, float maxtime)
@@ -152,7 +218,7 @@ namespace game {
 			.time = maxtime,
 			.maxtime = maxtime
 		};
-		timers.insert({ name, t });
+		timers.insert({ sym::intern(name), t });
 	}
 
 	void TimerManager::addTimer(const std::string& name, float time, float maxtime)
@@ -161,7 +227,7 @@ namespace game {
 			.time = time,
 			.maxtime = maxtime
 		};
-		timers.insert({ name, t });
+		timers.insert({ sym::intern(name), t });
 	}
 
 	void TimerManager::update(float dt)
@@ -177,10 +243,11 @@ namespace game {
 				t.second.time = t.second.maxtime;
 	}
 
-	bool TimerManager::getTimer(const std::string &name)
+	bool TimerManager::getTimer(sym::Symbol name)
 	{
-		if(!timers.count(name))
+		auto found = timers.find(name);
+		if(found == timers.end())
 			return false;
-		return timers.at(name).time < 0.0f;
+		return found->second.time < 0.0f;
 	}
 }
@@ -1,6 +1,15 @@
 #pragma once
+#include <functional>
 #include <iostream>
 #include "infworld.h"
+#include "renderqueue.h"
+#include "gfxbackend.h"
+#include "symbol.h"
+
+//Defined in ecs.h
+namespace ecs {
+	class World;
+}
 
 //Constants
 constexpr float SPEED = 48.0f;
@@ -14,6 +23,21 @@ constexpr float ZNEAR = 2.0f;
 constexpr float ZFAR = 20000.0f;
 
 constexpr int RANGE = 4;
+//Number of directions the horizon used for occlusion culling is split into
+constexpr unsigned int HORIZON_BINS = 512;
+//Radius of the minimap in pixels
+constexpr float MINIMAP_SIZE = 100.0f;
+//Particles drawn for one explosion when the particle budget allows it
+constexpr unsigned int PARTICLES_PER_EXPLOSION = 128;
+//Size of the explosion particle instance buffer, the particle budget can
+//not go above this
+constexpr unsigned int MAX_PARTICLES = 8192;
+//Length of one simulation step in arcade mode
+constexpr float SIM_TICK = 1.0f / 120.0f;
+//Distance (in chunk widths) past which trees are drawn as impostors and
+//the width of the band where the model fades into the impostor
+constexpr float IMPOSTOR_DIST = 4.0f;
+constexpr float IMPOSTOR_FADE = 0.5f;
 
 const glm::vec3 LIGHT = glm::normalize(glm::vec3(-1.0f));
 
@@ -53,23 +77,41 @@ namespace game {
 		glm::vec3 invRotate(const glm::vec3 &v) const;
 	};
 
+	//What the renderer gets to see of an enemy, the id stays the same for
+	//the lifetime of the enemy so that two snapshots of the world can be
+	//matched up
+	struct EntityState {
+		uint32_t id = 0;
+		Transform transform;
+	};
+
+	//Defined in simulation.h
+	struct InputState;
+
 	struct Timer {
 		float time = 0.0f;
 		float maxtime = 0.0f;
 	};
 
 	struct TimerManager {
-		std::unordered_map<std::string, Timer> timers;
+		std::unordered_map<sym::Symbol, Timer> timers;
 		void addTimer(const std::string& name, float maxtime);
 		void addTimer(const std::string& name, float time, float maxtime);
 		void update(float dt);
 		//Resets all timers that have time below 0.0
 		void reset();
-		bool getTimer(const std::string &name);
+		bool getTimer(sym::Symbol name);
 	};
 
-	void loadAssets();
-	//Initializes the shader uniforms
+	//File reading and decoding is spread over the job system, 'progress'
+	//is called on the main thread each time an asset is done loading
+	void loadAssets(
+		const std::function<void(unsigned int loaded, unsigned int total)> &progress = nullptr
+	);
+	//Renders the tree models into impostor atlases (see impostor.h),
+	//the shaders and tree models need to be loaded
+	void bakeImpostors();
+	//Initializes the shader uniforms and bakes the impostors
 	void initUniforms();
 	void generateChunks(
 		const infworld::worldseed &permutations,
@@ -90,9 +132,26 @@ namespace game {
 	game::PauseMenuActions arcadeModeGameLoop();
 	//Development Purposes
 	game::PauseMenuActions devModeGameLoop();
+	//Runs the world update and the display functions of arcade mode for
+	//'frames' frames with a fixed time step and no input and prints how
+	//long the CPU side of each frame took, this does not touch the gui so
+	//it can run with a headless window and the null graphics backend
+	//If 'recorder' is not null, the calls and bytes it logged per frame
+	//are also reported
+	//If 'tracepath' is not null, the times of every frame are written to
+	//it as csv so that single slow frames (like the ones where new chunks
+	//come into range) can be seen and not just the totals
+	void benchmarkGameLoop(
+		unsigned int frames,
+		int seed,
+		gfx::RecordingBackend *recorder,
+		const char *tracepath = nullptr
+	);
 	//Main menu
 	//Returns the game mode selected
 	game::MainMenuActions mainMenu();
+	//Draws the loading screen, meant to be passed to loadAssets
+	void loadingScreen(unsigned int loaded, unsigned int total);
   // Exit the Game
   void exitGame();
 
@@ -124,6 +183,8 @@ namespace gameobjects {
 		unsigned int health;
 		Player(glm::vec3 position);
 
+		//Planes the player can pick, a new player flies the first one
+		static const std::vector<std::string>& planeModels();
 		std::vector<std::string> model_name;
 		int current_model;
 		void damage(unsigned int amount);
@@ -132,7 +193,9 @@ namespace gameobjects {
 		//Returns the damagetimer amount left
 		float damageTimerProgress();
 		void rotateWithMouse(float dt);
+		//Reads the keys from the window
 		void update(float dt);
+		void update(float dt, const game::InputState &input);
 		void resetShootTimer();
 		void checkIfCrashed(float dt, const infworld::worldseed &permutations);
 		void setPlayerObj(int current);
@@ -161,138 +224,61 @@ namespace gameobjects {
 		void update(float dt);
 	};
 
-	struct Enemy {
-		//How many points the player gets if they kill the enemy
-		unsigned int scorevalue;
-		game::Transform transform;
-		std::unordered_map<std::string, float> values;
-		int hitpoints;
-		Enemy(glm::vec3 position, int hp, unsigned int scoreval);
-		void updateBalloon(float dt);
-		void updateBlimp(float dt);
-		void updateShip(float dt, const Player &player, std::vector<Bullet> &bullets);
-		void updateUfo(float dt, const infworld::worldseed &permutations);
-		void updatePlane(
-			float dt,
-			const Player &player,
-			std::vector<Bullet> &bullets,
-			const infworld::worldseed &permutations
-		);
-		void checkIfPlaneCrashed(const infworld::worldseed &permutations);
-		float getVal(const std::string &key) const;
-		void setVal(const std::string &key, float v);
-	};
-
-	Enemy spawnBalloon(const glm::vec3 &position, const infworld::worldseed &permutations);
-	Enemy spawnBlimp(const glm::vec3 &position, float rotation);
-	Enemy spawnShip(const glm::vec3 &position, const infworld::worldseed &permutations);
-	Enemy spawnUfo(
+	//Balloons, ships and barrels are entities in an ecs::World (see ecs.h),
+	//these add one above the terrain (or on the water) near 'position'
+	void spawnBalloon(
+		ecs::World &world,
 		const glm::vec3 &position,
-		float rotation,
 		const infworld::worldseed &permutations
 	);
-	Enemy spawnPlane(
+	void spawnShip(
+		ecs::World &world,
+		const glm::vec3 &position,
+		const infworld::worldseed &permutations
+	);
+	void spawnBarrel(
+		ecs::World &world,
 		const glm::vec3 &position,
-		float rotation,
 		const infworld::worldseed &permutations
 	);
-
-	struct Props {
-			//How many points the player gets if they kill the enemy
-			unsigned int scorevalue;
-			game::Transform transform;
-			std::unordered_map<std::string, float> values;
-			int hitpoints;
-			Props(glm::vec3 position, int hp, unsigned int scoreval);
-			void updateBarrel(float dt);
-			float getVal(const std::string &key) const;
-			void setVal(const std::string &key, float v);
-
-	};
-
-	Props spawnBarrel(const glm::vec3 &position, const infworld::worldseed &permutations);
 }
 
 namespace game {
+	//The spawn functions draw their values with rng::random() using
+	//'seed' (see infworld::getWorldSeed) and 'index', which should be
+	//different for every attempt (like the simulation tick) so that the
+	//result does not depend on what else was spawned before it
 	//Spawns barrels around the player
 	void spawnBarrels(
 		gameobjects::Player &player,
-		std::vector<gameobjects::Props> &barrels,
-		std::minstd_rand0 &lcg,
+		ecs::World &world,
+		uint32_t seed,
+		uint32_t index,
 		const infworld::worldseed &permutations
 	);
 	//Spawns balloons around the player
 	void spawnBalloons(
 		gameobjects::Player &player,
-		std::vector<gameobjects::Enemy> &balloons,
-		std::minstd_rand0 &lcg,
+		ecs::World &world,
+		uint32_t seed,
+		uint32_t index,
 		const infworld::worldseed &permutations
 	);
 	//Spawns ships around the player
 	void spawnShips(
 		gameobjects::Player &player,
-		std::vector<gameobjects::Enemy> &ships,
-		std::minstd_rand0 &lcg,
+		ecs::World &world,
+		uint32_t seed,
+		uint32_t index,
 		const infworld::worldseed &permutations
 	);
-	//Spawns blimps around the player
-	void spawnBlimps(
-		gameobjects::Player &player,
-		std::vector<gameobjects::Enemy> &blimps,
-		std::minstd_rand0 &lcg
-	);
-	//Spawn ufos around the player
-	void spawnUfos(
-		gameobjects::Player &player,
-		std::vector<gameobjects::Enemy> &ufos,
-		std::minstd_rand0 &lcg,
-		const infworld::worldseed &permutations
-	);
-	//Spawn planes around the player
-	void spawnPlanes(
-		gameobjects::Player &player,
-		std::vector<gameobjects::Enemy> &planes,
-		std::minstd_rand0 &lcg,
-		const infworld::worldseed &permutations,
-		float totalTime
-	);
-	void destroyEnemies(
-		gameobjects::Player &player,
-		std::vector<gameobjects::Enemy> &enemies,
-		std::vector<gameobjects::Explosion> &explosions,
-		float explosionscale,
-		float crashdist,
-		unsigned int &score
-	);
-	void checkForCollision(
-		gameobjects::Player &player,
-		std::vector<gameobjects::Enemy> &enemies,
-		std::vector<gameobjects::Explosion> &explosions,
-		float explosionscale,
-		const glm::vec3 &extents
-	);
-	void destroyProps(
-		gameobjects::Player &player,
-		std::vector<gameobjects::Props> &props,
-		std::vector<gameobjects::Explosion> &explosions,
-		float explosionscale,
-		float crashdist,
-		unsigned int &score
-	);
-	void checkForCollision(
-		gameobjects::Player &player,
-		std::vector<gameobjects::Props> &enemies,
-		const glm::vec3 &extents
-	);
-	//Check for collision among enemies
-	void checkForCollision(std::vector<gameobjects::Enemy> &enemies, float hitdist);
-	//Check for collision among props
-	void checkForCollision(std::vector<gameobjects::Props> &props, float hitdist);
 	//Returns the position the camera should be following
 	glm::vec3 getCameraFollowPos(const Transform &playertransform);
 	//Have the camera follow the player	
 	void updateCamera(gameobjects::Player &player);
 	void updateCamera(gameobjects::Player &player, float dt);
+	void updateCamera(const Transform &playertransform);
+	void updateCamera(const Transform &playertransform, float dt);
 	//Update explosions
 	void updateExplosions(
 		std::vector<gameobjects::Explosion> &explosions, 
@@ -307,11 +293,6 @@ namespace game {
 		const gameobjects::Player &player
 	);
 	void updateBullets(std::vector<gameobjects::Bullet> &bullets, float dt);
-	void checkForHit(
-		std::vector<gameobjects::Bullet> &bullets,
-		std::vector<gameobjects::Enemy> &enemies,
-		float hitdist
-	);
 	void checkForHit(
 		std::vector<gameobjects::Bullet> &bullets,
 		gameobjects::Player &player,
@@ -324,28 +305,169 @@ namespace game {
 }
 
 namespace gfx {
-	void displaySkybox();
-	void displayWater(float totalTime);
-	void displayDecorations(infworld::DecorationTable &decorations, float totalTime);
-	unsigned int displayTerrain(infworld::ChunkTable *chunktables, int maxlod, float lodscale);	
-	void generateDecorationOffsets(infworld::DecorationTable &decorations);
-	void displayPlayerPlane(float totalTime, const game::Transform &transform, const std::string& plane_model);
-	void displayExplosions(const std::vector<gameobjects::Explosion> &explosions);
-	void displayBalloons(const std::vector<gameobjects::Enemy> &balloons);
-	void displayBarrels(const std::vector<gameobjects::Props> &barrels);
-	void displayShips(const std::vector<gameobjects::Enemy> &ships);
-	void displayBlimps(const std::vector<gameobjects::Enemy> &blimps);
-	void displayUfos(const std::vector<gameobjects::Enemy> &ufos);
-	void displayPlanes(float totalTime, const std::vector<gameobjects::Enemy> &planes);
-	void displayBullets(const std::vector<gameobjects::Bullet> &bullets);
-	void displayMiniMapBackground(float totalTime);
-	void displayAttitude(float pitch, float roll);
-	void displaySpeed(float speed);
-	void displayFuel(float fuel, float totalTime);
-	void displayEnemyMarkers(
-		const std::vector<gameobjects::Enemy> &enemies,
-		const game::Transform &playertransform
+	//Something drawn with the textured shader that passed culling
+	struct ObjectInstance {
+		glm::vec3 position;
+		glm::mat4 transform;
+		glm::mat3 normal;
+	};
+
+	struct ExplosionInstance {
+		glm::vec3 position;
+		//Time the explosion started at
+		float start;
+		float scale;
+		//Squared distance to the camera
+		float distance2;
+	};
+
+	//One explosion particle, this is the layout of the particle instance
+	//buffer (attribute 1 is center + start, attribute 2 is the rest)
+	struct ParticleInstance {
+		glm::vec3 center;
+		float start;
+		//Picks the direction, size and spin of the particle
+		float seed;
+		float scale;
+		//Grows the particles when an explosion gets less of them
+		float size;
+	};
+
+	struct ParticleStats {
+		unsigned int explosions = 0;
+		unsigned int particles = 0;
+		unsigned int perexplosion = 0;
+		//Explosions that did not fit in the budget at all
+		unsigned int dropped = 0;
+	};
+
+	//How long one frame prep task took
+	struct PrepTiming {
+		const char *name;
+		float ms;
+	};
+
+	//The parts of the world that prepareFrame looks at, anything that is
+	//null is skipped
+	struct FrameInput {
+		infworld::ChunkTable *chunktables = nullptr;
+		int maxlod = 0;
+		float lodscale = 1.0f;
+		infworld::DecorationTable *decorations = nullptr;
+		const std::vector<game::EntityState> *balloons = nullptr;
+		const std::vector<game::EntityState> *ships = nullptr;
+		const std::vector<game::EntityState> *barrels = nullptr;
+		const std::vector<gameobjects::Explosion> *explosions = nullptr;
+		game::Transform playertransform;
+		//Time used for the start time of the explosion particles
+		float totalTime = 0.0f;
+		//Most particles that are drawn, explosions get fewer (but larger)
+		//particles once there are too many of them for this and the
+		//farthest ones are dropped when even that is not enough
+		unsigned int particlebudget = MAX_PARTICLES;
+	};
+
+	//Everything the display functions need that can be worked out without
+	//the graphics api, this is reused every frame so that the vectors do
+	//not have to be reallocated
+	struct FrameData {
+		//Center and range of each LOD used by the terrain shader
+		glm::vec2 terraincenter;
+		std::vector<glm::vec2> terrainranges;
+		std::vector<ObjectInstance> balloons, ships, barrels;
+		//HUD transforms of the minimap markers
+		std::vector<glm::mat4> balloonmarkers, shipmarkers;
+		//Sorted back to front
+		std::vector<ExplosionInstance> explosions;
+		//Particles of every explosion that is drawn, back to front
+		std::vector<ParticleInstance> particles;
+		ParticleStats particlestats;
+		std::vector<PrepTiming> timings;
+		//Wall clock time of the whole prep phase
+		float totalms = 0.0f;
+	};
+
+	//Frame prep, builds the horizon from the terrain and then culls the
+	//terrain (per LOD), the decorations, packs the transforms of each
+	//object type, places the minimap markers and sorts the explosions and
+	//fills in their particles on the job system, the results end up in
+	//'frame'
+	//Nothing here calls the graphics api, the display functions below
+	//consume 'frame' on the main thread
+	void prepareFrame(FrameData &frame, const FrameInput &input, geo::HorizonBuffer &horizon);
+	//Transforms of the objects that are not hidden behind 'horizon',
+	//objects are treated as spheres with 'radius'
+	void packObjects(
+		const std::vector<game::EntityState> &objects,
+		const geo::HorizonBuffer &horizon,
+		float radius,
+		float scale,
+		std::vector<ObjectInstance> &out
+	);
+
+	//These do not draw anything immediately, they add draw packets to
+	//'queue' which is then sorted and submitted once per frame
+	void displaySkybox(RenderQueue &queue);
+	void displayWater(RenderQueue &queue, float totalTime);
+	//Uploads the decorations (trees) that were visible in prepareFrame
+	//and draws them
+	void displayDecorations(
+		RenderQueue &queue,
+		infworld::DecorationTable &decorations,
+		float totalTime
+	);
+	//Draws the chunks that were visible in prepareFrame
+	unsigned int displayTerrain(
+		RenderQueue &queue,
+		infworld::ChunkTable *chunktables,
+		int maxlod,
+		const FrameData &frame
+	);
+	//Sets which tree model is used at what distance, trees further than
+	//'impostordist' chunk widths away are drawn as impostors if they
+	//were baked
+	void setDecorationLods(
+		infworld::DecorationTable &decorations,
+		float impostordist = IMPOSTOR_DIST
+	);
+	void displayPlayerPlane(
+		RenderQueue &queue,
+		float totalTime,
+		const game::Transform &transform,
+		sym::Symbol plane_model
+	);
+	//Updates the particle instance buffer and draws every particle with
+	//one instanced draw
+	void displayExplosions(
+		RenderQueue &queue,
+		const std::vector<ParticleInstance> &particles,
+		float totalTime
+	);
+	void displayBalloons(RenderQueue &queue, const std::vector<ObjectInstance> &balloons);
+	void displayBarrels(RenderQueue &queue, const std::vector<ObjectInstance> &barrels);
+	void displayShips(RenderQueue &queue, const std::vector<ObjectInstance> &ships);
+	void displayBlimps(
+		RenderQueue &queue,
+		const std::vector<game::EntityState> &blimps,
+		const geo::HorizonBuffer &horizon
+	);
+	void displayUfos(
+		RenderQueue &queue,
+		const std::vector<game::EntityState> &ufos,
+		const geo::HorizonBuffer &horizon
+	);
+	void displayPlanes(
+		RenderQueue &queue,
+		float totalTime,
+		const std::vector<game::EntityState> &planes,
+		const geo::HorizonBuffer &horizon
 	);
-	void displayCrosshair(const game::Transform &playertransform);
-	void displayHUDBackGrounds();
+	void displayBullets(RenderQueue &queue, const std::vector<gameobjects::Bullet> &bullets);
+	void displayMiniMapBackground(RenderQueue &queue, float totalTime);
+	void displayAttitude(RenderQueue &queue, float pitch, float roll);
+	void displaySpeed(RenderQueue &queue, float speed);
+	void displayFuel(RenderQueue &queue, float fuel, float totalTime);
+	void displayEnemyMarkers(RenderQueue &queue, const std::vector<glm::mat4> &markers);
+	void displayCrosshair(RenderQueue &queue, const game::Transform &playertransform);
+	void displayHUDBackGrounds(RenderQueue &queue);
 }
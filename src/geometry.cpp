@@ -46,4 +46,28 @@ namespace geo {
 			inFront(frustum.top, aabb) &&
 			inFront(frustum.bottom, aabb);
 	}
+
+	FrustumTest testFrustum(const Frustum &frustum, const AABB &aabb)
+	{
+		const Plane *planes[] = {
+			&frustum.back,
+			&frustum.front,
+			&frustum.left,
+			&frustum.right,
+			&frustum.top,
+			&frustum.bottom,
+		};
+
+		glm::vec3 extent = aabb.dimensions / 2.0f;
+		FrustumTest result = INSIDE_FRUSTUM;
+		for(const Plane *p : planes) {
+			float r = glm::dot(glm::abs(p->norm), extent);
+			float d = signedDist(*p, aabb.pos);
+			if(d < -r)
+				return OUTSIDE_FRUSTUM;
+			if(d < r)
+				result = INTERSECTS_FRUSTUM;
+		}
+		return result;
+	}
 }
@@ -27,9 +27,18 @@ namespace geo {
 			right;
 	};
 
+	enum FrustumTest {
+		OUTSIDE_FRUSTUM,
+		INTERSECTS_FRUSTUM,
+		INSIDE_FRUSTUM,
+	};
+
 	float signedDist(const Plane &p, const glm::vec3 &pos);
 	bool inFront(const Plane &p, const glm::vec3 &pos);
 	bool inFront(const Plane &p, const AABB &aabb);
 	bool intersectsFrustum(const Frustum &frustum, const AABB &aabb);
+	//Same as intersectsFrustum but also tells if the box is completely
+	//inside of the frustum
+	FrustumTest testFrustum(const Frustum &frustum, const AABB &aabb);
 };
 #endif
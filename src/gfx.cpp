@@ -1,10 +1,12 @@
 #define _USE_MATH_DEFINES
 #include "gfx.h"
+#include "assetpack.h"
+#include <algorithm>
 #include <assert.h>
 #include <fast_obj/fast_obj.h>
 #include <math.h>
-#include <sstream>
 #include <stb_image/stb_image.h>
+#include <string.h>
 #include <unordered_map>
 #include "logger.h"
 
@@ -27,27 +29,28 @@ void Model::dataToBuffers(const std::vector<unsigned int> &buffers) const {
   // index 3 = indices
   ASSERT(buffers.size() >= 4, "FAILED!!");
 
-  mesh::Meshf vertdata = vertData(), tcdata = tcData(), normData = normalData();
+  // The glm vectors are tightly packed floats so they are uploaded as is
   // vertex positions
-  glBindBuffer(GL_ARRAY_BUFFER, buffers.at(0));
-  glBufferData(GL_ARRAY_BUFFER, vertdata.size(), vertdata.ptr(),
-               GL_STATIC_DRAW);
-  glVertexAttribPointer(0, 3, GL_FLOAT, false, 3 * sizeof(float), (void *)0);
-  glEnableVertexAttribArray(0);
+  GFX->bindBuffer(GL_ARRAY_BUFFER, buffers.at(0));
+  GFX->bufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3),
+               vertices.data(), GL_STATIC_DRAW);
+  GFX->vertexAttribPointer(0, 3, GL_FLOAT, false, 3 * sizeof(float), (void *)0);
+  GFX->enableVertexAttribArray(0);
   // texture coordinates
-  glBindBuffer(GL_ARRAY_BUFFER, buffers.at(1));
-  glBufferData(GL_ARRAY_BUFFER, tcdata.size(), tcdata.ptr(), GL_STATIC_DRAW);
-  glVertexAttribPointer(1, 2, GL_FLOAT, false, 2 * sizeof(float), (void *)0);
-  glEnableVertexAttribArray(1);
+  GFX->bindBuffer(GL_ARRAY_BUFFER, buffers.at(1));
+  GFX->bufferData(GL_ARRAY_BUFFER, texturecoords.size() * sizeof(glm::vec2),
+               texturecoords.data(), GL_STATIC_DRAW);
+  GFX->vertexAttribPointer(1, 2, GL_FLOAT, false, 2 * sizeof(float), (void *)0);
+  GFX->enableVertexAttribArray(1);
   // normals
-  glBindBuffer(GL_ARRAY_BUFFER, buffers.at(2));
-  glBufferData(GL_ARRAY_BUFFER, normData.size(), normData.ptr(),
-               GL_STATIC_DRAW);
-  glVertexAttribPointer(2, 3, GL_FLOAT, false, 3 * sizeof(float), (void *)0);
-  glEnableVertexAttribArray(2);
+  GFX->bindBuffer(GL_ARRAY_BUFFER, buffers.at(2));
+  GFX->bufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3),
+               normals.data(), GL_STATIC_DRAW);
+  GFX->vertexAttribPointer(2, 3, GL_FLOAT, false, 3 * sizeof(float), (void *)0);
+  GFX->enableVertexAttribArray(2);
   // indices
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.at(3));
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int),
+  GFX->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.at(3));
+  GFX->bufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int),
                &indices[0], GL_STATIC_DRAW);
 }
 
@@ -338,36 +341,77 @@ void transformModelTc(Model &model, const glm::mat4 &transform) {
 }
 
 Model mergeModels(const Model &model1, const Model &model2) {
-  Model merged;
-
-  // Copy model data into merged model
-  merged.vertices = model1.vertices;
-  merged.normals = model1.normals;
-  merged.texturecoords = model1.texturecoords;
-  merged.indices = model1.indices;
-
-  // Copy model 2's data to the merged model (adjust vertices as needed)
-  for (auto &vert : model2.vertices)
-    merged.vertices.push_back(vert);
-  for (auto &norm : model2.normals)
-    merged.normals.push_back(norm);
-  for (auto &tc : model2.texturecoords)
-    merged.texturecoords.push_back(tc);
-  unsigned int startingindex = model1.vertices.size();
-  for (auto index : model2.indices)
-    merged.indices.push_back(startingindex + index);
-
+  Model merged = model1;
+  appendModel(merged, model2);
   return merged;
 }
 
-std::string indicesToStr(unsigned int v, unsigned int t, unsigned int n) {
-  std::stringstream ss;
-  ss << v << '/' << t << '/' << n;
-  return ss.str();
+void appendModel(Model &model, const Model &other) {
+  // Copy the other model's data to the end (adjust indices as needed)
+  unsigned int startingindex = model.vertices.size();
+  model.vertices.insert(model.vertices.end(), other.vertices.begin(),
+                        other.vertices.end());
+  model.normals.insert(model.normals.end(), other.normals.begin(),
+                       other.normals.end());
+  model.texturecoords.insert(model.texturecoords.end(),
+                             other.texturecoords.begin(),
+                             other.texturecoords.end());
+  model.indices.reserve(model.indices.size() + other.indices.size());
+  for (auto index : other.indices)
+    model.indices.push_back(startingindex + index);
 }
 
+// fast_obj reads the .obj and its .mtl files through these so that they can
+// come from the asset pack
+struct ObjFile {
+  assetpack::FileData data;
+  size_t pos = 0;
+};
+
+void *objFileOpen(const char *path, void *) {
+  ObjFile *file = new ObjFile;
+  if (!assetpack::readFile(path, file->data)) {
+    delete file;
+    return nullptr;
+  }
+  return file;
+}
+
+void objFileClose(void *file, void *) { delete (ObjFile *)file; }
+
+size_t objFileRead(void *file, void *dst, size_t bytes, void *) {
+  ObjFile *f = (ObjFile *)file;
+  size_t count = std::min(bytes, f->data.size() - f->pos);
+  memcpy(dst, f->data.data() + f->pos, count);
+  f->pos += count;
+  return count;
+}
+
+unsigned long objFileSize(void *file, void *) {
+  return ((ObjFile *)file)->data.size();
+}
+
+// position/texture coordinate/normal index triple of an obj face corner
+struct ObjIndex {
+  unsigned int p, t, n;
+  bool operator==(const ObjIndex &other) const {
+    return p == other.p && t == other.t && n == other.n;
+  }
+};
+
+struct ObjIndexHash {
+  size_t operator()(const ObjIndex &ind) const {
+    uint64_t h = ind.p;
+    h = h * 0x9e3779b97f4a7c15ULL ^ ind.t;
+    h = h * 0x9e3779b97f4a7c15ULL ^ ind.n;
+    return size_t(h ^ (h >> 32));
+  }
+};
+
 Model loadObjModel(const char *path) {
-  fastObjMesh *m = fast_obj_read(path);
+  const fastObjCallbacks callbacks = {objFileOpen, objFileClose, objFileRead,
+                                      objFileSize};
+  fastObjMesh *m = fast_obj_read_with_callbacks(path, &callbacks, nullptr);
 
   if (!m) {
     fast_obj_destroy(m);
@@ -404,20 +448,22 @@ Model loadObjModel(const char *path) {
     texturecoords.push_back(tc);
   }
 
-  std::unordered_map<std::string, unsigned int> indices;
+  std::unordered_map<ObjIndex, unsigned int, ObjIndexHash> indices;
+  indices.reserve(m->index_count);
   model.indices.reserve(m->index_count);
   unsigned int index = 0;
   for (int i = 0; i < m->index_count; i++) {
     fastObjIndex ind = m->indices[i];
-    std::string indstr = indicesToStr(ind.p, ind.t, ind.n);
-    if (indices.count(indstr))
-      model.indices.push_back(indices.at(indstr));
+    ObjIndex key = {ind.p, ind.t, ind.n};
+    auto found = indices.find(key);
+    if (found != indices.end())
+      model.indices.push_back(found->second);
     else {
       model.vertices.push_back(vertices.at(ind.p));
       model.normals.push_back(normals.at(ind.n));
       model.texturecoords.push_back(texturecoords.at(ind.t));
       model.indices.push_back(index);
-      indices.insert({indstr, index});
+      indices.insert({key, index});
       index++;
     }
   }
@@ -450,12 +496,12 @@ Meshf Model::tcData() const {
 } // namespace mesh
 
 namespace gfx {
-void Vao::bind() const { glBindVertexArray(vaoid); }
+void Vao::bind() const { GFX->bindVertexArray(vaoid); }
 
 void Vao::genBuffers(unsigned int count) {
-  glGenVertexArrays(1, &vaoid);
+  GFX->genVertexArrays(1, &vaoid);
   buffers = std::vector<unsigned int>(count);
-  glGenBuffers(buffers.size(), &buffers[0]);
+  GFX->genBuffers(buffers.size(), &buffers[0]);
 }
 
 Vao createQuadVao() {
@@ -470,17 +516,17 @@ Vao createQuadVao() {
 
   Vao quadvao;
   quadvao.buffers = std::vector<unsigned int>(2);
-  glGenVertexArrays(1, &quadvao.vaoid);
-  glBindVertexArray(quadvao.vaoid);
-  glGenBuffers(2, &quadvao.buffers[0]);
-  glBindBuffer(GL_ARRAY_BUFFER, quadvao.buffers[0]);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD), QUAD, GL_STATIC_DRAW);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadvao.buffers[1]);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(QUAD_INDICES), QUAD_INDICES,
+  GFX->genVertexArrays(1, &quadvao.vaoid);
+  GFX->bindVertexArray(quadvao.vaoid);
+  GFX->genBuffers(2, &quadvao.buffers[0]);
+  GFX->bindBuffer(GL_ARRAY_BUFFER, quadvao.buffers[0]);
+  GFX->bufferData(GL_ARRAY_BUFFER, sizeof(QUAD), QUAD, GL_STATIC_DRAW);
+  GFX->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadvao.buffers[1]);
+  GFX->bufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(QUAD_INDICES), QUAD_INDICES,
                GL_STATIC_DRAW);
-  glVertexAttribPointer(0, 3, GL_FLOAT, false, 3 * sizeof(float), (void *)0);
-  glEnableVertexAttribArray(0);
-  glBindVertexArray(0);
+  GFX->vertexAttribPointer(0, 3, GL_FLOAT, false, 3 * sizeof(float), (void *)0);
+  GFX->enableVertexAttribArray(0);
+  GFX->bindVertexArray(0);
 
   quadvao.vertcount = 6;
   return quadvao;
@@ -514,21 +560,63 @@ Vao createCubeVao() {
 
   Vao cubevao;
   cubevao.buffers = std::vector<unsigned int>(2);
-  glGenVertexArrays(1, &cubevao.vaoid);
-  glBindVertexArray(cubevao.vaoid);
-  glGenBuffers(2, &cubevao.buffers[0]);
-  glBindBuffer(GL_ARRAY_BUFFER, cubevao.buffers[0]);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(CUBE), CUBE, GL_STATIC_DRAW);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubevao.buffers[1]);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(CUBE_INDICES), CUBE_INDICES,
+  GFX->genVertexArrays(1, &cubevao.vaoid);
+  GFX->bindVertexArray(cubevao.vaoid);
+  GFX->genBuffers(2, &cubevao.buffers[0]);
+  GFX->bindBuffer(GL_ARRAY_BUFFER, cubevao.buffers[0]);
+  GFX->bufferData(GL_ARRAY_BUFFER, sizeof(CUBE), CUBE, GL_STATIC_DRAW);
+  GFX->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubevao.buffers[1]);
+  GFX->bufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(CUBE_INDICES), CUBE_INDICES,
                GL_STATIC_DRAW);
-  glVertexAttribPointer(0, 3, GL_FLOAT, false, 3 * sizeof(float), (void *)0);
-  glEnableVertexAttribArray(0);
+  GFX->vertexAttribPointer(0, 3, GL_FLOAT, false, 3 * sizeof(float), (void *)0);
+  GFX->enableVertexAttribArray(0);
 
   cubevao.vertcount = 36;
   return cubevao;
 }
 
+Vao createParticleVao(unsigned int capacity) {
+  // Same quad as createQuadVao
+  const float QUAD[] = {
+      1.0f,  0.0f, 1.0f, 1.0f,  0.0f, -1.0f,
+      -1.0f, 0.0f, 1.0f, -1.0f, 0.0f, -1.0f,
+  };
+
+  const unsigned int QUAD_INDICES[] = {
+      0, 1, 2, 1, 3, 2,
+  };
+
+  // center.xyz + start, then seed, scale, size
+  const unsigned int STRIDE = 7 * sizeof(float);
+
+  Vao particlevao;
+  particlevao.genBuffers(3);
+  particlevao.bind();
+  GFX->bindBuffer(GL_ARRAY_BUFFER, particlevao.buffers[0]);
+  GFX->bufferData(GL_ARRAY_BUFFER, sizeof(QUAD), QUAD, GL_STATIC_DRAW);
+  GFX->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, particlevao.buffers[1]);
+  GFX->bufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(QUAD_INDICES), QUAD_INDICES,
+               GL_STATIC_DRAW);
+  GFX->vertexAttribPointer(0, 3, GL_FLOAT, false, 3 * sizeof(float), (void *)0);
+  GFX->enableVertexAttribArray(0);
+
+  // Allocated once, the particles are written with bufferSubData
+  GFX->bindBuffer(GL_ARRAY_BUFFER, particlevao.buffers[2]);
+  GFX->bufferData(GL_ARRAY_BUFFER, STRIDE * capacity, nullptr, GL_DYNAMIC_DRAW);
+  GFX->vertexAttribPointer(1, 4, GL_FLOAT, false, STRIDE, (void *)0);
+  GFX->enableVertexAttribArray(1);
+  GFX->vertexAttribDivisor(1, 1);
+  GFX->vertexAttribPointer(2, 3, GL_FLOAT, false, STRIDE,
+                           (void *)(4 * sizeof(float)));
+  GFX->enableVertexAttribArray(2);
+  GFX->vertexAttribDivisor(2, 1);
+  GFX->bindVertexArray(0);
+  GFX->bindBuffer(GL_ARRAY_BUFFER, 0);
+
+  particlevao.vertcount = 6;
+  return particlevao;
+}
+
 Vao createModelVao(const mesh::Model &model) {
   Vao vao;
   vao.genBuffers(4);
@@ -539,18 +627,18 @@ Vao createModelVao(const mesh::Model &model) {
 }
 
 void destroyVao(Vao &vao) {
-  glDeleteVertexArrays(1, &vao.vaoid);
-  glDeleteBuffers(vao.buffers.size(), &vao.buffers[0]);
+  GFX->deleteVertexArrays(1, &vao.vaoid);
+  GFX->deleteBuffers(vao.buffers.size(), &vao.buffers[0]);
   vao.vertcount = 0;
   vao.buffers.clear();
 }
 
 void outputErrors() {
-  GLenum err = glGetError();
+  GLenum err = GFX->getError();
   int errorcount = 0;
   while (err != GL_NO_ERROR) {
     fprintf(stderr, "OpenGL error: %d\n", err);
-    err = glGetError();
+    err = GFX->getError();
     errorcount++;
   }
 
@@ -570,58 +658,85 @@ GLenum getFormat(int channels) {
   return GL_RGBA;
 }
 
-bool loadTexture(const char *path, unsigned int textureid, bool flipvertical) {
-  stbi_set_flip_vertically_on_load(flipvertical);
+bool decodeImage(const char *path, bool flipvertical, ImageData &image) {
+  // The flip flag is thread local so decoding on several threads at once
+  // does not mix up the flag between images
+  assetpack::FileData file;
+  if (!assetpack::readFile(path, file)) {
+    image = ImageData();
+    return false;
+  }
+  stbi_set_flip_vertically_on_load_thread(flipvertical);
   int width, height, channels;
-  unsigned char *data = stbi_load(path, &width, &height, &channels, 0);
-  bool success = false;
-  if (data) {
-    success = true;
-    GLenum format = getFormat(channels);
-    glBindTexture(GL_TEXTURE_2D, textureid);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
-                 GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    INFO("Texture loaded successfully : %s", path);
-  } else
-    ERROR("Failed to open: %s", path);
+  unsigned char *data = stbi_load_from_memory(
+      file.data(), int(file.size()), &width, &height, &channels, 0);
+  stbi_set_flip_vertically_on_load_thread(false); // reset flag to false
+  if (!data) {
+    image = ImageData();
+    return false;
+  }
+  image.width = width;
+  image.height = height;
+  image.channels = channels;
+  image.pixels = std::shared_ptr<unsigned char>(data, stbi_image_free);
+  return true;
+}
 
-  stbi_set_flip_vertically_on_load(false); // reset flag to false
-  stbi_image_free(data);
-  return success;
+void uploadTexture(const ImageData &image, unsigned int textureid) {
+  GLenum format = getFormat(image.channels);
+  GFX->bindTexture(GL_TEXTURE_2D, textureid);
+  GFX->texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  GFX->texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  GFX->texImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0,
+                  format, GL_UNSIGNED_BYTE, image.pixels.get());
+  GFX->generateMipmap(GL_TEXTURE_2D);
+}
+
+void uploadCubemap(const std::vector<ImageData> &faces,
+                   unsigned int textureid) {
+  assert(faces.size() == 6); // faces must have 6 elements in it
+  GFX->bindTexture(GL_TEXTURE_CUBE_MAP, textureid);
+
+  for (int i = 0; i < 6; i++) {
+    const ImageData &face = faces.at(i);
+    if (!face.pixels)
+      continue;
+    GLenum format = getFormat(face.channels);
+    GFX->texImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, format, face.width,
+                    face.height, 0, format, GL_UNSIGNED_BYTE,
+                    face.pixels.get());
+  }
+
+  GFX->texParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  GFX->texParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  GFX->texParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  GFX->texParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  GFX->texParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+}
+
+bool loadTexture(const char *path, unsigned int textureid, bool flipvertical) {
+  ImageData image;
+  if (!decodeImage(path, flipvertical, image)) {
+    ERROR("Failed to open: %s", path);
+    return false;
+  }
+  uploadTexture(image, textureid);
+  INFO("Texture loaded successfully : %s", path);
+  return true;
 }
 
 bool loadCubemap(const std::vector<std::string> &faces,
                  unsigned int textureid) {
   bool success = true;
-  int width, height, channels;
   assert(faces.size() == 6); // faces must have 6 elements in it
-  glBindTexture(GL_TEXTURE_CUBE_MAP, textureid);
-
+  std::vector<ImageData> images(6);
   for (int i = 0; i < 6; i++) {
-    unsigned char *data =
-        stbi_load(faces.at(i).c_str(), &width, &height, &channels, 0);
-
-    if (data) {
-      GLenum format = getFormat(channels);
-      glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, format, width, height,
-                   0, format, GL_UNSIGNED_BYTE, data);
-    } else {
+    if (!decodeImage(faces.at(i).c_str(), false, images.at(i))) {
       ERROR("Failed to open cubemap file: %s", faces.at(i).c_str());
       success = false;
     }
-
-    stbi_image_free(data);
   }
-
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
+  uploadCubemap(images, textureid);
   return success;
 }
 
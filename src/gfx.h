@@ -1,7 +1,8 @@
 #ifndef GFX_H
 #define GFX_H
 
-#include "opengl.h"
+#include "gfxbackend.h"
+#include <memory>
 #include <vector>
 #include <glm/glm.hpp>
 #include <string>
@@ -68,6 +69,8 @@ namespace mesh {
 	void transformModelTc(Model &model, const glm::mat4 &transform);
 	//Combines two models, returns the combined model
 	Model mergeModels(const Model &model1, const Model &model2);
+	//Adds 'other' to the end of 'model' in place
+	void appendModel(Model &model, const Model &other);
 	//Loads a model from an obj file, uses the fast_obj library as a dependency
 	Model loadObjModel(const char *path);
 }
@@ -77,6 +80,8 @@ namespace gfx {
 		unsigned int vertcount;
 		unsigned int vaoid;
 		std::vector<unsigned int> buffers;
+		//Type of the indices in the element buffer
+		GLenum indextype = GL_UNSIGNED_INT;
 		void genBuffers(unsigned int count);
 		void bind() const;
 	};
@@ -84,6 +89,10 @@ namespace gfx {
 	Vao createQuadVao();
 	//Create a cube vao (only position vectors - not texture/normal data)
 	Vao createCubeVao();
+	//Create a quad vao with an instance buffer (index 2) that has room for
+	//'capacity' particles, attribute 1 is a vec4 and attribute 2 is a vec3
+	//and both advance once per instance
+	Vao createParticleVao(unsigned int capacity);
 	//Creates a vao from a model (has normal and texture coordinate data)
 	Vao createModelVao(const mesh::Model &model);
 	void destroyVao(Vao &vao);
@@ -102,6 +111,18 @@ namespace gfx {
 	//Attempts to load all 6 faces of a cubemap from a vector of 6 paths
 	//If loading a face fails, the function will return false, otherwise true
 	bool loadCubemap(const std::vector<std::string> &faces, unsigned int textureid);
+	//Pixels read from an image file, decoding does not touch the graphics
+	//api so it can be done on any thread, the upload functions below must
+	//be called on the main thread
+	struct ImageData {
+		int width = 0, height = 0, channels = 0;
+		std::shared_ptr<unsigned char> pixels;
+	};
+	//Returns false (and leaves 'image' empty) if the file can not be read
+	bool decodeImage(const char *path, bool flipvertical, ImageData &image);
+	void uploadTexture(const ImageData &image, unsigned int textureid);
+	//'faces' are in the same order as for loadCubemap, empty faces are skipped
+	void uploadCubemap(const std::vector<ImageData> &faces, unsigned int textureid);
 
 	//Converts a normal vector (x, y, z) to a 2d vector consisting of
 	//angles that represent the vector (we assume the original 3d vector
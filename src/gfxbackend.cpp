@@ -0,0 +1,1153 @@
+#include "gfxbackend.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+	gfx::GLBackend glbackend;
+	gfx::GraphicsBackend *current = &glbackend;
+
+	//Only the formats that the engine uploads are handled
+	size_t textureBytes(GLsizei width, GLsizei height, GLenum format, GLenum type)
+	{
+		size_t channels = 4;
+		switch(format) {
+		case GL_RED:
+			channels = 1;
+			break;
+		case GL_RG:
+			channels = 2;
+			break;
+		case GL_RGB:
+			channels = 3;
+			break;
+		default:
+			break;
+		}
+		size_t sz = type == GL_FLOAT ? sizeof(float) : 1;
+		return size_t(width) * size_t(height) * channels * sz;
+	}
+
+	size_t sourceBytes(GLsizei count, const GLchar *const *string, const GLint *length)
+	{
+		size_t total = 0;
+		for(GLsizei i = 0; i < count; i++) {
+			if(length && length[i] >= 0)
+				total += length[i];
+			else
+				total += strlen(string[i]);
+		}
+		return total;
+	}
+
+	void generateIds(GLuint &nextid, GLsizei n, GLuint *ids)
+	{
+		for(GLsizei i = 0; i < n; i++)
+			ids[i] = nextid++;
+	}
+}
+
+namespace gfx {
+	GraphicsBackend* GraphicsBackend::get()
+	{
+		return current;
+	}
+
+	void GraphicsBackend::set(GraphicsBackend *backend)
+	{
+		current = backend ? backend : &glbackend;
+	}
+
+	void GLBackend::genVertexArrays(GLsizei n, GLuint *arrays)
+	{
+		glGenVertexArrays(n, arrays);
+	}
+
+	void GLBackend::deleteVertexArrays(GLsizei n, const GLuint *arrays)
+	{
+		glDeleteVertexArrays(n, arrays);
+	}
+
+	void GLBackend::bindVertexArray(GLuint array)
+	{
+		glBindVertexArray(array);
+	}
+
+	void GLBackend::genBuffers(GLsizei n, GLuint *buffers)
+	{
+		glGenBuffers(n, buffers);
+	}
+
+	void GLBackend::deleteBuffers(GLsizei n, const GLuint *buffers)
+	{
+		glDeleteBuffers(n, buffers);
+	}
+
+	void GLBackend::bindBuffer(GLenum target, GLuint buffer)
+	{
+		glBindBuffer(target, buffer);
+	}
+
+	void GLBackend::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+	{
+		glBindBufferBase(target, index, buffer);
+	}
+
+	void GLBackend::bufferData(
+		GLenum target,
+		GLsizeiptr size,
+		const void *data,
+		GLenum usage
+	) {
+		glBufferData(target, size, data, usage);
+	}
+
+	void GLBackend::bufferSubData(
+		GLenum target,
+		GLintptr offset,
+		GLsizeiptr size,
+		const void *data
+	) {
+		glBufferSubData(target, offset, size, data);
+	}
+
+	void GLBackend::vertexAttribPointer(
+		GLuint index,
+		GLint size,
+		GLenum type,
+		GLboolean normalized,
+		GLsizei stride,
+		const void *pointer
+	) {
+		glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+	}
+
+	void GLBackend::vertexAttribIPointer(
+		GLuint index,
+		GLint size,
+		GLenum type,
+		GLsizei stride,
+		const void *pointer
+	) {
+		glVertexAttribIPointer(index, size, type, stride, pointer);
+	}
+
+	void GLBackend::enableVertexAttribArray(GLuint index)
+	{
+		glEnableVertexAttribArray(index);
+	}
+
+	void GLBackend::vertexAttribDivisor(GLuint index, GLuint divisor)
+	{
+		glVertexAttribDivisor(index, divisor);
+	}
+
+	void GLBackend::genTextures(GLsizei n, GLuint *textures)
+	{
+		glGenTextures(n, textures);
+	}
+
+	void GLBackend::deleteTextures(GLsizei n, const GLuint *textures)
+	{
+		glDeleteTextures(n, textures);
+	}
+
+	void GLBackend::bindTexture(GLenum target, GLuint texture)
+	{
+		glBindTexture(target, texture);
+	}
+
+	void GLBackend::activeTexture(GLenum texture)
+	{
+		glActiveTexture(texture);
+	}
+
+	void GLBackend::texImage2D(
+		GLenum target,
+		GLint level,
+		GLint internalformat,
+		GLsizei width,
+		GLsizei height,
+		GLint border,
+		GLenum format,
+		GLenum type,
+		const void *pixels
+	) {
+		glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+	}
+
+	void GLBackend::texParameteri(GLenum target, GLenum pname, GLint param)
+	{
+		glTexParameteri(target, pname, param);
+	}
+
+	void GLBackend::generateMipmap(GLenum target)
+	{
+		glGenerateMipmap(target);
+	}
+
+	void GLBackend::genFramebuffers(GLsizei n, GLuint *framebuffers)
+	{
+		glGenFramebuffers(n, framebuffers);
+	}
+
+	void GLBackend::deleteFramebuffers(GLsizei n, const GLuint *framebuffers)
+	{
+		glDeleteFramebuffers(n, framebuffers);
+	}
+
+	void GLBackend::bindFramebuffer(GLenum target, GLuint framebuffer)
+	{
+		glBindFramebuffer(target, framebuffer);
+	}
+
+	void GLBackend::framebufferTexture2D(
+		GLenum target,
+		GLenum attachment,
+		GLenum textarget,
+		GLuint texture,
+		GLint level
+	) {
+		glFramebufferTexture2D(target, attachment, textarget, texture, level);
+	}
+
+	GLenum GLBackend::checkFramebufferStatus(GLenum target)
+	{
+		return glCheckFramebufferStatus(target);
+	}
+
+	GLuint GLBackend::createShader(GLenum type)
+	{
+		return glCreateShader(type);
+	}
+
+	void GLBackend::shaderSource(
+		GLuint shader,
+		GLsizei count,
+		const GLchar *const *string,
+		const GLint *length
+	) {
+		glShaderSource(shader, count, string, length);
+	}
+
+	void GLBackend::compileShader(GLuint shader)
+	{
+		glCompileShader(shader);
+	}
+
+	void GLBackend::getShaderiv(GLuint shader, GLenum pname, GLint *params)
+	{
+		glGetShaderiv(shader, pname, params);
+	}
+
+	void GLBackend::getShaderInfoLog(
+		GLuint shader,
+		GLsizei maxlen,
+		GLsizei *len,
+		GLchar *log
+	) {
+		glGetShaderInfoLog(shader, maxlen, len, log);
+	}
+
+	void GLBackend::deleteShader(GLuint shader)
+	{
+		glDeleteShader(shader);
+	}
+
+	GLuint GLBackend::createProgram()
+	{
+		return glCreateProgram();
+	}
+
+	void GLBackend::attachShader(GLuint program, GLuint shader)
+	{
+		glAttachShader(program, shader);
+	}
+
+	void GLBackend::detachShader(GLuint program, GLuint shader)
+	{
+		glDetachShader(program, shader);
+	}
+
+	void GLBackend::linkProgram(GLuint program)
+	{
+		glLinkProgram(program);
+	}
+
+	void GLBackend::validateProgram(GLuint program)
+	{
+		glValidateProgram(program);
+	}
+
+	void GLBackend::getProgramiv(GLuint program, GLenum pname, GLint *params)
+	{
+		glGetProgramiv(program, pname, params);
+	}
+
+	void GLBackend::getProgramInfoLog(
+		GLuint program,
+		GLsizei maxlen,
+		GLsizei *len,
+		GLchar *log
+	) {
+		glGetProgramInfoLog(program, maxlen, len, log);
+	}
+
+	void GLBackend::programParameteri(GLuint program, GLenum pname, GLint value)
+	{
+		glProgramParameteri(program, pname, value);
+	}
+
+	void GLBackend::getProgramBinary(
+		GLuint program,
+		GLsizei bufsize,
+		GLsizei *len,
+		GLenum *format,
+		void *binary
+	) {
+		glGetProgramBinary(program, bufsize, len, format, binary);
+	}
+
+	void GLBackend::programBinary(GLuint program, GLenum format, const void *binary, GLsizei len)
+	{
+		glProgramBinary(program, format, binary, len);
+	}
+
+	void GLBackend::useProgram(GLuint program)
+	{
+		glUseProgram(program);
+	}
+
+	GLint GLBackend::getUniformLocation(GLuint program, const GLchar *name)
+	{
+		return glGetUniformLocation(program, name);
+	}
+
+	void GLBackend::getActiveUniform(
+		GLuint program,
+		GLuint index,
+		GLsizei bufsize,
+		GLsizei *len,
+		GLint *size,
+		GLenum *type,
+		GLchar *name
+	) {
+		glGetActiveUniform(program, index, bufsize, len, size, type, name);
+	}
+
+	GLuint GLBackend::getUniformBlockIndex(GLuint program, const GLchar *name)
+	{
+		return glGetUniformBlockIndex(program, name);
+	}
+
+	void GLBackend::uniformBlockBinding(GLuint program, GLuint index, GLuint binding)
+	{
+		glUniformBlockBinding(program, index, binding);
+	}
+
+	void GLBackend::uniform1i(GLint location, GLint v)
+	{
+		glUniform1i(location, v);
+	}
+
+	void GLBackend::uniform1f(GLint location, GLfloat v)
+	{
+		glUniform1f(location, v);
+	}
+
+	void GLBackend::uniform2f(GLint location, GLfloat x, GLfloat y)
+	{
+		glUniform2f(location, x, y);
+	}
+
+	void GLBackend::uniform3f(
+		GLint location,
+		GLfloat x,
+		GLfloat y,
+		GLfloat z
+	) {
+		glUniform3f(location, x, y, z);
+	}
+
+	void GLBackend::uniform4f(
+		GLint location,
+		GLfloat x,
+		GLfloat y,
+		GLfloat z,
+		GLfloat w
+	) {
+		glUniform4f(location, x, y, z, w);
+	}
+
+	void GLBackend::uniform2fv(GLint location, GLsizei count, const GLfloat *v)
+	{
+		glUniform2fv(location, count, v);
+	}
+
+	void GLBackend::uniform3fv(GLint location, GLsizei count, const GLfloat *v)
+	{
+		glUniform3fv(location, count, v);
+	}
+
+	void GLBackend::uniform4fv(GLint location, GLsizei count, const GLfloat *v)
+	{
+		glUniform4fv(location, count, v);
+	}
+
+	void GLBackend::uniformMatrix3fv(
+		GLint location,
+		GLsizei count,
+		GLboolean transpose,
+		const GLfloat *v
+	) {
+		glUniformMatrix3fv(location, count, transpose, v);
+	}
+
+	void GLBackend::uniformMatrix4fv(
+		GLint location,
+		GLsizei count,
+		GLboolean transpose,
+		const GLfloat *v
+	) {
+		glUniformMatrix4fv(location, count, transpose, v);
+	}
+
+	void GLBackend::enable(GLenum cap)
+	{
+		glEnable(cap);
+	}
+
+	void GLBackend::disable(GLenum cap)
+	{
+		glDisable(cap);
+	}
+
+	void GLBackend::depthFunc(GLenum func)
+	{
+		glDepthFunc(func);
+	}
+
+	void GLBackend::depthMask(GLboolean flag)
+	{
+		glDepthMask(flag);
+	}
+
+	void GLBackend::cullFace(GLenum mode)
+	{
+		glCullFace(mode);
+	}
+
+	void GLBackend::blendFunc(GLenum sfactor, GLenum dfactor)
+	{
+		glBlendFunc(sfactor, dfactor);
+	}
+
+	void GLBackend::viewport(
+		GLint x,
+		GLint y,
+		GLsizei width,
+		GLsizei height
+	) {
+		glViewport(x, y, width, height);
+	}
+
+	void GLBackend::clear(GLbitfield mask)
+	{
+		glClear(mask);
+	}
+
+	void GLBackend::clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+	{
+		glClearColor(r, g, b, a);
+	}
+
+	void GLBackend::drawElements(
+		GLenum mode,
+		GLsizei count,
+		GLenum type,
+		const void *indices
+	) {
+		glDrawElements(mode, count, type, indices);
+	}
+
+	void GLBackend::drawElementsInstanced(
+		GLenum mode,
+		GLsizei count,
+		GLenum type,
+		const void *indices,
+		GLsizei instances
+	) {
+		glDrawElementsInstanced(mode, count, type, indices, instances);
+	}
+
+	GLenum GLBackend::getError()
+	{
+		return glGetError();
+	}
+
+	void GLBackend::getIntegerv(GLenum pname, GLint *data)
+	{
+		glGetIntegerv(pname, data);
+	}
+
+	const GLubyte* GLBackend::getString(GLenum name)
+	{
+		return glGetString(name);
+	}
+
+	void NullBackend::genVertexArrays(GLsizei n, GLuint *arrays)
+	{
+		generateIds(nextid, n, arrays);
+	}
+
+	void NullBackend::genBuffers(GLsizei n, GLuint *buffers)
+	{
+		generateIds(nextid, n, buffers);
+	}
+
+	void NullBackend::genTextures(GLsizei n, GLuint *textures)
+	{
+		generateIds(nextid, n, textures);
+	}
+
+	void NullBackend::genFramebuffers(GLsizei n, GLuint *framebuffers)
+	{
+		generateIds(nextid, n, framebuffers);
+	}
+
+	GLuint NullBackend::createShader(GLenum type)
+	{
+		(void)type;
+		return nextid++;
+	}
+
+	void NullBackend::getShaderiv(GLuint shader, GLenum pname, GLint *params)
+	{
+		(void)shader;
+		*params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+	}
+
+	void NullBackend::getShaderInfoLog(GLuint shader, GLsizei maxlen, GLsizei *len, GLchar *log)
+	{
+		(void)shader;
+		if(len)
+			*len = 0;
+		if(maxlen > 0)
+			log[0] = '\0';
+	}
+
+	GLuint NullBackend::createProgram()
+	{
+		return nextid++;
+	}
+
+	void NullBackend::getProgramiv(GLuint program, GLenum pname, GLint *params)
+	{
+		(void)program;
+		*params = (pname == GL_LINK_STATUS || pname == GL_VALIDATE_STATUS) ? GL_TRUE : 0;
+	}
+
+	void NullBackend::getProgramInfoLog(GLuint program, GLsizei maxlen, GLsizei *len, GLchar *log)
+	{
+		(void)program;
+		if(len)
+			*len = 0;
+		if(maxlen > 0)
+			log[0] = '\0';
+	}
+
+	void NullBackend::getActiveUniform(
+		GLuint program,
+		GLuint index,
+		GLsizei bufsize,
+		GLsizei *len,
+		GLint *size,
+		GLenum *type,
+		GLchar *name
+	) {
+		(void)program;
+		(void)index;
+		if(len)
+			*len = 0;
+		*size = 0;
+		*type = 0;
+		if(bufsize > 0)
+			name[0] = '\0';
+	}
+
+	void NullBackend::getProgramBinary(
+		GLuint program,
+		GLsizei bufsize,
+		GLsizei *len,
+		GLenum *format,
+		void *binary
+	) {
+		(void)program;
+		(void)bufsize;
+		(void)binary;
+		if(len)
+			*len = 0;
+		*format = 0;
+	}
+
+	void NullBackend::getIntegerv(GLenum pname, GLint *data)
+	{
+		(void)pname;
+		*data = 0;
+	}
+
+	const GLubyte* NullBackend::getString(GLenum name)
+	{
+		(void)name;
+		return (const GLubyte*)"null";
+	}
+
+	RecordingBackend::RecordingBackend(GraphicsBackend *forwardto)
+	{
+		forward = forwardto;
+	}
+
+	void RecordingBackend::record(const char *name, size_t bytes)
+	{
+		log.push_back({ name, bytes });
+		CallTotals &t = totals[name];
+		t.calls++;
+		t.bytes += bytes;
+	}
+
+	void RecordingBackend::clearLog()
+	{
+		log.clear();
+	}
+
+	size_t RecordingBackend::loggedBytes() const
+	{
+		size_t total = 0;
+		for(const auto &call : log)
+			total += call.bytes;
+		return total;
+	}
+
+	void RecordingBackend::printTotals() const
+	{
+		printf("%-24s %12s %14s\n", "call", "count", "bytes");
+		for(const auto &entry : totals) {
+			printf(
+				"%-24s %12llu %14llu\n",
+				entry.first.c_str(),
+				entry.second.calls,
+				entry.second.bytes
+			);
+		}
+	}
+
+	void RecordingBackend::genVertexArrays(GLsizei n, GLuint *arrays)
+	{
+		record("genVertexArrays");
+		forward->genVertexArrays(n, arrays);
+	}
+
+	void RecordingBackend::deleteVertexArrays(GLsizei n, const GLuint *arrays)
+	{
+		record("deleteVertexArrays");
+		forward->deleteVertexArrays(n, arrays);
+	}
+
+	void RecordingBackend::bindVertexArray(GLuint array)
+	{
+		record("bindVertexArray");
+		forward->bindVertexArray(array);
+	}
+
+	void RecordingBackend::genBuffers(GLsizei n, GLuint *buffers)
+	{
+		record("genBuffers");
+		forward->genBuffers(n, buffers);
+	}
+
+	void RecordingBackend::deleteBuffers(GLsizei n, const GLuint *buffers)
+	{
+		record("deleteBuffers");
+		forward->deleteBuffers(n, buffers);
+	}
+
+	void RecordingBackend::bindBuffer(GLenum target, GLuint buffer)
+	{
+		record("bindBuffer");
+		forward->bindBuffer(target, buffer);
+	}
+
+	void RecordingBackend::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+	{
+		record("bindBufferBase");
+		forward->bindBufferBase(target, index, buffer);
+	}
+
+	void RecordingBackend::bufferData(
+		GLenum target,
+		GLsizeiptr size,
+		const void *data,
+		GLenum usage
+	) {
+		record("bufferData", data ? size : 0);
+		forward->bufferData(target, size, data, usage);
+	}
+
+	void RecordingBackend::bufferSubData(
+		GLenum target,
+		GLintptr offset,
+		GLsizeiptr size,
+		const void *data
+	) {
+		record("bufferSubData", size);
+		forward->bufferSubData(target, offset, size, data);
+	}
+
+	void RecordingBackend::vertexAttribPointer(
+		GLuint index,
+		GLint size,
+		GLenum type,
+		GLboolean normalized,
+		GLsizei stride,
+		const void *pointer
+	) {
+		record("vertexAttribPointer");
+		forward->vertexAttribPointer(index, size, type, normalized, stride, pointer);
+	}
+
+	void RecordingBackend::vertexAttribIPointer(
+		GLuint index,
+		GLint size,
+		GLenum type,
+		GLsizei stride,
+		const void *pointer
+	) {
+		record("vertexAttribIPointer");
+		forward->vertexAttribIPointer(index, size, type, stride, pointer);
+	}
+
+	void RecordingBackend::enableVertexAttribArray(GLuint index)
+	{
+		record("enableVertexAttribArray");
+		forward->enableVertexAttribArray(index);
+	}
+
+	void RecordingBackend::vertexAttribDivisor(GLuint index, GLuint divisor)
+	{
+		record("vertexAttribDivisor");
+		forward->vertexAttribDivisor(index, divisor);
+	}
+
+	void RecordingBackend::genTextures(GLsizei n, GLuint *textures)
+	{
+		record("genTextures");
+		forward->genTextures(n, textures);
+	}
+
+	void RecordingBackend::deleteTextures(GLsizei n, const GLuint *textures)
+	{
+		record("deleteTextures");
+		forward->deleteTextures(n, textures);
+	}
+
+	void RecordingBackend::bindTexture(GLenum target, GLuint texture)
+	{
+		record("bindTexture");
+		forward->bindTexture(target, texture);
+	}
+
+	void RecordingBackend::activeTexture(GLenum texture)
+	{
+		record("activeTexture");
+		forward->activeTexture(texture);
+	}
+
+	void RecordingBackend::texImage2D(
+		GLenum target,
+		GLint level,
+		GLint internalformat,
+		GLsizei width,
+		GLsizei height,
+		GLint border,
+		GLenum format,
+		GLenum type,
+		const void *pixels
+	) {
+		record("texImage2D", pixels ? textureBytes(width, height, format, type) : 0);
+		forward->texImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+	}
+
+	void RecordingBackend::texParameteri(GLenum target, GLenum pname, GLint param)
+	{
+		record("texParameteri");
+		forward->texParameteri(target, pname, param);
+	}
+
+	void RecordingBackend::generateMipmap(GLenum target)
+	{
+		record("generateMipmap");
+		forward->generateMipmap(target);
+	}
+
+	void RecordingBackend::genFramebuffers(GLsizei n, GLuint *framebuffers)
+	{
+		record("genFramebuffers");
+		forward->genFramebuffers(n, framebuffers);
+	}
+
+	void RecordingBackend::deleteFramebuffers(GLsizei n, const GLuint *framebuffers)
+	{
+		record("deleteFramebuffers");
+		forward->deleteFramebuffers(n, framebuffers);
+	}
+
+	void RecordingBackend::bindFramebuffer(GLenum target, GLuint framebuffer)
+	{
+		record("bindFramebuffer");
+		forward->bindFramebuffer(target, framebuffer);
+	}
+
+	void RecordingBackend::framebufferTexture2D(
+		GLenum target,
+		GLenum attachment,
+		GLenum textarget,
+		GLuint texture,
+		GLint level
+	) {
+		record("framebufferTexture2D");
+		forward->framebufferTexture2D(target, attachment, textarget, texture, level);
+	}
+
+	GLenum RecordingBackend::checkFramebufferStatus(GLenum target)
+	{
+		record("checkFramebufferStatus");
+		return forward->checkFramebufferStatus(target);
+	}
+
+	GLuint RecordingBackend::createShader(GLenum type)
+	{
+		record("createShader");
+		return forward->createShader(type);
+	}
+
+	void RecordingBackend::shaderSource(
+		GLuint shader,
+		GLsizei count,
+		const GLchar *const *string,
+		const GLint *length
+	) {
+		record("shaderSource", sourceBytes(count, string, length));
+		forward->shaderSource(shader, count, string, length);
+	}
+
+	void RecordingBackend::compileShader(GLuint shader)
+	{
+		record("compileShader");
+		forward->compileShader(shader);
+	}
+
+	void RecordingBackend::getShaderiv(GLuint shader, GLenum pname, GLint *params)
+	{
+		record("getShaderiv");
+		forward->getShaderiv(shader, pname, params);
+	}
+
+	void RecordingBackend::getShaderInfoLog(
+		GLuint shader,
+		GLsizei maxlen,
+		GLsizei *len,
+		GLchar *log
+	) {
+		record("getShaderInfoLog");
+		forward->getShaderInfoLog(shader, maxlen, len, log);
+	}
+
+	void RecordingBackend::deleteShader(GLuint shader)
+	{
+		record("deleteShader");
+		forward->deleteShader(shader);
+	}
+
+	GLuint RecordingBackend::createProgram()
+	{
+		record("createProgram");
+		return forward->createProgram();
+	}
+
+	void RecordingBackend::attachShader(GLuint program, GLuint shader)
+	{
+		record("attachShader");
+		forward->attachShader(program, shader);
+	}
+
+	void RecordingBackend::detachShader(GLuint program, GLuint shader)
+	{
+		record("detachShader");
+		forward->detachShader(program, shader);
+	}
+
+	void RecordingBackend::linkProgram(GLuint program)
+	{
+		record("linkProgram");
+		forward->linkProgram(program);
+	}
+
+	void RecordingBackend::validateProgram(GLuint program)
+	{
+		record("validateProgram");
+		forward->validateProgram(program);
+	}
+
+	void RecordingBackend::getProgramiv(GLuint program, GLenum pname, GLint *params)
+	{
+		record("getProgramiv");
+		forward->getProgramiv(program, pname, params);
+	}
+
+	void RecordingBackend::getProgramInfoLog(
+		GLuint program,
+		GLsizei maxlen,
+		GLsizei *len,
+		GLchar *log
+	) {
+		record("getProgramInfoLog");
+		forward->getProgramInfoLog(program, maxlen, len, log);
+	}
+
+	void RecordingBackend::programParameteri(GLuint program, GLenum pname, GLint value)
+	{
+		record("programParameteri");
+		forward->programParameteri(program, pname, value);
+	}
+
+	void RecordingBackend::getProgramBinary(
+		GLuint program,
+		GLsizei bufsize,
+		GLsizei *len,
+		GLenum *format,
+		void *binary
+	) {
+		record("getProgramBinary");
+		forward->getProgramBinary(program, bufsize, len, format, binary);
+	}
+
+	void RecordingBackend::programBinary(
+		GLuint program,
+		GLenum format,
+		const void *binary,
+		GLsizei len
+	) {
+		record("programBinary", len);
+		forward->programBinary(program, format, binary, len);
+	}
+
+	void RecordingBackend::useProgram(GLuint program)
+	{
+		record("useProgram");
+		forward->useProgram(program);
+	}
+
+	GLint RecordingBackend::getUniformLocation(GLuint program, const GLchar *name)
+	{
+		record("getUniformLocation");
+		return forward->getUniformLocation(program, name);
+	}
+
+	void RecordingBackend::getActiveUniform(
+		GLuint program,
+		GLuint index,
+		GLsizei bufsize,
+		GLsizei *len,
+		GLint *size,
+		GLenum *type,
+		GLchar *name
+	) {
+		record("getActiveUniform");
+		forward->getActiveUniform(program, index, bufsize, len, size, type, name);
+	}
+
+	GLuint RecordingBackend::getUniformBlockIndex(GLuint program, const GLchar *name)
+	{
+		record("getUniformBlockIndex");
+		return forward->getUniformBlockIndex(program, name);
+	}
+
+	void RecordingBackend::uniformBlockBinding(GLuint program, GLuint index, GLuint binding)
+	{
+		record("uniformBlockBinding");
+		forward->uniformBlockBinding(program, index, binding);
+	}
+
+	void RecordingBackend::uniform1i(GLint location, GLint v)
+	{
+		record("uniform1i", sizeof(GLint));
+		forward->uniform1i(location, v);
+	}
+
+	void RecordingBackend::uniform1f(GLint location, GLfloat v)
+	{
+		record("uniform1f", sizeof(GLfloat));
+		forward->uniform1f(location, v);
+	}
+
+	void RecordingBackend::uniform2f(GLint location, GLfloat x, GLfloat y)
+	{
+		record("uniform2f", sizeof(GLfloat) * 2);
+		forward->uniform2f(location, x, y);
+	}
+
+	void RecordingBackend::uniform3f(
+		GLint location,
+		GLfloat x,
+		GLfloat y,
+		GLfloat z
+	) {
+		record("uniform3f", sizeof(GLfloat) * 3);
+		forward->uniform3f(location, x, y, z);
+	}
+
+	void RecordingBackend::uniform4f(
+		GLint location,
+		GLfloat x,
+		GLfloat y,
+		GLfloat z,
+		GLfloat w
+	) {
+		record("uniform4f", sizeof(GLfloat) * 4);
+		forward->uniform4f(location, x, y, z, w);
+	}
+
+	void RecordingBackend::uniform2fv(GLint location, GLsizei count, const GLfloat *v)
+	{
+		record("uniform2fv", sizeof(GLfloat) * 2 * count);
+		forward->uniform2fv(location, count, v);
+	}
+
+	void RecordingBackend::uniform3fv(GLint location, GLsizei count, const GLfloat *v)
+	{
+		record("uniform3fv", sizeof(GLfloat) * 3 * count);
+		forward->uniform3fv(location, count, v);
+	}
+
+	void RecordingBackend::uniform4fv(GLint location, GLsizei count, const GLfloat *v)
+	{
+		record("uniform4fv", sizeof(GLfloat) * 4 * count);
+		forward->uniform4fv(location, count, v);
+	}
+
+	void RecordingBackend::uniformMatrix3fv(
+		GLint location,
+		GLsizei count,
+		GLboolean transpose,
+		const GLfloat *v
+	) {
+		record("uniformMatrix3fv", sizeof(GLfloat) * 9 * count);
+		forward->uniformMatrix3fv(location, count, transpose, v);
+	}
+
+	void RecordingBackend::uniformMatrix4fv(
+		GLint location,
+		GLsizei count,
+		GLboolean transpose,
+		const GLfloat *v
+	) {
+		record("uniformMatrix4fv", sizeof(GLfloat) * 16 * count);
+		forward->uniformMatrix4fv(location, count, transpose, v);
+	}
+
+	void RecordingBackend::enable(GLenum cap)
+	{
+		record("enable");
+		forward->enable(cap);
+	}
+
+	void RecordingBackend::disable(GLenum cap)
+	{
+		record("disable");
+		forward->disable(cap);
+	}
+
+	void RecordingBackend::depthFunc(GLenum func)
+	{
+		record("depthFunc");
+		forward->depthFunc(func);
+	}
+
+	void RecordingBackend::depthMask(GLboolean flag)
+	{
+		record("depthMask");
+		forward->depthMask(flag);
+	}
+
+	void RecordingBackend::cullFace(GLenum mode)
+	{
+		record("cullFace");
+		forward->cullFace(mode);
+	}
+
+	void RecordingBackend::blendFunc(GLenum sfactor, GLenum dfactor)
+	{
+		record("blendFunc");
+		forward->blendFunc(sfactor, dfactor);
+	}
+
+	void RecordingBackend::viewport(
+		GLint x,
+		GLint y,
+		GLsizei width,
+		GLsizei height
+	) {
+		record("viewport");
+		forward->viewport(x, y, width, height);
+	}
+
+	void RecordingBackend::clear(GLbitfield mask)
+	{
+		record("clear");
+		forward->clear(mask);
+	}
+
+	void RecordingBackend::clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+	{
+		record("clearColor");
+		forward->clearColor(r, g, b, a);
+	}
+
+	void RecordingBackend::drawElements(
+		GLenum mode,
+		GLsizei count,
+		GLenum type,
+		const void *indices
+	) {
+		record("drawElements");
+		forward->drawElements(mode, count, type, indices);
+	}
+
+	void RecordingBackend::drawElementsInstanced(
+		GLenum mode,
+		GLsizei count,
+		GLenum type,
+		const void *indices,
+		GLsizei instances
+	) {
+		record("drawElementsInstanced");
+		forward->drawElementsInstanced(mode, count, type, indices, instances);
+	}
+
+	GLenum RecordingBackend::getError()
+	{
+		record("getError");
+		return forward->getError();
+	}
+
+	void RecordingBackend::getIntegerv(GLenum pname, GLint *data)
+	{
+		record("getIntegerv");
+		forward->getIntegerv(pname, data);
+	}
+
+	const GLubyte* RecordingBackend::getString(GLenum name)
+	{
+		record("getString");
+		return forward->getString(name);
+	}
+}
@@ -0,0 +1,556 @@
+/*
+ * Every OpenGL call the engine makes goes through a GraphicsBackend so that
+ * the real driver can be swapped out: GLBackend forwards to OpenGL,
+ * NullBackend does nothing (but hands out ids and reports success so that
+ * the rest of the engine behaves as if everything worked) and
+ * RecordingBackend keeps a log of the calls and how many bytes were
+ * uploaded before passing them on to another backend
+ *
+ * The null and recording backends do not need a GL context, they are used
+ * to run the game loop headless (see game::benchmarkGameLoop)
+ * */
+
+#ifndef GFXBACKEND_H
+#define GFXBACKEND_H
+
+#include "opengl.h"
+#include <stddef.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace gfx {
+	class GraphicsBackend {
+	public:
+		virtual ~GraphicsBackend() {}
+
+		//Vertex arrays and buffers
+		virtual void genVertexArrays(GLsizei n, GLuint *arrays) = 0;
+		virtual void deleteVertexArrays(GLsizei n, const GLuint *arrays) = 0;
+		virtual void bindVertexArray(GLuint array) = 0;
+		virtual void genBuffers(GLsizei n, GLuint *buffers) = 0;
+		virtual void deleteBuffers(GLsizei n, const GLuint *buffers) = 0;
+		virtual void bindBuffer(GLenum target, GLuint buffer) = 0;
+		virtual void bindBufferBase(GLenum target, GLuint index, GLuint buffer) = 0;
+		virtual void bufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage) = 0;
+		virtual void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) = 0;
+		virtual void vertexAttribPointer(
+			GLuint index,
+			GLint size,
+			GLenum type,
+			GLboolean normalized,
+			GLsizei stride,
+			const void *pointer
+		) = 0;
+		//Integer attributes, the shader reads them as int/uint
+		virtual void vertexAttribIPointer(
+			GLuint index,
+			GLint size,
+			GLenum type,
+			GLsizei stride,
+			const void *pointer
+		) = 0;
+		virtual void enableVertexAttribArray(GLuint index) = 0;
+		virtual void vertexAttribDivisor(GLuint index, GLuint divisor) = 0;
+
+		//Textures
+		virtual void genTextures(GLsizei n, GLuint *textures) = 0;
+		virtual void deleteTextures(GLsizei n, const GLuint *textures) = 0;
+		virtual void bindTexture(GLenum target, GLuint texture) = 0;
+		virtual void activeTexture(GLenum texture) = 0;
+		virtual void texImage2D(
+			GLenum target,
+			GLint level,
+			GLint internalformat,
+			GLsizei width,
+			GLsizei height,
+			GLint border,
+			GLenum format,
+			GLenum type,
+			const void *pixels
+		) = 0;
+		virtual void texParameteri(GLenum target, GLenum pname, GLint param) = 0;
+		virtual void generateMipmap(GLenum target) = 0;
+
+		//Framebuffers
+		virtual void genFramebuffers(GLsizei n, GLuint *framebuffers) = 0;
+		virtual void deleteFramebuffers(GLsizei n, const GLuint *framebuffers) = 0;
+		virtual void bindFramebuffer(GLenum target, GLuint framebuffer) = 0;
+		virtual void framebufferTexture2D(
+			GLenum target,
+			GLenum attachment,
+			GLenum textarget,
+			GLuint texture,
+			GLint level
+		) = 0;
+		virtual GLenum checkFramebufferStatus(GLenum target) = 0;
+
+		//Shaders
+		virtual GLuint createShader(GLenum type) = 0;
+		virtual void shaderSource(
+			GLuint shader,
+			GLsizei count,
+			const GLchar *const *string,
+			const GLint *length
+		) = 0;
+		virtual void compileShader(GLuint shader) = 0;
+		virtual void getShaderiv(GLuint shader, GLenum pname, GLint *params) = 0;
+		virtual void getShaderInfoLog(GLuint shader, GLsizei maxlen, GLsizei *len, GLchar *log) = 0;
+		virtual void deleteShader(GLuint shader) = 0;
+		virtual GLuint createProgram() = 0;
+		virtual void attachShader(GLuint program, GLuint shader) = 0;
+		virtual void detachShader(GLuint program, GLuint shader) = 0;
+		virtual void linkProgram(GLuint program) = 0;
+		virtual void validateProgram(GLuint program) = 0;
+		virtual void getProgramiv(GLuint program, GLenum pname, GLint *params) = 0;
+		virtual void getProgramInfoLog(GLuint program, GLsizei maxlen, GLsizei *len, GLchar *log) = 0;
+		virtual void programParameteri(GLuint program, GLenum pname, GLint value) = 0;
+		virtual void getProgramBinary(
+			GLuint program,
+			GLsizei bufsize,
+			GLsizei *len,
+			GLenum *format,
+			void *binary
+		) = 0;
+		virtual void programBinary(GLuint program, GLenum format, const void *binary, GLsizei len) = 0;
+		virtual void useProgram(GLuint program) = 0;
+		virtual GLint getUniformLocation(GLuint program, const GLchar *name) = 0;
+		virtual void getActiveUniform(
+			GLuint program,
+			GLuint index,
+			GLsizei bufsize,
+			GLsizei *len,
+			GLint *size,
+			GLenum *type,
+			GLchar *name
+		) = 0;
+		virtual GLuint getUniformBlockIndex(GLuint program, const GLchar *name) = 0;
+		virtual void uniformBlockBinding(GLuint program, GLuint index, GLuint binding) = 0;
+
+		//Uniforms
+		virtual void uniform1i(GLint location, GLint v) = 0;
+		virtual void uniform1f(GLint location, GLfloat v) = 0;
+		virtual void uniform2f(GLint location, GLfloat x, GLfloat y) = 0;
+		virtual void uniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z) = 0;
+		virtual void uniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w) = 0;
+		virtual void uniform2fv(GLint location, GLsizei count, const GLfloat *v) = 0;
+		virtual void uniform3fv(GLint location, GLsizei count, const GLfloat *v) = 0;
+		virtual void uniform4fv(GLint location, GLsizei count, const GLfloat *v) = 0;
+		virtual void uniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *v) = 0;
+		virtual void uniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *v) = 0;
+
+		//Fixed function state
+		virtual void enable(GLenum cap) = 0;
+		virtual void disable(GLenum cap) = 0;
+		virtual void depthFunc(GLenum func) = 0;
+		virtual void depthMask(GLboolean flag) = 0;
+		virtual void cullFace(GLenum mode) = 0;
+		virtual void blendFunc(GLenum sfactor, GLenum dfactor) = 0;
+		virtual void viewport(GLint x, GLint y, GLsizei width, GLsizei height) = 0;
+		virtual void clear(GLbitfield mask) = 0;
+		virtual void clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) = 0;
+
+		//Drawing
+		virtual void drawElements(GLenum mode, GLsizei count, GLenum type, const void *indices) = 0;
+		virtual void drawElementsInstanced(
+			GLenum mode,
+			GLsizei count,
+			GLenum type,
+			const void *indices,
+			GLsizei instances
+		) = 0;
+
+		virtual GLenum getError() = 0;
+		virtual void getIntegerv(GLenum pname, GLint *data) = 0;
+		virtual const GLubyte* getString(GLenum name) = 0;
+
+		//The backend that GFX refers to, this is a GLBackend unless it
+		//was changed with set()
+		static GraphicsBackend* get();
+		//Does not take ownership, 'backend' must outlive its use
+		static void set(GraphicsBackend *backend);
+	};
+
+	class GLBackend : public GraphicsBackend {
+	public:
+		void genVertexArrays(GLsizei n, GLuint *arrays) override;
+		void deleteVertexArrays(GLsizei n, const GLuint *arrays) override;
+		void bindVertexArray(GLuint array) override;
+		void genBuffers(GLsizei n, GLuint *buffers) override;
+		void deleteBuffers(GLsizei n, const GLuint *buffers) override;
+		void bindBuffer(GLenum target, GLuint buffer) override;
+		void bindBufferBase(GLenum target, GLuint index, GLuint buffer) override;
+		void bufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage) override;
+		void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) override;
+		void vertexAttribPointer(
+			GLuint index,
+			GLint size,
+			GLenum type,
+			GLboolean normalized,
+			GLsizei stride,
+			const void *pointer
+		) override;
+		void vertexAttribIPointer(
+			GLuint index,
+			GLint size,
+			GLenum type,
+			GLsizei stride,
+			const void *pointer
+		) override;
+		void enableVertexAttribArray(GLuint index) override;
+		void vertexAttribDivisor(GLuint index, GLuint divisor) override;
+		void genTextures(GLsizei n, GLuint *textures) override;
+		void deleteTextures(GLsizei n, const GLuint *textures) override;
+		void bindTexture(GLenum target, GLuint texture) override;
+		void activeTexture(GLenum texture) override;
+		void texImage2D(
+			GLenum target,
+			GLint level,
+			GLint internalformat,
+			GLsizei width,
+			GLsizei height,
+			GLint border,
+			GLenum format,
+			GLenum type,
+			const void *pixels
+		) override;
+		void texParameteri(GLenum target, GLenum pname, GLint param) override;
+		void generateMipmap(GLenum target) override;
+		void genFramebuffers(GLsizei n, GLuint *framebuffers) override;
+		void deleteFramebuffers(GLsizei n, const GLuint *framebuffers) override;
+		void bindFramebuffer(GLenum target, GLuint framebuffer) override;
+		void framebufferTexture2D(
+			GLenum target,
+			GLenum attachment,
+			GLenum textarget,
+			GLuint texture,
+			GLint level
+		) override;
+		GLenum checkFramebufferStatus(GLenum target) override;
+		GLuint createShader(GLenum type) override;
+		void shaderSource(
+			GLuint shader,
+			GLsizei count,
+			const GLchar *const *string,
+			const GLint *length
+		) override;
+		void compileShader(GLuint shader) override;
+		void getShaderiv(GLuint shader, GLenum pname, GLint *params) override;
+		void getShaderInfoLog(GLuint shader, GLsizei maxlen, GLsizei *len, GLchar *log) override;
+		void deleteShader(GLuint shader) override;
+		GLuint createProgram() override;
+		void attachShader(GLuint program, GLuint shader) override;
+		void detachShader(GLuint program, GLuint shader) override;
+		void linkProgram(GLuint program) override;
+		void validateProgram(GLuint program) override;
+		void getProgramiv(GLuint program, GLenum pname, GLint *params) override;
+		void getProgramInfoLog(GLuint program, GLsizei maxlen, GLsizei *len, GLchar *log) override;
+		void programParameteri(GLuint program, GLenum pname, GLint value) override;
+		void getProgramBinary(
+			GLuint program,
+			GLsizei bufsize,
+			GLsizei *len,
+			GLenum *format,
+			void *binary
+		) override;
+		void programBinary(GLuint program, GLenum format, const void *binary, GLsizei len) override;
+		void useProgram(GLuint program) override;
+		GLint getUniformLocation(GLuint program, const GLchar *name) override;
+		void getActiveUniform(
+			GLuint program,
+			GLuint index,
+			GLsizei bufsize,
+			GLsizei *len,
+			GLint *size,
+			GLenum *type,
+			GLchar *name
+		) override;
+		GLuint getUniformBlockIndex(GLuint program, const GLchar *name) override;
+		void uniformBlockBinding(GLuint program, GLuint index, GLuint binding) override;
+		void uniform1i(GLint location, GLint v) override;
+		void uniform1f(GLint location, GLfloat v) override;
+		void uniform2f(GLint location, GLfloat x, GLfloat y) override;
+		void uniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z) override;
+		void uniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w) override;
+		void uniform2fv(GLint location, GLsizei count, const GLfloat *v) override;
+		void uniform3fv(GLint location, GLsizei count, const GLfloat *v) override;
+		void uniform4fv(GLint location, GLsizei count, const GLfloat *v) override;
+		void uniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *v) override;
+		void uniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *v) override;
+		void enable(GLenum cap) override;
+		void disable(GLenum cap) override;
+		void depthFunc(GLenum func) override;
+		void depthMask(GLboolean flag) override;
+		void cullFace(GLenum mode) override;
+		void blendFunc(GLenum sfactor, GLenum dfactor) override;
+		void viewport(GLint x, GLint y, GLsizei width, GLsizei height) override;
+		void clear(GLbitfield mask) override;
+		void clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) override;
+		void drawElements(GLenum mode, GLsizei count, GLenum type, const void *indices) override;
+		void drawElementsInstanced(
+			GLenum mode,
+			GLsizei count,
+			GLenum type,
+			const void *indices,
+			GLsizei instances
+		) override;
+		GLenum getError() override;
+		void getIntegerv(GLenum pname, GLint *data) override;
+		const GLubyte* getString(GLenum name) override;
+	};
+
+	//Ids are handed out from a counter, shaders always compile and link,
+	//queries return zero unless they have to succeed and everything else
+	//is ignored
+	class NullBackend : public GraphicsBackend {
+		GLuint nextid = 1;
+	public:
+		void genVertexArrays(GLsizei n, GLuint *arrays) override;
+		void deleteVertexArrays(GLsizei, const GLuint *) override {}
+		void bindVertexArray(GLuint) override {}
+		void genBuffers(GLsizei n, GLuint *buffers) override;
+		void deleteBuffers(GLsizei, const GLuint *) override {}
+		void bindBuffer(GLenum, GLuint) override {}
+		void bindBufferBase(GLenum, GLuint, GLuint) override {}
+		void bufferData(GLenum, GLsizeiptr, const void *, GLenum) override {}
+		void bufferSubData(GLenum, GLintptr, GLsizeiptr, const void *) override {}
+		void vertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void *) override {}
+		void vertexAttribIPointer(GLuint, GLint, GLenum, GLsizei, const void *) override {}
+		void enableVertexAttribArray(GLuint) override {}
+		void vertexAttribDivisor(GLuint, GLuint) override {}
+		void genTextures(GLsizei n, GLuint *textures) override;
+		void deleteTextures(GLsizei, const GLuint *) override {}
+		void bindTexture(GLenum, GLuint) override {}
+		void activeTexture(GLenum) override {}
+		void texImage2D(
+			GLenum,
+			GLint,
+			GLint,
+			GLsizei,
+			GLsizei,
+			GLint,
+			GLenum,
+			GLenum,
+			const void *
+		) override {}
+		void texParameteri(GLenum, GLenum, GLint) override {}
+		void generateMipmap(GLenum) override {}
+		void genFramebuffers(GLsizei n, GLuint *framebuffers) override;
+		void deleteFramebuffers(GLsizei, const GLuint *) override {}
+		void bindFramebuffer(GLenum, GLuint) override {}
+		void framebufferTexture2D(GLenum, GLenum, GLenum, GLuint, GLint) override {}
+		GLenum checkFramebufferStatus(GLenum) override { return GL_FRAMEBUFFER_COMPLETE; }
+		GLuint createShader(GLenum) override;
+		void shaderSource(GLuint, GLsizei, const GLchar *const *, const GLint *) override {}
+		void compileShader(GLuint) override {}
+		void getShaderiv(GLuint shader, GLenum pname, GLint *params) override;
+		void getShaderInfoLog(GLuint shader, GLsizei maxlen, GLsizei *len, GLchar *log) override;
+		void deleteShader(GLuint) override {}
+		GLuint createProgram() override;
+		void attachShader(GLuint, GLuint) override {}
+		void detachShader(GLuint, GLuint) override {}
+		void linkProgram(GLuint) override {}
+		void validateProgram(GLuint) override {}
+		void getProgramiv(GLuint program, GLenum pname, GLint *params) override;
+		void getProgramInfoLog(GLuint program, GLsizei maxlen, GLsizei *len, GLchar *log) override;
+		void programParameteri(GLuint, GLenum, GLint) override {}
+		void getProgramBinary(GLuint program, GLsizei bufsize, GLsizei *len, GLenum *format, void *binary) override;
+		void programBinary(GLuint, GLenum, const void *, GLsizei) override {}
+		void useProgram(GLuint) override {}
+		GLint getUniformLocation(GLuint, const GLchar *) override { return 0; }
+		void getActiveUniform(
+			GLuint program,
+			GLuint index,
+			GLsizei bufsize,
+			GLsizei *len,
+			GLint *size,
+			GLenum *type,
+			GLchar *name
+		) override;
+		GLuint getUniformBlockIndex(GLuint, const GLchar *) override { return 0; }
+		void uniformBlockBinding(GLuint, GLuint, GLuint) override {}
+		void uniform1i(GLint, GLint) override {}
+		void uniform1f(GLint, GLfloat) override {}
+		void uniform2f(GLint, GLfloat, GLfloat) override {}
+		void uniform3f(GLint, GLfloat, GLfloat, GLfloat) override {}
+		void uniform4f(GLint, GLfloat, GLfloat, GLfloat, GLfloat) override {}
+		void uniform2fv(GLint, GLsizei, const GLfloat *) override {}
+		void uniform3fv(GLint, GLsizei, const GLfloat *) override {}
+		void uniform4fv(GLint, GLsizei, const GLfloat *) override {}
+		void uniformMatrix3fv(GLint, GLsizei, GLboolean, const GLfloat *) override {}
+		void uniformMatrix4fv(GLint, GLsizei, GLboolean, const GLfloat *) override {}
+		void enable(GLenum) override {}
+		void disable(GLenum) override {}
+		void depthFunc(GLenum) override {}
+		void depthMask(GLboolean) override {}
+		void cullFace(GLenum) override {}
+		void blendFunc(GLenum, GLenum) override {}
+		void viewport(GLint, GLint, GLsizei, GLsizei) override {}
+		void clear(GLbitfield) override {}
+		void clearColor(GLfloat, GLfloat, GLfloat, GLfloat) override {}
+		void drawElements(GLenum, GLsizei, GLenum, const void *) override {}
+		void drawElementsInstanced(GLenum, GLsizei, GLenum, const void *, GLsizei) override {}
+		GLenum getError() override { return GL_NO_ERROR; }
+		//Reports zero program binary formats so nothing is cached
+		void getIntegerv(GLenum pname, GLint *data) override;
+		const GLubyte* getString(GLenum name) override;
+	};
+
+	//Logs every call and then forwards it to 'forward' (which can be a
+	//GLBackend to record a real frame or a NullBackend to run headless)
+	class RecordingBackend : public GraphicsBackend {
+		GraphicsBackend *forward;
+		void record(const char *name, size_t bytes = 0);
+	public:
+		struct Call {
+			//Name of the GL function without the gl prefix
+			const char *name;
+			//Number of bytes sent to the GPU by the call
+			size_t bytes;
+		};
+		struct CallTotals {
+			unsigned long long calls = 0;
+			unsigned long long bytes = 0;
+		};
+		//Every call since the last clearLog()
+		std::vector<Call> log;
+		//Totals for each function since the backend was created
+		std::map<std::string, CallTotals> totals;
+
+		RecordingBackend(GraphicsBackend *forwardto);
+		void clearLog();
+		//Sum of the bytes uploaded by the calls in the log
+		size_t loggedBytes() const;
+		//Writes the totals as a table to stdout
+		void printTotals() const;
+
+		void genVertexArrays(GLsizei n, GLuint *arrays) override;
+		void deleteVertexArrays(GLsizei n, const GLuint *arrays) override;
+		void bindVertexArray(GLuint array) override;
+		void genBuffers(GLsizei n, GLuint *buffers) override;
+		void deleteBuffers(GLsizei n, const GLuint *buffers) override;
+		void bindBuffer(GLenum target, GLuint buffer) override;
+		void bindBufferBase(GLenum target, GLuint index, GLuint buffer) override;
+		void bufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage) override;
+		void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) override;
+		void vertexAttribPointer(
+			GLuint index,
+			GLint size,
+			GLenum type,
+			GLboolean normalized,
+			GLsizei stride,
+			const void *pointer
+		) override;
+		void vertexAttribIPointer(
+			GLuint index,
+			GLint size,
+			GLenum type,
+			GLsizei stride,
+			const void *pointer
+		) override;
+		void enableVertexAttribArray(GLuint index) override;
+		void vertexAttribDivisor(GLuint index, GLuint divisor) override;
+		void genTextures(GLsizei n, GLuint *textures) override;
+		void deleteTextures(GLsizei n, const GLuint *textures) override;
+		void bindTexture(GLenum target, GLuint texture) override;
+		void activeTexture(GLenum texture) override;
+		void texImage2D(
+			GLenum target,
+			GLint level,
+			GLint internalformat,
+			GLsizei width,
+			GLsizei height,
+			GLint border,
+			GLenum format,
+			GLenum type,
+			const void *pixels
+		) override;
+		void texParameteri(GLenum target, GLenum pname, GLint param) override;
+		void generateMipmap(GLenum target) override;
+		void genFramebuffers(GLsizei n, GLuint *framebuffers) override;
+		void deleteFramebuffers(GLsizei n, const GLuint *framebuffers) override;
+		void bindFramebuffer(GLenum target, GLuint framebuffer) override;
+		void framebufferTexture2D(
+			GLenum target,
+			GLenum attachment,
+			GLenum textarget,
+			GLuint texture,
+			GLint level
+		) override;
+		GLenum checkFramebufferStatus(GLenum target) override;
+		GLuint createShader(GLenum type) override;
+		void shaderSource(
+			GLuint shader,
+			GLsizei count,
+			const GLchar *const *string,
+			const GLint *length
+		) override;
+		void compileShader(GLuint shader) override;
+		void getShaderiv(GLuint shader, GLenum pname, GLint *params) override;
+		void getShaderInfoLog(GLuint shader, GLsizei maxlen, GLsizei *len, GLchar *log) override;
+		void deleteShader(GLuint shader) override;
+		GLuint createProgram() override;
+		void attachShader(GLuint program, GLuint shader) override;
+		void detachShader(GLuint program, GLuint shader) override;
+		void linkProgram(GLuint program) override;
+		void validateProgram(GLuint program) override;
+		void getProgramiv(GLuint program, GLenum pname, GLint *params) override;
+		void getProgramInfoLog(GLuint program, GLsizei maxlen, GLsizei *len, GLchar *log) override;
+		void programParameteri(GLuint program, GLenum pname, GLint value) override;
+		void getProgramBinary(
+			GLuint program,
+			GLsizei bufsize,
+			GLsizei *len,
+			GLenum *format,
+			void *binary
+		) override;
+		void programBinary(GLuint program, GLenum format, const void *binary, GLsizei len) override;
+		void useProgram(GLuint program) override;
+		GLint getUniformLocation(GLuint program, const GLchar *name) override;
+		void getActiveUniform(
+			GLuint program,
+			GLuint index,
+			GLsizei bufsize,
+			GLsizei *len,
+			GLint *size,
+			GLenum *type,
+			GLchar *name
+		) override;
+		GLuint getUniformBlockIndex(GLuint program, const GLchar *name) override;
+		void uniformBlockBinding(GLuint program, GLuint index, GLuint binding) override;
+		void uniform1i(GLint location, GLint v) override;
+		void uniform1f(GLint location, GLfloat v) override;
+		void uniform2f(GLint location, GLfloat x, GLfloat y) override;
+		void uniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z) override;
+		void uniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w) override;
+		void uniform2fv(GLint location, GLsizei count, const GLfloat *v) override;
+		void uniform3fv(GLint location, GLsizei count, const GLfloat *v) override;
+		void uniform4fv(GLint location, GLsizei count, const GLfloat *v) override;
+		void uniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *v) override;
+		void uniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *v) override;
+		void enable(GLenum cap) override;
+		void disable(GLenum cap) override;
+		void depthFunc(GLenum func) override;
+		void depthMask(GLboolean flag) override;
+		void cullFace(GLenum mode) override;
+		void blendFunc(GLenum sfactor, GLenum dfactor) override;
+		void viewport(GLint x, GLint y, GLsizei width, GLsizei height) override;
+		void clear(GLbitfield mask) override;
+		void clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) override;
+		void drawElements(GLenum mode, GLsizei count, GLenum type, const void *indices) override;
+		void drawElementsInstanced(
+			GLenum mode,
+			GLsizei count,
+			GLenum type,
+			const void *indices,
+			GLsizei instances
+		) override;
+		GLenum getError() override;
+		void getIntegerv(GLenum pname, GLint *data) override;
+		const GLubyte* getString(GLenum name) override;
+	};
+}
+
+#define GFX gfx::GraphicsBackend::get()
+
+#endif
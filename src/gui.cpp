@@ -1,4 +1,6 @@
 #include "gui.h"
+#include "assets.h"
+#include "jobs.h"
 #include "colors.h"
 #include "game.h"
 #include "imgui.h"
@@ -7,6 +9,31 @@
 #include "window.h"
 #include <glm/glm.hpp>
 
+namespace {
+void drawResidency(const char *label, const assets::Residency &residency) {
+  const float mb = 1024.0f * 1024.0f;
+  assets::ResidencyStats stats = residency.getStats();
+  ImGui::Text("%s : %u/%u resident, %u loading", label, stats.resident,
+              stats.total, stats.loading);
+  ImGui::Text("%.1f / %.1f MB, %u evicted", float(stats.used) / mb,
+              float(stats.budget) / mb, stats.evicted);
+  if (ImGui::TreeNode(label)) {
+    for (const auto &asset : residency.list()) {
+      if (asset.second.state == assets::Residency::UNLOADED)
+        continue;
+      if (asset.second.state == assets::Residency::LOADING) {
+        ImGui::Text("%s : loading", sym::name(asset.first));
+        continue;
+      }
+      ImGui::Text("%s : %.2f MB, used %u frame(s) ago", sym::name(asset.first),
+                  float(asset.second.bytes) / mb,
+                  residency.getFrame() - asset.second.lastused);
+    }
+    ImGui::TreePop();
+  }
+}
+} // namespace
+
 Gui::Gui() {
 
   IMGUI_CHECKVERSION();
@@ -89,6 +116,42 @@ void Gui::drawUI() {
     ImGui::Text("Ship Count : %d", dItems.shipCount);
     ImGui::Separator();
     ImGui::Text("Balloon Count : %d", dItems.balloonCount);
+    ImGui::Separator();
+    ImGui::Text("Render Queue");
+    ImGui::Text("Draw calls : %u", dItems.renderStats.draws);
+    ImGui::Text("State changes : %u", dItems.renderStats.stateChanges);
+    ImGui::Text("Program changes : %u", dItems.renderStats.programChanges);
+    ImGui::Text("Texture changes : %u", dItems.renderStats.textureChanges);
+    ImGui::Text("VAO changes : %u", dItems.renderStats.vaoChanges);
+    ImGui::Text("Uniform uploads : %u", dItems.renderStats.uniformUploads);
+    ImGui::Separator();
+    ImGui::Text("Terrain Culling");
+    for (int i = 0; i < MAX_LOD; i++) {
+      const infworld::ChunkCullStats &stats = dItems.terrainCulling[i];
+      ImGui::Text("LOD %d : %u drawn, %u culled, %u occluded (%u tests)", i,
+                  stats.drawn, stats.culled, stats.occluded, stats.tests);
+    }
+    ImGui::Separator();
+    ImGui::Text("Decoration Culling");
+    ImGui::Text("Chunks : %u drawn, %u culled, %u occluded",
+                dItems.decorationCulling.drawn, dItems.decorationCulling.culled,
+                dItems.decorationCulling.occluded);
+    ImGui::Text("Instances : %u in %u draws",
+                dItems.decorationCulling.instances,
+                dItems.decorationCulling.draws);
+    ImGui::Separator();
+    ImGui::Text("Particles : %u (%u explosions, %u each)",
+                dItems.particles.particles, dItems.particles.explosions,
+                dItems.particles.perexplosion);
+    ImGui::Text("Explosions dropped : %u", dItems.particles.dropped);
+    ImGui::Separator();
+    ImGui::Text("Frame Prep (%u workers) : %.2f ms", JOBS->workerCount(),
+                dItems.framePrepTotal);
+    for (const auto &timing : dItems.framePrep)
+      ImGui::Text("%s : %.3f ms", timing.name, timing.ms);
+    ImGui::Separator();
+    drawResidency("Textures", TEXTURES->getResidency());
+    drawResidency("Models", VAOS->getResidency());
 
     ImGui::End();
   }
@@ -232,6 +295,34 @@ game::MainMenuActions Gui::drawMainMenu() {
     return action;
  }
 
+void Gui::drawLoadingScreen(unsigned int loaded, unsigned int total) {
+  Window &window = Window::getInstance();
+  int w = window.getWidth();
+  int h = window.getHeight();
+
+  ImGui::SetNextWindowPos(ImVec2(w * 0.5f, h * 0.5f), ImGuiCond_Always,
+                          ImVec2(0.5f, 0.5f));
+  ImGui::SetNextWindowSize(ImVec2(w * 0.4f, 0.0f));
+
+  ImGuiWindowFlags window_flags =
+      ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize |
+      ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoBackground;
+
+  if (ImGui::Begin("LoadingScreen", nullptr, window_flags)) {
+    ImGui::SetWindowFontScale(2.0f);
+    float text_width = ImGui::CalcTextSize("Loading...").x;
+    ImGui::SetCursorPosX((ImGui::GetWindowSize().x - text_width) * 0.5f);
+    ImGui::Text("Loading...");
+    ImGui::SetWindowFontScale(1.0f);
+
+    float fraction = total > 0 ? float(loaded) / float(total) : 1.0f;
+    char overlay[32];
+    snprintf(overlay, sizeof(overlay), "%u / %u", loaded, total);
+    ImGui::ProgressBar(fraction, ImVec2(-1.0f, 0.0f), overlay);
+    ImGui::End();
+  }
+}
+
 void Gui::drawHUD() {
 
   ImGuiViewport *viewport = ImGui::GetMainViewport();
@@ -13,6 +13,12 @@ struct DebugItems{
   glm::vec3 cameraPosition;
   int shipCount;
   int balloonCount;
+  gfx::QueueStats renderStats;
+  infworld::ChunkCullStats terrainCulling[MAX_LOD];
+  infworld::DecorationCullStats decorationCulling;
+  std::vector<gfx::PrepTiming> framePrep;
+  float framePrepTotal = 0.0f;
+  gfx::ParticleStats particles;
 };
 
 struct HUDItems {
@@ -42,6 +48,8 @@ public:
   void drawUI();
   void drawHUD();
   game::MainMenuActions drawMainMenu();
+  // Progress of game::loadAssets
+  void drawLoadingScreen(unsigned int loaded, unsigned int total);
   game::PauseMenuActions drawPauseMenu();
   game::DeathMenuActions drawDeathMenu();
   DebugItems dItems;
@@ -0,0 +1,132 @@
+#include "horizon.h"
+#include <algorithm>
+#include <math.h>
+
+//Anything with a slope at or below this is never hidden
+constexpr float NO_HORIZON = -1e9f;
+
+namespace geo {
+	HorizonBuffer::HorizonBuffer(unsigned int bins)
+	{
+		slopes = std::vector<float>(bins, NO_HORIZON);
+		distances = std::vector<float>(bins, 0.0f);
+	}
+
+	void HorizonBuffer::clear(const glm::vec3 &camerapos)
+	{
+		eye = camerapos;
+		std::fill(slopes.begin(), slopes.end(), NO_HORIZON);
+		std::fill(distances.begin(), distances.end(), 0.0f);
+	}
+
+	bool HorizonBuffer::getSpan(
+		const glm::vec2 &min,
+		const glm::vec2 &max,
+		float &minbin,
+		float &maxbin,
+		float &mindist,
+		float &maxdist
+	) const {
+		glm::vec2 e = glm::vec2(eye.x, eye.z);
+		if(e.x >= min.x && e.x <= max.x && e.y >= min.y && e.y <= max.y)
+			return false;
+
+		glm::vec2 nearest = glm::clamp(e, min, max);
+		mindist = glm::length(nearest - e);
+
+		const glm::vec2 corners[] = {
+			min,
+			glm::vec2(max.x, min.y),
+			glm::vec2(min.x, max.y),
+			max,
+		};
+
+		//Since the camera is outside of the rectangle, the rectangle covers
+		//less than half of the circle so we can measure the angles of the
+		//corners relative to the angle of the center without wrapping
+		glm::vec2 center = (min + max) / 2.0f - e;
+		float centerangle = atan2f(center.y, center.x);
+		float minangle = 0.0f, maxangle = 0.0f;
+		maxdist = 0.0f;
+		for(const auto &corner : corners) {
+			glm::vec2 d = corner - e;
+			float angle = atan2f(d.y, d.x) - centerangle;
+			if(angle > float(M_PI))
+				angle -= 2.0f * float(M_PI);
+			else if(angle < -float(M_PI))
+				angle += 2.0f * float(M_PI);
+			minangle = std::min(minangle, angle);
+			maxangle = std::max(maxangle, angle);
+			maxdist = std::max(maxdist, glm::length(d));
+		}
+
+		float binsperradian = float(slopes.size()) / (2.0f * float(M_PI));
+		//Angles are in the range [0, 2pi)
+		float start = centerangle + minangle;
+		if(start < 0.0f)
+			start += 2.0f * float(M_PI);
+		minbin = start * binsperradian;
+		maxbin = minbin + (maxangle - minangle) * binsperradian;
+		return true;
+	}
+
+	void HorizonBuffer::addOccluder(
+		const glm::vec2 &min,
+		const glm::vec2 &max,
+		float minheight
+	) {
+		float minbin, maxbin, mindist, maxdist;
+		if(!getSpan(min, max, minbin, maxbin, mindist, maxdist))
+			return;
+
+		//Every ray in a bin passes over the rectangle somewhere between
+		//mindist and maxdist, we take the lowest slope that a line of
+		//sight could have over the rectangle so that this stays conservative
+		float dy = minheight - eye.y;
+		if(dy <= 0.0f && mindist <= 0.0f)
+			return;
+		float slope = dy / (dy > 0.0f ? maxdist : mindist);
+
+		//Only bins that are completely covered by the rectangle
+		int first = int(ceilf(minbin)), last = int(floorf(maxbin)) - 1;
+		int count = slopes.size();
+		for(int i = first; i <= last; i++) {
+			int bin = i % count;
+			if(slope <= slopes[bin])
+				continue;
+			//Everything past both occluders is hidden by the higher one
+			slopes[bin] = slope;
+			distances[bin] = std::max(distances[bin], maxdist);
+		}
+	}
+
+	bool HorizonBuffer::occluded(const glm::vec3 &min, const glm::vec3 &max) const
+	{
+		float minbin, maxbin, mindist, maxdist;
+		if(!getSpan(glm::vec2(min.x, min.z), glm::vec2(max.x, max.z), minbin, maxbin, mindist, maxdist))
+			return false;
+		if(mindist <= 0.0f)
+			return false;
+
+		//Highest slope of a line from the camera to the box
+		float dy = max.y - eye.y;
+		float slope = dy / (dy > 0.0f ? mindist : maxdist);
+
+		int first = int(floorf(minbin)), last = int(floorf(maxbin));
+		int count = slopes.size();
+		if(last - first >= count)
+			return false;
+		for(int i = first; i <= last; i++) {
+			int bin = i % count;
+			if(slope >= slopes[bin] || mindist < distances[bin])
+				return false;
+		}
+
+		return true;
+	}
+
+	unsigned int HorizonBuffer::binCount() const
+	{
+		return slopes.size();
+	}
+}
@@ -0,0 +1,49 @@
+/*
+ * CPU horizon culling, near terrain is rasterized into a 1D buffer of
+ * azimuth bins that stores how high the horizon is in each direction as
+ * seen from the camera, anything far away that is entirely below the
+ * horizon is hidden behind terrain and does not need to be drawn
+ *
+ * This does not depend on OpenGL so it can be used without a window
+ * */
+
+#ifndef HORIZON_H
+#define HORIZON_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace geo {
+	class HorizonBuffer {
+		//Each bin stores the slope (height / horizontal distance) of the
+		//horizon and the distance from the camera that it is valid past
+		std::vector<float> slopes;
+		std::vector<float> distances;
+		glm::vec3 eye = glm::vec3(0.0f);
+
+		//Returns false if 'eye' is inside of the rectangle,
+		//otherwise outputs the angle range (in bins, maxbin >= minbin but
+		//it can be larger than the bin count) and the distance range of
+		//the rectangle
+		bool getSpan(
+			const glm::vec2 &min,
+			const glm::vec2 &max,
+			float &minbin,
+			float &maxbin,
+			float &mindist,
+			float &maxdist
+		) const;
+	public:
+		HorizonBuffer(unsigned int bins);
+		//Resets the buffer so that nothing is occluded
+		void clear(const glm::vec3 &camerapos);
+		//Adds a rectangle in the xz plane where the ground is at least
+		//'minheight' high (such as a terrain chunk)
+		void addOccluder(const glm::vec2 &min, const glm::vec2 &max, float minheight);
+		//Returns true if the box is hidden behind the horizon
+		bool occluded(const glm::vec3 &min, const glm::vec3 &max) const;
+		unsigned int binCount() const;
+	};
+}
+
+#endif
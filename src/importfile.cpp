@@ -1,6 +1,8 @@
 #include "importfile.h"
+#include "assetpack.h"
 #include <fstream>
 #include <stdio.h>
+#include <string.h>
 
 namespace impfile {
 	Result::Result(bool e, std::string m)
@@ -106,7 +108,7 @@ namespace impfile {
 	Result parseVariable(Variable &var, std::stringstream &stream) 
 	{
 		Variable v;
-		char c;
+		char c = '\0';
 		std::string* readinto = &v.first;
 		//If quotecount is odd, that means we are in a quote
 		//If it is even, we are outside of a quote
@@ -195,13 +197,29 @@ namespace impfile {
 	{
 		std::vector<Entry> entries;
 
-		std::stringstream filecontents;
-		std::ifstream file(path);
+		assetpack::FileData data;
 		//Failed to open file, return empty vector
-		if(!file.is_open()) {
+		if(!assetpack::readFile(path, data)) {
 			fprintf(stderr, "failed to open file: %s\n", path);
 			return entries;
 		}
+
+		std::string_view contents((const char*)data.data(), data.size());
+		Result res = isCompiled(contents) ?
+			parseCompiled(contents, entries) :
+			parseText(contents, entries, path);
+		if(res.isError()) {
+			fprintf(stderr, "Syntax error in %s\n", path);
+			res.output();
+		}
+		return entries;
+	}
+
+	std::vector<Entry> parseLegacy(std::istream &file, const char *path)
+	{
+		std::vector<Entry> entries;
+
+		std::stringstream filecontents;
 		
 		//Otherwise read the entire file's contents
 		//I don't anticipate the import files to be particularly large so
@@ -233,7 +251,6 @@ namespace impfile {
 			entries.push_back(e);
 		}
 
-		file.close();
 		return entries;
 	}
 
@@ -281,4 +298,225 @@ namespace impfile {
 		sstream << f;
 		entry.variables.insert({ name, sstream.str() });
 	}
+
+	Cursor::Cursor(std::string_view t, const char *p)
+	{
+		text = t;
+		path = p;
+	}
+
+	bool Cursor::done() const
+	{
+		return pos >= text.size();
+	}
+
+	char Cursor::peek() const
+	{
+		return done() ? '\0' : text[pos];
+	}
+
+	void Cursor::advance()
+	{
+		if(done())
+			return;
+		if(text[pos] == '\n') {
+			line++;
+			column = 1;
+		}
+		else
+			column++;
+		pos++;
+	}
+
+	Result Cursor::error(const std::string &msg) const
+	{
+		return Result::Error(
+			std::string(path) + ":" + std::to_string(line) + ":" +
+			std::to_string(column) + ": " + msg
+		);
+	}
+
+	void skipWhitespace(Cursor &cursor)
+	{
+		while(!cursor.done()) {
+			char c = cursor.peek();
+			if(c == '#') {
+				while(!cursor.done() && cursor.peek() != '\n')
+					cursor.advance();
+			}
+			else if(std::isspace((unsigned char)c))
+				cursor.advance();
+			else
+				return;
+		}
+	}
+
+	Result readQuoted(Cursor &cursor, std::string_view &str, const char *what)
+	{
+		if(cursor.peek() != '\"')
+			return cursor.error(std::string("Expected a quoted ") + what);
+		Cursor start = cursor;
+		cursor.advance();
+		size_t begin = cursor.pos;
+		while(!cursor.done() && cursor.peek() != '\"') {
+			if(cursor.peek() == '\n')
+				return start.error("Mismatched quotes");
+			cursor.advance();
+		}
+		if(cursor.done())
+			return start.error("Mismatched quotes");
+		str = cursor.text.substr(begin, cursor.pos - begin);
+		cursor.advance();
+		return Result::Ok();
+	}
+
+	Result expect(Cursor &cursor, char c)
+	{
+		skipWhitespace(cursor);
+		if(cursor.peek() != c)
+			return cursor.error(std::string("Expected \'") + c + "\'");
+		cursor.advance();
+		return Result::Ok();
+	}
+
+	Result parseText(std::string_view text, std::vector<Entry> &entries, const char *path)
+	{
+		Cursor cursor(text, path);
+		while(true) {
+			skipWhitespace(cursor);
+			if(cursor.done())
+				return Result::Ok();
+
+			Entry entry;
+			std::string_view name;
+			Cursor namestart = cursor;
+			Result res = readQuoted(cursor, name, "entry name");
+			if(res.isError())
+				return res;
+			if(name.empty())
+				return namestart.error("Empty entry name");
+			entry.name = std::string(name);
+			res = expect(cursor, '{');
+			if(res.isError())
+				return res;
+
+			while(true) {
+				skipWhitespace(cursor);
+				if(cursor.done())
+					return cursor.error("No closing } for \'" + entry.name + "\'");
+				if(cursor.peek() == '}') {
+					cursor.advance();
+					break;
+				}
+
+				std::string_view var, value;
+				Cursor varstart = cursor;
+				res = readQuoted(cursor, var, "variable name");
+				if(res.isError())
+					return res;
+				if(var.empty())
+					return varstart.error("Empty variable name");
+				res = expect(cursor, '=');
+				if(res.isError())
+					return res;
+				skipWhitespace(cursor);
+				res = readQuoted(cursor, value, "value");
+				if(res.isError())
+					return res;
+				//The ';' after the last variable is optional
+				skipWhitespace(cursor);
+				if(cursor.peek() != '}') {
+					res = expect(cursor, ';');
+					if(res.isError())
+						return res;
+				}
+				entry.variables.insert({ std::string(var), std::string(value) });
+			}
+			entries.push_back(std::move(entry));
+		}
+	}
+
+	bool isCompiled(std::string_view data)
+	{
+		return data.size() >= sizeof(COMPILED_MAGIC) &&
+			memcmp(data.data(), COMPILED_MAGIC, sizeof(COMPILED_MAGIC)) == 0;
+	}
+
+	namespace {
+		void writeU32(std::string &out, uint32_t n)
+		{
+			out.append((const char*)&n, sizeof(n));
+		}
+
+		void writeString(std::string &out, const std::string &str)
+		{
+			writeU32(out, str.size());
+			out += str;
+		}
+
+		bool readU32(std::string_view data, size_t &pos, uint32_t &n)
+		{
+			if(data.size() - pos < sizeof(n))
+				return false;
+			memcpy(&n, data.data() + pos, sizeof(n));
+			pos += sizeof(n);
+			return true;
+		}
+
+		bool readString(std::string_view data, size_t &pos, std::string &str)
+		{
+			uint32_t length;
+			if(!readU32(data, pos, length) || data.size() - pos < length)
+				return false;
+			str.assign(data.data() + pos, length);
+			pos += length;
+			return true;
+		}
+	}
+
+	std::string compile(const std::vector<Entry> &entries)
+	{
+		std::string out(COMPILED_MAGIC, sizeof(COMPILED_MAGIC));
+		writeU32(out, COMPILED_VERSION);
+		writeU32(out, entries.size());
+		for(const auto &entry : entries) {
+			writeString(out, entry.name);
+			writeU32(out, entry.variables.size());
+			for(const auto &var : entry.variables) {
+				writeString(out, var.first);
+				writeString(out, var.second);
+			}
+		}
+		return out;
+	}
+
+	Result parseCompiled(std::string_view data, std::vector<Entry> &entries)
+	{
+		size_t pos = sizeof(COMPILED_MAGIC);
+		uint32_t version, count;
+		if(!isCompiled(data) || !readU32(data, pos, version) || !readU32(data, pos, count))
+			return Result::Error("Not a compiled impfile");
+		if(version != COMPILED_VERSION)
+			return Result::Error("Compiled impfile is version " + std::to_string(version));
+
+		//Every entry takes at least its name length and variable count, a
+		//count that could not fit in the rest of the file is not reserved
+		if(count > (data.size() - pos) / 8)
+			return Result::Error("Compiled impfile is truncated");
+		entries.reserve(entries.size() + count);
+		for(uint32_t i = 0; i < count; i++) {
+			Entry entry;
+			uint32_t varcount;
+			if(!readString(data, pos, entry.name) || !readU32(data, pos, varcount))
+				return Result::Error("Compiled impfile is truncated");
+			for(uint32_t j = 0; j < varcount; j++) {
+				Variable var;
+				if(!readString(data, pos, var.first) || !readString(data, pos, var.second))
+					return Result::Error("Compiled impfile is truncated");
+				entry.variables.insert(std::move(var));
+			}
+			entries.push_back(std::move(entry));
+		}
+		return Result::Ok();
+	}
 }
@@ -2,6 +2,9 @@
 #include <string>
 #include <unordered_map>
 #include <sstream>
+#include <cctype>
+#include <stdint.h>
+#include <string_view>
 #include <vector>
 
 /*
@@ -58,7 +61,50 @@ namespace impfile {
 	//returns true if it can successfully parse an entry
 	Result parseEntry(Entry &entry, std::stringstream &stream);
 	
+	//Reads either the text or the compiled form
 	std::vector<Entry> parseFile(const char *path);
+	//The original line based parser that goes through stringstreams,
+	//only kept around to compare against
+	std::vector<Entry> parseLegacy(std::istream &file, const char *path);
+
+	//Position in the text being parsed, used for error messages
+	struct Cursor {
+		std::string_view text;
+		const char *path;
+		size_t pos = 0;
+		unsigned int line = 1, column = 1;
+		Cursor(std::string_view text, const char *path);
+		bool done() const;
+		char peek() const;
+		void advance();
+		//The error is prefixed with path:line:column
+		Result error(const std::string &msg) const;
+	};
+	//Skips whitespace and comments
+	void skipWhitespace(Cursor &cursor);
+	//Reads a quoted string on a single line, 'str' points into
+	//the text being parsed
+	Result readQuoted(Cursor &cursor, std::string_view &str, const char *what);
+	//Skips whitespace and then expects 'c'
+	Result expect(Cursor &cursor, char c);
+	//Parses 'text' in one pass, each name and value is only copied once
+	//into the entries, 'path' is used for error messages, on an error
+	//'entries' holds every entry before the one that failed
+	Result parseText(
+		std::string_view text,
+		std::vector<Entry> &entries,
+		const char *path = "<text>"
+	);
+
+	//Compiled form for shipping builds:
+	//"IMPB", version, entry count and then for each entry its name,
+	//variable count and the variable names and values, every count is a
+	//uint32 and every string is a uint32 length followed by the bytes
+	constexpr char COMPILED_MAGIC[4] = { 'I', 'M', 'P', 'B' };
+	constexpr uint32_t COMPILED_VERSION = 1;
+	bool isCompiled(std::string_view data);
+	std::string compile(const std::vector<Entry> &entries);
+	Result parseCompiled(std::string_view data, std::vector<Entry> &entries);
 	
 	//converts an entry into a string
 	std::string entryToString(const Entry &entry);
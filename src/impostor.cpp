@@ -0,0 +1,228 @@
+#include "impostor.h"
+#include "assets.h"
+#include "infworld.h"
+#include "logger.h"
+#include "plants.h"
+#include <algorithm>
+#include <cmath>
+#include <float.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <unordered_map>
+
+namespace {
+	std::unordered_map<sym::Symbol, impostor::Atlas> atlases;
+
+	unsigned int createTexture(
+		GLint internalformat,
+		int width,
+		int height,
+		GLenum format,
+		GLenum type
+	) {
+		unsigned int id;
+		GFX->genTextures(1, &id);
+		GFX->bindTexture(GL_TEXTURE_2D, id);
+		GFX->texImage2D(
+			GL_TEXTURE_2D,
+			0,
+			internalformat,
+			width,
+			height,
+			0,
+			format,
+			type,
+			nullptr
+		);
+		GFX->texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		GFX->texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		GFX->texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		GFX->texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		return id;
+	}
+}
+
+namespace impostor {
+	bool bake(
+		const std::string &name,
+		const std::string &vaoname,
+		const std::string &texturename,
+		const mesh::Model &model
+	) {
+		Atlas atlas;
+		atlas.texture = sym::intern(name);
+		if(!model.vertices.empty()) {
+			atlas.bottom = atlas.top = model.vertices[0].y;
+			for(const auto &v : model.vertices) {
+				atlas.radius = std::max(atlas.radius, glm::length(glm::vec2(v.x, v.z)));
+				atlas.bottom = std::min(atlas.bottom, v.y);
+				atlas.top = std::max(atlas.top, v.y);
+			}
+		}
+		if(atlas.radius <= 0.0f || atlas.top <= atlas.bottom) {
+			WARN("Can not make an impostor of %s, it has no size", vaoname.c_str());
+			return false;
+		}
+
+		const float aspect = 2.0f * atlas.radius / (atlas.top - atlas.bottom);
+		const int tilewidth = std::clamp(int(float(TILE_HEIGHT) * aspect), 16, 256);
+		atlas.width = tilewidth * VIEWS;
+		atlas.height = TILE_HEIGHT;
+
+		unsigned int color =
+			createTexture(GL_RGBA, atlas.width, atlas.height, GL_RGBA, GL_UNSIGNED_BYTE);
+		unsigned int depth = createTexture(
+			GL_DEPTH_COMPONENT24,
+			atlas.width,
+			atlas.height,
+			GL_DEPTH_COMPONENT,
+			GL_UNSIGNED_INT
+		);
+		unsigned int fbo;
+		GFX->genFramebuffers(1, &fbo);
+		GFX->bindFramebuffer(GL_FRAMEBUFFER, fbo);
+		GFX->framebufferTexture2D(
+			GL_FRAMEBUFFER,
+			GL_COLOR_ATTACHMENT0,
+			GL_TEXTURE_2D,
+			color,
+			0
+		);
+		GFX->framebufferTexture2D(
+			GL_FRAMEBUFFER,
+			GL_DEPTH_ATTACHMENT,
+			GL_TEXTURE_2D,
+			depth,
+			0
+		);
+		if(GFX->checkFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			WARN("Impostor framebuffer for %s is incomplete", vaoname.c_str());
+			GFX->bindFramebuffer(GL_FRAMEBUFFER, 0);
+			GFX->deleteFramebuffers(1, &fbo);
+			GFX->deleteTextures(1, &color);
+			GFX->deleteTextures(1, &depth);
+			return false;
+		}
+
+		GFX->viewport(0, 0, atlas.width, atlas.height);
+		GFX->clearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		GFX->clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		GFX->enable(GL_DEPTH_TEST);
+		GFX->depthMask(GL_TRUE);
+		GFX->disable(GL_CULL_FACE);
+		GFX->disable(GL_BLEND);
+
+		//One instance at the origin without any variation
+		const gfx::Vao &vao = VAOS->getVao(sym::intern(vaoname));
+		const infworld::DecorationInstance instance = infworld::packDecoration(
+			glm::vec3(0.0f),
+			glm::vec2(0.0f),
+			0.0f
+		);
+		GFX->bindBuffer(GL_ARRAY_BUFFER, vao.buffers.at(4));
+		GFX->bufferData(GL_ARRAY_BUFFER, sizeof(instance), &instance, GL_STREAM_DRAW);
+		GFX->bindBuffer(GL_ARRAY_BUFFER, 0);
+
+		assets::TextureInfo texture = TEXTURES->getTexture(sym::intern(texturename));
+		GFX->activeTexture(GL_TEXTURE0);
+		GFX->bindTexture(texture.target, texture.id);
+
+		//Lit the same way as displayDecorations, without wind and
+		//without fading into the impostor
+		ShaderProgram &shader = SHADERS->getShader("tree"_sym);
+		shader.use();
+		shader.uniformInt("tex", 0);
+		shader.uniformMat4x4("transform", glm::mat4(1.0f));
+		shader.uniformVec3("lightdir", glm::normalize(glm::vec3(-1.0f)));
+		shader.uniformFloat("time", 0.0f);
+		shader.uniformFloat("windstrength", 0.0f);
+		shader.uniformFloat("specularfactor", 0.0f);
+		shader.uniformFloat("impostordist", FLT_MAX);
+		shader.uniformFloat("impostorfade", 1.0f);
+		shader.uniformFloat("chunkwidth", 0.0f);
+		shader.uniformInt("novariation", 1);
+		const float camdist = atlas.radius + 1.0f;
+		shader.uniformMat4x4(
+			"persp",
+			glm::ortho(
+				-atlas.radius,
+				atlas.radius,
+				atlas.bottom,
+				atlas.top,
+				0.01f,
+				camdist * 2.0f
+			)
+		);
+
+		vao.bind();
+		//View i is seen from (sin(a), 0, cos(a)) with a = 2pi * i / VIEWS,
+		//impostor-vert.glsl picks the view with the same angle
+		for(unsigned int i = 0; i < VIEWS; i++) {
+			float angle = 2.0f * float(M_PI) * float(i) / float(VIEWS);
+			glm::vec3 eye = glm::vec3(std::sin(angle), 0.0f, std::cos(angle)) * camdist;
+			shader.uniformMat4x4(
+				"view",
+				glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f))
+			);
+			shader.uniformVec3("camerapos", eye);
+			GFX->viewport(tilewidth * i, 0, tilewidth, atlas.height);
+			GFX->drawElementsInstanced(
+				GL_TRIANGLES,
+				vao.vertcount,
+				vao.indextype,
+				nullptr,
+				1
+			);
+		}
+		//The decorations are drawn with the same program
+		shader.uniformInt("novariation", 0);
+
+		GFX->bindFramebuffer(GL_FRAMEBUFFER, 0);
+		GFX->deleteFramebuffers(1, &fbo);
+		GFX->deleteTextures(1, &depth);
+
+		//A few levels are enough at the distances impostors are drawn at,
+		//lower ones would blend neighbouring views together
+		GFX->bindTexture(GL_TEXTURE_2D, color);
+		GFX->generateMipmap(GL_TEXTURE_2D);
+		GFX->texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 4);
+		GFX->texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		GFX->texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		TEXTURES->add(name, { color, GL_TEXTURE_2D });
+		atlases[sym::intern(name)] = atlas;
+		INFO(
+			"Baked impostor %s (%dx%d, %u views)",
+			name.c_str(),
+			atlas.width,
+			atlas.height,
+			VIEWS
+		);
+		return true;
+	}
+
+	const Atlas* get(sym::Symbol name)
+	{
+		auto found = atlases.find(name);
+		return found == atlases.end() ? nullptr : &found->second;
+	}
+
+	gfx::Vao createQuadVao()
+	{
+		mesh::Model quad;
+		quad.vertices = {
+			glm::vec3(-0.5f, 0.0f, 0.0f),
+			glm::vec3(0.5f, 0.0f, 0.0f),
+			glm::vec3(0.5f, 1.0f, 0.0f),
+			glm::vec3(-0.5f, 1.0f, 0.0f),
+		};
+		quad.texturecoords = {
+			glm::vec2(0.0f, 0.0f),
+			glm::vec2(1.0f, 0.0f),
+			glm::vec2(1.0f, 1.0f),
+			glm::vec2(0.0f, 1.0f),
+		};
+		quad.normals.assign(4, glm::vec3(0.0f, 0.0f, 1.0f));
+		quad.indices = { 0, 1, 2, 2, 3, 0 };
+		return plants::createPlantVao(quad);
+	}
+}
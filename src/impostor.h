@@ -0,0 +1,53 @@
+/*
+ * Impostors for distant decorations, each tree model is rendered from
+ * VIEWS directions around its vertical axis into one row of an atlas once
+ * the assets are loaded, trees that are far away are then drawn as camera
+ * facing quads that show whichever view is closest to the direction of the
+ * camera instead of the full 3d model
+ * */
+
+#ifndef IMPOSTOR_H
+#define IMPOSTOR_H
+
+#include "gfx.h"
+#include "symbol.h"
+#include <string>
+
+namespace impostor {
+	//Number of directions each model is rendered from, must match VIEWS
+	//in impostor-vert.glsl
+	constexpr unsigned int VIEWS = 8;
+	//Height of a view in the atlas in pixels, the width depends on the
+	//proportions of the model
+	constexpr int TILE_HEIGHT = 128;
+
+	struct Atlas {
+		//Name of the atlas in the texture manager
+		sym::Symbol texture;
+		int width = 0, height = 0;
+		//Bounds of the model (before it is scaled), the quad is
+		//2 * radius wide and goes from bottom to top
+		float radius = 0.0f;
+		float bottom = 0.0f, top = 0.0f;
+	};
+
+	//Renders the vao called 'vaoname' (a plant vao, see createPlantVao)
+	//with the 'tree' shader and the texture 'texturename' into an atlas
+	//that is added to the texture manager as 'name', 'model' is only used
+	//for its bounds, the framebuffer is set back to 0 afterwards but the
+	//viewport is not restored
+	//Returns false if the framebuffer could not be created
+	bool bake(
+		const std::string &name,
+		const std::string &vaoname,
+		const std::string &texturename,
+		const mesh::Model &model
+	);
+	//Returns nullptr if 'name' was not baked
+	const Atlas* get(sym::Symbol name);
+	//Quad with x in [-0.5, 0.5] and y in [0, 1] for drawing impostors,
+	//the instances go in buffer 4 like the plant vaos
+	gfx::Vao createQuadVao();
+}
+
+#endif
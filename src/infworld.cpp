@@ -17,6 +17,14 @@ namespace infworld {
 		return permutations;
 	}
 
+	uint32_t getWorldSeed(const worldseed &permutations)
+	{
+		uint32_t seed = 0;
+		for(int value : permutations.at(0))
+			seed = rng::pcgHash(seed + uint32_t(value));
+		return seed;
+	}
+
 	float smoothstep(float x)
 	{
 		return x * x * (3.0f - 2.0f * x);
@@ -71,9 +79,11 @@ namespace infworld {
 		int chunkx,
 		int chunkz,
 		float maxheight,
-		float chunkscale
+		float chunkscale,
+		ChunkBounds *bounds
 	) {
 		mesh::ElementArrayBuffer<float> worldarraybuffer;
+		float minh = 1.0f, maxh = -1.0f;
 
 		worldarraybuffer.mesh.vertices.reserve(PREC * PREC * 3 * 2);
 
@@ -95,9 +105,14 @@ namespace infworld {
 				worldarraybuffer.mesh.vertices.push_back(vertex.y / maxheight);	
 				worldarraybuffer.mesh.vertices.push_back(n.x);
 				worldarraybuffer.mesh.vertices.push_back(n.y);
+				minh = std::min(minh, vertex.y / maxheight);
+				maxh = std::max(maxh, vertex.y / maxheight);
 			}
 		}
 
+		if(bounds)
+			*bounds = { minh, maxh };
+
 		return worldarraybuffer;
 	}
 
@@ -108,10 +123,17 @@ namespace infworld {
 		float maxheight,
 		float chunkscale
 	) {
-		return {
-			infworld::createChunkElementArray(permutations, x, z, maxheight, chunkscale),
-			{ x, z }
-		};
+		ChunkData chunk;
+		chunk.position = { x, z };
+		chunk.chunkmesh = infworld::createChunkElementArray(
+			permutations,
+			x,
+			z,
+			maxheight,
+			chunkscale,
+			&chunk.bounds
+		);
+		return chunk;
 	}
 
 	inline unsigned int joinBuilderThreads(
@@ -1,15 +1,20 @@
 #ifndef INFWORLD_H
 #define INFWORLD_H
 
+#include <float.h>
 #include <stdint.h>
 #include <vector>
 #include <glm/glm.hpp>
+#include <mutex>
 #include <random>
 #include <unordered_map>
 #include "noise.h"
 #include "gfx.h"
 #include "geometry.h"
 #include "shader.h"
+#include "renderqueue.h"
+#include "horizon.h"
+#include "jobs.h"
 
 constexpr unsigned int PREC = 40;
 constexpr float CHUNK_SZ = 64.0f;
@@ -35,59 +40,273 @@ namespace infworld {
 		int x = 0, z = 0;
 	};
 
+	//Lowest and highest point of a chunk, divided by the max height
+	//(the default is the most conservative bound possible)
+	struct ChunkBounds {
+		float minheight = -1.0f;
+		float maxheight = 1.0f;
+	};
+
 	struct ChunkData {
 		mesh::ElementArrayBuffer<float> chunkmesh;
 		ChunkPos position;
+		ChunkBounds bounds;
+	};
+
+	//Number of chunks in a chunk table that were drawn/culled in a frame
+	struct ChunkCullStats {
+		unsigned int drawn = 0;
+		unsigned int culled = 0;
+		//Hidden behind terrain
+		unsigned int occluded = 0;
+		//Number of frustum tests done
+		unsigned int tests = 0;
 	};
 
 	enum DecorationType {
 		TREE,
 		PINE_TREE,
 	};
+	constexpr unsigned int DECORATION_TYPE_COUNT = 2;
+
+	//Bits of a decoration's variation, the yaw is in 1/64ths of a turn,
+	//the scale is (bits + 48) / 64 and the tint is (bits - 16) / 16 of the
+	//largest leaf tint, the vertex shaders take the variation from a hash
+	//of the packed x and z so it is not stored (see tree-vert.glsl)
+	constexpr unsigned int VARIATION_YAW_SHIFT = 0;
+	constexpr unsigned int VARIATION_SCALE_SHIFT = 6;
+	constexpr unsigned int VARIATION_TINT_SHIFT = 11;
+	//Largest scale a decoration can get
+	constexpr float MAX_VARIATION_SCALE = 79.0f / 64.0f;
 
 	struct Decoration {
 		glm::vec3 position;
 		DecorationType type;
 	};
 
+	//Decorations are placed no higher than this fraction of HEIGHT (see
+	//PLACEMENTS in chunkdecorations.cpp) and no lower than 0
+	constexpr float DECORATION_MAX_HEIGHT = 0.3f;
+	//Instance heights are stored in steps of 1 / DECORATION_HEIGHT_STEPS
+	//above 0, in 10 bits where 1023 is only used by DECORATION_HIDDEN
+	constexpr float DECORATION_HEIGHT_STEPS = 5.0f;
+	static_assert(
+		HEIGHT * SCALE * DECORATION_MAX_HEIGHT * DECORATION_HEIGHT_STEPS < 1023.0f,
+		"Decoration heights must fit in 10 bits"
+	);
+
+	//Steps across the width of a chunk that x and z are stored in (11 bits)
+	constexpr float DECORATION_POSITION_STEPS = 2047.0f;
+	//Chunks up to this far from the world origin (in chunks) unpack within
+	//the errors below, further out the float world positions themselves
+	//are rounded by more than the margin left for them
+	constexpr float DECORATION_MAX_CHUNK_DISTANCE = 256.0f;
+	//Largest error of a position after packDecoration and
+	//unpackDecoration, horizontally as a fraction of the chunk width and
+	//vertically in world space, half a step plus the rounding of the float
+	//world positions
+	constexpr float DECORATION_XZ_ERROR =
+		0.5f / DECORATION_POSITION_STEPS +
+		4.0f * FLT_EPSILON * (DECORATION_MAX_CHUNK_DISTANCE + 1.0f);
+	constexpr float DECORATION_HEIGHT_ERROR =
+		0.5f / DECORATION_HEIGHT_STEPS +
+		4.0f * FLT_EPSILON * HEIGHT * SCALE * DECORATION_MAX_HEIGHT;
+	static_assert(
+		CHUNK_SZ * 2.0f * SCALE * DECORATION_XZ_ERROR < 0.15f &&
+		DECORATION_HEIGHT_ERROR < 0.15f,
+		"Decorations must be placed to within 0.15 units of where they were generated"
+	);
+
+	//What a decoration instance is drawn with, attribute 3 is an integer
+	//with x in bits 0 to 10 and z in bits 11 to 21 (steps across the chunk,
+	//the shader adds the chunk origin) and the height in bits 22 to 31
+	struct DecorationInstance {
+		uint32_t packed;
+	};
+	static_assert(sizeof(DecorationInstance) == 4, "DecorationInstance must be 4 bytes");
+	constexpr unsigned int DECORATION_X_SHIFT = 0;
+	constexpr unsigned int DECORATION_Z_SHIFT = 11;
+	constexpr unsigned int DECORATION_HEIGHT_SHIFT = 22;
+	//Value of DecorationInstance::packed that fills the unused part of a
+	//slot, the vertex shaders move these out of view so that the slots of
+	//neighbouring chunks can be drawn as one range, packDecoration never
+	//returns it
+	constexpr uint32_t DECORATION_HIDDEN = 0xffffffff;
+	//'position' is in world space, 'origin' is the center of the chunk
+	//(x and z in world space) and 'width' is the width of the chunk in
+	//world space, 'position' must be inside the chunk
+	DecorationInstance packDecoration(
+		const glm::vec3 &position,
+		const glm::vec2 &origin,
+		float width
+	);
+	//Width in world space of a decoration chunk made with 'chunkscale'
+	float decorationChunkWidth(float chunkscale);
+	//Center of the chunk at 'pos' (x and z in world space) that its
+	//decorations are packed relative to
+	glm::vec2 decorationOrigin(ChunkPos pos, float width);
+	//Position in world space, within DECORATION_XZ_ERROR * width and
+	//DECORATION_HEIGHT_ERROR of the one that was packed
+	glm::vec3 unpackDecoration(
+		const DecorationInstance &instance,
+		const glm::vec2 &origin,
+		float width
+	);
+
+	//Most decorations of each type a chunk can have, the instance buffer
+	//of a type has a slot of this many instances for every chunk
+	constexpr unsigned int DECORATION_SLOT_SIZE[DECORATION_TYPE_COUNT] = {
+		35, //TREE
+		119, //PINE_TREE
+	};
+
+	//Instances of the decorations in a chunk, sorted by type, each type
+	//is copied into the chunk's slot in the instance buffer of that type
+	struct ChunkInstances {
+		std::vector<DecorationInstance> offsets[DECORATION_TYPE_COUNT];
+		//Center of the chunk the offsets are relative to, this is kept
+		//with the offsets since the table moves a chunk before its new
+		//decorations are ready
+		glm::vec2 origin = glm::vec2(0.0f);
+		//Bounding box of every decoration in the chunk
+		glm::vec3 min = glm::vec3(0.0f), max = glm::vec3(0.0f);
+	};
+
+	//Slots from 'first' on that are drawn with one instanced draw, every
+	//slot but the last is drawn whole (unused entries are
+	//DECORATION_HIDDEN), the slots between the chunks of the run are
+	//either empty or not visible
+	struct DecorationRun {
+		unsigned int first;
+		unsigned int instances;
+		//Bounding box of the visible chunks in the run
+		glm::vec3 min, max;
+	};
+
+	//A model that is used for a decoration type when the chunk
+	//is between mindist and maxdist away from the camera
+	struct DecorationLod {
+		DecorationType type;
+		//The model, its vertex buffers are shared by the run vaos
+		gfx::Vao model;
+		//Vao k reads its instances (attributes 3 and 4) from the first slot
+		//of run k, they are kept between frames and only pointed at a new
+		//slot when run k starts somewhere else
+		std::vector<unsigned int> runvaos;
+		std::vector<unsigned int> runvaoslots;
+		float mindist, maxdist;
+		//Number of instances that passed culling this frame
+		unsigned int count = 0;
+		//Runs of chunks that passed culling and are in range this frame
+		std::vector<DecorationRun> runs;
+	};
+
+	struct DecorationCullStats {
+		unsigned int drawn = 0;
+		unsigned int culled = 0;
+		unsigned int occluded = 0;
+		unsigned int instances = 0;
+		unsigned int draws = 0;
+	};
+
 	class DecorationTable {
 		unsigned int size;
 		int centerx = 0, centerz = 0;
 		float chunkscale;
 		//"Chunk decorations" - this is supposed to represent features such
-		//as trees (in this case we only have two types of trees)
-		std::vector<std::vector<Decoration>> decorations;
+		//as trees (in this case we only have two types of trees), only
+		//their packed instances are kept
+		std::vector<ChunkInstances> instances;
 		std::vector<ChunkPos> positions;
-		std::unordered_map<unsigned int, unsigned int> vaoCount;
+		std::vector<DecorationLod> lods;
+		//Reused every frame when culling
+		std::vector<float> distances;
+		DecorationCullStats cullstats;
+		//One buffer per decoration type with a fixed slot of
+		//DECORATION_SLOT_SIZE instances for every chunk, 0 until the
+		//first upload
+		unsigned int instancebuffers[DECORATION_TYPE_COUNT] = {};
+		//Origin of the chunk in each slot (vec2), shared by every type
+		unsigned int originbuffer = 0;
+		//Chunks that were generated since their slots were last written
+		std::vector<unsigned int> dirty;
+		std::vector<bool> isdirty;
 
-		void genDecorations(
-			const worldseed &permutations,
-			DecorationType type,
-			unsigned int n,
-			int x,
-			int z,
-			unsigned int index,
-			std::minstd_rand0 &lcg
-		);	
+		//Decorations of a chunk that were generated on a worker, they
+		//replace the ones in the table only once the whole chunk is done
+		//so the old chunk is drawn until then
+		struct GeneratedChunk {
+			unsigned int index;
+			//Matches generations[index] unless the chunk was given a new
+			//position while it was being generated
+			unsigned int generation;
+			ChunkInstances instances;
+		};
+		//Incremented every time a chunk is given a new position
+		std::vector<unsigned int> generations;
+		std::mutex generatedmutex;
+		std::vector<GeneratedChunk> generated;
+		jobs::TaskGroup generating;
+
+		//Slots wrap around the grid (x and z modulo size) so a chunk keeps
+		//the same neighbours in the slot order as it has on the grid
+		unsigned int slotOf(ChunkPos pos) const;
 		void generate(const worldseed &permutations, unsigned int index);
+		void markDirty(unsigned int index);
+		//Swaps the chunks that finished generating into the table
+		void publishGenerated();
 	public:
 		DecorationTable(unsigned int sz, float scale);
-		//Draw chunk decorations
-		void drawDecorations(const gfx::Vao &vao);
+		//The instance buffers and run vaos are owned by the table, it
+		//waits for the chunks that are still generating when destroyed
+		DecorationTable(const DecorationTable &) = delete;
+		DecorationTable& operator=(const DecorationTable &) = delete;
+		~DecorationTable();
+		//Adds an instanced draw for each run of chunks with decorations
+		//that use 'vao' that was visible when cull was last called
+		void drawDecorations(
+			gfx::RenderQueue &queue,
+			const gfx::Material &material,
+			const gfx::Vao &vao
+		);
 		//Generate decorations
 		void genDecorations(const worldseed &permutations);
-		//Returns true if new decorations needed to be generated
+		//Publishes the chunks that finished generating and, if the camera
+		//moved into a new chunk, starts generating the chunks that came
+		//into range on the job system ('permutations' must outlive the
+		//table), returns true if new decorations needed to be generated
 		bool genNewDecorations(
 			float camerax,
 			float cameraz,
 			const worldseed &permutations
 		);
-		void generateOffsets(
+		//Use 'vao' to draw decorations of 'type' in chunks with a center
+		//that is between mindist and maxdist away from the camera,
+		//'vao' must be a plant vao (see createPlantVao)
+		void setLod(
 			DecorationType type,
 			const gfx::Vao &vao,
-			unsigned int minrange,
-			unsigned int maxrange
+			float mindist,
+			float maxdist
 		);
+		//Tests every chunk against the view frustum and the horizon
+		//(if it is not null) and gathers the visible chunks for each lod
+		//into runs, this does not touch the graphics api so it can be
+		//called from another thread
+		void cull(
+			const geo::Frustum &viewfrustum,
+			const geo::HorizonBuffer *horizon,
+			const glm::vec3 &camerapos
+		);
+		//Rewrites the slots of the chunks that were generated since the
+		//last upload and points the run vaos at the runs, must be called
+		//on the main thread before drawing
+		void upload();
+		//Deletes the instance buffers and run vaos
+		void clearBuffers();
+		const DecorationCullStats& getCullStats() const;
+		//Width of a chunk in world space
+		float chunkWidth() const;
 		unsigned int count();
 	};
 
@@ -99,11 +318,56 @@ namespace infworld {
 		std::vector<unsigned int> vaoids;
 		std::vector<unsigned int> bufferids; 
 		std::vector<ChunkPos> chunkpos;
+		std::vector<ChunkBounds> chunkbounds;
+		//World space box of each chunk, kept up to date when a chunk is
+		//added or replaced so that culling does not rebuild them
+		std::vector<glm::vec3> chunkmin, chunkmax;
 		int centerx = 0, centerz = 0;
 
 		//For generating new chunks
 		std::vector<unsigned int> indices;
 		std::vector<ChunkPos> newChunks;
+
+		//Quadtree over the chunk grid that is only rebuilt when chunks are
+		//replaced, the center moves or the range skipped for the previous
+		//LOD changes, nodes are culled as a whole and if a node is
+		//completely inside the view frustum then none of its chunks are
+		//tested
+		struct QuadNode {
+			glm::vec3 min, max;
+			//-1 if this is not a leaf
+			int chunk;
+			int children[4];
+			//Number of chunks in this node
+			unsigned int chunks;
+		};
+		std::vector<QuadNode> quadtree;
+		int quadtreeroot = -1;
+		bool quadtreedirty = true;
+		//minrange that the quadtree was built with
+		int quadtreeminrange = -1;
+		//Chunks outside of minrange, counted when the quadtree is built
+		unsigned int cullcandidates = 0;
+		//Chunk index for each cell in the grid, -1 if empty
+		std::vector<int> grid;
+		//Chunks that are waiting to be replaced and are outside the grid
+		std::vector<unsigned int> outsidegrid;
+		ChunkCullStats cullstats;
+
+		glm::vec3 chunkCenter(unsigned int index);
+		geo::AABB chunkAABB(unsigned int index);
+		void updateBounds(unsigned int index);
+		//Places the chunks in the grid and builds the quadtree over them
+		void rebuildQuadtree(int minrange);
+		int buildQuadtree(int x, int z, int sz, int minrange);
+		void cullQuadNode(
+			int node,
+			bool inside,
+			const geo::Frustum &viewfrustum,
+			const geo::HorizonBuffer *horizon
+		);
+		//Chunks that passed culling, filled by cull() and used by draw()
+		std::vector<unsigned int> visible;
 	public:
 		ChunkTable(unsigned int range, float scale, float h);
 		ChunkTable();
@@ -127,18 +391,65 @@ namespace infworld {
 			float cameraz,
 			const worldseed &permutations
 		);
-		//returns the number of chunks drawn
-		unsigned int draw(ShaderProgram &shader, const geo::Frustum &viewfrustum);
-		unsigned int draw(
-			ShaderProgram &shader,
+		//Finds the chunks that are visible, if 'horizon' is not null then
+		//chunks hidden behind it are not visible, chunks that are less than
+		//'minrange' away from the center (they are drawn by the previous
+		//LOD) are skipped, returns the number of visible chunks
+		//This does not touch the graphics api and only writes to this
+		//table so tables can be culled on different threads
+		unsigned int cull(
 			unsigned int minrange,
-			const geo::Frustum &viewfrustum
+			const geo::Frustum &viewfrustum,
+			const geo::HorizonBuffer *horizon = nullptr
+		);
+		//Adds a draw packet for every chunk that was visible the last time
+		//cull() was called, returns the number of chunks drawn
+		unsigned int draw(gfx::RenderQueue &queue, const gfx::Material &material);
+		//Adds every chunk that is entirely inside of the square ring
+		//between 'minrange' and 'maxrange' around 'center' as an occluder,
+		//this should match the range that the terrain shader draws
+		//(maxrange <= 0 means there is no outer limit)
+		void addOccluders(
+			geo::HorizonBuffer &horizon,
+			const glm::vec2 &center,
+			float minrange,
+			float maxrange
 		);
 		float scale() const;
 		unsigned int range() const;	
+		//Culling stats from the last time this table was culled
+		const ChunkCullStats& getCullStats() const;
 	};
 
+	//Most decorations a chunk can have (every candidate of every type)
+	constexpr unsigned int MAX_CHUNK_DECORATIONS =
+		DECORATION_SLOT_SIZE[TREE] + DECORATION_SLOT_SIZE[PINE_TREE];
+	//Replaces 'out' with the decorations of the chunk at 'pos', each
+	//candidate is tested against the noise mask before its height is
+	//worked out and only the ones in the altitude band of their type are
+	//kept, 'chunkscale' is the same as in the DecorationTable
+	//The result only depends on the permutations and 'pos' so chunks can
+	//be placed in any order and on any thread
+	void placeDecorations(
+		const worldseed &permutations,
+		ChunkPos pos,
+		float chunkscale,
+		std::vector<Decoration> &out
+	);
+	//The old placement that computed the height of every candidate and
+	//then filtered them in three passes, the output is the same as
+	//placeDecorations (see --bench-decorations)
+	void placeDecorationsLegacy(
+		const worldseed &permutations,
+		ChunkPos pos,
+		float chunkscale,
+		std::vector<Decoration> &out
+	);
+
 	worldseed makePermutations(int seed, unsigned int count);
+	//Seed for rng::random() that belongs to a world, it only depends on
+	//the permutations so anything that has them can draw the same values
+	uint32_t getWorldSeed(const worldseed &permutations);
 	float getHeight(float x, float z, const worldseed &permutations);
 	float interpolate(float x, float lowerx, float upperx, float a, float b);
 	glm::vec3 getTerrainVertex(
@@ -147,12 +458,14 @@ namespace infworld {
 		const worldseed &permutations,
 		float maxheight
 	);
+	//If 'bounds' is not null, it is set to the min/max height of the chunk
 	mesh::ElementArrayBuffer<float> createChunkElementArray(
 		const worldseed &permutations,
 		int chunkx,
 		int chunkz,
 		float maxheight,
-		float chunkscale
+		float chunkscale,
+		ChunkBounds *bounds = nullptr
 	);
 	ChunkData buildChunk(
 		const infworld::worldseed &permutations,
@@ -0,0 +1,120 @@
+#include "jobs.h"
+#include <algorithm>
+
+namespace jobs {
+	JobSystem::JobSystem()
+	{
+		//The main thread also runs jobs while it waits
+		unsigned int threads = std::thread::hardware_concurrency();
+		unsigned int count = threads > 1 ? threads - 1 : 1;
+		for(unsigned int i = 0; i < count; i++)
+			workers.push_back(std::thread(&JobSystem::workerLoop, this));
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		available.notify_all();
+		for(auto &worker : workers)
+			worker.join();
+	}
+
+	JobSystem* JobSystem::get()
+	{
+		static JobSystem jobsystem;
+		return &jobsystem;
+	}
+
+	void JobSystem::workerLoop()
+	{
+		while(true) {
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				available.wait(lock, [this]() { return stopping || !queue.empty(); });
+				if(queue.empty())
+					return;
+				job = std::move(queue.front().job);
+				queue.pop_front();
+			}
+			job();
+		}
+	}
+
+	void JobSystem::submit(Job job, const TaskGroup *group)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			queue.push_back({ std::move(job), group });
+		}
+		available.notify_one();
+	}
+
+	bool JobSystem::runPending(const TaskGroup *group)
+	{
+		Job job;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto found = std::find_if(
+				queue.begin(),
+				queue.end(),
+				[group](const QueuedJob &queued) { return queued.group == group; }
+			);
+			if(found == queue.end())
+				return false;
+			job = std::move(found->job);
+			queue.erase(found);
+		}
+		job();
+		return true;
+	}
+
+	unsigned int JobSystem::workerCount() const
+	{
+		return workers.size();
+	}
+
+	TaskGroup::TaskGroup()
+	{
+		pending = 0;
+	}
+
+	void TaskGroup::run(Job job)
+	{
+		pending++;
+		JOBS->submit([this, job]() {
+			job();
+			pending--;
+		}, this);
+	}
+
+	void TaskGroup::wait()
+	{
+		while(pending > 0) {
+			if(!JOBS->runPending(this))
+				std::this_thread::yield();
+		}
+	}
+
+	void parallelFor(
+		unsigned int count,
+		unsigned int grain,
+		const std::function<void(unsigned int, unsigned int)> &fn
+	) {
+		grain = std::max(grain, 1u);
+		if(count <= grain) {
+			fn(0, count);
+			return;
+		}
+
+		TaskGroup group;
+		for(unsigned int begin = 0; begin < count; begin += grain) {
+			unsigned int end = std::min(begin + grain, count);
+			group.run([&fn, begin, end]() { fn(begin, end); });
+		}
+		group.wait();
+	}
+}
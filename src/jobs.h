@@ -0,0 +1,78 @@
+/*
+ * Small job system, a fixed pool of worker threads pulls jobs from a single
+ * queue, jobs are grouped into task groups so that the thread that
+ * submitted them can wait for them to finish (and helps run the queued
+ * jobs of that group while it waits instead of sleeping, jobs of other
+ * groups are left to the workers so that waiting on the main thread never
+ * picks up unrelated background work)
+ *
+ * Jobs must not touch the graphics api since the GL context only belongs
+ * to the main thread
+ * */
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jobs {
+	typedef std::function<void()> Job;
+
+	class TaskGroup;
+
+	class JobSystem {
+		struct QueuedJob {
+			Job job;
+			//nullptr for jobs that were submitted without a group
+			const TaskGroup *group;
+		};
+		std::vector<std::thread> workers;
+		std::deque<QueuedJob> queue;
+		std::mutex mutex;
+		std::condition_variable available;
+		bool stopping = false;
+
+		JobSystem();
+		void workerLoop();
+	public:
+		~JobSystem();
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+		static JobSystem* get();
+		void submit(Job job, const TaskGroup *group = nullptr);
+		//Runs the oldest queued job of 'group' (nullptr for jobs without a
+		//group) on the calling thread, returns false if there was none
+		bool runPending(const TaskGroup *group = nullptr);
+		unsigned int workerCount() const;
+	};
+
+	class TaskGroup {
+		std::atomic<unsigned int> pending;
+	public:
+		TaskGroup();
+		//The group must not be destroyed before wait() returns
+		void run(Job job);
+		//Blocks until every job in the group has finished, only runs jobs
+		//of this group on the calling thread
+		void wait();
+	};
+
+	//Calls fn(begin, end) for ranges of at most 'grain' items that cover
+	//[0, count), the ranges run in parallel and this returns once all of
+	//them are done
+	void parallelFor(
+		unsigned int count,
+		unsigned int grain,
+		const std::function<void(unsigned int, unsigned int)> &fn
+	);
+}
+
+#define JOBS jobs::JobSystem::get()
+
+#endif
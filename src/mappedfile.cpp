@@ -0,0 +1,118 @@
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const char *path)
+{
+	close();
+
+	HANDLE handle = CreateFileA(
+		path,
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		nullptr
+	);
+	if(handle == INVALID_HANDLE_VALUE)
+		return false;
+	file = handle;
+
+	LARGE_INTEGER filesize;
+	if(!GetFileSizeEx(handle, &filesize) || filesize.QuadPart == 0) {
+		close();
+		return false;
+	}
+
+	mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(!mapping) {
+		close();
+		return false;
+	}
+
+	ptr = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if(!ptr) {
+		close();
+		return false;
+	}
+	length = size_t(filesize.QuadPart);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if(ptr)
+		UnmapViewOfFile(ptr);
+	if(mapping)
+		CloseHandle(mapping);
+	if(file)
+		CloseHandle(file);
+	ptr = nullptr;
+	mapping = nullptr;
+	file = nullptr;
+	length = 0;
+}
+#else
+bool MappedFile::open(const char *path)
+{
+	close();
+
+	int fd = ::open(path, O_RDONLY);
+	if(fd < 0)
+		return false;
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size <= 0) {
+		::close(fd);
+		return false;
+	}
+
+	void *mapped = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	//The mapping stays valid after the descriptor is closed
+	::close(fd);
+	if(mapped == MAP_FAILED)
+		return false;
+
+	ptr = (const unsigned char*)mapped;
+	length = size_t(st.st_size);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if(ptr)
+		munmap((void*)ptr, length);
+	ptr = nullptr;
+	length = 0;
+}
+#endif
+
+bool MappedFile::isOpen() const
+{
+	return ptr != nullptr;
+}
+
+const unsigned char* MappedFile::data() const
+{
+	return ptr;
+}
+
+size_t MappedFile::size() const
+{
+	return length;
+}
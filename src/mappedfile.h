@@ -0,0 +1,33 @@
+/*
+ * Read only memory mapping of a whole file, the pages are only read in from
+ * disk once they are touched so large baked assets can be handed to the
+ * graphics api without first being copied into a buffer of our own
+ * */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stddef.h>
+
+class MappedFile {
+	const unsigned char *ptr = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	void *file = nullptr;
+	void *mapping = nullptr;
+#endif
+public:
+	MappedFile() {}
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	//Returns false if the file can not be opened or is empty, any file
+	//that was open before is closed first
+	bool open(const char *path);
+	void close();
+	bool isOpen() const;
+	const unsigned char* data() const;
+	size_t size() const;
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "game.h"
+#include "assets.h"
 #include "gui.h"
 #include "window.h"
 #include <SDL.h>
@@ -14,6 +15,26 @@ void exitGame() {
     window.setIsRunning(false);
 }
 
+void loadingScreen(unsigned int loaded, unsigned int total) {
+  // Presenting waits for vsync so only redraw every so often to keep
+  // that from slowing down the loading itself
+  static double lastDraw = -1.0;
+  double now = getTime();
+  if (loaded < total && lastDraw >= 0.0 && now - lastDraw < 1.0 / 30.0)
+    return;
+  lastDraw = now;
+
+  Window &window = Window::getInstance();
+  Gui &gui = Gui::getInstance();
+
+  gui.newFrame();
+  GFX->clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  gui.drawLoadingScreen(loaded, total);
+  gui.render();
+  window.swapBuffers();
+  window.pollEvents();
+}
+
 game::MainMenuActions mainMenu() {
   Window &window = Window::getInstance();
   Gui &gui = Gui::getInstance();
@@ -25,9 +46,13 @@ game::MainMenuActions mainMenu() {
   window.getCamera().position = glm::vec3(0.0f);
 
   gobjs::Player player(glm::vec3(14.0f, -8.0f, -40.0f));
+  // Only re-interned when the plane selection changes
+  sym::Symbol planeModel = sym::intern(player.getPlayerObj());
 
   float dt = 0.0f;
   float totalTime = 0.0f;
+  gfx::RenderQueue queue;
+  gfx::GLQueueBackend backend;
   while (!window.shouldClose()) {
     float start = getTime();
 
@@ -37,12 +62,15 @@ game::MainMenuActions mainMenu() {
     window.updatePerspectiveMat(FOVY, ZNEAR, ZFAR, window.getWidth(),
                                 window.getHeight());
 
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    GFX->clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    queue.begin(window.getCamera().position, window.getZfar());
 
-    gfx::displayPlayerPlane(totalTime, player.transform, player.getPlayerObj());
+    gfx::displayPlayerPlane(queue, totalTime, player.transform, planeModel);
 
     // Display skybox
-    gfx::displaySkybox();
+    gfx::displaySkybox(queue);
+    queue.submit(backend);
+    assets::updateResidency();
 
     game::MainMenuActions selected = gui.drawMainMenu();
 
@@ -51,9 +79,9 @@ game::MainMenuActions mainMenu() {
     gui.render();
 
     window.updateKeyStates();
-    glEnable(GL_CULL_FACE);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
+    GFX->enable(GL_CULL_FACE);
+    GFX->enable(GL_DEPTH_TEST);
+    GFX->enable(GL_BLEND);
     window.swapBuffers();
     window.pollEvents();
     gfx::outputErrors();
@@ -69,12 +97,14 @@ game::MainMenuActions mainMenu() {
       int c = player.getCurrentIndex();
       c = (c - 1) % 2;
       player.setPlayerObj(c);
+      planeModel = sym::intern(player.getPlayerObj());
       break;
     }
     case CHANGE_PLANE_PLUS: {
       int c = player.getCurrentIndex();
       c = (c + 1) % 2;
       player.setPlayerObj(c);
+      planeModel = sym::intern(player.getPlayerObj());
       break;
     }
     case EXIT_GAME: {
@@ -107,7 +137,7 @@ game::MainMenuActions mainMenu() {
 // 		//Update perspective matrix
 // 		state->updatePerspectiveMat(FOVY, ZNEAR, ZFAR);
 
-// 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+// 		GFX->clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 // 		//Display skybox
 // 		gfx::displaySkybox();
@@ -116,8 +146,8 @@ game::MainMenuActions mainMenu() {
 
 // 		state->updateKeyStates();
 // 		nk_glfw3_render(state->getNkGlfw(), NK_ANTI_ALIASING_ON, 512 *
-// 1024, 128 * 1024); 		glEnable(GL_CULL_FACE); 		glEnable(GL_DEPTH_TEST);
-// 		glEnable(GL_BLEND);
+// 1024, 128 * 1024); 		GFX->enable(GL_CULL_FACE); 		GFX->enable(GL_DEPTH_TEST);
+// 		GFX->enable(GL_BLEND);
 // 		glfwSwapBuffers(state->getWindow());
 // 		glfwPollEvents();
 // 		gfx::outputErrors();
@@ -143,7 +173,7 @@ game::MainMenuActions mainMenu() {
 // 		//Update perspective matrix
 // 		state->updatePerspectiveMat(FOVY, ZNEAR, ZFAR);
 
-// 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+// 		GFX->clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 // 		//Display skybox
 // 		gfx::displaySkybox();
@@ -152,8 +182,8 @@ game::MainMenuActions mainMenu() {
 
 // 		state->updateKeyStates();
 // 		nk_glfw3_render(state->getNkGlfw(), NK_ANTI_ALIASING_ON, 512 *
-// 1024, 128 * 1024); 		glEnable(GL_CULL_FACE); 		glEnable(GL_DEPTH_TEST);
-// 		glEnable(GL_BLEND);
+// 1024, 128 * 1024); 		GFX->enable(GL_CULL_FACE); 		GFX->enable(GL_DEPTH_TEST);
+// 		GFX->enable(GL_BLEND);
 // 		glfwSwapBuffers(state->getWindow());
 // 		glfwPollEvents();
 // 		gfx::outputErrors();
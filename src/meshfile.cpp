@@ -0,0 +1,232 @@
+#include "meshfile.h"
+#include "importfile.h"
+#include "logger.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <vector>
+
+namespace {
+	constexpr char MAGIC[4] = { 'M', 'E', 'S', 'H' };
+
+	bool modificationTime(const std::string &path, time_t &mtime)
+	{
+		struct stat st;
+		if(stat(path.c_str(), &st) != 0)
+			return false;
+		mtime = st.st_mtime;
+		return true;
+	}
+
+	template<typename T>
+	std::vector<T> convertIndices(const std::vector<unsigned int> &indices)
+	{
+		std::vector<T> converted(indices.size());
+		for(size_t i = 0; i < indices.size(); i++)
+			converted[i] = T(indices[i]);
+		return converted;
+	}
+}
+
+namespace meshfile {
+	std::string bakedPath(const std::string &objpath)
+	{
+		size_t dot = objpath.find_last_of('.');
+		size_t slash = objpath.find_last_of("/\\");
+		if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+			return objpath + ".mesh";
+		return objpath.substr(0, dot) + ".mesh";
+	}
+
+	bool isUpToDate(const std::string &bakedpath, const std::string &sourcepath)
+	{
+		if(assetpack::contains(bakedpath))
+			return true;
+		time_t baked, source;
+		if(!modificationTime(bakedpath, baked))
+			return false;
+		//Only the baked file was shipped
+		if(!modificationTime(sourcepath, source))
+			return true;
+		return baked >= source;
+	}
+
+	bool write(const char *path, const mesh::Model &model)
+	{
+		size_t count = model.vertices.size();
+		if(model.normals.size() != count || model.texturecoords.size() != count) {
+			ERROR("Can not bake %s: attribute counts do not match", path);
+			return false;
+		}
+
+		Header header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.vertexcount = count;
+		header.indexcount = model.indices.size();
+		header.indexsize = count <= 0x10000 ? 2 : 4;
+
+		std::vector<Vertex> vertices(count);
+		glm::vec3 boundsmin(0.0f), boundsmax(0.0f);
+		for(size_t i = 0; i < count; i++) {
+			const glm::vec3 &pos = model.vertices[i];
+			const glm::vec2 &tc = model.texturecoords[i];
+			const glm::vec3 &norm = model.normals[i];
+			vertices[i] = {
+				{ pos.x, pos.y, pos.z },
+				{ tc.x, tc.y },
+				{ norm.x, norm.y, norm.z },
+			};
+			boundsmin = i == 0 ? pos : glm::min(boundsmin, pos);
+			boundsmax = i == 0 ? pos : glm::max(boundsmax, pos);
+		}
+		for(int i = 0; i < 3; i++) {
+			header.boundsmin[i] = boundsmin[i];
+			header.boundsmax[i] = boundsmax[i];
+		}
+
+		//Written to a temporary file first so that the game never maps a
+		//half written mesh
+		std::string temppath = std::string(path) + ".tmp";
+		FILE *file = fopen(temppath.c_str(), "wb");
+		if(!file) {
+			ERROR("Failed to write %s", temppath.c_str());
+			return false;
+		}
+		bool ok =
+			fwrite(&header, sizeof(header), 1, file) == 1 &&
+			fwrite(vertices.data(), sizeof(Vertex), count, file) == count;
+		if(ok && header.indexsize == 2) {
+			std::vector<uint16_t> indices = convertIndices<uint16_t>(model.indices);
+			ok = fwrite(indices.data(), 2, indices.size(), file) == indices.size();
+		}
+		else if(ok) {
+			const std::vector<unsigned int> &indices = model.indices;
+			ok = fwrite(indices.data(), 4, indices.size(), file) == indices.size();
+		}
+		ok = fclose(file) == 0 && ok;
+		remove(path);
+		if(!ok || rename(temppath.c_str(), path) != 0) {
+			ERROR("Failed to write %s", path);
+			remove(temppath.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	bool MeshData::open(const char *path)
+	{
+		header = nullptr;
+		if(!assetpack::readFile(path, file))
+			return false;
+
+		const Header *h = (const Header*)file.data();
+		bool valid =
+			file.size() >= sizeof(Header) &&
+			memcmp(h->magic, MAGIC, sizeof(MAGIC)) == 0 &&
+			h->version == VERSION &&
+			(h->indexsize == 2 || h->indexsize == 4);
+		if(valid) {
+			uint64_t expected =
+				sizeof(Header) +
+				uint64_t(h->vertexcount) * sizeof(Vertex) +
+				uint64_t(h->indexcount) * h->indexsize;
+			valid = file.size() == expected;
+		}
+
+		if(!valid) {
+			WARN("%s is not a valid mesh file", path);
+			file = assetpack::FileData();
+			return false;
+		}
+		header = h;
+		return true;
+	}
+
+	const Header& MeshData::getHeader() const
+	{
+		return *header;
+	}
+
+	const Vertex* MeshData::vertices() const
+	{
+		return (const Vertex*)(file.data() + sizeof(Header));
+	}
+
+	const void* MeshData::indices() const
+	{
+		return file.data() + sizeof(Header) + header->vertexcount * sizeof(Vertex);
+	}
+
+	GLenum MeshData::indexType() const
+	{
+		return header->indexsize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	}
+
+	gfx::Vao createVao(const MeshData &mesh)
+	{
+		const Header &header = mesh.getHeader();
+
+		gfx::Vao vao;
+		vao.genBuffers(2);
+		vao.bind();
+
+		GFX->bindBuffer(GL_ARRAY_BUFFER, vao.buffers.at(0));
+		GFX->bufferData(
+			GL_ARRAY_BUFFER,
+			header.vertexcount * sizeof(Vertex),
+			mesh.vertices(),
+			GL_STATIC_DRAW
+		);
+		GFX->vertexAttribPointer(
+			0, 3, GL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, position)
+		);
+		GFX->enableVertexAttribArray(0);
+		GFX->vertexAttribPointer(
+			1, 2, GL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, texcoord)
+		);
+		GFX->enableVertexAttribArray(1);
+		GFX->vertexAttribPointer(
+			2, 3, GL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, normal)
+		);
+		GFX->enableVertexAttribArray(2);
+
+		GFX->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, vao.buffers.at(1));
+		GFX->bufferData(
+			GL_ELEMENT_ARRAY_BUFFER,
+			header.indexcount * header.indexsize,
+			mesh.indices(),
+			GL_STATIC_DRAW
+		);
+
+		vao.vertcount = header.indexcount;
+		vao.indextype = mesh.indexType();
+		return vao;
+	}
+
+	unsigned int bakeModels(const char *path)
+	{
+		std::vector<impfile::Entry> entries = impfile::parseFile(path);
+		unsigned int failed = 0;
+		for(const auto &entry : entries) {
+			std::string objpath = entry.getVar("path");
+			std::string meshpath = bakedPath(objpath);
+			mesh::Model model = mesh::loadObjModel(objpath.c_str());
+			if(model.indices.empty() || !write(meshpath.c_str(), model)) {
+				ERROR("Failed to bake %s", objpath.c_str());
+				failed++;
+				continue;
+			}
+			INFO(
+				"Baked %s -> %s (%zu vertices, %zu indices)",
+				objpath.c_str(),
+				meshpath.c_str(),
+				model.vertices.size(),
+				model.indices.size()
+			);
+		}
+		return failed;
+	}
+}
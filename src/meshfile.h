@@ -0,0 +1,82 @@
+/*
+ * Baked mesh format, .obj models are converted ahead of time (see the
+ * --bake option) into a file that is laid out exactly the way the vertex
+ * and index buffers want it so loading one is just mapping the file and
+ * passing the two ranges to the graphics api
+ *
+ * Layout (little endian):
+ * Header
+ * vertexcount * Vertex (position, texture coordinate, normal interleaved)
+ * indexcount * indexsize bytes (16 bit if every index fits, 32 bit otherwise)
+ * */
+
+#ifndef MESH_FILE_H
+#define MESH_FILE_H
+
+#include "gfx.h"
+#include "assetpack.h"
+#include <stdint.h>
+#include <string>
+
+namespace meshfile {
+	//Bump this if the layout changes, old files are then ignored
+	constexpr uint32_t VERSION = 1;
+
+	struct Vertex {
+		float position[3];
+		float texcoord[2];
+		float normal[3];
+	};
+	static_assert(sizeof(Vertex) == 32, "Vertex must be tightly packed");
+
+	struct Header {
+		char magic[4];
+		uint32_t version;
+		uint32_t vertexcount;
+		uint32_t indexcount;
+		//2 or 4
+		uint32_t indexsize;
+		uint32_t reserved;
+		//Axis aligned bounding box of the positions
+		float boundsmin[3];
+		float boundsmax[3];
+	};
+	//Keeps the vertex data that follows 4 byte aligned
+	static_assert(sizeof(Header) == 48, "Header must be tightly packed");
+
+	//foo.obj -> foo.mesh
+	std::string bakedPath(const std::string &objpath);
+	//Returns true if 'bakedpath' exists and is not older than 'sourcepath',
+	//a baked file in the mounted asset pack is always up to date
+	bool isUpToDate(const std::string &bakedpath, const std::string &sourcepath);
+	//Returns false if the file could not be written
+	bool write(const char *path, const mesh::Model &model);
+
+	//A baked mesh mapped into memory (on its own or as part of the asset
+	//pack), the vertex and index pointers point into the mapping so they
+	//are only valid while this is open
+	class MeshData {
+		assetpack::FileData file;
+		const Header *header = nullptr;
+	public:
+		//Returns false if the file can not be read or is not a valid mesh
+		//file of the current version
+		bool open(const char *path);
+		const Header& getHeader() const;
+		const Vertex* vertices() const;
+		const void* indices() const;
+		//GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+		GLenum indexType() const;
+	};
+
+	//Uploads a baked mesh, must be called on the main thread
+	//Index 0 is the interleaved vertex buffer (attributes 0, 1 and 2 are
+	//the position, texture coordinate and normal like createModelVao)
+	//Index 1 is the index buffer
+	gfx::Vao createVao(const MeshData &mesh);
+	//Bakes every model listed in the models impfile at 'path', returns the
+	//number of models that could not be baked
+	unsigned int bakeModels(const char *path);
+}
+
+#endif
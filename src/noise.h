@@ -1,11 +1,72 @@
 #ifndef NOISE_H
 #define NOISE_H
 #include <array>
+#include <stdint.h>
 
 namespace rng {
 	//Array that represents a random permutation of 0 -> 255
 	typedef std::array<int, 256> permutation256;
 	void createPermutation(permutation256 &p, int seed);
+
+	//Every kind of value that is drawn with random() has its own stream so
+	//that values drawn for different things never line up, new streams
+	//go at the end so that existing seeds keep giving the same world
+	enum Stream : uint32_t {
+		STREAM_DECORATION_COUNT,
+		STREAM_DECORATION_X,
+		STREAM_DECORATION_Z,
+		//No longer drawn (the shaders hash the packed position instead),
+		//kept so that the streams after it keep their values
+		STREAM_DECORATION_VARIATION,
+		STREAM_BALLOON_CHANCE,
+		STREAM_BALLOON_DISTANCE,
+		STREAM_BALLOON_ANGLE,
+		STREAM_SHIP_CHANCE,
+		STREAM_SHIP_DISTANCE,
+		STREAM_SHIP_ANGLE,
+		STREAM_BARREL_CHANCE,
+		STREAM_BARREL_DISTANCE,
+		STREAM_BARREL_ANGLE,
+	};
+
+	//PCG hash from "Hash Functions for GPU Rendering" (Jarzynski and Olano)
+	constexpr uint32_t pcgHash(uint32_t v)
+	{
+		uint32_t state = v * 747796405u + 2891336453u;
+		uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+		return (word >> 22u) ^ word;
+	}
+
+	//Counter based random numbers, each value is a hash of its key
+	//(seed, chunk, index, stream) so any value can be drawn on its own in
+	//any order or on any thread and it is always the same
+	constexpr uint32_t random(
+		uint32_t seed,
+		int32_t chunkx,
+		int32_t chunkz,
+		uint32_t index,
+		Stream stream
+	) {
+		uint32_t h = pcgHash(seed + pcgHash(uint32_t(stream)));
+		h = pcgHash(h + uint32_t(chunkx));
+		h = pcgHash(h + uint32_t(chunkz));
+		return pcgHash(h + index);
+	}
+	//For values that do not belong to a chunk
+	constexpr uint32_t random(uint32_t seed, uint32_t index, Stream stream)
+	{
+		return random(seed, 0, 0, index, stream);
+	}
+	//Maps a value from random() to [0, 1)
+	constexpr float toFloat(uint32_t r)
+	{
+		return float(r >> 8) / 16777216.0f;
+	}
+	//Maps a value from random() to [0, n)
+	constexpr uint32_t toRange(uint32_t r, uint32_t n)
+	{
+		return uint32_t((uint64_t(r) * n) >> 32);
+	}
 }
 
 namespace perlin {
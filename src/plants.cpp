@@ -2,117 +2,299 @@
 #include <math.h>
 #include "plants.h"
 #include "gfx.h"
+#include "infworld.h"
 #include <glm/gtc/matrix_transform.hpp>
-#include <stack>
-
-struct BranchProperties {
-	glm::mat4 transform = glm::mat4(1.0f); //rotation and scale
-	glm::vec3 position = glm::vec3(0.0f);
-	unsigned int depth = 0; //How far up the branch is
-};
-
-BranchProperties getTop(const std::stack<BranchProperties> &stack)
-{
-	BranchProperties properties;
-	if(!stack.empty())
-		properties = stack.top();
-	return properties;
-}
+#include <algorithm>
+#include <stddef.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+namespace {
+	struct BranchProperties {
+		glm::mat4 transform = glm::mat4(1.0f); //rotation and scale
+		glm::vec3 position = glm::vec3(0.0f);
+		unsigned int depth = 0; //How far up the branch is
+	};
+
+	//Texture coordinates of the bark (left half of the texture)
+	glm::mat4 barkTc()
+	{
+		glm::mat4 transformtc(1.0f);
+		transformtc = glm::translate(transformtc, glm::vec3(0.01f, 0.0f, 0.0f));
+		return glm::scale(transformtc, glm::vec3(0.48f, 2.0f, 1.0f));
+	}
 
-mesh::Model createBranchSegment(
-	const BranchProperties &branch,
-	float thickness,
-	float decreaseAmt,
-	float length,
-	unsigned int detail
-) {	
-	float radius1 = std::max(thickness - decreaseAmt * float(branch.depth), 0.01f);
-	float radius2 = std::max(thickness - decreaseAmt * float(branch.depth + 1), 0.01f);
-	mesh::Model segment = mesh::createFrustumModel(detail, radius1, radius2);
-	
-	glm::mat4 transformtc(1.0f);
-	transformtc = glm::translate(transformtc, glm::vec3(0.01f, 0.0f, 0.0f));
-	transformtc = glm::scale(transformtc, glm::vec3(0.48f, 2.0f, 1.0f));
-	mesh::transformModelTc(segment, transformtc);
-	
-	//Transform the model
-	glm::mat4 translate = glm::translate(glm::mat4(1.0f), branch.position);
-	//By default the frustum has height 1.0 so we scale it up
-	glm::mat4 scaleHeight = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, length, 1.0f));
-	glm::mat4 transform = translate * branch.transform * scaleHeight;
-	mesh::transformModel(segment, transform);
-
-	return segment;
-}
+	//The pieces a plant is built out of, each one is built once and then
+	//transformed straight into the output mesh every time it is used
+	class PlantParts {
+		float thickness, decreaseAmt;
+		unsigned int detail;
+		//Indexed by depth since the branches get thinner as they go up
+		std::vector<mesh::Model> segments;
+	public:
+		mesh::Model end;
+		mesh::Model leaves;
+		int leafcount;
+
+		PlantParts(float thick, float decrease, unsigned int d)
+		{
+			thickness = thick;
+			decreaseAmt = decrease;
+			detail = d;
+			end = mesh::createConeModel1(detail);
+			mesh::transformModelTc(end, barkTc());
+
+			glm::mat4 transformtc = glm::translate(glm::mat4(1.0f), glm::vec3(0.51f, 0.0f, 0.0f));
+			transformtc = glm::scale(transformtc, glm::vec3(0.48f, 1.0f, 1.0f));
+			leafcount = std::max<int>((2 * detail) / 3 - 1, 1);
+			leaves = mesh::createPlaneModel(std::max<int>(detail / 2 - 2, 0));
+			mesh::transformModelTc(leaves, transformtc);
+		}
 
-mesh::Model createBranchEnd(
-	const BranchProperties &branch,
-	float thickness,
-	float decreaseAmt,
-	float length,
-	unsigned int detail
-) {
-	mesh::Model endsegment = mesh::createConeModel1(detail);
-	
-	glm::mat4 transformtc(1.0f);
-	transformtc = glm::translate(transformtc, glm::vec3(0.01f, 0.0f, 0.0f));
-	transformtc = glm::scale(transformtc, glm::vec3(0.48f, 2.0f, 1.0f));
-	mesh::transformModelTc(endsegment, transformtc);
-
-	float radius = std::max(thickness - decreaseAmt * float(branch.depth), 0.01f);
-	mesh::transformModel(
-		endsegment, 
-		glm::scale(
-			glm::mat4(1.0f),
-			glm::vec3(radius, length, radius)
-		)
-	);
-	
-	//Transform the model
-	glm::mat4 translate = glm::translate(glm::mat4(1.0f), branch.position);
-	glm::mat4 transform = translate * branch.transform;
-	mesh::transformModel(endsegment, transform);
-
-	//Leaves
-	float scale = 1.0f;
-	if(branch.depth <= 2)
-		scale = 0.5f;
-
-	transformtc = glm::translate(glm::mat4(1.0f), glm::vec3(0.51f, 0.0f, 0.0f));
-	transformtc = glm::scale(transformtc, glm::vec3(0.48f, 1.0f, 1.0f));
-	int leafcount = std::max<int>((2 * detail) / 3 - 1, 1);
-	int leafdetail = std::max<int>(detail / 2 - 2, 0);
-	for(int i = 0; i < leafcount; i++) {
-		mesh::Model leaves = mesh::createPlaneModel(leafdetail);
-		mesh::transformModelTc(leaves, transformtc);
-
-		glm::vec3 offset = 
-			(1.0f - scale) * 
-			glm::vec3(branch.transform * glm::vec4(0.0f, length, 0.0f, 1.0f));
-
-		glm::mat4 translate = 
-			glm::translate(
-				glm::mat4(1.0f),
-				branch.position + offset
-			);
-		glm::mat4 rotation = 
-			glm::rotate(
-				glm::mat4(1.0f),
-				glm::radians(120.0f) * i, glm::vec3(0.0f, 1.0f, 0.0f)
-			);
-		glm::mat4 scaleMat = glm::scale(glm::mat4(1.0f), glm::vec3(scale));
-		glm::mat4 transform =
-			translate *
-			branch.transform *
-			rotation *
-			scaleMat *
-			glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-
-		mesh::transformModel(leaves, transform);
-		endsegment = mesh::mergeModels(endsegment, leaves);
+		float radius(unsigned int depth) const
+		{
+			return std::max(thickness - decreaseAmt * float(depth), 0.01f);
+		}
+
+		const mesh::Model& segment(unsigned int depth)
+		{
+			while(segments.size() <= depth) {
+				unsigned int d = segments.size();
+				segments.push_back(mesh::createFrustumModel(detail, radius(d), radius(d + 1)));
+				mesh::transformModelTc(segments.back(), barkTc());
+			}
+			return segments.at(depth);
+		}
+	};
+
+	//Interprets the symbols of an L-system one at a time, the first pass
+	//(with no output) only counts the vertices and indices so that the
+	//second pass can write into arrays that are already the right size
+	class Turtle {
+		PlantParts &parts;
+		float length;
+		glm::mat4 rotations[5];
+		mesh::Model *out;
+		std::vector<BranchProperties> stack;
+		BranchProperties branch;
+		//A branch ends at an 'F' followed by ']' or the end so every
+		//symbol is held back until the one after it is known
+		char pending = '\0';
+
+		void add(const mesh::Model &part, const glm::mat4 &transform)
+		{
+			if(out) {
+				const glm::mat4 normalMat = glm::transpose(glm::inverse(transform));
+				for(size_t i = 0; i < part.vertices.size(); i++) {
+					const glm::vec3 &vert = part.vertices[i];
+					const glm::vec3 &norm = part.normals[i];
+					out->vertices[vertexcount + i] =
+						transform * glm::vec4(vert.x, vert.y, vert.z, 1.0f);
+					out->normals[vertexcount + i] = glm::normalize(
+						glm::vec3(normalMat * glm::vec4(norm.x, norm.y, norm.z, 1.0f))
+					);
+					out->texturecoords[vertexcount + i] = part.texturecoords[i];
+				}
+				for(size_t i = 0; i < part.indices.size(); i++)
+					out->indices[indexcount + i] = vertexcount + part.indices[i];
+			}
+			vertexcount += part.vertices.size();
+			indexcount += part.indices.size();
+		}
+
+		void addSegment()
+		{
+			glm::mat4 translate = glm::translate(glm::mat4(1.0f), branch.position);
+			//By default the frustum has height 1.0 so we scale it up
+			glm::mat4 scaleHeight = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, length, 1.0f));
+			add(parts.segment(branch.depth), translate * branch.transform * scaleHeight);
+		}
+
+		void addEnd()
+		{
+			float radius = parts.radius(branch.depth);
+			glm::mat4 translate = glm::translate(glm::mat4(1.0f), branch.position);
+			glm::mat4 scale = glm::scale(glm::mat4(1.0f), glm::vec3(radius, length, radius));
+			add(parts.end, translate * branch.transform * scale);
+
+			//Leaves
+			float leafscale = branch.depth <= 2 ? 0.5f : 1.0f;
+			glm::vec3 offset =
+				(1.0f - leafscale) *
+				glm::vec3(branch.transform * glm::vec4(0.0f, length, 0.0f, 1.0f));
+			glm::mat4 leaftranslate = glm::translate(glm::mat4(1.0f), branch.position + offset);
+			glm::mat4 scaleMat = glm::scale(glm::mat4(1.0f), glm::vec3(leafscale));
+			for(int i = 0; i < parts.leafcount; i++) {
+				glm::mat4 rotation = 
+					glm::rotate(
+						glm::mat4(1.0f),
+						glm::radians(120.0f) * i, glm::vec3(0.0f, 1.0f, 0.0f)
+					);
+				glm::mat4 transform =
+					leaftranslate *
+					branch.transform *
+					rotation *
+					scaleMat *
+					glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+				add(parts.leaves, transform);
+			}
+		}
+
+		void step(char ch, char next)
+		{
+			switch(ch) {
+			case '<':
+				branch.transform *= rotations[0];
+				break;
+			case '>':
+				branch.transform *= rotations[1];
+				break;
+			case '&':
+				branch.transform *= rotations[2];
+				break;
+			case '+':
+				branch.transform *= rotations[3];
+				break;
+			case '-':
+				branch.transform *= rotations[4];
+				break;
+			case 'F':
+				if(next == '\0' || next == ']')
+					addEnd();
+				else
+					addSegment();
+				branch.position += glm::vec3(branch.transform * glm::vec4(0.0f, length, 0.0f, 1.0f));
+				branch.depth++;
+				break;
+			case '[':
+				stack.push_back(branch);
+				break;
+			case ']':
+				branch = BranchProperties();
+				if(!stack.empty()) {
+					branch = stack.back();
+					stack.pop_back();
+				}
+				break;
+			default:
+				break;
+			}
+		}
+	public:
+		size_t vertexcount = 0, indexcount = 0;
+
+		Turtle(PlantParts &p, float angle, float len, mesh::Model *output) : parts(p)
+		{
+			length = len;
+			out = output;
+			rotations[0] = glm::rotate(glm::mat4(1.0f), angle, glm::vec3(1.0f, 0.0f, 0.0f));
+			rotations[1] = glm::rotate(glm::mat4(1.0f), -angle, glm::vec3(1.0f, 0.0f, 0.0f));
+			rotations[2] = glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f));
+			rotations[3] = glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 0.0f, 1.0f));
+			rotations[4] = glm::rotate(glm::mat4(1.0f), -angle, glm::vec3(0.0f, 0.0f, 1.0f));
+		}
+
+		void operator()(char ch)
+		{
+			if(pending != '\0')
+				step(pending, ch);
+			pending = ch;
+		}
+
+		void finish()
+		{
+			if(pending != '\0')
+				step(pending, '\0');
+			pending = '\0';
+		}
+	};
+
+	//Passes every symbol of 'str' after 'iterations' rewrites to 'emit'
+	//without building the rewritten string
+	template<typename Emit>
+	void expand(
+		const std::string &str,
+		const std::string &rule,
+		unsigned int iterations,
+		Emit &emit
+	) {
+		for(char ch : str) {
+			if(ch == 'F' && iterations > 0)
+				expand(rule, rule, iterations - 1, emit);
+			else
+				emit(ch);
+		}
+	}
+
+	mesh::Model buildPlant(
+		const std::string &axiom,
+		const std::string &rule,
+		unsigned int iterations,
+		float angle,
+		float length,
+		float thickness,
+		float decreaseAmt,
+		unsigned int detail
+	) {
+		PlantParts parts(thickness, decreaseAmt, detail);
+
+		Turtle counter(parts, angle, length, nullptr);
+		expand(axiom, rule, iterations, counter);
+		counter.finish();
+
+		mesh::Model plant;
+		plant.vertices.resize(counter.vertexcount);
+		plant.normals.resize(counter.vertexcount);
+		plant.texturecoords.resize(counter.vertexcount);
+		plant.indices.resize(counter.indexcount);
+		Turtle builder(parts, angle, length, &plant);
+		expand(axiom, rule, iterations, builder);
+		builder.finish();
+		return plant;
 	}
 
-	return endsegment;
+	struct PlantKey {
+		std::string axiom, rule;
+		unsigned int iterations, detail;
+		float angle, length, thickness, decreaseAmt;
+
+		bool operator<(const PlantKey &other) const
+		{
+			return
+				std::tie(axiom, rule, iterations, detail, angle, length, thickness, decreaseAmt) <
+				std::tie(
+					other.axiom,
+					other.rule,
+					other.iterations,
+					other.detail,
+					other.angle,
+					other.length,
+					other.thickness,
+					other.decreaseAmt
+				);
+		}
+	};
+
+	std::mutex cachemutex;
+	std::map<PlantKey, std::shared_ptr<const mesh::Model>> plantcache;
+
+	//Attribute 3 reads one infworld::DecorationInstance per instance from
+	//'buffer' starting at 'offset' bytes
+	void setInstanceAttributes(unsigned int buffer, size_t offset)
+	{
+		GFX->bindBuffer(GL_ARRAY_BUFFER, buffer);
+		GFX->vertexAttribIPointer(
+			3,
+			1,
+			GL_UNSIGNED_INT,
+			sizeof(infworld::DecorationInstance),
+			(void*)(offset + offsetof(infworld::DecorationInstance, packed))
+		);
+		GFX->enableVertexAttribArray(3);
+		GFX->vertexAttribDivisor(3, 1);
+	}
 }
 
 namespace plants {
@@ -122,16 +304,19 @@ namespace plants {
 		const std::string &rule
 	) {
 		std::string result = axiom;
-
-		for(int i = 0; i < iterations; i++) {
-			std::string currentIteration = result;
-			result.clear();
-			for(int j = 0; j < currentIteration.size(); j++) {
-				if(currentIteration.at(j) == 'F')
-					result.append(rule);
+		std::string next;
+
+		for(unsigned int i = 0; i < iterations; i++) {
+			size_t fcount = std::count(result.begin(), result.end(), 'F');
+			next.clear();
+			next.reserve(result.size() - fcount + fcount * rule.size());
+			for(char ch : result) {
+				if(ch == 'F')
+					next.append(rule);
 				else
-					result += currentIteration.at(j);
+					next += ch;
 			}
+			result.swap(next);
 		}
 
 		return result;
@@ -145,61 +330,41 @@ namespace plants {
 		float decreaseAmt,
 		unsigned int detail
 	) {
-		const std::unordered_map<char, glm::mat4> rotations = {
-			{ '<', glm::rotate(glm::mat4(1.0f), angle, glm::vec3(1.0f, 0.0f, 0.0f)) },
-			{ '>', glm::rotate(glm::mat4(1.0f), -angle, glm::vec3(1.0f, 0.0f, 0.0f)) },
-			{ '&', glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f)) },
-			{ '+', glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 0.0f, 1.0f)) },
-			{ '-', glm::rotate(glm::mat4(1.0f), -angle, glm::vec3(0.0f, 0.0f, 1.0f)) },
-		};
-
-		mesh::Model plant;
-	
-		//Create leaves and branches
-		std::stack<BranchProperties> branchStack;
-
-		BranchProperties branch;
-		for(int i = 0; i < str.size(); i++) {
-			char ch = str.at(i);
-			mesh::Model treepart;
-
-			if(rotations.count(ch)) {
-				branch.transform *= rotations.at(ch);
-				continue;
-			}
+		return buildPlant(str, "", 0, angle, length, thickness, decreaseAmt, detail);
+	}
 
-			switch(ch) {
-			case 'F':
-				if(i == str.size() - 1 || str.at(i + 1) == ']')
-					treepart = createBranchEnd(branch, thickness, decreaseAmt, length, detail);
-				else
-					treepart = createBranchSegment(branch, thickness, decreaseAmt, length, detail);
-				branch.position += glm::vec3(branch.transform * glm::vec4(0.0f, length, 0.0f, 1.0f));
-				branch.depth++;
-				plant = mesh::mergeModels(plant, treepart);
-				break;
-			case '[':
-				branchStack.push(branch);
-				break;
-			case ']':
-				branch = getTop(branchStack);				
-				branchStack.pop();
-				break;
-			default:
-				break;
-			}
+	mesh::Model createLSystemPlant(
+		const std::string &axiom,
+		const std::string &rule,
+		unsigned int iterations,
+		float angle,
+		float length,
+		float thickness,
+		float decreaseAmt,
+		unsigned int detail
+	) {
+		PlantKey key = {
+			axiom, rule, iterations, detail, angle, length, thickness, decreaseAmt
+		};
+		{
+			std::lock_guard<std::mutex> lock(cachemutex);
+			auto cached = plantcache.find(key);
+			if(cached != plantcache.end())
+				return *cached->second;
 		}
 
-		return plant;
+		//Built without holding the lock so that different plants can be
+		//built at the same time
+		auto plant = std::make_shared<const mesh::Model>(
+			buildPlant(axiom, rule, iterations, angle, length, thickness, decreaseAmt, detail)
+		);
+		std::lock_guard<std::mutex> lock(cachemutex);
+		plantcache.insert({ key, plant });
+		return *plant;
 	}
 
-	gfx::Vao createPineTreeModel(unsigned int detail)
+	mesh::Model createPineTreeMesh(unsigned int detail)
 	{
-		gfx::Vao pinetree;
-		//Index 4 is the instance offset array
-		pinetree.genBuffers(5);
-		pinetree.bind();
-
 		glm::mat4 transform;
 		glm::mat4 transformtc;
 
@@ -220,7 +385,7 @@ namespace plants {
 			transformtc = glm::translate(transformtc, glm::vec3(0.01f, 0.0f, 0.0f));
 			transformtc = glm::scale(transformtc, glm::vec3(0.48f, 8.0f / 5.0f, 1.0f));
 			mesh::transformModelTc(bottom, transformtc);
-			treemodel = mesh::mergeModels(treemodel, bottom);
+			mesh::appendModel(treemodel, bottom);
 		}
 
 		//Generate rest of the pine tree
@@ -240,27 +405,15 @@ namespace plants {
 			mesh::transformModel(part, transform);	
 			mesh::transformModelTc(part, transformtc);
 			
-			treemodel = mesh::mergeModels(treemodel, part);
+			mesh::appendModel(treemodel, part);
 			top.y -= scale * 0.6f;
 		}	
 
-		pinetree.vertcount = treemodel.indices.size();	
-		treemodel.dataToBuffers(pinetree.buffers);
-		glBindBuffer(GL_ARRAY_BUFFER, pinetree.buffers.at(4));
-		glVertexAttribPointer(3, 3, GL_FLOAT, false, 3 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(3);
-		glVertexAttribDivisor(3, 1);
-
-		return pinetree;
+		return treemodel;
 	}
 
-	gfx::Vao createTreeModel(unsigned int detail)
+	mesh::Model createTreeMesh(unsigned int detail)
 	{
-		gfx::Vao tree;
-		//Index 4 is the instance offset array
-		tree.genBuffers(5);
-		tree.bind();
-
 		const float ANGLE = glm::radians(30.0f);
 		const float LENGTH = 0.8f;
 		const float THICKNESS = 0.15f;
@@ -268,9 +421,10 @@ namespace plants {
 		const unsigned int ITERATIONS = 2;
 		const std::string RULE = "F[&&>F]F[--F][&&&&-F][&&&&&&&&-F]";
 
-		std::string str = lsystem(ITERATIONS, "F", RULE);
-		mesh::Model treemodel = createPlantFromStr(
-			str,
+		mesh::Model treemodel = createLSystemPlant(
+			"F",
+			RULE,
+			ITERATIONS,
 			ANGLE,
 			LENGTH,
 			THICKNESS,
@@ -288,16 +442,82 @@ namespace plants {
 			transformtc = glm::translate(transformtc, glm::vec3(0.01f, 0.0f, 0.0f));
 			transformtc = glm::scale(transformtc, glm::vec3(0.48f, 8.0f / 5.0f, 1.0f));
 			mesh::transformModelTc(bottom, transformtc);
-			treemodel = mesh::mergeModels(treemodel, bottom);
+			mesh::appendModel(treemodel, bottom);
+		}
+
+		return treemodel;
+	}
+
+	gfx::Vao createPlantVao(const mesh::Model &model)
+	{
+		gfx::Vao plant;
+		//Index 4 is the instance array (see infworld::DecorationInstance)
+		plant.genBuffers(5);
+		plant.bind();
+
+		plant.vertcount = model.indices.size();
+		model.dataToBuffers(plant.buffers);
+		setInstanceAttributes(plant.buffers.at(4), 0);
+
+		return plant;
+	}
+
+	gfx::Vao createPlantSlotVao(const gfx::Vao &plant)
+	{
+		gfx::Vao slot;
+		GFX->genVertexArrays(1, &slot.vaoid);
+		slot.vertcount = plant.vertcount;
+		slot.indextype = plant.indextype;
+		GFX->bindVertexArray(slot.vaoid);
+
+		//Same layout as Model::dataToBuffers
+		const GLint sizes[] = { 3, 2, 3 };
+		for(GLuint i = 0; i < 3; i++) {
+			GFX->bindBuffer(GL_ARRAY_BUFFER, plant.buffers.at(i));
+			GFX->vertexAttribPointer(i, sizes[i], GL_FLOAT, false, sizes[i] * sizeof(float), (void*)0);
+			GFX->enableVertexAttribArray(i);
 		}
+		GFX->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, plant.buffers.at(3));
+
+		GFX->bindVertexArray(0);
+		return slot;
+	}
+
+	void pointPlantSlotVao(
+		unsigned int vaoid,
+		unsigned int instancebuffer,
+		unsigned int originbuffer,
+		unsigned int slot,
+		unsigned int slotsize
+	) {
+		GFX->bindVertexArray(vaoid);
+		setInstanceAttributes(
+			instancebuffer,
+			sizeof(infworld::DecorationInstance) * slotsize * slot
+		);
+		//There is no base instance in GL 3.3/GLES 3.0 so the origin is
+		//stepped once per slot with the divisor instead
+		GFX->bindBuffer(GL_ARRAY_BUFFER, originbuffer);
+		GFX->vertexAttribPointer(
+			4,
+			2,
+			GL_FLOAT,
+			false,
+			sizeof(glm::vec2),
+			(void*)(sizeof(glm::vec2) * slot)
+		);
+		GFX->enableVertexAttribArray(4);
+		GFX->vertexAttribDivisor(4, slotsize);
+		GFX->bindVertexArray(0);
+	}
 
-		tree.vertcount = treemodel.indices.size();
-		treemodel.dataToBuffers(tree.buffers);
-		glBindBuffer(GL_ARRAY_BUFFER, tree.buffers.at(4));
-		glVertexAttribPointer(3, 3, GL_FLOAT, false, 3 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(3);
-		glVertexAttribDivisor(3, 1);
+	gfx::Vao createPineTreeModel(unsigned int detail)
+	{
+		return createPlantVao(createPineTreeMesh(detail));
+	}
 
-		return tree;
+	gfx::Vao createTreeModel(unsigned int detail)
+	{
+		return createPlantVao(createTreeMesh(detail));
 	}
 }
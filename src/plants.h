@@ -51,6 +51,43 @@ namespace plants {
 		float decreaseAmt,
 		unsigned int detail
 	);
+	//Same as createPlantFromStr(lsystem(iterations, axiom, rule), ...) but
+	//the rewritten string is never built, the symbols are expanded one at
+	//a time and every part is written straight into a mesh that is sized
+	//before it is filled in
+	//The meshes are cached (by the grammar, iterations, detail and the
+	//other arguments) so asking for the same plant again only copies it,
+	//can be called from any thread
+	mesh::Model createLSystemPlant(
+		const std::string &axiom,
+		const std::string &rule,
+		unsigned int iterations,
+		float angle,
+		float length,
+		float thickness,
+		float decreaseAmt,
+		unsigned int detail
+	);
+	//Only build the mesh so that they can be called from any thread
+	mesh::Model createPineTreeMesh(unsigned int detail);
+	mesh::Model createTreeMesh(unsigned int detail);
+	//Creates the vao for a plant mesh, index 4 is the instance array
+	//(attribute 3, one infworld::DecorationInstance per instance)
+	gfx::Vao createPlantVao(const mesh::Model &model);
+	//Vao that draws 'plant' with its instances read from the buffers
+	//given to pointPlantSlotVao, it shares the buffers of 'plant' and
+	//only owns the vao itself
+	gfx::Vao createPlantSlotVao(const gfx::Vao &plant);
+	//Points a vao from createPlantSlotVao at slot 'slot' of
+	//'instancebuffer' (attribute 3, 'slotsize' instances per slot) and of
+	//'originbuffer' (attribute 4, one vec2 per slot)
+	void pointPlantSlotVao(
+		unsigned int vaoid,
+		unsigned int instancebuffer,
+		unsigned int originbuffer,
+		unsigned int slot,
+		unsigned int slotsize
+	);
 	gfx::Vao createPineTreeModel(unsigned int detail);	
 	gfx::Vao createTreeModel(unsigned int detail);
 }
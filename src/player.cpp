@@ -1,5 +1,6 @@
 #include "game.h"
 #include "window.h"
+#include "simulation.h"
 #include <SDL.h>
 // #include "audio.hpp"
 
@@ -25,11 +26,15 @@ Player::Player(glm::vec3 position) {
   speed = SPEED;
   health = DEFAULT_HEALTH;
   fuel = DEFAULT_FUEL;
-  model_name.push_back("plane_douglas");
-  model_name.push_back("plane");
+  model_name = planeModels();
   current_model = 0;
 }
 
+const std::vector<std::string> &Player::planeModels() {
+  static const std::vector<std::string> models = {"plane_douglas", "plane"};
+  return models;
+}
+
 void Player::setPlayerObj(int current) { current_model = current; }
 
 void Player::damage(unsigned int amount) {
@@ -77,7 +82,9 @@ void Player::rotateWithMouse(float dt) {
   }
 }
 
-void Player::update(float dt) {
+void Player::update(float dt) { update(dt, game::InputState::capture()); }
+
+void Player::update(float dt, const game::InputState &input) {
   // Keep track of how long the player has crashed,
   // this is so that the game can delay showing the death screen until
   // the explosion animation is done playing
@@ -97,24 +104,22 @@ void Player::update(float dt) {
   if (fuel < 0.0f)
     fuel = 0.0f;
 
-  Window &window = Window::getInstance();
-
   // Turn left/right
-  if (window.getKeyState(SDLK_d) == JUST_PRESSED)
+  if (input.getKeyState(SDLK_d) == JUST_PRESSED)
     yRotationDirection = Player::RY_RIGHT;
-  else if (window.getKeyState(SDLK_a) == JUST_PRESSED)
+  else if (input.getKeyState(SDLK_a) == JUST_PRESSED)
     yRotationDirection = Player::RY_LEFT;
-  else if (window.getKeyState(SDLK_a) == RELEASED &&
-           window.getKeyState(SDLK_d) == RELEASED)
+  else if (input.getKeyState(SDLK_a) == RELEASED &&
+           input.getKeyState(SDLK_d) == RELEASED)
     yRotationDirection = Player::RY_NONE;
 
   // Change pitch
-  if (window.getKeyState(SDLK_s) == JUST_PRESSED)
+  if (input.getKeyState(SDLK_s) == JUST_PRESSED)
     xRotationDirection = Player::RX_UP;
-  else if (window.getKeyState(SDLK_w) == JUST_PRESSED)
+  else if (input.getKeyState(SDLK_w) == JUST_PRESSED)
     xRotationDirection = Player::RX_DOWN;
-  else if (window.getKeyState(SDLK_s) == RELEASED &&
-           window.getKeyState(SDLK_w) == RELEASED)
+  else if (input.getKeyState(SDLK_s) == RELEASED &&
+           input.getKeyState(SDLK_w) == RELEASED)
     xRotationDirection = Player::RX_NONE;
 
   // Rotate with mouse
@@ -151,13 +156,13 @@ void Player::update(float dt) {
 
   transform.position += transform.direction() * speed / 2.0f * dt;
   // Acceleration
-  if (window.keyIsHeld(window.getKeyState(SDLK_LSHIFT)))
+  if (input.keyIsHeld(SDLK_LSHIFT))
     speed += ACCELERATION * dt;
-  else if (window.getScrollSpeed() > 0.0)
+  else if (input.scrollspeed > 0.0)
     speed += ACCELERATION * 4.0f * dt;
-  else if (window.keyIsHeld(window.getKeyState(SDLK_LCTRL)))
+  else if (input.keyIsHeld(SDLK_LCTRL))
     speed -= ACCELERATION * dt;
-  else if (window.getScrollSpeed() < 0.0)
+  else if (input.scrollspeed < 0.0)
     speed -= ACCELERATION * 4.0f * dt;
   speed = std::min(speed, SPEED * 3.0f);
   speed = std::max(speed, SPEED);
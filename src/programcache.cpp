@@ -0,0 +1,158 @@
+#include "programcache.h"
+#include "gfxbackend.h"
+#include "logger.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace {
+	constexpr char MAGIC[4] = { 'P', 'B', 'I', 'N' };
+	//Bump this if the header changes
+	constexpr uint32_t VERSION = 1;
+
+	struct CacheHeader {
+		char magic[4];
+		uint32_t version;
+		uint64_t sourcehash;
+		uint64_t driverhash;
+		uint32_t format;
+		uint32_t length;
+	};
+
+	std::string glString(GLenum name)
+	{
+		const GLubyte *str = GFX->getString(name);
+		if(!str)
+			return "";
+		return std::string((const char*)str);
+	}
+}
+
+namespace shadercache {
+	uint64_t hash(const void *data, size_t len, uint64_t h)
+	{
+		return sym::hash((const char*)data, len, h);
+	}
+
+	uint64_t hash(const std::string &str, uint64_t h)
+	{
+		return hash(str.data(), str.size(), h);
+	}
+
+	ProgramCache::ProgramCache(const std::string &pathprefix)
+	{
+		prefix = pathprefix;
+		if(prefix.empty())
+			return;
+
+		GLint formats = 0;
+		GFX->getIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		//Older drivers that do not know the enum leave an error behind
+		while(GFX->getError() != GL_NO_ERROR);
+		supported = formats > 0;
+		if(!supported) {
+			INFO("Program binaries are not supported, shaders will not be cached");
+			return;
+		}
+
+		driverhash = hash(glString(GL_VENDOR));
+		driverhash = hash(glString(GL_RENDERER), driverhash);
+		driverhash = hash(glString(GL_VERSION), driverhash);
+		driverhash = hash(glString(GL_SHADING_LANGUAGE_VERSION), driverhash);
+	}
+
+	bool ProgramCache::enabled() const
+	{
+		return supported;
+	}
+
+	std::string ProgramCache::path(const std::string &name) const
+	{
+		return prefix + name + ".progbin";
+	}
+
+	bool ProgramCache::load(const std::string &name, uint64_t sourcehash, unsigned int program)
+	{
+		if(!supported)
+			return false;
+
+		std::string filepath = path(name);
+		FILE *file = fopen(filepath.c_str(), "rb");
+		if(!file)
+			return false;
+
+		CacheHeader header;
+		std::vector<unsigned char> binary;
+		bool valid =
+			fread(&header, sizeof(header), 1, file) == 1 &&
+			memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 &&
+			header.version == VERSION &&
+			header.sourcehash == sourcehash &&
+			header.driverhash == driverhash &&
+			header.length > 0;
+		if(valid) {
+			binary.resize(header.length);
+			valid = fread(binary.data(), 1, binary.size(), file) == binary.size();
+		}
+		fclose(file);
+
+		if(valid) {
+			GFX->programBinary(program, header.format, binary.data(), binary.size());
+			GLint linkStatus = 0;
+			GFX->getProgramiv(program, GL_LINK_STATUS, &linkStatus);
+			valid = linkStatus == GL_TRUE;
+		}
+
+		//Out of date or rejected by the driver, it gets written again
+		//once the program has been compiled from source
+		if(!valid) {
+			INFO("Discarding cached program %s", name.c_str());
+			remove(filepath.c_str());
+		}
+		return valid;
+	}
+
+	void ProgramCache::store(const std::string &name, uint64_t sourcehash, unsigned int program)
+	{
+		if(!supported)
+			return;
+
+		GLint length = 0;
+		GFX->getProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if(length <= 0)
+			return;
+
+		std::vector<unsigned char> binary(length);
+		GLsizei written = 0;
+		GLenum format = 0;
+		GFX->getProgramBinary(program, length, &written, &format, binary.data());
+		if(written <= 0)
+			return;
+
+		CacheHeader header;
+		memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.sourcehash = sourcehash;
+		header.driverhash = driverhash;
+		header.format = format;
+		header.length = written;
+
+		//Written to a temporary file first so that a crash while writing
+		//can not leave a broken binary behind
+		std::string filepath = path(name), temppath = filepath + ".tmp";
+		FILE *file = fopen(temppath.c_str(), "wb");
+		if(!file) {
+			WARN("Failed to write %s", temppath.c_str());
+			return;
+		}
+		bool ok =
+			fwrite(&header, sizeof(header), 1, file) == 1 &&
+			fwrite(binary.data(), 1, written, file) == size_t(written);
+		ok = fclose(file) == 0 && ok;
+		remove(filepath.c_str());
+		if(!ok || rename(temppath.c_str(), filepath.c_str()) != 0) {
+			WARN("Failed to write %s", filepath.c_str());
+			remove(temppath.c_str());
+		}
+	}
+}
@@ -0,0 +1,43 @@
+/*
+ * On disk cache of linked shader programs, a program is stored as the
+ * binary the driver hands back with glGetProgramBinary together with a
+ * hash of its sources and a hash of the driver (vendor, renderer and
+ * version strings), if either changes or the driver refuses the binary the
+ * file is removed and the program is compiled from source again
+ *
+ * Drivers that do not support any binary formats (and the null graphics
+ * backend) simply disable the cache
+ * */
+
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include "symbol.h"
+#include <stdint.h>
+#include <string>
+
+namespace shadercache {
+	//64 bit FNV-1a, 'h' can be the result of a previous call
+	//to continue hashing
+	uint64_t hash(const void *data, size_t len, uint64_t h = sym::FNV_OFFSET);
+	uint64_t hash(const std::string &str, uint64_t h = sym::FNV_OFFSET);
+
+	class ProgramCache {
+		//Prepended to the name of each program to get its file
+		std::string prefix;
+		uint64_t driverhash = 0;
+		bool supported = false;
+		std::string path(const std::string &name) const;
+	public:
+		//An empty 'prefix' disables the cache
+		ProgramCache(const std::string &prefix);
+		bool enabled() const;
+		//Tries to link 'program' from the cached binary of 'name', returns
+		//false if there is no usable binary (a stale one is removed)
+		bool load(const std::string &name, uint64_t sourcehash, unsigned int program);
+		//Writes the binary of the linked 'program' to the cache
+		void store(const std::string &name, uint64_t sourcehash, unsigned int program);
+	};
+}
+
+#endif
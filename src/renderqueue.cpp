@@ -0,0 +1,432 @@
+#include "renderqueue.h"
+#include "gfxbackend.h"
+#include <string.h>
+#include <unordered_map>
+#include <glm/gtc/type_ptr.hpp>
+
+//Layout of the sort key (most significant bits first):
+//opaque/sky:  pass(2) state(6) shader(8) texture(10) vao(14) depth(24)
+//transparent: pass(2) inverse depth(24) state(6) shader(8) texture(10) vao(14)
+//hud:         pass(2) sequence(24) state(6) shader(8) texture(10) vao(14)
+constexpr uint64_t SHADER_BITS = 8;
+constexpr uint64_t TEXTURE_BITS = 10;
+constexpr uint64_t VAO_BITS = 14;
+constexpr uint64_t DEPTH_BITS = 24;
+constexpr uint64_t MATERIAL_BITS = gfx::STATE_BITS + SHADER_BITS + TEXTURE_BITS + VAO_BITS;
+
+namespace {
+	uint64_t mask(uint64_t value, uint64_t bits)
+	{
+		return value & ((uint64_t(1) << bits) - 1);
+	}
+}
+
+namespace gfx {
+	Uniform uniform(sym::Symbol name, int i)
+	{
+		Uniform u;
+		u.name = name;
+		u.type = UNIFORM_INT;
+		u.i = i;
+		return u;
+	}
+
+	Uniform uniform(sym::Symbol name, float f)
+	{
+		Uniform u;
+		u.name = name;
+		u.type = UNIFORM_FLOAT;
+		u.f[0] = f;
+		return u;
+	}
+
+	Uniform uniform(sym::Symbol name, const glm::vec2 &v)
+	{
+		Uniform u;
+		u.name = name;
+		u.type = UNIFORM_VEC2;
+		memcpy(u.f, glm::value_ptr(v), sizeof(float) * 2);
+		return u;
+	}
+
+	Uniform uniform(sym::Symbol name, const glm::vec3 &v)
+	{
+		Uniform u;
+		u.name = name;
+		u.type = UNIFORM_VEC3;
+		memcpy(u.f, glm::value_ptr(v), sizeof(float) * 3);
+		return u;
+	}
+
+	Uniform uniform(sym::Symbol name, const glm::vec4 &v)
+	{
+		Uniform u;
+		u.name = name;
+		u.type = UNIFORM_VEC4;
+		memcpy(u.f, glm::value_ptr(v), sizeof(float) * 4);
+		return u;
+	}
+
+	Uniform uniform(sym::Symbol name, const glm::mat3 &m)
+	{
+		Uniform u;
+		u.name = name;
+		u.type = UNIFORM_MAT3;
+		memcpy(u.f, glm::value_ptr(m), sizeof(float) * 9);
+		return u;
+	}
+
+	Uniform uniform(sym::Symbol name, const glm::mat4 &m)
+	{
+		Uniform u;
+		u.name = name;
+		u.type = UNIFORM_MAT4;
+		memcpy(u.f, glm::value_ptr(m), sizeof(float) * 16);
+		return u;
+	}
+
+	void GLQueueBackend::setState(uint8_t state, uint8_t changed)
+	{
+		if(changed & STATE_DEPTH_TEST) {
+			if(state & STATE_DEPTH_TEST)
+				GFX->enable(GL_DEPTH_TEST);
+			else
+				GFX->disable(GL_DEPTH_TEST);
+		}
+
+		if(changed & STATE_DEPTH_WRITE)
+			GFX->depthMask((state & STATE_DEPTH_WRITE) ? GL_TRUE : GL_FALSE);
+
+		if(changed & STATE_DEPTH_LEQUAL)
+			GFX->depthFunc((state & STATE_DEPTH_LEQUAL) ? GL_LEQUAL : GL_LESS);
+
+		if(changed & (STATE_CULL_BACK | STATE_CULL_FRONT)) {
+			if(state & (STATE_CULL_BACK | STATE_CULL_FRONT)) {
+				GFX->enable(GL_CULL_FACE);
+				GFX->cullFace((state & STATE_CULL_FRONT) ? GL_FRONT : GL_BACK);
+			}
+			else
+				GFX->disable(GL_CULL_FACE);
+		}
+
+		if(changed & STATE_BLEND) {
+			if(state & STATE_BLEND) {
+				GFX->enable(GL_BLEND);
+				GFX->blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			}
+			else
+				GFX->disable(GL_BLEND);
+		}
+	}
+
+	void GLQueueBackend::useProgram(ShaderProgram &shader)
+	{
+		shader.use();
+	}
+
+	void GLQueueBackend::bindTexture(unsigned int target, unsigned int id)
+	{
+		GFX->activeTexture(GL_TEXTURE0);
+		GFX->bindTexture(target, id);
+	}
+
+	void GLQueueBackend::bindVao(unsigned int vao)
+	{
+		GFX->bindVertexArray(vao);
+	}
+
+	void GLQueueBackend::uniform(ShaderProgram &shader, const Uniform &u)
+	{
+		int location = shader.getUniformLocation(u.name);
+		switch(u.type) {
+		case UNIFORM_INT:
+			GFX->uniform1i(location, u.i);
+			break;
+		case UNIFORM_FLOAT:
+			GFX->uniform1f(location, u.f[0]);
+			break;
+		case UNIFORM_VEC2:
+			GFX->uniform2fv(location, 1, u.f);
+			break;
+		case UNIFORM_VEC3:
+			GFX->uniform3fv(location, 1, u.f);
+			break;
+		case UNIFORM_VEC4:
+			GFX->uniform4fv(location, 1, u.f);
+			break;
+		case UNIFORM_MAT3:
+			GFX->uniformMatrix3fv(location, 1, false, u.f);
+			break;
+		case UNIFORM_MAT4:
+			GFX->uniformMatrix4fv(location, 1, false, u.f);
+			break;
+		}
+	}
+
+	void GLQueueBackend::draw(unsigned int count, unsigned int instances, unsigned int indextype)
+	{
+		if(instances == 0)
+			GFX->drawElements(GL_TRIANGLES, count, indextype, 0);
+		else
+			GFX->drawElementsInstanced(GL_TRIANGLES, count, indextype, 0, instances);
+	}
+
+	void RecordingQueueBackend::setState(uint8_t state, uint8_t changed)
+	{
+		(void)changed;
+		calls.push_back({ SET_STATE, state });
+	}
+
+	void RecordingQueueBackend::useProgram(ShaderProgram &shader)
+	{
+		calls.push_back({ USE_PROGRAM, shader.getid() });
+	}
+
+	void RecordingQueueBackend::bindTexture(unsigned int target, unsigned int id)
+	{
+		(void)target;
+		calls.push_back({ BIND_TEXTURE, id });
+	}
+
+	void RecordingQueueBackend::bindVao(unsigned int vao)
+	{
+		calls.push_back({ BIND_VAO, vao });
+	}
+
+	void RecordingQueueBackend::uniform(ShaderProgram &shader, const Uniform &u)
+	{
+		(void)u;
+		calls.push_back({ UNIFORM, shader.getid() });
+	}
+
+	void RecordingQueueBackend::draw(unsigned int count, unsigned int instances, unsigned int indextype)
+	{
+		(void)instances;
+		(void)indextype;
+		calls.push_back({ DRAW, count });
+	}
+
+	void radixSort(std::vector<SortItem> &items, std::vector<SortItem> &tmp)
+	{
+		tmp.resize(items.size());
+		for(unsigned int shift = 0; shift < 64; shift += 8) {
+			size_t counts[256] = { 0 };
+			for(const auto &item : items)
+				counts[(item.key >> shift) & 0xff]++;
+
+			//Every key has the same byte here, nothing to do
+			if(counts[(items.empty() ? 0 : items[0].key >> shift) & 0xff] == items.size())
+				continue;
+
+			size_t offset = 0;
+			for(int i = 0; i < 256; i++) {
+				size_t c = counts[i];
+				counts[i] = offset;
+				offset += c;
+			}
+
+			for(const auto &item : items)
+				tmp[counts[(item.key >> shift) & 0xff]++] = item;
+			items.swap(tmp);
+		}
+	}
+
+	uint64_t makeSortKey(
+		RenderPass pass,
+		uint8_t state,
+		unsigned int shader,
+		unsigned int texture,
+		unsigned int vao,
+		float depth,
+		uint32_t sequence
+	) {
+		uint64_t material = mask(state, STATE_BITS);
+		material = (material << SHADER_BITS) | mask(shader, SHADER_BITS);
+		material = (material << TEXTURE_BITS) | mask(texture, TEXTURE_BITS);
+		material = (material << VAO_BITS) | mask(vao, VAO_BITS);
+
+		depth = glm::clamp(depth, 0.0f, 1.0f);
+		uint64_t maxd = (uint64_t(1) << DEPTH_BITS) - 1;
+		uint64_t d = uint64_t(depth * float(maxd));
+		uint64_t p = uint64_t(pass) << (MATERIAL_BITS + DEPTH_BITS);
+
+		switch(pass) {
+		case PASS_TRANSPARENT:
+			return p | ((maxd - d) << MATERIAL_BITS) | material;
+		case PASS_HUD:
+			return p | (mask(sequence, DEPTH_BITS) << MATERIAL_BITS) | material;
+		default:
+			return p | (material << DEPTH_BITS) | d;
+		}
+	}
+
+	void RenderQueue::begin(const glm::vec3 &camerapos, float farplane)
+	{
+		packets.clear();
+		items.clear();
+		uniformdata.clear();
+		eye = camerapos;
+		maxdepth = farplane;
+	}
+
+	UniformRange RenderQueue::addUniforms(std::initializer_list<Uniform> values)
+	{
+		UniformRange range;
+		range.first = uniformdata.size();
+		range.count = values.size();
+		uniformdata.insert(uniformdata.end(), values.begin(), values.end());
+		return range;
+	}
+
+	void RenderQueue::push(
+		const Material &material,
+		unsigned int vao,
+		unsigned int count,
+		unsigned int indextype,
+		const glm::vec3 &position,
+		UniformRange uniforms,
+		unsigned int instances
+	) {
+		DrawPacket packet;
+		packet.shader = material.shader;
+		packet.texturetarget = material.texturetarget;
+		packet.textureid = material.textureid;
+		packet.vao = vao;
+		packet.count = count;
+		packet.indextype = indextype;
+		packet.instances = instances;
+		packet.state = material.state;
+		packet.shared = material.shared;
+		packet.uniforms = uniforms;
+
+		float depth = glm::length(position - eye) / maxdepth;
+		uint64_t key = makeSortKey(
+			material.pass,
+			material.state,
+			material.shader->getid(),
+			material.textureid,
+			vao,
+			depth,
+			packets.size()
+		);
+		items.push_back({ key, uint32_t(packets.size()) });
+		packets.push_back(packet);
+	}
+
+	void RenderQueue::draw(
+		const Material &material,
+		unsigned int vao,
+		unsigned int count,
+		const glm::vec3 &position,
+		UniformRange uniforms,
+		unsigned int instances
+	) {
+		push(material, vao, count, GL_UNSIGNED_INT, position, uniforms, instances);
+	}
+
+	void RenderQueue::draw(
+		const Material &material,
+		unsigned int vao,
+		unsigned int count,
+		const glm::vec3 &position,
+		std::initializer_list<Uniform> uniforms,
+		unsigned int instances
+	) {
+		draw(material, vao, count, position, addUniforms(uniforms), instances);
+	}
+
+	void RenderQueue::draw(
+		const Material &material,
+		const Vao &vao,
+		const glm::vec3 &position,
+		UniformRange uniforms,
+		unsigned int instances
+	) {
+		push(material, vao.vaoid, vao.vertcount, vao.indextype, position, uniforms, instances);
+	}
+
+	void RenderQueue::draw(
+		const Material &material,
+		const Vao &vao,
+		const glm::vec3 &position,
+		std::initializer_list<Uniform> uniforms,
+		unsigned int instances
+	) {
+		draw(material, vao, position, addUniforms(uniforms), instances);
+	}
+
+	void RenderQueue::submit(QueueBackend &backend)
+	{
+		stats = QueueStats();
+		radixSort(items, sortscratch);
+
+		//program id -> first index of the shared range it last received
+		std::unordered_map<unsigned int, uint32_t> appliedShared;
+		ShaderProgram *shader = nullptr;
+		unsigned int texture = 0, texturetarget = 0, vao = 0;
+		uint8_t state = 0;
+		bool first = true;
+
+		for(const auto &item : items) {
+			const DrawPacket &packet = packets[item.index];
+
+			if(first || packet.state != state) {
+				uint8_t changed = first ? 0xff : (packet.state ^ state);
+				backend.setState(packet.state, changed);
+				state = packet.state;
+				stats.stateChanges++;
+			}
+
+			if(packet.shader != shader) {
+				backend.useProgram(*packet.shader);
+				shader = packet.shader;
+				stats.programChanges++;
+			}
+
+			if(packet.textureid != 0 &&
+			   (packet.textureid != texture || packet.texturetarget != texturetarget)) {
+				backend.bindTexture(packet.texturetarget, packet.textureid);
+				texture = packet.textureid;
+				texturetarget = packet.texturetarget;
+				stats.textureChanges++;
+			}
+
+			if(packet.vao != vao || first) {
+				backend.bindVao(packet.vao);
+				vao = packet.vao;
+				stats.vaoChanges++;
+			}
+
+			unsigned int id = shader->getid();
+			auto applied = appliedShared.find(id);
+			if(packet.shared.count > 0 &&
+			   (applied == appliedShared.end() || applied->second != packet.shared.first)) {
+				for(uint32_t i = 0; i < packet.shared.count; i++)
+					backend.uniform(*shader, uniformdata[packet.shared.first + i]);
+				appliedShared[id] = packet.shared.first;
+				stats.uniformUploads += packet.shared.count;
+			}
+
+			for(uint32_t i = 0; i < packet.uniforms.count; i++)
+				backend.uniform(*shader, uniformdata[packet.uniforms.first + i]);
+			stats.uniformUploads += packet.uniforms.count;
+
+			backend.draw(packet.count, packet.instances, packet.indextype);
+			stats.draws++;
+			first = false;
+		}
+
+		if(!first && state != STATE_DEFAULT)
+			backend.setState(STATE_DEFAULT, state ^ STATE_DEFAULT);
+	}
+
+	unsigned int RenderQueue::size() const
+	{
+		return packets.size();
+	}
+
+	const QueueStats& RenderQueue::getStats() const
+	{
+		return stats;
+	}
+}
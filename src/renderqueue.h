@@ -0,0 +1,254 @@
+/*
+ * Sorted render queue, the display functions emit small draw packets into
+ * the queue instead of drawing immediately, the packets are then sorted by
+ * a 64 bit key (pass, render state, shader, texture, vao, depth) and
+ * submitted in one go so that state only changes when it has to
+ * */
+
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <stdint.h>
+#include <vector>
+#include <initializer_list>
+#include <glm/glm.hpp>
+#include "gfx.h"
+#include "shader.h"
+
+namespace gfx {
+	//Passes are the most significant bits of the sort key so everything in
+	//one pass is drawn before anything in the next pass
+	enum RenderPass {
+		PASS_OPAQUE,
+		PASS_SKY,
+		//Sorted back to front
+		PASS_TRANSPARENT,
+		//Drawn in the order the packets were added
+		PASS_HUD,
+	};
+
+	//Fixed function state that a packet needs to be drawn with
+	enum RenderStateFlags {
+		STATE_DEPTH_TEST = 1 << 0,
+		STATE_DEPTH_WRITE = 1 << 1,
+		//depth function is GL_LEQUAL instead of GL_LESS
+		STATE_DEPTH_LEQUAL = 1 << 2,
+		STATE_CULL_BACK = 1 << 3,
+		STATE_CULL_FRONT = 1 << 4,
+		STATE_BLEND = 1 << 5,
+	};
+	constexpr uint8_t STATE_BITS = 6;
+	constexpr uint8_t STATE_DEFAULT =
+		STATE_DEPTH_TEST | STATE_DEPTH_WRITE | STATE_CULL_BACK;
+	//Used for HUD elements (blending, no depth test, no culling)
+	constexpr uint8_t STATE_OVERLAY = STATE_BLEND | STATE_CULL_BACK;
+
+	enum UniformType {
+		UNIFORM_INT,
+		UNIFORM_FLOAT,
+		UNIFORM_VEC2,
+		UNIFORM_VEC3,
+		UNIFORM_VEC4,
+		UNIFORM_MAT3,
+		UNIFORM_MAT4,
+	};
+
+	struct Uniform {
+		//Built with "name"_sym so that submitting does not hash the name
+		sym::Symbol name;
+		UniformType type;
+		union {
+			int i;
+			float f[16];
+		};
+	};
+
+	Uniform uniform(sym::Symbol name, int i);
+	Uniform uniform(sym::Symbol name, float f);
+	Uniform uniform(sym::Symbol name, const glm::vec2 &v);
+	Uniform uniform(sym::Symbol name, const glm::vec3 &v);
+	Uniform uniform(sym::Symbol name, const glm::vec4 &v);
+	Uniform uniform(sym::Symbol name, const glm::mat3 &m);
+	Uniform uniform(sym::Symbol name, const glm::mat4 &m);
+
+	//A range of uniforms stored in the queue
+	struct UniformRange {
+		uint32_t first = 0;
+		uint32_t count = 0;
+	};
+
+	//Everything needed to draw something apart from the mesh itself,
+	//'shared' is a range of uniforms that is the same for every packet using
+	//this material (such as the view/perspective matrices) and is only
+	//uploaded when the shader last saw a different range
+	//A uniform should either always be in 'shared' or always be per packet
+	//for a given shader, otherwise a packet may overwrite a shared value
+	struct Material {
+		RenderPass pass = PASS_OPAQUE;
+		ShaderProgram *shader = nullptr;
+		unsigned int texturetarget = 0;
+		unsigned int textureid = 0;
+		uint8_t state = STATE_DEFAULT;
+		UniformRange shared;
+	};
+
+	struct DrawPacket {
+		ShaderProgram *shader;
+		unsigned int texturetarget;
+		unsigned int textureid;
+		unsigned int vao;
+		//Number of indices
+		unsigned int count;
+		//GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+		unsigned int indextype;
+		//0 = not instanced
+		unsigned int instances;
+		uint8_t state;
+		UniformRange shared;
+		UniformRange uniforms;
+	};
+
+	//The queue only talks to the graphics api through this, the GL
+	//implementation is what the game uses but it can be swapped out for
+	//the recording backend below to look at what would be submitted
+	//without needing a GPU
+	class QueueBackend {
+	public:
+		virtual ~QueueBackend() {}
+		//'changed' has the bits that differ from the previous state
+		virtual void setState(uint8_t state, uint8_t changed) = 0;
+		virtual void useProgram(ShaderProgram &shader) = 0;
+		virtual void bindTexture(unsigned int target, unsigned int id) = 0;
+		virtual void bindVao(unsigned int vao) = 0;
+		virtual void uniform(ShaderProgram &shader, const Uniform &u) = 0;
+		virtual void draw(unsigned int count, unsigned int instances, unsigned int indextype) = 0;
+	};
+
+	class GLQueueBackend : public QueueBackend {
+	public:
+		void setState(uint8_t state, uint8_t changed) override;
+		void useProgram(ShaderProgram &shader) override;
+		void bindTexture(unsigned int target, unsigned int id) override;
+		void bindVao(unsigned int vao) override;
+		void uniform(ShaderProgram &shader, const Uniform &u) override;
+		void draw(unsigned int count, unsigned int instances, unsigned int indextype) override;
+	};
+
+	//Keeps a log of every call instead of calling the graphics api
+	class RecordingQueueBackend : public QueueBackend {
+	public:
+		enum CallType {
+			SET_STATE,
+			USE_PROGRAM,
+			BIND_TEXTURE,
+			BIND_VAO,
+			UNIFORM,
+			DRAW,
+		};
+		struct Call {
+			CallType type;
+			//state/program id/texture id/vao id/index count
+			unsigned int value;
+		};
+		std::vector<Call> calls;
+		void setState(uint8_t state, uint8_t changed) override;
+		void useProgram(ShaderProgram &shader) override;
+		void bindTexture(unsigned int target, unsigned int id) override;
+		void bindVao(unsigned int vao) override;
+		void uniform(ShaderProgram &shader, const Uniform &u) override;
+		void draw(unsigned int count, unsigned int instances, unsigned int indextype) override;
+	};
+
+	struct QueueStats {
+		unsigned int draws = 0;
+		unsigned int stateChanges = 0;
+		unsigned int programChanges = 0;
+		unsigned int textureChanges = 0;
+		unsigned int vaoChanges = 0;
+		unsigned int uniformUploads = 0;
+	};
+
+	struct SortItem {
+		uint64_t key;
+		uint32_t index;
+	};
+
+	//Stable LSD radix sort on the 64 bit keys, 'tmp' is scratch space
+	//(passes where every key has the same byte are skipped)
+	void radixSort(std::vector<SortItem> &items, std::vector<SortItem> &tmp);
+
+	//Builds the sort key for a packet, depth is normalized to [0, 1]
+	uint64_t makeSortKey(
+		RenderPass pass,
+		uint8_t state,
+		unsigned int shader,
+		unsigned int texture,
+		unsigned int vao,
+		float depth,
+		uint32_t sequence
+	);
+
+	class RenderQueue {
+		std::vector<DrawPacket> packets;
+		std::vector<SortItem> items;
+		std::vector<SortItem> sortscratch;
+		std::vector<Uniform> uniformdata;
+		glm::vec3 eye = glm::vec3(0.0f);
+		float maxdepth = 1.0f;
+		QueueStats stats;
+		void push(
+			const Material &material,
+			unsigned int vao,
+			unsigned int count,
+			unsigned int indextype,
+			const glm::vec3 &position,
+			UniformRange uniforms,
+			unsigned int instances
+		);
+	public:
+		//Clears the queue, depth of packets is measured from 'camerapos'
+		//and normalized with 'farplane'
+		void begin(const glm::vec3 &camerapos, float farplane);
+		UniformRange addUniforms(std::initializer_list<Uniform> values);
+		//Adds a draw, 'position' is used for depth sorting
+		//The vao is assumed to have 32 bit indices
+		void draw(
+			const Material &material,
+			unsigned int vao,
+			unsigned int count,
+			const glm::vec3 &position,
+			UniformRange uniforms,
+			unsigned int instances = 0
+		);
+		void draw(
+			const Material &material,
+			unsigned int vao,
+			unsigned int count,
+			const glm::vec3 &position,
+			std::initializer_list<Uniform> uniforms,
+			unsigned int instances = 0
+		);
+		//Draws all of 'vao' with whatever index type it has
+		void draw(
+			const Material &material,
+			const Vao &vao,
+			const glm::vec3 &position,
+			UniformRange uniforms,
+			unsigned int instances = 0
+		);
+		void draw(
+			const Material &material,
+			const Vao &vao,
+			const glm::vec3 &position,
+			std::initializer_list<Uniform> uniforms,
+			unsigned int instances = 0
+		);
+		//Sorts the packets and submits them to the backend, state is reset
+		//to STATE_DEFAULT afterwards
+		void submit(QueueBackend &backend);
+		unsigned int size() const;
+		const QueueStats& getStats() const;
+	};
+}
+
+#endif
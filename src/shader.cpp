@@ -1,4 +1,6 @@
 #include "shader.h"
+#include "programcache.h"
+#include "assetpack.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -6,12 +8,12 @@
 
 std::string readShaderFile(const char* path)
 {
-	std::ifstream shaderFile(path);
-
-	if(!shaderFile) {
+	assetpack::FileData data;
+	if(!assetpack::readFile(path, data)) {
 		std::cerr << "Failed to open " << path << '\n';
 		return "";
 	}
+	std::istringstream shaderFile(data.str());
 
 	std::string line;
 	std::stringstream shaderFileContents;
@@ -48,25 +50,24 @@ std::string readShaderFile(const char* path)
 			shaderFileContents << line << '\n';
 		}
 	}
-	shaderFile.close();
 	return shaderFileContents.str();
 }
 
 unsigned int createShader(const char* path, GLenum shaderType)
 {
-	unsigned int shader = glCreateShader(shaderType);
+	unsigned int shader = GFX->createShader(shaderType);
 
 	//Read shader file
 	std::string shaderCode = readShaderFile(path);
 	const char *shaderCodeBegin = shaderCode.c_str();
 	const int len = shaderCode.size();
-	glShaderSource(shader, 1, &shaderCodeBegin, &len);
+	GFX->shaderSource(shader, 1, &shaderCodeBegin, &len);
 
 	//Compile the shader
-	glCompileShader(shader);
+	GFX->compileShader(shader);
 
 	int compileStatus;
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
+	GFX->getShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
 	//Shader failed to compile
 	if(compileStatus != 1) {
 		std::cerr << path << " failed to compile!\n";
@@ -75,7 +76,7 @@ unsigned int createShader(const char* path, GLenum shaderType)
 		char message[1024]; //For now, we will just assume all error
 							//messages < 1024 character long
 		int len;
-		glGetShaderInfoLog(shader, 1023, &len, message);	
+		GFX->getShaderInfoLog(shader, 1023, &len, message);	
 		message[len] = '\0';
 		std::cerr << message << '\n';
 	}
@@ -83,18 +84,121 @@ unsigned int createShader(const char* path, GLenum shaderType)
 	return shader;
 }
 
+namespace {
+	void outputCompileErrors(unsigned int shader, const std::string &path)
+	{
+		int compileStatus;
+		GFX->getShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
+		if(compileStatus == 1)
+			return;
+
+		std::cerr << path << " failed to compile!\n";
+		char message[1024];
+		int len = 0;
+		GFX->getShaderInfoLog(shader, 1023, &len, message);
+		message[len] = '\0';
+		std::cerr << message << '\n';
+	}
+
+	//Returns true if the program linked
+	bool outputLinkErrors(unsigned int program, const std::string &name)
+	{
+		int linkStatus;
+		GFX->getProgramiv(program, GL_LINK_STATUS, &linkStatus);
+		if(linkStatus == 1)
+			return true;
+
+		std::cerr << "Failed to link program " << name << "!\n";
+		char message[1024];
+		int len = 0;
+		GFX->getProgramInfoLog(program, 1023, &len, message);
+		message[len] = '\0';
+		std::cerr << message << '\n';
+		return false;
+	}
+
+	unsigned int compileSource(const std::string &source, GLenum shaderType)
+	{
+		unsigned int shader = GFX->createShader(shaderType);
+		const char *sourceBegin = source.c_str();
+		const int len = source.size();
+		GFX->shaderSource(shader, 1, &sourceBegin, &len);
+		GFX->compileShader(shader);
+		return shader;
+	}
+}
+
+std::vector<unsigned int> createPrograms(
+	const std::vector<ShaderSource> &sources,
+	const std::string &cacheprefix
+) {
+	shadercache::ProgramCache cache(cacheprefix);
+
+	const size_t count = sources.size();
+	std::vector<unsigned int> programs(count);
+	std::vector<unsigned int> vertex(count, 0), fragment(count, 0);
+	std::vector<uint64_t> sourcehashes(count);
+	std::vector<bool> cached(count, false);
+
+	//Load what we can from the cache and start compiling everything else,
+	//nothing waits on the driver in this loop
+	for(size_t i = 0; i < count; i++) {
+		const ShaderSource &source = sources[i];
+		std::string vertcode = readShaderFile(source.vertpath.c_str());
+		std::string fragcode = readShaderFile(source.fragpath.c_str());
+		sourcehashes[i] = shadercache::hash(fragcode, shadercache::hash(vertcode));
+
+		programs[i] = GFX->createProgram();
+		cached[i] = cache.load(source.name, sourcehashes[i], programs[i]);
+		if(cached[i])
+			continue;
+		vertex[i] = compileSource(vertcode, GL_VERTEX_SHADER);
+		fragment[i] = compileSource(fragcode, GL_FRAGMENT_SHADER);
+	}
+
+	//Link everything
+	for(size_t i = 0; i < count; i++) {
+		if(cached[i])
+			continue;
+		GFX->attachShader(programs[i], vertex[i]);
+		GFX->attachShader(programs[i], fragment[i]);
+		if(cache.enabled())
+			GFX->programParameteri(programs[i], GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		GFX->linkProgram(programs[i]);
+	}
+
+	//Only now wait for the results
+	for(size_t i = 0; i < count; i++) {
+		if(cached[i])
+			continue;
+		outputCompileErrors(vertex[i], sources[i].vertpath);
+		outputCompileErrors(fragment[i], sources[i].fragpath);
+		bool linked = outputLinkErrors(programs[i], sources[i].name);
+
+		GFX->detachShader(programs[i], vertex[i]);
+		GFX->detachShader(programs[i], fragment[i]);
+		GFX->deleteShader(vertex[i]);
+		GFX->deleteShader(fragment[i]);
+
+		if(linked)
+			cache.store(sources[i].name, sourcehashes[i], programs[i]);
+	}
+
+	return programs;
+}
+
 ShaderProgram::ShaderProgram(unsigned int vertex, unsigned int fragment)
 {
-	programid = glCreateProgram();
+	programid = GFX->createProgram();
 	
-	glAttachShader(programid, vertex);
-	glAttachShader(programid, fragment);
-	glLinkProgram(programid);
-	glValidateProgram(programid);
+	GFX->attachShader(programid, vertex);
+	GFX->attachShader(programid, fragment);
+	GFX->linkProgram(programid);
+	GFX->validateProgram(programid);
 	
 	//Check for linker errors
 	int linkStatus;
-	glGetProgramiv(programid, GL_LINK_STATUS, &linkStatus);
+	GFX->getProgramiv(programid, GL_LINK_STATUS, &linkStatus);
 	//Failed to link
 	if(linkStatus != 1) {
 		//Output linker errors
@@ -102,28 +206,28 @@ ShaderProgram::ShaderProgram(unsigned int vertex, unsigned int fragment)
 
 		char message[1024];
 		int len;
-		glGetProgramInfoLog(programid, 1023, &len, message);
+		GFX->getProgramInfoLog(programid, 1023, &len, message);
 		std::cerr << message << '\n';
 	}
 
-	glDetachShader(programid, vertex);
-	glDetachShader(programid, fragment);
+	GFX->detachShader(programid, vertex);
+	GFX->detachShader(programid, fragment);
 }
 
 ShaderProgram::ShaderProgram(const char *vertpath, const char *fragpath)
 {
-	programid = glCreateProgram();
+	programid = GFX->createProgram();
 
 	unsigned int vertex = createShader(vertpath, GL_VERTEX_SHADER),
 				 fragment = createShader(fragpath, GL_FRAGMENT_SHADER);
-	glAttachShader(programid, vertex);
-	glAttachShader(programid, fragment);
-	glLinkProgram(programid);
-	glValidateProgram(programid);
+	GFX->attachShader(programid, vertex);
+	GFX->attachShader(programid, fragment);
+	GFX->linkProgram(programid);
+	GFX->validateProgram(programid);
 	
 	//Check for linker errors
 	int linkStatus;
-	glGetProgramiv(programid, GL_LINK_STATUS, &linkStatus);
+	GFX->getProgramiv(programid, GL_LINK_STATUS, &linkStatus);
 	//Failed to link
 	if(linkStatus != 1) {
 		//Output linker errors
@@ -131,85 +235,123 @@ ShaderProgram::ShaderProgram(const char *vertpath, const char *fragpath)
 
 		char message[1024];
 		int len;
-		glGetProgramInfoLog(programid, 1023, &len, message);
+		GFX->getProgramInfoLog(programid, 1023, &len, message);
 		std::cerr << message << '\n';
 	}
 
-	glDetachShader(programid, vertex);
-	glDetachShader(programid, fragment);
+	GFX->detachShader(programid, vertex);
+	GFX->detachShader(programid, fragment);
 	//Clean up
-	glDeleteShader(vertex);
-	glDeleteShader(fragment);
+	GFX->deleteShader(vertex);
+	GFX->deleteShader(fragment);
+}
+
+ShaderProgram::ShaderProgram(unsigned int program)
+{
+	programid = program;
 }
 
 void ShaderProgram::use()
 {
-	glUseProgram(programid);
+	GFX->useProgram(programid);
 }
 
-int ShaderProgram::getUniformLocation(const char *uniformName)
+void ShaderProgram::cacheActiveUniforms()
+{
+	activeUniformsCached = true;
+	GLint count = 0, maxlen = 0;
+	GFX->getProgramiv(programid, GL_ACTIVE_UNIFORMS, &count);
+	GFX->getProgramiv(programid, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxlen);
+	std::vector<char> buf(maxlen + 1);
+	for(GLint i = 0; i < count; i++) {
+		GLsizei len = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		GFX->getActiveUniform(programid, i, buf.size(), &len, &size, &type, buf.data());
+		if(len <= 0)
+			continue;
+		std::string name(buf.data(), len);
+		//Arrays are listed as "name[0]" but set through "name"
+		if(name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+			name.resize(name.size() - 3);
+		int location = GFX->getUniformLocation(programid, name.c_str());
+		uniformLocations[sym::intern(name)] = location;
+	}
+}
+
+int ShaderProgram::getUniformLocation(sym::Symbol uniform)
 {
-	if(uniformLocations.count(uniformName) == 0) {
-		int location = glGetUniformLocation(programid, uniformName);
-		uniformLocations[uniformName] = location;
+	if(!activeUniformsCached)
+		cacheActiveUniforms();
+
+	auto found = uniformLocations.find(uniform);
+	if(found == uniformLocations.end()) {
+		//Not active (unused or misspelled), remember the -1 as well
+		int location = GFX->getUniformLocation(programid, sym::name(uniform));
+		uniformLocations.insert({ uniform, location });
 		return location;
 	}
 
-	return uniformLocations[uniformName];
+	return found->second;
+}
+
+int ShaderProgram::getUniformLocation(const char *uniformName)
+{
+	return getUniformLocation(sym::intern(uniformName));
 }
 
 int ShaderProgram::getUniformBlockIndex(const char *uniformBlockName)
 {
-	int index = glGetUniformBlockIndex(programid, uniformBlockName);
+	int index = GFX->getUniformBlockIndex(programid, uniformBlockName);
 	return index;
 }
 
 void ShaderProgram::setBinding(const char *uniformBlockName, unsigned int binding)
 {
 	int index = getUniformBlockIndex(uniformBlockName);
-	glUniformBlockBinding(programid, index, binding);
+	GFX->uniformBlockBinding(programid, index, binding);
 }
 
 void ShaderProgram::uniformMat3x3(const char *uniformName, const glm::mat3 &mat)
 {
 	int location = getUniformLocation(uniformName);
-	glUniformMatrix3fv(location, 1, false, glm::value_ptr(mat));
+	GFX->uniformMatrix3fv(location, 1, false, glm::value_ptr(mat));
 }
 
 void ShaderProgram::uniformMat4x4(const char *uniformName, const glm::mat4 &mat)
 {
 	int location = getUniformLocation(uniformName);
-	glUniformMatrix4fv(location, 1, false, glm::value_ptr(mat));
+	GFX->uniformMatrix4fv(location, 1, false, glm::value_ptr(mat));
 }
 
 void ShaderProgram::uniformVec4(const char *uniformName, const glm::vec4 &vec)
 {
 	int location = getUniformLocation(uniformName);
-	glUniform4f(location, vec.x, vec.y, vec.z, vec.w);
+	GFX->uniform4f(location, vec.x, vec.y, vec.z, vec.w);
 }
 
 void ShaderProgram::uniformVec3(const char *uniformName, const glm::vec3 &vec)
 {
 	int location = getUniformLocation(uniformName);
-	glUniform3f(location, vec.x, vec.y, vec.z);
+	GFX->uniform3f(location, vec.x, vec.y, vec.z);
 }
 
 void ShaderProgram::uniformVec2(const char *uniformName, const glm::vec2 &vec)
 {
 	int location = getUniformLocation(uniformName);
-	glUniform2f(location, vec.x, vec.y);
+	GFX->uniform2f(location, vec.x, vec.y);
 }
 
 void ShaderProgram::uniformFloat(const char *uniformName, float value)
 {
 	int location = getUniformLocation(uniformName);
-	glUniform1f(location, value);
+	GFX->uniform1f(location, value);
 }
 
 void ShaderProgram::uniformInt(const char *uniformName, int value)
 {
 	int location = getUniformLocation(uniformName);
-	glUniform1i(location, value);
+	GFX->uniform1i(location, value);
 }
 
 unsigned int ShaderProgram::getid()
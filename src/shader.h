@@ -2,9 +2,11 @@
 #define SHADER_H
 
 #include <string>
-#include "opengl.h"
+#include "gfxbackend.h"
+#include "symbol.h"
 #include <glm/glm.hpp>
-#include <map>
+#include <unordered_map>
+#include <vector>
 
 typedef unsigned int ShaderId;
 
@@ -20,9 +22,31 @@ typedef unsigned int ShaderId;
  //will output any compiler errors to stderr
  unsigned int createShader(const char *path, GLenum shaderType);
 
+ struct ShaderSource {
+   std::string name;
+   std::string vertpath;
+   std::string fragpath;
+ };
+ //Creates a linked program for each of 'sources', returns the program ids
+ //in the same order. Programs are loaded from the binary cache at
+ //'cacheprefix' when possible (an empty prefix disables the cache), the
+ //rest have all of their shaders compiled and then all of them linked
+ //before any status is checked so that drivers that compile on their own
+ //threads can work on every program at once
+ //will output any compiler or linker errors to stderr
+ std::vector<unsigned int> createPrograms(
+   const std::vector<ShaderSource> &sources,
+   const std::string &cacheprefix
+ );
+
 class ShaderProgram {
-  std::map<std::string, int> uniformLocations;
+  //Keyed by the symbol of the uniform name, holds every active uniform of
+  //the program after the first lookup
+  std::unordered_map<sym::Symbol, int> uniformLocations;
+  bool activeUniformsCached = false;
   unsigned int programid;
+  //Interns the names of the active uniforms and stores their locations
+  void cacheActiveUniforms();
   
 public:
    //creates a shader program by taking in two shader ids,
@@ -32,8 +56,13 @@ public:
    ShaderProgram(unsigned int vertex, unsigned int fragment);
    //creates a shader by taking the path of a vertex and fragment shader
    ShaderProgram(const char *vertpath, const char *fragpath);
+   //takes an already linked program
+   explicit ShaderProgram(unsigned int program);
    void use();
    int getUniformLocation(const char *uniformName);
+   //Lookups of "name"_sym do not touch the name, only a uniform that the
+   //program does not have is looked up by the name it was interned with
+   int getUniformLocation(sym::Symbol uniform);
    int getUniformBlockIndex(const char *uniformBlockName);
    void setBinding(const char *uniformBlockName, unsigned int binding);
    unsigned int getid();
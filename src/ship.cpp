@@ -1,42 +1,11 @@
+#include "ecs.h"
 #include "game.h"
 
 namespace gobjs = gameobjects;
 
 namespace gameobjects {
-void Enemy::updateShip(float dt, const Player &player, std::vector<Bullet> &bullets) {
-  // Ships bob up and down on the water
-  if (transform.position.y > values.at("maxy")) {
-    transform.position.y = values.at("maxy");
-    values.at("direction") *= -1.0f;
-  } else if (transform.position.y < values.at("miny")) {
-    transform.position.y = values.at("miny");
-    values.at("direction") *= -1.0f;
-  }
-
-  transform.position.y += 8.0f * dt * values.at("direction");
-
-  // Shoot rockets at the player
-  float shootTimer = getVal("shoottimer");
-  shootTimer += dt;
-  setVal("shoottimer", shootTimer);
-
-  if (shootTimer > 3.0f) { // Shoot every 3 seconds
-    setVal("shoottimer", 0.0f);
-
-    // Aim at player
-    glm::vec3 toPlayer = player.transform.position - transform.position;
-    toPlayer = glm::normalize(toPlayer);
-
-    // Set rotation to face player
-    transform.rotation.y = atan2f(toPlayer.x, toPlayer.z);
-
-    // Spawn rocket
-    bullets.push_back(Bullet(transform, 0.0f, glm::vec3(0.0f, 5.0f, 0.0f)));
-  }
-}
-
-Enemy spawnShip(const glm::vec3 &position,
-                const infworld::worldseed &permutations) {
+void spawnShip(ecs::World &world, const glm::vec3 &position,
+               const infworld::worldseed &permutations) {
   float h =
       infworld::getHeight(position.z / SCALE * float(PREC + 1) / float(PREC),
                           position.x / SCALE * float(PREC + 1) / float(PREC),
@@ -51,33 +20,36 @@ Enemy spawnShip(const glm::vec3 &position,
 
   float y = 10.0f; // Slightly above water level so ship is visible
   glm::vec3 pos(position.x, y, position.z);
-  Enemy ship = Enemy(pos, 10, 50);
+  size_t i = world.create(ecs::SHIP, pos);
 
-  float miny = y - 8.0f;
-  float maxy = y + 8.0f;
-  float direction = 1.0f;
-  ship.setVal("miny", miny);
-  ship.setVal("maxy", maxy);
-  ship.setVal("direction", direction);
-  ship.setVal("shoottimer", 0.0f);
-  return ship;
+  // Ships bob up and down on the water and shoot rockets at the player
+  // every few seconds (see ecs::bob and ecs::shoot)
+  ecs::Archetype &ships = world.get(ecs::SHIP);
+  ships.bobminy[i] = y - 8.0f;
+  ships.bobmaxy[i] = y + 8.0f;
 }
 } // namespace gameobjects
 
 namespace game {
-void spawnShips(gobjs::Player &player, std::vector<gobjs::Enemy> &ships,
-                std::minstd_rand0 &lcg,
-                const infworld::worldseed &permutations) {
-  if (ships.size() >= 3)
+void spawnShips(gobjs::Player &player, ecs::World &world, uint32_t seed,
+                uint32_t index, const infworld::worldseed &permutations) {
+  size_t count = world.count(ecs::SHIP);
+  if (count >= 3)
     return;
 
-  int randval = lcg() % 3;
-  if (randval > 0 && ships.size() > 0)
+  uint32_t randval =
+      rng::toRange(rng::random(seed, index, rng::STREAM_SHIP_CHANCE), 3);
+  if (randval > 0 && count > 0)
     return;
 
   glm::vec3 center = player.transform.position;
-  float dist = float(lcg() % 256) / 256.0f * CHUNK_SZ * 12.0f + CHUNK_SZ * 6.0f;
-  float angle = float(lcg() % 256) / 256.0f * glm::radians(360.0f);
+  float dist =
+      rng::toFloat(rng::random(seed, index, rng::STREAM_SHIP_DISTANCE)) *
+          CHUNK_SZ * 12.0f +
+      CHUNK_SZ * 6.0f;
+  float angle =
+      rng::toFloat(rng::random(seed, index, rng::STREAM_SHIP_ANGLE)) *
+      glm::radians(360.0f);
   glm::vec3 position =
       center + dist * glm::vec3(cosf(angle), 0.0f, sinf(angle));
 
@@ -90,7 +62,7 @@ void spawnShips(gobjs::Player &player, std::vector<gobjs::Enemy> &ships,
 
   // Only spawn if terrain is below water level
   if (h < 0.0f) {
-    ships.push_back(gobjs::spawnShip(position, permutations));
+    gobjs::spawnShip(world, position, permutations);
   }
 }
 } // namespace game
@@ -0,0 +1,305 @@
+#include "simulation.h"
+#include "logger.h"
+#include <algorithm>
+
+namespace gobjs = gameobjects;
+
+namespace {
+	KeyState findState(const std::map<int, KeyState> &states, int key)
+	{
+		auto it = states.find(key);
+		if(it == states.end())
+			return RELEASED;
+		return it->second;
+	}
+
+	void mergeStates(std::map<int, KeyState> &states, const std::map<int, KeyState> &newer)
+	{
+		for(const auto &newstate : newer) {
+			KeyState &state = states[newstate.first];
+			//The simulation has not seen this press yet
+			if(state == JUST_PRESSED)
+				continue;
+			state = newstate.second;
+		}
+	}
+
+	void consumeStates(std::map<int, KeyState> &states)
+	{
+		for(auto &state : states)
+			if(state.second == JUST_PRESSED)
+				state.second = HELD;
+	}
+
+	game::Transform lerpTransform(const game::Transform &a, const game::Transform &b, float t)
+	{
+		game::Transform transform;
+		transform.position = glm::mix(a.position, b.position, t);
+		transform.rotation = glm::mix(a.rotation, b.rotation, t);
+		transform.scale = glm::mix(a.scale, b.scale, t);
+		return transform;
+	}
+
+	//Both 'prev' and 'curr' are sorted by id
+	void lerpEntities(
+		const std::vector<game::EntityState> &prev,
+		const std::vector<game::EntityState> &curr,
+		float t,
+		std::vector<game::EntityState> &out
+	) {
+		out.resize(curr.size());
+		auto it = prev.begin();
+		for(size_t i = 0; i < curr.size(); i++) {
+			out[i] = curr[i];
+			it = std::lower_bound(
+				it,
+				prev.end(),
+				curr[i].id,
+				[](const game::EntityState &e, uint32_t id) { return e.id < id; }
+			);
+			if(it != prev.end() && it->id == curr[i].id)
+				out[i].transform = lerpTransform(it->transform, curr[i].transform, t);
+		}
+	}
+}
+
+namespace game {
+	KeyState InputState::getKeyState(int key) const
+	{
+		return findState(keys, key);
+	}
+
+	KeyState InputState::getButtonState(int button) const
+	{
+		return findState(buttons, button);
+	}
+
+	bool InputState::keyIsHeld(int key) const
+	{
+		KeyState state = getKeyState(key);
+		return state == JUST_PRESSED || state == HELD;
+	}
+
+	bool InputState::buttonIsHeld(int button) const
+	{
+		KeyState state = getButtonState(button);
+		return state == JUST_PRESSED || state == HELD;
+	}
+
+	InputState InputState::capture()
+	{
+		Window &window = Window::getInstance();
+		InputState state;
+		state.keys = window.getKeyStates();
+		state.buttons = window.getButtonStates();
+		state.scrollspeed = window.getScrollSpeed();
+		return state;
+	}
+
+	void InputState::merge(const InputState &newer)
+	{
+		mergeStates(keys, newer.keys);
+		mergeStates(buttons, newer.buttons);
+		if(newer.scrollspeed != 0.0)
+			scrollspeed = newer.scrollspeed;
+	}
+
+	void InputState::consume()
+	{
+		consumeStates(keys);
+		consumeStates(buttons);
+		scrollspeed = 0.0;
+	}
+
+	void interpolateSnapshots(
+		const WorldSnapshot &prev,
+		const WorldSnapshot &curr,
+		float t,
+		float tickdt,
+		WorldSnapshot &out
+	) {
+		t = std::min(std::max(t, 0.0f), 1.0f);
+
+		out.tick = curr.tick;
+		out.published = curr.published;
+		out.totalTime = glm::mix(prev.totalTime, curr.totalTime, t);
+		out.player = lerpTransform(prev.player, curr.player, t);
+		out.crashed = curr.crashed;
+		out.speed = glm::mix(prev.speed, curr.speed, t);
+		out.fuel = glm::mix(prev.fuel, curr.fuel, t);
+		out.health = curr.health;
+		out.score = curr.score;
+		lerpEntities(prev.balloons, curr.balloons, t, out.balloons);
+		lerpEntities(prev.ships, curr.ships, t, out.ships);
+
+		//Bullets fly in a straight line so they are moved back along their
+		//path instead of being matched up with the previous snapshot
+		out.bullets = curr.bullets;
+		float behind = (1.0f - t) * tickdt;
+		for(auto &bullet : out.bullets)
+			bullet.transform.position -= bullet.transform.direction() * bullet.speed * behind;
+
+		out.explosions = curr.explosions;
+	}
+
+	ArcadeWorld::ArcadeWorld(int seed) :
+		permutations(infworld::makePermutations(seed, 9)),
+		player(glm::vec3(0.0f, HEIGHT * SCALE * 0.5f, 0.0f))
+	{
+		randomseed = infworld::getWorldSeed(permutations);
+		timers.addTimer("spawn_balloon", 0.0f, 50.0f);
+		timers.addTimer("spawn_ship", 0.0f, 100.0f);
+		// timers.addTimer("spawn_barrel", 0.0f, 70.0f);
+	}
+
+	void ArcadeWorld::step(float dt, const InputState &input)
+	{
+		timers.update(dt);
+
+		totalTime += dt;
+		bool justcrashed = player.crashed;
+		player.checkIfCrashed(dt, permutations);
+		justcrashed = player.crashed ^ justcrashed;
+		//Update explosions
+		if(justcrashed) {
+			explosions.push_back(gobjs::Explosion(player.transform.position));
+			// SNDSRC->playid("explosion", player.transform.position);
+			WARN("Plane Crashed");
+		}
+		player.update(dt, input);
+		updateExplosions(explosions, player.transform.position, dt);
+
+		//Shoot bullets
+		if(player.shoottimer <= 0.0f &&
+		   (input.keyIsHeld(SDLK_SPACE) || input.buttonIsHeld(SDL_BUTTON_LEFT)) &&
+		   !player.crashed) {
+			// SNDSRC->playid("shoot", player.transform.position);
+			player.resetShootTimer();
+			bullets.push_back(gobjs::Bullet(player, glm::vec3(-8.5f, -0.75f, 8.5f)));
+			bullets.push_back(gobjs::Bullet(player, glm::vec3(8.5f, -0.75f, 8.5f)));
+		}
+		//Update bullets
+		checkBulletDist(bullets, player);
+		updateBullets(bullets, dt);
+		checkForBulletTerrainCollision(bullets, permutations);
+		ecs::hit(entities, bullets);
+
+		//Spawn balloons and ships
+		if(timers.getTimer("spawn_balloon"_sym))
+			spawnBalloons(player, entities, randomseed, uint32_t(tick), permutations);
+		if(timers.getTimer("spawn_ship"_sym))
+			spawnShips(player, entities, randomseed, uint32_t(tick), permutations);
+		ecs::bob(entities);
+		ecs::move(entities, dt);
+		ecs::shoot(entities, dt, player, bullets);
+		//Destroy any enemies that are too far away or have run out of health
+		ecs::destroy(entities, player, explosions, score);
+		ecs::cull(entities, player.transform.position, ecs::CULL_DIST);
+		entities.removeDead();
+
+		tick++;
+	}
+
+	void ArcadeWorld::snapshot(WorldSnapshot &out) const
+	{
+		out.tick = tick;
+		out.totalTime = totalTime;
+		out.player = player.transform;
+		out.crashed = player.crashed;
+		out.speed = player.speed;
+		out.fuel = player.fuel;
+		out.health = player.health;
+		out.score = score;
+		//Entities stay sorted by id (see ecs.h)
+		entities.getStates(ecs::BALLOON, out.balloons);
+		entities.getStates(ecs::SHIP, out.ships);
+		out.bullets = bullets;
+		out.explosions = explosions;
+	}
+
+	SimulationThread::SimulationThread(ArcadeWorld &w, float dt) :
+		world(w),
+		tickdt(dt)
+	{
+		running = false;
+		paused = false;
+	}
+
+	SimulationThread::~SimulationThread()
+	{
+		stop();
+	}
+
+	void SimulationThread::start()
+	{
+		if(running)
+			return;
+		running = true;
+		thread = std::thread(&SimulationThread::run, this);
+	}
+
+	void SimulationThread::stop()
+	{
+		running = false;
+		if(thread.joinable())
+			thread.join();
+	}
+
+	void SimulationThread::setPaused(bool p)
+	{
+		paused = p;
+	}
+
+	void SimulationThread::pushInput(const InputState &newer)
+	{
+		std::lock_guard<std::mutex> lock(inputmutex);
+		input.merge(newer);
+	}
+
+	bool SimulationThread::update()
+	{
+		return snapshots.update();
+	}
+
+	const WorldSnapshot& SimulationThread::latest() const
+	{
+		return snapshots.read();
+	}
+
+	float SimulationThread::getTickDt() const
+	{
+		return tickdt;
+	}
+
+	void SimulationThread::run()
+	{
+		typedef std::chrono::steady_clock clock;
+		const clock::duration tick =
+			std::chrono::duration_cast<clock::duration>(std::chrono::duration<float>(tickdt));
+		clock::time_point next = clock::now();
+		InputState stepinput;
+		while(running) {
+			if(!paused) {
+				{
+					std::lock_guard<std::mutex> lock(inputmutex);
+					stepinput = input;
+					input.consume();
+				}
+				world.step(tickdt, stepinput);
+
+				WorldSnapshot &out = snapshots.write();
+				world.snapshot(out);
+				out.published = clock::now();
+				snapshots.publish();
+			}
+
+			next += tick;
+			//If the simulation falls too far behind then skip ahead
+			//instead of trying to catch up all at once
+			clock::time_point now = clock::now();
+			if(now - next > tick * 4)
+				next = now;
+			std::this_thread::sleep_until(next);
+		}
+	}
+}
@@ -0,0 +1,127 @@
+/*
+ * Arcade mode simulation, the world is stepped at a fixed rate on its own
+ * thread and every step publishes a snapshot of what the renderer needs
+ * into a triple buffer, the main thread draws by blending the two latest
+ * snapshots so that the simulation runs while the main thread waits on
+ * the GPU and for the buffer swap
+ *
+ * The simulation thread never touches the window, the camera or the
+ * graphics api, input is copied over to it with InputState
+ * */
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "ecs.h"
+#include "game.h"
+#include "window.h"
+#include "triplebuffer.h"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace game {
+	//Copy of the keyboard and mouse state at some point in time
+	struct InputState {
+		std::map<int, KeyState> keys;
+		std::map<int, KeyState> buttons;
+		double scrollspeed = 0.0;
+		KeyState getKeyState(int key) const;
+		KeyState getButtonState(int button) const;
+		bool keyIsHeld(int key) const;
+		bool buttonIsHeld(int button) const;
+		//Copies the current input state of the window
+		static InputState capture();
+		//Takes the states from 'newer' but keeps any press that has not
+		//been stepped with yet so that a quick tap is never lost
+		void merge(const InputState &newer);
+		//Called once a step has seen this input, presses become holds
+		void consume();
+	};
+
+	//Everything that is drawn or shown on the HUD after one step, none of
+	//it points back into the world
+	struct WorldSnapshot {
+		uint64_t tick = 0;
+		float totalTime = 0.0f;
+		//When the step that made this snapshot finished
+		std::chrono::steady_clock::time_point published;
+		Transform player;
+		bool crashed = false;
+		float speed = 0.0f;
+		float fuel = 0.0f;
+		unsigned int health = 0;
+		unsigned int score = 0;
+		//Sorted by id
+		std::vector<EntityState> balloons, ships;
+		std::vector<gameobjects::Bullet> bullets;
+		std::vector<gameobjects::Explosion> explosions;
+	};
+
+	//Blends 'prev' into 'curr' by 't' (0 is prev, 1 is curr) and writes
+	//the result to 'out', 'tickdt' is the time between the two snapshots
+	//Enemies are matched up by id, anything that only exists in 'curr' is
+	//drawn where 'curr' has it
+	void interpolateSnapshots(
+		const WorldSnapshot &prev,
+		const WorldSnapshot &curr,
+		float t,
+		float tickdt,
+		WorldSnapshot &out
+	);
+
+	//The part of arcade mode that is simulated
+	struct ArcadeWorld {
+		infworld::worldseed permutations;
+		//Seed for rng::random(), spawns are keyed by the tick
+		uint32_t randomseed;
+		gameobjects::Player player;
+		std::vector<gameobjects::Bullet> bullets;
+		//Balloons and ships
+		ecs::World entities;
+		std::vector<gameobjects::Explosion> explosions;
+		TimerManager timers;
+		float totalTime = 0.0f;
+		unsigned int score = 0;
+		uint64_t tick = 0;
+		ArcadeWorld(int seed);
+		//Advances the world by 'dt'
+		void step(float dt, const InputState &input);
+		void snapshot(WorldSnapshot &out) const;
+	};
+
+	//Steps an ArcadeWorld every 'tickdt' seconds on its own thread, the
+	//world must not be touched by anything else while the thread runs
+	class SimulationThread {
+		ArcadeWorld &world;
+		float tickdt;
+		TripleBuffer<WorldSnapshot> snapshots;
+		std::mutex inputmutex;
+		//Input that has been pushed but not stepped with yet
+		InputState input;
+		std::atomic<bool> running;
+		std::atomic<bool> paused;
+		std::thread thread;
+		void run();
+	public:
+		SimulationThread(ArcadeWorld &world, float tickdt);
+		//Stops the thread
+		~SimulationThread();
+		SimulationThread(const SimulationThread&) = delete;
+		SimulationThread& operator=(const SimulationThread&) = delete;
+		void start();
+		void stop();
+		void setPaused(bool p);
+		//Called by the main thread once per frame after polling events
+		void pushInput(const InputState &newer);
+		//Picks up the latest snapshot, returns false if there is no new one
+		bool update();
+		//The snapshot picked up by the last update()
+		const WorldSnapshot& latest() const;
+		float getTickDt() const;
+	};
+}
+
+#endif
@@ -0,0 +1,34 @@
+#include "symbol.h"
+#include "logger.h"
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+	std::mutex mutex;
+	//Nodes are never moved so the strings stay where name() found them
+	std::unordered_map<sym::Symbol, std::string> names;
+}
+
+namespace sym {
+	Symbol intern(const std::string &str)
+	{
+		Symbol symbol(str);
+		std::lock_guard<std::mutex> lock(mutex);
+		auto inserted = names.insert({ symbol, str });
+		if(!inserted.second && inserted.first->second != str) {
+			ERROR(
+				"%s and %s have the same symbol",
+				inserted.first->second.c_str(),
+				str.c_str()
+			);
+		}
+		return symbol;
+	}
+
+	const char* name(Symbol symbol)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto found = names.find(symbol);
+		return found == names.end() ? "?" : found->second.c_str();
+	}
+}
@@ -0,0 +1,84 @@
+/*
+ * Interned strings, names that are looked up every frame (assets, timers,
+ * shader uniforms) are turned into a Symbol and the tables that hold them
+ * are keyed by the symbol so that a lookup hashes and compares one integer
+ * instead of building and comparing strings
+ *
+ * A symbol is the 64 bit FNV-1a hash of its string (hash() below is also
+ * what shadercache::hash uses), so a string literal is turned into one at
+ * compile time with "name"_sym, the tables register their names with intern() so
+ * that they can be printed and so that two different names that hash the
+ * same are caught
+ * */
+
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace sym {
+	constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+	constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+	//'h' can be the result of a previous call to continue hashing
+	constexpr uint64_t hash(const char *str, size_t len, uint64_t h = FNV_OFFSET)
+	{
+		for(size_t i = 0; i < len; i++) {
+			h ^= (unsigned char)str[i];
+			h *= FNV_PRIME;
+		}
+		return h;
+	}
+
+	constexpr size_t length(const char *str)
+	{
+		size_t len = 0;
+		while(str[len])
+			len++;
+		return len;
+	}
+
+	struct Symbol {
+		//The symbol of ""
+		uint64_t id = FNV_OFFSET;
+		constexpr Symbol() {}
+		//These hash 'str' every time they are called, literals should use
+		//"name"_sym instead which compilers fold into a constant
+		explicit constexpr Symbol(const char *str) : id(hash(str, length(str))) {}
+		explicit Symbol(const std::string &str) : id(hash(str.data(), str.size())) {}
+		constexpr bool empty() const { return id == FNV_OFFSET; }
+		constexpr bool operator==(Symbol other) const { return id == other.id; }
+		constexpr bool operator!=(Symbol other) const { return id != other.id; }
+		constexpr bool operator<(Symbol other) const { return id < other.id; }
+	};
+
+	//Returns the symbol of 'str' and remembers 'str' for name(), logs an
+	//error if a different string was interned with the same symbol, can
+	//be called from any thread
+	Symbol intern(const std::string &str);
+	//The string that 'symbol' was interned from, "?" if it never was
+	const char* name(Symbol symbol);
+}
+
+constexpr sym::Symbol operator""_sym(const char *str, size_t len)
+{
+	sym::Symbol symbol;
+	symbol.id = sym::hash(str, len);
+	return symbol;
+}
+
+namespace std {
+	//The id already is a hash
+	template<>
+	struct hash<sym::Symbol> {
+		size_t operator()(sym::Symbol symbol) const
+		{
+			return size_t(symbol.id);
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,319 @@
+#include "texturefile.h"
+#include "assets.h"
+#include "logger.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+namespace {
+	constexpr char MAGIC[4] = { 'T', 'E', 'X', 'B' };
+
+	bool modificationTime(const std::string &path, time_t &mtime)
+	{
+		struct stat st;
+		if(stat(path.c_str(), &st) != 0)
+			return false;
+		mtime = st.st_mtime;
+		return true;
+	}
+
+	uint64_t align4(uint64_t n)
+	{
+		return (n + 3) & ~uint64_t(3);
+	}
+
+	uint32_t rowStride(uint32_t width, uint32_t channels)
+	{
+		return uint32_t(align4(uint64_t(width) * channels));
+	}
+
+	//Averages 2x2 blocks, the last row/column is repeated for odd sizes
+	texturefile::Image downsample(const texturefile::Image &src, uint32_t channels)
+	{
+		texturefile::Image dst;
+		dst.width = src.width > 1 ? src.width / 2 : 1;
+		dst.height = src.height > 1 ? src.height / 2 : 1;
+		uint32_t srcstride = rowStride(src.width, channels);
+		uint32_t dststride = rowStride(dst.width, channels);
+		dst.pixels.resize(uint64_t(dststride) * dst.height, 0);
+
+		for(uint32_t y = 0; y < dst.height; y++) {
+			uint32_t y0 = std::min(y * 2, src.height - 1);
+			uint32_t y1 = std::min(y * 2 + 1, src.height - 1);
+			const unsigned char *row0 = &src.pixels[uint64_t(y0) * srcstride];
+			const unsigned char *row1 = &src.pixels[uint64_t(y1) * srcstride];
+			unsigned char *out = &dst.pixels[uint64_t(y) * dststride];
+			for(uint32_t x = 0; x < dst.width; x++) {
+				uint32_t x0 = std::min(x * 2, src.width - 1) * channels;
+				uint32_t x1 = std::min(x * 2 + 1, src.width - 1) * channels;
+				for(uint32_t c = 0; c < channels; c++) {
+					unsigned int sum =
+						row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+					out[x * channels + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+		return dst;
+	}
+}
+
+namespace texturefile {
+	std::vector<Image> buildMipChain(const gfx::ImageData &image, bool mipmaps)
+	{
+		std::vector<Image> levels(1);
+		Image &base = levels[0];
+		base.width = image.width;
+		base.height = image.height;
+		uint32_t channels = image.channels;
+		uint32_t stride = rowStride(base.width, channels);
+		uint32_t rowsize = base.width * channels;
+		base.pixels.resize(uint64_t(stride) * base.height, 0);
+		for(uint32_t y = 0; y < base.height; y++) {
+			memcpy(
+				&base.pixels[uint64_t(y) * stride],
+				image.pixels.get() + uint64_t(y) * rowsize,
+				rowsize
+			);
+		}
+
+		if(!mipmaps)
+			return levels;
+		while(levels.back().width > 1 || levels.back().height > 1)
+			levels.push_back(downsample(levels.back(), channels));
+		return levels;
+	}
+
+	bool write(
+		const char *path,
+		Target target,
+		uint32_t channels,
+		uint32_t flags,
+		const std::vector<std::vector<Image>> &faces
+	) {
+		if(faces.empty() || faces[0].empty())
+			return false;
+
+		Header header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.target = target;
+		header.format = FORMAT_RAW;
+		header.flags = flags;
+		header.channels = channels;
+		header.faces = faces.size();
+		header.levels = faces[0].size();
+
+		std::vector<Level> levels;
+		uint64_t offset = align4(sizeof(Header) + sizeof(Level) * header.faces * header.levels);
+		for(const auto &face : faces) {
+			if(face.size() != header.levels)
+				return false;
+			for(const auto &image : face) {
+				levels.push_back({ image.width, image.height, offset, image.pixels.size() });
+				offset = align4(offset + image.pixels.size());
+			}
+		}
+
+		//Written to a temporary file first so that the game never maps a
+		//half written texture
+		std::string temppath = std::string(path) + ".tmp";
+		FILE *file = fopen(temppath.c_str(), "wb");
+		if(!file) {
+			ERROR("Failed to write %s", temppath.c_str());
+			return false;
+		}
+		bool ok =
+			fwrite(&header, sizeof(header), 1, file) == 1 &&
+			fwrite(levels.data(), sizeof(Level), levels.size(), file) == levels.size();
+		size_t i = 0;
+		for(const auto &face : faces) {
+			for(const auto &image : face) {
+				if(!ok)
+					break;
+				ok = fseek(file, long(levels[i++].offset), SEEK_SET) == 0 &&
+					fwrite(image.pixels.data(), 1, image.pixels.size(), file) == image.pixels.size();
+			}
+		}
+		ok = fclose(file) == 0 && ok;
+		remove(path);
+		if(!ok || rename(temppath.c_str(), path) != 0) {
+			ERROR("Failed to write %s", path);
+			remove(temppath.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	bool TextureData::open(const char *path)
+	{
+		header = nullptr;
+		levels = nullptr;
+		if(!assetpack::readFile(path, file))
+			return false;
+
+		const Header *h = (const Header*)file.data();
+		bool valid =
+			file.size() >= sizeof(Header) &&
+			memcmp(h->magic, MAGIC, sizeof(MAGIC)) == 0 &&
+			h->version == VERSION &&
+			h->format == FORMAT_RAW &&
+			h->channels >= 1 && h->channels <= 4 &&
+			h->levels > 0 && h->levels <= 32 &&
+			((h->target == TARGET_2D && h->faces == 1) ||
+			 (h->target == TARGET_CUBEMAP && h->faces == 6)) &&
+			file.size() >= sizeof(Header) + sizeof(Level) * uint64_t(h->faces) * h->levels;
+		if(valid) {
+			const Level *l = (const Level*)(file.data() + sizeof(Header));
+			for(uint32_t i = 0; i < h->faces * h->levels && valid; i++) {
+				uint64_t expected = uint64_t(rowStride(l[i].width, h->channels)) * l[i].height;
+				valid =
+					l[i].size == expected &&
+					l[i].offset % 4 == 0 &&
+					l[i].offset + l[i].size <= file.size();
+			}
+		}
+
+		if(!valid) {
+			WARN("%s is not a valid texture file", path);
+			file = assetpack::FileData();
+			return false;
+		}
+		header = h;
+		levels = (const Level*)(file.data() + sizeof(Header));
+		return true;
+	}
+
+	const Header& TextureData::getHeader() const
+	{
+		return *header;
+	}
+
+	const Level& TextureData::getLevel(uint32_t face, uint32_t level) const
+	{
+		return levels[face * header->levels + level];
+	}
+
+	const unsigned char* TextureData::pixels(uint32_t face, uint32_t level) const
+	{
+		return file.data() + getLevel(face, level).offset;
+	}
+
+	void upload(const TextureData &texture, unsigned int textureid)
+	{
+		const Header &header = texture.getHeader();
+		GLenum format = gfx::getFormat(header.channels);
+		GLenum target = header.target == TARGET_CUBEMAP ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+		GFX->bindTexture(target, textureid);
+
+		for(uint32_t face = 0; face < header.faces; face++) {
+			GLenum facetarget =
+				header.target == TARGET_CUBEMAP ?
+				GL_TEXTURE_CUBE_MAP_POSITIVE_X + face :
+				GL_TEXTURE_2D;
+			for(uint32_t i = 0; i < header.levels; i++) {
+				const Level &level = texture.getLevel(face, i);
+				GFX->texImage2D(
+					facetarget,
+					i,
+					format,
+					level.width,
+					level.height,
+					0,
+					format,
+					GL_UNSIGNED_BYTE,
+					texture.pixels(face, i)
+				);
+			}
+		}
+
+		GFX->texParameteri(target, GL_TEXTURE_MAX_LEVEL, header.levels - 1);
+		if(header.target == TARGET_CUBEMAP) {
+			GFX->texParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			GFX->texParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			GFX->texParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			GFX->texParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			GFX->texParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		}
+		else {
+			GFX->texParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			GFX->texParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		}
+	}
+
+	std::string bakedPath(const std::string &name, const std::string &sourcepath)
+	{
+		size_t slash = sourcepath.find_last_of("/\\");
+		std::string dir = slash == std::string::npos ? "" : sourcepath.substr(0, slash + 1);
+		return dir + name + ".tex";
+	}
+
+	bool isUpToDate(const std::string &bakedpath, const std::vector<std::string> &sources)
+	{
+		if(assetpack::contains(bakedpath))
+			return true;
+		time_t baked;
+		if(!modificationTime(bakedpath, baked))
+			return false;
+		for(const auto &source : sources) {
+			time_t mtime;
+			//Sources that were not shipped are ignored
+			if(modificationTime(source, mtime) && mtime > baked)
+				return false;
+		}
+		return true;
+	}
+
+	unsigned int bakeTextures(const char *path)
+	{
+		std::vector<impfile::Entry> entries = impfile::parseFile(path);
+		unsigned int failed = 0;
+		for(const auto &entry : entries) {
+			assets::TextureMetaData metadata = assets::entryToTextureMetaData(entry);
+			bool cubemap = metadata.target == "cubemap";
+			std::vector<std::string> sources =
+				cubemap ? metadata.cubemapPaths : std::vector<std::string>{ metadata.path };
+			std::string bakedpath = bakedPath(metadata.name, sources.at(0));
+
+			//Cubemaps are sampled without mipmaps so only the 2d
+			//textures get a full chain (like glGenerateMipmap did)
+			std::vector<std::vector<Image>> faces;
+			int channels = 0;
+			bool ok = true;
+			for(const auto &source : sources) {
+				gfx::ImageData image;
+				bool flip = !cubemap && metadata.flipv;
+				if(!gfx::decodeImage(source.c_str(), flip, image)) {
+					ERROR("Failed to open: %s", source.c_str());
+					ok = false;
+					break;
+				}
+				if(!faces.empty() && (image.channels != channels ||
+				   image.width != int(faces[0][0].width) ||
+				   image.height != int(faces[0][0].height))) {
+					ERROR("Cubemap faces of %s do not match", metadata.name.c_str());
+					ok = false;
+					break;
+				}
+				channels = image.channels;
+				faces.push_back(buildMipChain(image, !cubemap));
+			}
+
+			uint32_t flags = !cubemap && metadata.flipv ? uint32_t(FLAG_FLIPPED) : 0u;
+			Target target = cubemap ? TARGET_CUBEMAP : TARGET_2D;
+			if(!ok || !write(bakedpath.c_str(), target, channels, flags, faces)) {
+				ERROR("Failed to bake texture %s", metadata.name.c_str());
+				failed++;
+				continue;
+			}
+			INFO(
+				"Baked %s -> %s (%zu level(s))",
+				metadata.name.c_str(),
+				bakedpath.c_str(),
+				faces[0].size()
+			);
+		}
+		return failed;
+	}
+}
@@ -0,0 +1,114 @@
+/*
+ * Baked texture format, the images listed in the textures impfile are
+ * decoded, flipped and mipmapped ahead of time (see the --bake option) so
+ * that loading a texture is mapping the file and passing each level to
+ * the graphics api without running the image decoder
+ *
+ * Layout (little endian):
+ * Header
+ * faces * levels * Level (face major, level 0 is the full size image)
+ * pixel data, every level starts 4 byte aligned and its rows are padded
+ * to 4 bytes so the default unpack alignment can be used
+ * */
+
+#ifndef TEXTURE_FILE_H
+#define TEXTURE_FILE_H
+
+#include "gfx.h"
+#include "assetpack.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace texturefile {
+	//Bump this if the layout changes, old files are then ignored
+	constexpr uint32_t VERSION = 1;
+
+	enum Target : uint32_t {
+		TARGET_2D,
+		TARGET_CUBEMAP,
+	};
+
+	enum Format : uint32_t {
+		//8 bits per channel, uncompressed
+		FORMAT_RAW,
+	};
+
+	enum Flags : uint32_t {
+		//The rows were flipped vertically when baking
+		FLAG_FLIPPED = 1 << 0,
+	};
+
+	struct Header {
+		char magic[4];
+		uint32_t version;
+		uint32_t target;
+		uint32_t format;
+		uint32_t flags;
+		uint32_t channels;
+		uint32_t faces;
+		uint32_t levels;
+	};
+	static_assert(sizeof(Header) == 32, "Header must be tightly packed");
+
+	struct Level {
+		uint32_t width;
+		uint32_t height;
+		//From the start of the file
+		uint64_t offset;
+		uint64_t size;
+	};
+	static_assert(sizeof(Level) == 24, "Level must be tightly packed");
+
+	//Pixels of one mip level with rows padded to 4 bytes
+	struct Image {
+		uint32_t width = 0, height = 0;
+		std::vector<unsigned char> pixels;
+	};
+
+	//Copies a decoded image into level 0 and box filters it down to 1x1
+	//if 'mipmaps' is true
+	std::vector<Image> buildMipChain(const gfx::ImageData &image, bool mipmaps);
+	//'faces' holds the mip chain of each face (1 for 2d textures, 6 for
+	//cubemaps), every face must have the same size and level count
+	bool write(
+		const char *path,
+		Target target,
+		uint32_t channels,
+		uint32_t flags,
+		const std::vector<std::vector<Image>> &faces
+	);
+
+	//A baked texture mapped into memory (on its own or as part of the asset
+	//pack), pixels() points into the mapping so it is only valid while this
+	//is open
+	class TextureData {
+		assetpack::FileData file;
+		const Header *header = nullptr;
+		const Level *levels = nullptr;
+	public:
+		//Returns false if the file can not be read or is not a valid
+		//texture file of the current version
+		bool open(const char *path);
+		const Header& getHeader() const;
+		const Level& getLevel(uint32_t face, uint32_t level) const;
+		const unsigned char* pixels(uint32_t face, uint32_t level) const;
+	};
+
+	//Uploads every level of a baked texture, must be called on the main
+	//thread, the texture parameters match gfx::uploadTexture and
+	//gfx::uploadCubemap
+	void upload(const TextureData &texture, unsigned int textureid);
+	//The baked file of the texture 'name' goes next to its (first) source
+	//image: assets/textures/foo.png -> assets/textures/<name>.tex
+	std::string bakedPath(const std::string &name, const std::string &sourcepath);
+	//Returns true if 'bakedpath' exists and is not older than any of
+	//the 'sources', a baked file in the mounted asset pack is always up
+	//to date
+	bool isUpToDate(const std::string &bakedpath, const std::vector<std::string> &sources);
+	//Bakes every texture listed in the textures impfile at 'path', returns
+	//the number of textures that could not be baked
+	unsigned int bakeTextures(const char *path);
+}
+
+#endif
@@ -0,0 +1,62 @@
+/*
+ * Lock free triple buffer for handing values from one producer thread to
+ * one consumer thread, the producer always has a slot to write into and the
+ * consumer always sees the most recently published value so neither side
+ * ever waits on the other, values that are published faster than they are
+ * read are dropped
+ * */
+
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+template<typename T>
+class TripleBuffer {
+	//Set on the middle index when it holds a value the consumer
+	//has not picked up yet
+	static constexpr unsigned int FRESH = 4;
+
+	T slots[3];
+	unsigned int back = 0, front = 1;
+	std::atomic<unsigned int> middle;
+public:
+	TripleBuffer()
+	{
+		middle = 2;
+	}
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	//Producer side, the slot to fill in before calling publish(), it still
+	//holds whatever was written into it two publishes ago
+	T& write()
+	{
+		return slots[back];
+	}
+
+	//Producer side, hands the written slot over to the consumer
+	void publish()
+	{
+		back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+	}
+
+	//Consumer side, picks up the latest published value if there is one,
+	//returns false if nothing was published since the last call
+	bool update()
+	{
+		if(!(middle.load(std::memory_order_relaxed) & FRESH))
+			return false;
+		front = middle.exchange(front, std::memory_order_acq_rel) & ~FRESH;
+		return true;
+	}
+
+	//Consumer side, the value picked up by the last update()
+	const T& read() const
+	{
+		return slots[front];
+	}
+};
+
+#endif
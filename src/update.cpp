@@ -81,52 +81,65 @@ namespace game {
 	}
 
 	void updateCamera(gobjs::Player &player)
+	{
+		updateCamera(player.transform);
+	}
+
+	void updateCamera(gobjs::Player &player, float dt)
+	{
+		updateCamera(player.transform, dt);
+	}
+
+	void updateCamera(const Transform &playertransform)
 	{
 		Camera& cam = Window::getInstance().getCamera();
 		//Update camera
-		cam.position = game::getCameraFollowPos(player.transform);
-		cam.yaw = -(player.transform.rotation.y + glm::radians(180.0f));
-		cam.pitch = player.transform.rotation.x;
+		cam.position = game::getCameraFollowPos(playertransform);
+		cam.yaw = -(playertransform.rotation.y + glm::radians(180.0f));
+		cam.pitch = playertransform.rotation.x;
 	}
 
-	void updateCamera(gobjs::Player &player, float dt)
+	void updateCamera(const Transform &playertransform, float dt)
 	{
 		Camera& cam = Window::getInstance().getCamera();
 		//Update camera
-		cam.position = game::getCameraFollowPos(player.transform);
+		cam.position = game::getCameraFollowPos(playertransform);
 		float
-			yaw = -(player.transform.rotation.y + glm::radians(180.0f)),
-			pitch = player.transform.rotation.x;
+			yaw = -(playertransform.rotation.y + glm::radians(180.0f)),
+			pitch = playertransform.rotation.x;
 		cam.yaw += (yaw - cam.yaw) * 6.0f * dt;
 		cam.pitch += (pitch - cam.pitch) * 7.0f * dt;
-	}	
+	}
 
 	void updateExplosions(
 		std::vector<gobjs::Explosion> &explosions, 
 		const glm::vec3 &center,
 		float dt
 	) {
-		for(auto &explosion : explosions)
-			explosion.update(dt);
-
-		explosions.erase(std::remove_if(
-			explosions.begin(),
-			explosions.end(),
-			[](gobjs::Explosion &explosion) {
-				return !explosion.visible;
-			}
-		), explosions.end());
-
-		std::sort(
-			explosions.begin(),
-			explosions.end(),
-			[&center](gobjs::Explosion &e1, gobjs::Explosion &e2) {
-				glm::vec3 
-					d1 = e1.transform.position - center,
-					d2 = e2.transform.position - center;
-				return glm::length(d1) > glm::length(d2);
+		//Update and remove the finished explosions in one pass
+		size_t live = 0;
+		for(size_t i = 0; i < explosions.size(); i++) {
+			explosions[i].update(dt);
+			if(explosions[i].visible)
+				explosions[live++] = explosions[i];
+		}
+		explosions.erase(explosions.begin() + live, explosions.end());
+
+		//Farthest first, the order carries over from the last update so
+		//an insertion sort on the squared distance is close to linear
+		for(size_t i = 1; i < explosions.size(); i++) {
+			gobjs::Explosion explosion = explosions[i];
+			glm::vec3 d = explosion.transform.position - center;
+			float dist2 = glm::dot(d, d);
+			size_t j = i;
+			for(; j > 0; j--) {
+				glm::vec3 dprev = explosions[j - 1].transform.position - center;
+				if(glm::dot(dprev, dprev) >= dist2)
+					break;
+				explosions[j] = explosions[j - 1];
 			}
-		);
+			explosions[j] = explosion;
+		}
 	}
 
 	void updateBullets(std::vector<gobjs::Bullet> &bullets, float dt)
@@ -155,23 +168,6 @@ namespace game {
 		}
 	}
 
-	void checkForHit(
-		std::vector<gobjs::Bullet> &bullets,
-		std::vector<gobjs::Enemy> &enemies,
-		float hitdist
-	) {
-		for(auto &bullet : bullets) {
-			for(auto &enemy : enemies) {
-				glm::vec3 diff = bullet.transform.position - enemy.transform.position;
-				float dist = glm::length(diff);
-				if(dist < hitdist) {
-					bullet.destroyed = true;
-					enemy.hitpoints--;
-				}
-			}
-		}
-	}
-
 	void checkForHit(
 		std::vector<gobjs::Bullet> &bullets,
 		gobjs::Player &player,
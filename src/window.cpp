@@ -1,9 +1,30 @@
 #include "window.h"
+#include "gfxbackend.h"
 #include <SDL.h>
 #include <iostream>
 #include "imgui_impl_sdl2.h"
 
+bool Window::sHeadless = false;
+
 Window::Window(){
+  mShouldClose = false;
+
+  cam = Camera(glm::vec3(0.0f, 360.0f, 0.0f));
+  mousex = 0.0;
+  mousey = 0.0;
+  persp = glm::mat4(1.0f);
+
+  currentFovy = 0.0f;
+  currentAspect = 0.0f;
+  currentZnear = 0.0f;
+  currentZfar = 0.0f;
+
+  scrollspeed = 0.0f;
+
+  // No window or GL context, only the camera and input state exist
+  if (sHeadless) {
+    return;
+  }
 
   // SDL2 initialization
   if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS) != 0) {
@@ -58,22 +79,12 @@ Window::Window(){
   // Enable vsync
   SDL_GL_SetSwapInterval(1);
 
-  mShouldClose = false;
-
-  cam = Camera(glm::vec3(0.0f, 360.0f, 0.0f));
-  mousex = 0.0;
-  mousey = 0.0;
-  persp = glm::mat4(1.0f);
-
-  currentFovy = 0.0f;
-  currentAspect = 0.0f;
-  currentZnear = 0.0f;
-  currentZfar = 0.0f;
-
-  scrollspeed = 0.0f;
  }
 
 Window::~Window() {
+  if(sHeadless) {
+    return;
+  }
   if(mGLContext) {
     SDL_GL_DeleteContext(mGLContext);
   }
@@ -87,7 +98,7 @@ void Window::onResize(int width, int height){
   mWidth = width;
   mHeight = height;
 
-  glViewport(0, 0, width, height);
+  GFX->viewport(0, 0, width, height);
 
   updatePerspectiveMat(currentFovy, currentZnear, currentZfar, width, height);
 }
@@ -273,6 +284,9 @@ bool Window::keyIsHeld(KeyState keystate)
 }
 
 void Window::setCursorInputMode(int mode){
+  if(sHeadless) {
+    return;
+  }
   if(mode == CURSOR_DISABLED) {
     SDL_SetRelativeMouseMode(SDL_TRUE);
     SDL_ShowCursor(SDL_DISABLE);
@@ -285,16 +299,32 @@ void Window::setCursorInputMode(int mode){
   }
 }
 
+void Window::setHeadless(bool headless)
+{
+  sHeadless = headless;
+}
+
+bool Window::isHeadless()
+{
+  return sHeadless;
+}
+
 // SDL2 method implementations
 bool Window::shouldClose() const {
   return mShouldClose;
 }
 
 void Window::swapBuffers() {
+  if(sHeadless) {
+    return;
+  }
   SDL_GL_SwapWindow(mWindow);
 }
 
 void Window::pollEvents() {
+  if(sHeadless) {
+    return;
+  }
   SDL_Event event;
   while (SDL_PollEvent(&event)) {
     // Let ImGui process the event first
@@ -386,6 +416,9 @@ void Window::processSDLEvent(SDL_Event& event) {
 
 void Window::initMousePos()
 {
+  if(sHeadless) {
+    return;
+  }
   int mousex, mousey;
   SDL_GetMouseState(&mousex, &mousey);
   setMousePos(mousex, mousey);
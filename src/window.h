@@ -47,6 +47,12 @@ public:
     return instance;
   }
 
+  //Must be called before the first getInstance(), a headless window
+  //does not create an SDL window or a GL context so it can only be used
+  //with a graphics backend that does not need one (see gfxbackend.h)
+  static void setHeadless(bool headless);
+  static bool isHeadless();
+
   Window(const Window&) = delete;
   Window& operator=(const Window&) = delete;
 
@@ -79,6 +85,8 @@ public:
   void clearInputState();
   KeyState getKeyState(int key);
   KeyState getButtonState(int button);
+  const std::map<int, KeyState>& getKeyStates() const { return keystates; }
+  const std::map<int, KeyState>& getButtonStates() const { return mousebuttonstates; }
   void initMousePos();
   bool keyIsHeld(KeyState keystate);
   void setCursorInputMode(int mode);
@@ -90,8 +98,10 @@ private:
   Window();
   ~Window();
 
-  SDL_Window* mWindow;
-  SDL_GLContext mGLContext;
+  static bool sHeadless;
+
+  SDL_Window* mWindow = nullptr;
+  SDL_GLContext mGLContext = nullptr;
   bool mShouldClose = false;
 
   int mWidth = 1280;
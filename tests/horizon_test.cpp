@@ -0,0 +1,51 @@
+#include "horizon.h"
+#include "logger.h"
+#include <glm/glm.hpp>
+
+// Builds a horizon from a synthetic ridge and checks which boxes behind it
+// are reported as hidden
+int main() {
+  geo::HorizonBuffer horizon(256);
+  const glm::vec3 eye(0.0f, 10.0f, 0.0f);
+  horizon.clear(eye);
+  // A ridge at least 60 high across the view 100 to 200 away down +x
+  horizon.addOccluder(glm::vec2(100.0f, -50.0f), glm::vec2(200.0f, 50.0f),
+                      60.0f);
+
+  struct Case {
+    const char *name;
+    glm::vec3 min, max;
+    bool hidden;
+  };
+  const Case cases[] = {
+      {"low chunk behind the ridge", glm::vec3(400.0f, 0.0f, -20.0f),
+       glm::vec3(500.0f, 30.0f, 20.0f), true},
+      {"peak above the ridge line", glm::vec3(400.0f, 0.0f, -20.0f),
+       glm::vec3(500.0f, 200.0f, 20.0f), false},
+      {"chunk in front of the ridge", glm::vec3(50.0f, 0.0f, -10.0f),
+       glm::vec3(80.0f, 5.0f, 10.0f), false},
+      {"chunk beside the ridge", glm::vec3(400.0f, 0.0f, 300.0f),
+       glm::vec3(500.0f, 30.0f, 340.0f), false},
+      {"chunk behind the camera", glm::vec3(-500.0f, 0.0f, -20.0f),
+       glm::vec3(-400.0f, 30.0f, 20.0f), false},
+  };
+
+  bool ok = true;
+  for (const auto &c : cases) {
+    bool hidden = horizon.occluded(c.min, c.max);
+    INFO("%-28s %s (expected %s)", c.name, hidden ? "hidden" : "visible",
+         c.hidden ? "hidden" : "visible");
+    ok = ok && hidden == c.hidden;
+  }
+
+  // Nothing is hidden once the buffer is cleared
+  horizon.clear(eye);
+  for (const auto &c : cases)
+    ok = ok && !horizon.occluded(c.min, c.max);
+
+  if (!ok) {
+    ERROR("Horizon culling hid the wrong boxes");
+    return 1;
+  }
+  return 0;
+}
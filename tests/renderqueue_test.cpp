@@ -0,0 +1,114 @@
+#include "gfxbackend.h"
+#include "logger.h"
+#include "renderqueue.h"
+#include "shader.h"
+#include "symbol.h"
+#include <vector>
+
+// Queues a fixed set of packets into the recording backend and checks the
+// order they are submitted in and how often the state changes, no window or
+// GPU is needed
+int main() {
+  using namespace gfx;
+  NullBackend null;
+  GraphicsBackend::set(&null);
+
+  ShaderProgram a(1), b(2);
+  const unsigned int TEX_A = 10, TEX_B = 11, VAO_A = 100, VAO_B = 101;
+  auto material = [](RenderPass pass, ShaderProgram &shader,
+                     unsigned int texture, uint8_t state,
+                     UniformRange shared) {
+    Material m;
+    m.pass = pass;
+    m.shader = &shader;
+    m.texturetarget = GL_TEXTURE_2D;
+    m.textureid = texture;
+    m.state = state;
+    m.shared = shared;
+    return m;
+  };
+
+  RenderQueue queue;
+  queue.begin(glm::vec3(0.0f), 1000.0f);
+  UniformRange shared =
+      queue.addUniforms({uniform("view"_sym, glm::mat4(1.0f))});
+  Material opaqueA1 = material(PASS_OPAQUE, a, TEX_A, STATE_DEFAULT, shared);
+  Material opaqueA2 = material(PASS_OPAQUE, a, TEX_B, STATE_DEFAULT, shared);
+  Material opaqueB = material(PASS_OPAQUE, b, TEX_B, STATE_DEFAULT, shared);
+  Material blended = material(PASS_TRANSPARENT, a, TEX_A,
+                              STATE_DEPTH_TEST | STATE_BLEND, shared);
+  Material hud = material(PASS_HUD, b, TEX_B, STATE_OVERLAY, UniformRange());
+  // The index count identifies each packet in the recording
+  queue.draw(blended, VAO_A, 1, glm::vec3(0.0f, 0.0f, 10.0f), UniformRange());
+  queue.draw(opaqueB, VAO_B, 2, glm::vec3(0.0f, 0.0f, 10.0f), UniformRange());
+  queue.draw(hud, VAO_B, 3, glm::vec3(0.0f), UniformRange());
+  queue.draw(opaqueA1, VAO_B, 4, glm::vec3(0.0f, 0.0f, 5.0f), UniformRange());
+  queue.draw(opaqueB, VAO_B, 5, glm::vec3(0.0f, 0.0f, 500.0f), UniformRange());
+  queue.draw(blended, VAO_A, 6, glm::vec3(0.0f, 0.0f, 200.0f), UniformRange());
+  queue.draw(opaqueA2, VAO_A, 7, glm::vec3(0.0f), UniformRange());
+  queue.draw(opaqueA1, VAO_A, 8, glm::vec3(0.0f, 0.0f, 900.0f),
+             {uniform("transform"_sym, glm::mat4(1.0f))});
+  queue.draw(hud, VAO_B, 9, glm::vec3(0.0f), UniformRange());
+
+  RecordingQueueBackend recording;
+  queue.submit(recording);
+  GraphicsBackend::set(nullptr);
+
+  // Opaque by shader, texture, vao and then front to back, transparent
+  // back to front and the hud in the order it was added
+  const std::vector<unsigned int> expected = {8, 4, 7, 2, 5, 6, 1, 3, 9};
+  std::vector<unsigned int> order;
+  unsigned int programs = 0, textures = 0, vaos = 0, states = 0, uniforms = 0;
+  for (const auto &call : recording.calls) {
+    switch (call.type) {
+    case RecordingQueueBackend::DRAW:
+      order.push_back(call.value);
+      break;
+    case RecordingQueueBackend::USE_PROGRAM:
+      programs++;
+      break;
+    case RecordingQueueBackend::BIND_TEXTURE:
+      textures++;
+      break;
+    case RecordingQueueBackend::BIND_VAO:
+      vaos++;
+      break;
+    case RecordingQueueBackend::SET_STATE:
+      states++;
+      break;
+    case RecordingQueueBackend::UNIFORM:
+      uniforms++;
+      break;
+    }
+  }
+
+  bool ok = true;
+  auto check = [&ok](const char *name, unsigned int got, unsigned int want) {
+    INFO("%-16s %u (expected %u)", name, got, want);
+    ok = ok && got == want;
+  };
+  for (size_t i = 0; i < expected.size(); i++)
+    check("draw", i < order.size() ? order[i] : 0, expected[i]);
+  check("draws", order.size(), expected.size());
+  // a b a b
+  check("program changes", programs, 4);
+  // TEX_A TEX_B TEX_A TEX_B
+  check("texture changes", textures, 4);
+  // VAO_A VAO_B VAO_A VAO_B VAO_A VAO_B
+  check("vao changes", vaos, 6);
+  // default, blend, overlay and back to default at the end
+  check("state changes", states, 4);
+  // The shared view once per program and the transform of packet 8
+  check("uniforms", uniforms, 3);
+  const QueueStats &stats = queue.getStats();
+  check("stats draws", stats.draws, order.size());
+  check("stats programs", stats.programChanges, programs);
+  check("stats textures", stats.textureChanges, textures);
+  check("stats vaos", stats.vaoChanges, vaos);
+  check("stats uniforms", stats.uniformUploads, uniforms);
+  if (!ok) {
+    ERROR("Render queue submitted in the wrong order");
+    return 1;
+  }
+  return 0;
+}